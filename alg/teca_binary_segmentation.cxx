@@ -207,7 +207,7 @@ const_p_teca_dataset teca_binary_segmentation::execute(
     // do segmentation and segmentation
     size_t n_elem = input_array->size();
     p_teca_unsigned_int_array segmentation =
-        teca_unsigned_int_array::New(n_elem);
+        teca_unsigned_int_array::New(n_elem, teca_uninitialized);
 
     TEMPLATE_DISPATCH(const teca_variant_array_impl,
         input_array.get(),
@@ -294,7 +294,7 @@ const_p_teca_dataset teca_l2_norm::execute(
     // allocate the output array
     unsigned long n = c0->size();
     p_teca_variant_array l2_norm = c0->new_instance();
-    l2_norm->resize(n);
+    l2_norm->resize(n, teca_uninitialized);
 
     // compute l2 norm
     TEMPLATE_DISPATCH_FP(
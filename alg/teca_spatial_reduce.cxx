@@ -0,0 +1,380 @@
+#include "teca_spatial_reduce.h"
+
+#include "teca_cartesian_mesh.h"
+#include "teca_table.h"
+#include "teca_array_collection.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_spatial_executive.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#if defined(TECA_HAS_BOOST)
+#include <boost/program_options.hpp>
+#endif
+
+using std::string;
+using std::vector;
+using std::cerr;
+using std::endl;
+
+//#define TECA_DEBUG
+
+namespace {
+
+// copy the points of the tile from the input array, which covers
+// in_ext, into the output array, which covers out_ext. the halo is
+// cropped.
+template <typename num_t>
+void copy_tile(num_t *out, const unsigned long *out_ext,
+    const num_t *in, const unsigned long *in_ext, const unsigned long *tile)
+{
+    unsigned long out_nx = out_ext[1] - out_ext[0] + 1;
+    unsigned long out_ny = out_ext[3] - out_ext[2] + 1;
+    unsigned long in_nx = in_ext[1] - in_ext[0] + 1;
+    unsigned long in_ny = in_ext[3] - in_ext[2] + 1;
+    unsigned long nx = tile[1] - tile[0] + 1;
+
+    for (unsigned long k = tile[4]; k <= tile[5]; ++k)
+    {
+        for (unsigned long j = tile[2]; j <= tile[3]; ++j)
+        {
+            const num_t *src = in + ((k - in_ext[4])*in_ny
+                + j - in_ext[2])*in_nx + tile[0] - in_ext[0];
+
+            num_t *dest = out + ((k - out_ext[4])*out_ny
+                + j - out_ext[2])*out_nx + tile[0] - out_ext[0];
+
+            std::copy(src, src + nx, dest);
+        }
+    }
+}
+
+// copy the points of the tile from each of the input arrays into
+// the corresponding output array. returns non-zero if the arrays
+// don't match.
+int copy_tile(const p_teca_array_collection &out, const unsigned long *out_ext,
+    const const_p_teca_array_collection &in, const unsigned long *in_ext,
+    const unsigned long *tile)
+{
+    unsigned int n_arrays = out->size();
+    for (unsigned int i = 0; i < n_arrays; ++i)
+    {
+        const string &name = out->get_name(i);
+
+        p_teca_variant_array out_a = out->get(i);
+        const_p_teca_variant_array in_a = in->get(name);
+        if (!in_a)
+        {
+            TECA_ERROR("array \"" << name << "\" is missing from a tile")
+            return -1;
+        }
+
+        bool copied = false;
+        TEMPLATE_DISPATCH(teca_variant_array_impl,
+            out_a.get(),
+
+            const TT *in_t = dynamic_cast<const TT*>(in_a.get());
+            if (in_t)
+            {
+                copy_tile(static_cast<TT*>(out_a.get())->get(), out_ext,
+                    in_t->get(), in_ext, tile);
+                copied = true;
+            }
+            )
+
+        if (!copied)
+        {
+            TECA_ERROR("array \"" << name << "\" has a different type "
+                "in each tile")
+            return -1;
+        }
+    }
+
+    return 0;
+}
+};
+
+
+// --------------------------------------------------------------------------
+teca_spatial_reduce::teca_spatial_reduce() :
+    number_of_i_tiles(1), number_of_j_tiles(0), halo(1)
+{
+    this->set_number_of_input_connections(1);
+    this->set_number_of_output_ports(1);
+}
+
+// --------------------------------------------------------------------------
+teca_spatial_reduce::~teca_spatial_reduce()
+{}
+
+#if defined(TECA_HAS_BOOST)
+// --------------------------------------------------------------------------
+void teca_spatial_reduce::get_properties_description(
+    const string &prefix, options_description &global_opts)
+{
+    this->teca_threaded_algorithm::get_properties_description(prefix, global_opts);
+
+    options_description opts("Options for "
+        + (prefix.empty()?"teca_spatial_reduce":prefix));
+
+    opts.add_options()
+        TECA_POPTS_GET(unsigned long, prefix, number_of_i_tiles,
+            "number of tiles in the i direction (1)")
+        TECA_POPTS_GET(unsigned long, prefix, number_of_j_tiles,
+            "number of tiles in the j direction. If set to 0 a tile "
+            "per thread is used. (0)")
+        TECA_POPTS_GET(unsigned long, prefix, halo,
+            "number of points to grow each tile by (1)")
+        ;
+
+    global_opts.add(opts);
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_reduce::set_properties(
+    const string &prefix, variables_map &opts)
+{
+    this->teca_threaded_algorithm::set_properties(prefix, opts);
+
+    TECA_POPTS_SET(opts, unsigned long, prefix, number_of_i_tiles)
+    TECA_POPTS_SET(opts, unsigned long, prefix, number_of_j_tiles)
+    TECA_POPTS_SET(opts, unsigned long, prefix, halo)
+}
+#endif
+
+// --------------------------------------------------------------------------
+void teca_spatial_reduce::get_tiles(const std::vector<unsigned long> &extent,
+    std::vector<std::vector<unsigned long>> &tiles) const
+{
+    unsigned long n_j = this->number_of_j_tiles ?
+        this->number_of_j_tiles : this->get_thread_pool_size();
+
+    teca_spatial_executive::partition(extent.data(),
+        this->number_of_i_tiles, n_j, tiles);
+}
+
+// --------------------------------------------------------------------------
+teca_metadata teca_spatial_reduce::get_output_metadata(
+    unsigned int port,
+    const std::vector<teca_metadata> &input_md)
+{
+#ifdef TECA_DEBUG
+    cerr << teca_parallel_id()
+        << "teca_spatial_reduce::get_output_metadata" << endl;
+#endif
+    (void)port;
+
+    teca_metadata out_md(input_md[0]);
+    return out_md;
+}
+
+// --------------------------------------------------------------------------
+std::vector<teca_metadata> teca_spatial_reduce::get_upstream_request(
+    unsigned int port, const std::vector<teca_metadata> &input_md,
+    const teca_metadata &request)
+{
+#ifdef TECA_DEBUG
+    cerr << teca_parallel_id()
+        << "teca_spatial_reduce::get_upstream_request" << endl;
+#endif
+    (void)port;
+
+    vector<teca_metadata> up_reqs;
+
+    vector<unsigned long> whole_extent;
+    if (input_md[0].get("whole_extent", whole_extent)
+        || (whole_extent.size() != 6))
+    {
+        TECA_ERROR("metadata is missing \"whole_extent\"")
+        return up_reqs;
+    }
+
+    vector<unsigned long> extent;
+    if (request.get("extent", extent))
+        extent = whole_extent;
+
+    vector<vector<unsigned long>> tiles;
+    this->get_tiles(extent, tiles);
+
+    size_t n_tiles = tiles.size();
+    up_reqs.resize(n_tiles, request);
+    for (size_t i = 0; i < n_tiles; ++i)
+    {
+        vector<unsigned long> tile_ext(6);
+        teca_spatial_executive::add_halo(tiles[i].data(), this->halo,
+            whole_extent.data(), tile_ext.data());
+
+        up_reqs[i].insert("extent", tile_ext);
+        up_reqs[i].insert("tile_extent", tiles[i]);
+    }
+
+    return up_reqs;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_spatial_reduce::execute(
+    unsigned int port, const std::vector<const_p_teca_dataset> &input_data,
+    const teca_metadata &request)
+{
+#ifdef TECA_DEBUG
+    cerr << teca_parallel_id()
+        << "teca_spatial_reduce::execute" << endl;
+#endif
+    (void)port;
+
+    size_t n_in = input_data.size();
+    if (!n_in || !input_data[0])
+    {
+        TECA_ERROR("empty input")
+        return nullptr;
+    }
+
+    // tile-local tables are concatenated
+    if (std::dynamic_pointer_cast<const teca_table>(input_data[0]))
+    {
+        p_teca_table out_table = teca_table::New();
+        out_table->copy_structure(
+            std::static_pointer_cast<const teca_table>(input_data[0]));
+
+        for (size_t i = 0; i < n_in; ++i)
+        {
+            const_p_teca_table in_table
+                = std::dynamic_pointer_cast<const teca_table>(input_data[i]);
+
+            if (!in_table)
+            {
+                TECA_ERROR("input " << i << " is not a table")
+                return nullptr;
+            }
+
+            out_table->concatenate_rows(in_table);
+        }
+
+        return out_table;
+    }
+
+    // mesh tiles are copied into place, cropping the halo
+    const_p_teca_cartesian_mesh in_mesh
+        = std::dynamic_pointer_cast<const teca_cartesian_mesh>(input_data[0]);
+
+    if (!in_mesh)
+    {
+        TECA_ERROR("input is not a teca_cartesian_mesh or a teca_table")
+        return nullptr;
+    }
+
+    vector<unsigned long> extent;
+    if (request.get("extent", extent))
+        in_mesh->get_whole_extent(extent);
+
+    // the tiles are the same as those requested, in the same order
+    vector<vector<unsigned long>> tiles;
+    this->get_tiles(extent, tiles);
+
+    size_t n_tiles = tiles.size();
+    if (n_tiles != n_in)
+    {
+        TECA_ERROR(<< n_in << " tiles were received but "
+            << n_tiles << " were expected")
+        return nullptr;
+    }
+
+    p_teca_cartesian_mesh out_mesh = teca_cartesian_mesh::New();
+    out_mesh->copy_metadata(in_mesh);
+    out_mesh->set_extent(extent);
+
+    unsigned long n_points = (extent[1] - extent[0] + 1)
+        *(extent[3] - extent[2] + 1)*(extent[5] - extent[4] + 1);
+
+    // allocate the output arrays like those of the first tile
+    const_p_teca_array_collection in_arrays = in_mesh->get_point_arrays();
+    p_teca_array_collection out_arrays = out_mesh->get_point_arrays();
+    unsigned int n_arrays = in_arrays->size();
+    for (unsigned int i = 0; i < n_arrays; ++i)
+    {
+        out_arrays->append(in_arrays->get_name(i),
+            in_arrays->get(i)->new_instance(n_points));
+    }
+
+    p_teca_variant_array x = in_mesh->get_x_coordinates()->new_instance(
+        extent[1] - extent[0] + 1);
+
+    p_teca_variant_array y = in_mesh->get_y_coordinates()->new_instance(
+        extent[3] - extent[2] + 1);
+
+    p_teca_array_collection out_x = teca_array_collection::New();
+    out_x->append("x", x);
+
+    p_teca_array_collection out_y = teca_array_collection::New();
+    out_y->append("y", y);
+
+    unsigned long out_x_ext[6] = {extent[0], extent[1], 0, 0, 0, 0};
+    unsigned long out_y_ext[6] = {extent[2], extent[3], 0, 0, 0, 0};
+
+    for (size_t i = 0; i < n_in; ++i)
+    {
+        const_p_teca_cartesian_mesh tile_mesh
+            = std::dynamic_pointer_cast<const teca_cartesian_mesh>(input_data[i]);
+
+        if (!tile_mesh)
+        {
+            TECA_ERROR("input " << i << " is not a teca_cartesian_mesh")
+            return nullptr;
+        }
+
+        const unsigned long *tile = tiles[i].data();
+
+        unsigned long in_ext[6];
+        tile_mesh->get_extent(in_ext);
+
+        if ((in_ext[0] > tile[0]) || (in_ext[1] < tile[1])
+            || (in_ext[2] > tile[2]) || (in_ext[3] < tile[3])
+            || (in_ext[4] > tile[4]) || (in_ext[5] < tile[5]))
+        {
+            TECA_ERROR("tile " << i << " does not cover the requested extent")
+            return nullptr;
+        }
+
+        if (copy_tile(out_arrays, extent.data(),
+            tile_mesh->get_point_arrays(), in_ext, tile))
+        {
+            TECA_ERROR("failed to copy tile " << i)
+            return nullptr;
+        }
+
+        // the coordinates are treated as one dimensional arrays
+        p_teca_array_collection in_x = teca_array_collection::New();
+        in_x->append("x", std::const_pointer_cast<teca_variant_array>(
+            tile_mesh->get_x_coordinates()));
+
+        p_teca_array_collection in_y = teca_array_collection::New();
+        in_y->append("y", std::const_pointer_cast<teca_variant_array>(
+            tile_mesh->get_y_coordinates()));
+
+        unsigned long in_x_ext[6] = {in_ext[0], in_ext[1], 0, 0, 0, 0};
+        unsigned long tile_x[6] = {tile[0], tile[1], 0, 0, 0, 0};
+
+        unsigned long in_y_ext[6] = {in_ext[2], in_ext[3], 0, 0, 0, 0};
+        unsigned long tile_y[6] = {tile[2], tile[3], 0, 0, 0, 0};
+
+        if (copy_tile(out_x, out_x_ext, in_x, in_x_ext, tile_x)
+            || copy_tile(out_y, out_y_ext, in_y, in_y_ext, tile_y))
+        {
+            TECA_ERROR("failed to copy the coordinates of tile " << i)
+            return nullptr;
+        }
+    }
+
+    out_mesh->set_x_coordinates(x);
+    out_mesh->set_y_coordinates(y);
+
+    // non-geometric data is the same in each tile
+    out_mesh->get_information_arrays()->shallow_copy(
+        std::const_pointer_cast<teca_array_collection>(
+            in_mesh->get_information_arrays()));
+
+    return out_mesh;
+}
@@ -0,0 +1,95 @@
+#ifndef teca_spatial_reduce_h
+#define teca_spatial_reduce_h
+
+#include "teca_shared_object.h"
+#include "teca_dataset_fwd.h"
+#include "teca_metadata.h"
+#include "teca_threaded_algorithm.h"
+
+#include <string>
+#include <vector>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_spatial_reduce)
+
+/// splits the requested extent into tiles processed in parallel
+/**
+an algorithm that splits the extent of each request into tiles,
+issues an upstream request per tile, and reassembles the results.
+the tiles are executed by the thread pool, such that a single
+large time step is processed in parallel.
+
+each tile is grown by halo points in i and j, clamped to the
+whole extent, so that stencil algorithms upstream such as
+teca_vorticity and teca_laplacian have the data they need on the
+edges of the tile. the tile proper is passed in the upstream
+request as "tile_extent" and the halo is cropped when the tiles
+are copied into the output mesh. algorithms upstream should treat
+the edges of the requested extent as boundaries only where they
+coincide with the edges of the whole extent.
+
+when the upstream produces tables rather than meshes, for instance
+a detector that reports tile-local candidates, the rows of the
+tables are concatenated. rows found in the halo are not removed.
+
+by default the extent is split in the j direction only, into one
+tile per thread. splitting in the i direction breaks periodicity
+in longitude.
+
+meta data keys:
+     requires:
+         whole_extent
+
+     consumes:
+         tile_extent
+*/
+class teca_spatial_reduce : public teca_threaded_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(teca_spatial_reduce)
+    ~teca_spatial_reduce();
+
+    // report/initialize to/from Boost program options
+    // objects.
+    TECA_GET_ALGORITHM_PROPERTIES_DESCRIPTION()
+    TECA_SET_ALGORITHM_PROPERTIES()
+
+    // set the number of tiles in the i and j directions. a value
+    // of 0 in j results in one tile per thread. the defaults are
+    // 1 and 0.
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_i_tiles)
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_j_tiles)
+
+    // set the number of points to grow each tile by. this should
+    // be the width of the widest stencil upstream. the default
+    // is 1.
+    TECA_ALGORITHM_PROPERTY(unsigned long, halo)
+
+protected:
+    teca_spatial_reduce();
+
+private:
+    teca_metadata get_output_metadata(
+        unsigned int port,
+        const std::vector<teca_metadata> &input_md) override;
+
+    std::vector<teca_metadata> get_upstream_request(
+        unsigned int port,
+        const std::vector<teca_metadata> &input_md,
+        const teca_metadata &request) override;
+
+    const_p_teca_dataset execute(
+        unsigned int port,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override;
+
+    // split the extent into tiles
+    void get_tiles(const std::vector<unsigned long> &extent,
+        std::vector<std::vector<unsigned long>> &tiles) const;
+
+private:
+    unsigned long number_of_i_tiles;
+    unsigned long number_of_j_tiles;
+    unsigned long halo;
+};
+
+#endif
@@ -47,6 +47,12 @@ teca_metadata teca_table_reduce::initialize_output_metadata(
     return output_md;
 }
 
+// --------------------------------------------------------------------------
+p_teca_dataset teca_table_reduce::new_reduction_dataset() const
+{
+    return teca_table::New();
+}
+
 // --------------------------------------------------------------------------
 p_teca_dataset teca_table_reduce::reduce(
     const const_p_teca_dataset &left_ds,
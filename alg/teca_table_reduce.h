@@ -39,6 +39,8 @@ protected:
     teca_metadata initialize_output_metadata(
         unsigned int port,
         const std::vector<teca_metadata> &input_md) override;
+
+    p_teca_dataset new_reduction_dataset() const override;
 };
 
 #endif
@@ -657,6 +657,7 @@ teca_metadata teca_tc_wind_radii::teca_tc_wind_radii::get_output_metadata(
         = teca_programmable_algorithm::New();
 
     capture_storm_data->set_input_connection(this->internals->storm_pipeline_port);
+    capture_storm_data->set_communicator(this->get_communicator());
 
     capture_storm_data->set_execute_callback(
         [&storm_data] (unsigned int, const std::vector<const_p_teca_dataset> &in_data,
@@ -673,7 +674,7 @@ teca_metadata teca_tc_wind_radii::teca_tc_wind_radii::get_output_metadata(
     int is_init = 0;
     MPI_Initialized(&is_init);
     if (is_init)
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_rank(this->get_communicator(), &rank);
 #endif
     // validate the table
     if (rank == 0)
@@ -735,7 +736,7 @@ teca_metadata teca_tc_wind_radii::teca_tc_wind_radii::get_output_metadata(
         teca_binary_stream bs;
         if (this->internals->storm_table && (rank == 0))
             this->internals->storm_table->to_stream(bs);
-        bs.broadcast();
+        bs.broadcast(this->get_communicator(), 0);
         if (bs && (rank != 0))
         {
            p_teca_table tmp = teca_table::New();
@@ -774,6 +775,12 @@ teca_metadata teca_tc_wind_radii::teca_tc_wind_radii::get_output_metadata(
     this->internals->metadata.insert(
         "number_of_time_steps", this->internals->number_of_storms);
 
+    // storms with long tracks take longest to process, have them
+    // scheduled first so they don't hold up the end of the run
+    std::vector<long> priority(this->internals->storm_counts.begin(),
+        this->internals->storm_counts.end());
+    this->internals->metadata.insert("time_step_priority", priority);
+
     return this->internals->metadata;
 }
 
@@ -353,7 +353,7 @@ const_p_teca_dataset teca_vorticity::execute(
 
     // allocate the output array
     p_teca_variant_array vort = comp_0->new_instance();
-    vort->resize(comp_0->size());
+    vort->resize(comp_0->size(), teca_uninitialized);
 
     // compute vorticity
     NESTED_TEMPLATE_DISPATCH_FP(
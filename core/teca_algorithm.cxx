@@ -2,14 +2,19 @@
 #include "teca_dataset.h"
 #include "teca_algorithm_executive.h"
 #include "teca_threadsafe_queue.h"
+#include "teca_tracer.h"
 
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
+#include <set>
+#include <unordered_map>
 #include <iostream>
 #include <utility>
 #include <algorithm>
 #include <mutex>
+#include <atomic>
 
 using std::vector;
 using std::map;
@@ -19,6 +24,161 @@ using std::istream;
 using std::pair;
 using std::mutex;
 
+// cached output data for a single output port. datasets are kept
+// in least to most recently used order and are indexed by the
+// digest of the request. requests with the same digest are
+// disambiguated by a full comparison. the memory used by the
+// cached datasets is tracked per port and process wide.
+class teca_request_data_cache
+{
+public:
+    struct entry_t
+    {
+        entry_t(const teca_metadata &req, const const_p_teca_dataset &ds,
+            unsigned long n_bytes, unsigned long long t) : request(req),
+            data(ds), bytes(n_bytes), stamp(t) {}
+
+        teca_metadata request;
+        const_p_teca_dataset data;
+        unsigned long bytes;
+        unsigned long long stamp;
+    };
+
+    using list_t = std::list<entry_t>;
+    using index_t = std::unordered_multimap<unsigned long long, list_t::iterator>;
+
+    teca_request_data_cache() : bytes(0) {}
+    teca_request_data_cache(teca_request_data_cache &&other);
+    ~teca_request_data_cache() { this->clear(); }
+
+    teca_request_data_cache(const teca_request_data_cache &) = delete;
+    void operator=(const teca_request_data_cache &) = delete;
+
+    // locate the entry for the request and mark it most recently
+    // used. returns end() if the request is not cached.
+    list_t::iterator find(const teca_metadata &request);
+
+    // insert or replace the dataset for the request. the entry
+    // becomes the most recently used.
+    void insert(const teca_metadata &request, const const_p_teca_dataset &data);
+
+    // remove the least and most recently used entries
+    void pop_front() { this->erase(this->entries.begin()); }
+    void pop_back() { this->erase(--this->entries.end()); }
+
+    list_t::iterator end() { return this->entries.end(); }
+
+    entry_t &front() { return this->entries.front(); }
+    entry_t &back() { return this->entries.back(); }
+
+    size_t size() const noexcept { return this->entries.size(); }
+    bool empty() const noexcept { return this->entries.empty(); }
+
+    void clear();
+
+    // get the bytes held by the datasets cached here
+    unsigned long get_memory_usage() const noexcept { return this->bytes; }
+
+    // get the bytes held by all caches in the process
+    static unsigned long get_total_memory_usage() noexcept
+    { return teca_request_data_cache::total_bytes; }
+
+private:
+    void erase(list_t::iterator it);
+
+private:
+    list_t entries;
+    index_t index;
+    unsigned long bytes;
+
+    static std::atomic<unsigned long> total_bytes;
+    static std::atomic<unsigned long long> access_time;
+};
+
+// --------------------------------------------------------------------------
+std::atomic<unsigned long> teca_request_data_cache::total_bytes(0);
+std::atomic<unsigned long long> teca_request_data_cache::access_time(0);
+
+// --------------------------------------------------------------------------
+teca_request_data_cache::teca_request_data_cache(
+    teca_request_data_cache &&other) : entries(std::move(other.entries)),
+    index(std::move(other.index)), bytes(other.bytes)
+{
+    other.entries.clear();
+    other.index.clear();
+    other.bytes = 0;
+}
+
+// --------------------------------------------------------------------------
+void teca_request_data_cache::clear()
+{
+    total_bytes -= this->bytes;
+    this->bytes = 0;
+    this->entries.clear();
+    this->index.clear();
+}
+
+// --------------------------------------------------------------------------
+teca_request_data_cache::list_t::iterator
+teca_request_data_cache::find(const teca_metadata &request)
+{
+    auto range = this->index.equal_range(request.get_digest());
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        list_t::iterator eit = it->second;
+        if (eit->request == request)
+        {
+            // move to the most recently used position
+            eit->stamp = ++access_time;
+            this->entries.splice(this->entries.end(), this->entries, eit);
+            return eit;
+        }
+    }
+    return this->entries.end();
+}
+
+// --------------------------------------------------------------------------
+void teca_request_data_cache::insert(const teca_metadata &request,
+    const const_p_teca_dataset &data)
+{
+    unsigned long n_bytes = data ? data->get_memory_usage() : 0;
+
+    list_t::iterator it = this->find(request);
+    if (it != this->entries.end())
+    {
+        this->bytes += n_bytes - it->bytes;
+        total_bytes += n_bytes - it->bytes;
+        it->data = data;
+        it->bytes = n_bytes;
+        return;
+    }
+
+    this->entries.emplace_back(request, data, n_bytes, ++access_time);
+    this->index.emplace(request.get_digest(), --this->entries.end());
+
+    this->bytes += n_bytes;
+    total_bytes += n_bytes;
+}
+
+// --------------------------------------------------------------------------
+void teca_request_data_cache::erase(list_t::iterator it)
+{
+    auto range = this->index.equal_range(it->request.get_digest());
+    for (auto iit = range.first; iit != range.second; ++iit)
+    {
+        if (iit->second == it)
+        {
+            this->index.erase(iit);
+            break;
+        }
+    }
+
+    this->bytes -= it->bytes;
+    total_bytes -= it->bytes;
+
+    this->entries.erase(it);
+}
+
 
 // implementation for managing input connections
 // and cached output data
@@ -72,6 +232,30 @@ public:
     void set_data_cache_size(unsigned int n);
     unsigned int get_data_cache_size() const noexcept;
 
+    // set/get the maximum bytes cached by this algorithm summed
+    // over all output ports. negative values disable the limit
+    void set_data_cache_memory_budget(long n_bytes);
+    long get_data_cache_memory_budget() const noexcept
+    { return this->data_cache_memory_budget; }
+
+    // get the bytes cached by this algorithm (thread safe)
+    unsigned long get_data_cache_memory_usage();
+
+    // evict least recently used datasets until the cached bytes
+    // are within this algorithm's budget. the caller must hold
+    // the data cache mutex
+    void enforce_data_cache_memory_budget();
+
+    // evict least recently used datasets across all algorithms
+    // until the cached bytes are within the process wide budget.
+    // the caller must not hold any data cache mutex
+    static void enforce_global_data_cache_memory_budget();
+
+    // get the port whose least recently used dataset is older than
+    // all others, and that dataset's access time. returns -1 if the
+    // caches are empty. the caller must hold the data cache mutex
+    int get_least_recently_used(unsigned long long &stamp);
+
     // set/clear modified flag for the given port
     void set_modified();
     void set_modified(unsigned int port);
@@ -82,6 +266,17 @@ public:
     // get the modified state of the given port
     int get_modified(unsigned int port) const;
 
+    // get the time of the last modification
+    unsigned long get_modified_time() const noexcept
+    { return this->modified_time; }
+
+    // get/set the cached metadata report for the given port
+    int get_cached_metadata(unsigned int port,
+        unsigned long modified_time, teca_metadata &md);
+
+    void cache_metadata(unsigned int port,
+        unsigned long modified_time, const teca_metadata &md);
+
     // set/get the executive
     p_teca_algorithm_executive get_executive();
     void set_executive(p_teca_algorithm_executive &exec);
@@ -89,6 +284,10 @@ public:
     // set the number of threads
     void set_number_of_threads(unsigned int n_threads);
 
+    // set/get the communicator
+    void set_communicator(MPI_Comm c) { this->comm = c; }
+    MPI_Comm get_communicator() const { return this->comm; }
+
     // print internal state to the stream
     void to_stream(ostream &os) const;
     void from_stream(istream &is);
@@ -103,16 +302,38 @@ public:
     // cached output data. maps from a request
     // to the cached dataset, one per output port
     unsigned int data_cache_size;
-    using req_data_map = map<teca_metadata, const_p_teca_dataset>;
-    vector<req_data_map> data_cache;
+    vector<teca_request_data_cache> data_cache;
     mutex data_cache_mutex;
 
+    // limits on the bytes cached by this algorithm and by all
+    // algorithms in the process
+    long data_cache_memory_budget;
+    static std::atomic<long> global_data_cache_memory_budget;
+
+    // all live instances, used to apply the process wide limit
+    static std::set<teca_algorithm_internals*> instances;
+    static mutex instances_mutex;
+
     // flag that indicates if the cache on output port
     // i is invalid
     vector<int> modified;
 
+    // time of the last modification. the value is taken from
+    // a process wide counter when the modified flags are set
+    std::atomic<unsigned long> modified_time;
+    static std::atomic<unsigned long> global_time;
+
+    // cached metadata reports one per output port, and the
+    // pipeline modified time at which each was made
+    vector<teca_metadata> metadata_cache;
+    vector<unsigned long> metadata_time;
+    mutex metadata_cache_mutex;
+
     // executive
     p_teca_algorithm_executive exec;
+
+    // communicator used in parallel execution
+    MPI_Comm comm;
 };
 
 // --------------------------------------------------------------------------
@@ -120,15 +341,30 @@ teca_algorithm_internals::teca_algorithm_internals()
             :
     name("teca_algorithm"),
     data_cache_size(1),
+    data_cache_memory_budget(-1),
     modified(1),
-    exec(teca_algorithm_executive::New())
+    modified_time(++global_time),
+    exec(teca_algorithm_executive::New()),
+    comm(MPI_COMM_WORLD)
 {
     this->set_number_of_outputs(1);
+
+    std::lock_guard<mutex> lock(instances_mutex);
+    instances.insert(this);
 }
 
+// --------------------------------------------------------------------------
+std::atomic<unsigned long> teca_algorithm_internals::global_time(0);
+std::atomic<long> teca_algorithm_internals::global_data_cache_memory_budget(-1);
+std::set<teca_algorithm_internals*> teca_algorithm_internals::instances;
+mutex teca_algorithm_internals::instances_mutex;
+
 // --------------------------------------------------------------------------
 teca_algorithm_internals::~teca_algorithm_internals() noexcept
-{}
+{
+    std::lock_guard<mutex> lock(instances_mutex);
+    instances.erase(this);
+}
 
 // --------------------------------------------------------------------------
 void teca_algorithm_internals::set_number_of_inputs(unsigned int n)
@@ -168,12 +404,23 @@ void teca_algorithm_internals::set_number_of_outputs(unsigned int n)
     }
 
     // create a chacne for each output
+    {
+    std::lock_guard<mutex> lock(this->data_cache_mutex);
     this->data_cache.clear();
     this->data_cache.resize(n);
+    }
 
     // create a modified flag for each output
     this->modified.clear();
     this->modified.resize(n, 1);
+    this->modified_time = ++global_time;
+
+    // create a metadata cache for each output
+    std::lock_guard<mutex> lock(this->metadata_cache_mutex);
+    this->metadata_cache.clear();
+    this->metadata_cache.resize(n);
+    this->metadata_time.clear();
+    this->metadata_time.resize(n, 0);
 }
 
 // --------------------------------------------------------------------------
@@ -185,14 +432,16 @@ unsigned int teca_algorithm_internals::get_number_of_outputs() const noexcept
 // --------------------------------------------------------------------------
 void teca_algorithm_internals::set_data_cache_size(unsigned int n)
 {
+    std::lock_guard<mutex> lock(this->data_cache_mutex);
+
     this->data_cache_size = n;
     unsigned int n_out = this->get_number_of_outputs();
     for (unsigned int i = 0; i < n_out; ++i)
     {
-        req_data_map &cache = this->data_cache[i];
+        teca_request_data_cache &cache = this->data_cache[i];
 
         while (cache.size() >  n)
-            cache.erase(cache.begin());
+            cache.pop_front();
     }
 }
 
@@ -213,15 +462,17 @@ void teca_algorithm_internals::clear_data_cache(unsigned int port)
 // --------------------------------------------------------------------------
 void teca_algorithm_internals::pop_cache(unsigned int port, int top)
 {
-    req_data_map &cache = this->data_cache[port];
+    std::lock_guard<mutex> lock(this->data_cache_mutex);
+
+    teca_request_data_cache &cache = this->data_cache[port];
 
     if (cache.empty())
         return;
 
     if (top)
-        cache.erase(--cache.end()); // newest
+        cache.pop_back(); // newest
     else
-        cache.erase(cache.begin()); // oldest
+        cache.pop_front(); // oldest
 }
 
 // --------------------------------------------------------------------------
@@ -232,20 +483,132 @@ int teca_algorithm_internals::cache_output_data(
 {
     if (this->data_cache_size)
     {
+        {
         std::lock_guard<mutex> lock(this->data_cache_mutex);
 
-        req_data_map &cache = this->data_cache[port];
+        teca_request_data_cache &cache = this->data_cache[port];
 
-        auto res = cache.insert(req_data_map::value_type(request, data));
-        if (!res.second)
-            res.first->second = data;
+        cache.insert(request, data);
+
+        while (cache.size() > this->data_cache_size)
+            cache.pop_front();
+
+        this->enforce_data_cache_memory_budget();
+        }
 
-        while (cache.size() >= this->data_cache_size)
-            cache.erase(cache.begin());
+        teca_algorithm_internals::enforce_global_data_cache_memory_budget();
     }
     return 0;
 }
 
+// --------------------------------------------------------------------------
+void teca_algorithm_internals::set_data_cache_memory_budget(long n_bytes)
+{
+    std::lock_guard<mutex> lock(this->data_cache_mutex);
+    this->data_cache_memory_budget = n_bytes;
+    this->enforce_data_cache_memory_budget();
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_algorithm_internals::get_data_cache_memory_usage()
+{
+    std::lock_guard<mutex> lock(this->data_cache_mutex);
+
+    unsigned long n_bytes = 0;
+    unsigned int n_out = this->data_cache.size();
+    for (unsigned int i = 0; i < n_out; ++i)
+        n_bytes += this->data_cache[i].get_memory_usage();
+
+    return n_bytes;
+}
+
+// --------------------------------------------------------------------------
+int teca_algorithm_internals::get_least_recently_used(unsigned long long &stamp)
+{
+    int port = -1;
+    unsigned int n_out = this->data_cache.size();
+    for (unsigned int i = 0; i < n_out; ++i)
+    {
+        teca_request_data_cache &cache = this->data_cache[i];
+        if (!cache.empty() && ((port < 0) || (cache.front().stamp < stamp)))
+        {
+            port = i;
+            stamp = cache.front().stamp;
+        }
+    }
+    return port;
+}
+
+// --------------------------------------------------------------------------
+void teca_algorithm_internals::enforce_data_cache_memory_budget()
+{
+    if (this->data_cache_memory_budget < 0)
+        return;
+
+    unsigned long budget = this->data_cache_memory_budget;
+
+    unsigned long n_bytes = 0;
+    unsigned int n_out = this->data_cache.size();
+    for (unsigned int i = 0; i < n_out; ++i)
+        n_bytes += this->data_cache[i].get_memory_usage();
+
+    while (n_bytes > budget)
+    {
+        unsigned long long stamp = 0;
+        int port = this->get_least_recently_used(stamp);
+        if (port < 0)
+            break;
+
+        teca_request_data_cache &cache = this->data_cache[port];
+        n_bytes -= cache.front().bytes;
+        cache.pop_front();
+    }
+}
+
+// --------------------------------------------------------------------------
+void teca_algorithm_internals::enforce_global_data_cache_memory_budget()
+{
+    long budget = global_data_cache_memory_budget;
+    if ((budget < 0) ||
+        (teca_request_data_cache::get_total_memory_usage() <=
+        static_cast<unsigned long>(budget)))
+        return;
+
+    // holding the instance lock keeps the instances alive and
+    // serializes eviction. the data cache mutexes are only taken
+    // while this lock is held, never the other way around.
+    std::lock_guard<mutex> ilock(instances_mutex);
+
+    while (teca_request_data_cache::get_total_memory_usage() >
+        static_cast<unsigned long>(budget))
+    {
+        // find the least recently used dataset in the process
+        teca_algorithm_internals *lru = nullptr;
+        unsigned long long lru_stamp = 0;
+        for (teca_algorithm_internals *inst : instances)
+        {
+            std::lock_guard<mutex> lock(inst->data_cache_mutex);
+            unsigned long long stamp = 0;
+            if ((inst->get_least_recently_used(stamp) >= 0) &&
+                (!lru || (stamp < lru_stamp)))
+            {
+                lru = inst;
+                lru_stamp = stamp;
+            }
+        }
+
+        if (!lru)
+            break;
+
+        // evict it, unless it was used in the meantime
+        std::lock_guard<mutex> lock(lru->data_cache_mutex);
+        unsigned long long stamp = 0;
+        int port = lru->get_least_recently_used(stamp);
+        if ((port >= 0) && (stamp == lru_stamp))
+            lru->data_cache[port].pop_front();
+    }
+}
+
 // --------------------------------------------------------------------------
 const_p_teca_dataset teca_algorithm_internals::get_output_data(
     unsigned int port,
@@ -253,12 +616,12 @@ const_p_teca_dataset teca_algorithm_internals::get_output_data(
 {
     std::lock_guard<mutex> lock(this->data_cache_mutex);
 
-    req_data_map &cache = this->data_cache[port];
+    teca_request_data_cache &cache = this->data_cache[port];
 
-    req_data_map::iterator it = cache.find(request);
+    teca_request_data_cache::list_t::iterator it = cache.find(request);
     if (it != cache.end())
     {
-        return it->second;
+        return it->data;
     }
 
     return const_p_teca_dataset();
@@ -269,12 +632,12 @@ const_p_teca_dataset teca_algorithm_internals::get_output_data(unsigned int port
 {
     std::lock_guard<mutex> lock(this->data_cache_mutex);
 
-    req_data_map &cache = this->data_cache[port];
+    teca_request_data_cache &cache = this->data_cache[port];
 
     if (cache.empty())
         return const_p_teca_dataset();
 
-    return cache.rbegin()->second; // newest
+    return cache.back().data; // newest
 }
 
 // --------------------------------------------------------------------------
@@ -287,6 +650,7 @@ int teca_algorithm_internals::get_modified(unsigned int port) const
 void teca_algorithm_internals::set_modified(unsigned int port)
 {
     this->modified[port] = 1;
+    this->modified_time = ++global_time;
 }
 
 // --------------------------------------------------------------------------
@@ -295,6 +659,34 @@ void teca_algorithm_internals::set_modified()
     std::for_each(
         this->modified.begin(), this->modified.end(),
         [](int &m){ m = 1; });
+    this->modified_time = ++global_time;
+}
+
+// --------------------------------------------------------------------------
+int teca_algorithm_internals::get_cached_metadata(unsigned int port,
+    unsigned long time, teca_metadata &md)
+{
+    std::lock_guard<mutex> lock(this->metadata_cache_mutex);
+
+    if (this->metadata_time[port] != time)
+        return -1;
+
+    md = this->metadata_cache[port];
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+void teca_algorithm_internals::cache_metadata(unsigned int port,
+    unsigned long time, const teca_metadata &md)
+{
+    std::lock_guard<mutex> lock(this->metadata_cache_mutex);
+
+    // a report made before a later modification is not kept
+    if (this->metadata_time[port] > time)
+        return;
+
+    this->metadata_cache[port] = md;
+    this->metadata_time[port] = time;
 }
 
 // --------------------------------------------------------------------------
@@ -448,6 +840,43 @@ void teca_algorithm::set_cache_size(unsigned int n)
     this->set_modified();
 }
 
+// --------------------------------------------------------------------------
+void teca_algorithm::set_cache_memory_budget(long n_bytes)
+{
+    this->internals->set_data_cache_memory_budget(n_bytes);
+}
+
+// --------------------------------------------------------------------------
+long teca_algorithm::get_cache_memory_budget() const
+{
+    return this->internals->get_data_cache_memory_budget();
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_algorithm::get_cache_memory_usage() const
+{
+    return this->internals->get_data_cache_memory_usage();
+}
+
+// --------------------------------------------------------------------------
+void teca_algorithm::set_global_cache_memory_budget(long n_bytes)
+{
+    teca_algorithm_internals::global_data_cache_memory_budget = n_bytes;
+    teca_algorithm_internals::enforce_global_data_cache_memory_budget();
+}
+
+// --------------------------------------------------------------------------
+long teca_algorithm::get_global_cache_memory_budget()
+{
+    return teca_algorithm_internals::global_data_cache_memory_budget;
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_algorithm::get_global_cache_memory_usage()
+{
+    return teca_request_data_cache::get_total_memory_usage();
+}
+
 // --------------------------------------------------------------------------
 void teca_algorithm::set_modified()
 {
@@ -472,6 +901,36 @@ void teca_algorithm::clear_modified(unsigned int port)
     this->internals->clear_modified(port);
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_algorithm::get_pipeline_modified_time()
+{
+    unsigned long time = this->internals->get_modified_time();
+
+    unsigned int n = this->get_number_of_input_connections();
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        p_teca_algorithm &up = get_algorithm(this->get_input_connection(i));
+        if (up)
+            time = std::max(time, up->get_pipeline_modified_time());
+    }
+
+    return time;
+}
+
+// --------------------------------------------------------------------------
+int teca_algorithm::get_cached_metadata(unsigned int port,
+    unsigned long modified_time, teca_metadata &md)
+{
+    return this->internals->get_cached_metadata(port, modified_time, md);
+}
+
+// --------------------------------------------------------------------------
+void teca_algorithm::cache_metadata(unsigned int port,
+    unsigned long modified_time, const teca_metadata &md)
+{
+    this->internals->cache_metadata(port, modified_time, md);
+}
+
 // --------------------------------------------------------------------------
 void teca_algorithm::set_executive(p_teca_algorithm_executive exec)
 {
@@ -484,6 +943,28 @@ p_teca_algorithm_executive teca_algorithm::get_executive()
     return this->internals->get_executive();
 }
 
+// --------------------------------------------------------------------------
+void teca_algorithm::set_communicator(MPI_Comm comm)
+{
+    this->internals->set_communicator(comm);
+    this->set_modified();
+
+    // and the upstream algorithms
+    unsigned int n_inputs = this->get_number_of_input_connections();
+    for (unsigned int i = 0; i < n_inputs; ++i)
+    {
+        p_teca_algorithm &alg = get_algorithm(this->get_input_connection(i));
+        if (alg)
+            alg->set_communicator(comm);
+    }
+}
+
+// --------------------------------------------------------------------------
+MPI_Comm teca_algorithm::get_communicator() const
+{
+    return this->internals->get_communicator();
+}
+
 // --------------------------------------------------------------------------
 void teca_algorithm::set_number_of_input_connections(unsigned int n)
 {
@@ -551,8 +1032,14 @@ teca_metadata teca_algorithm::get_cache_key(
 {
     (void) port;
 
-    // default implementation passes the request through
-    return request;
+    // default implementation passes the request through, less
+    // the scheduling priority which doesn't change the data
+    if (!request.has("__request_priority"))
+        return request;
+
+    teca_metadata key(request);
+    key.remove("__request_priority");
+    return key;
 }
 
 // --------------------------------------------------------------------------
@@ -562,6 +1049,15 @@ teca_metadata teca_algorithm::get_output_metadata(
     p_teca_algorithm alg = get_algorithm(current);
     unsigned int port = get_port(current);
 
+    // use the cached report unless something changed since
+    // it was made. this saves walking the upstream pipeline
+    // and copying its metadata on every request.
+    unsigned long modified_time = alg->get_pipeline_modified_time();
+
+    teca_metadata output_md;
+    if (!alg->get_cached_metadata(port, modified_time, output_md))
+        return output_md;
+
     // gather upstream metadata one per input
     // connection.
 
@@ -576,7 +1072,14 @@ teca_metadata teca_algorithm::get_output_metadata(
     // now that we have metadata for the algorithm's
     // inputs, call the override to do the actual work
     // of reporting output meta data
-    return alg->get_output_metadata(port, input_md);
+    {
+    teca_trace_span span("get_output_metadata", alg.get(), port);
+    output_md = alg->get_output_metadata(port, input_md);
+    }
+
+    alg->cache_metadata(port, modified_time, output_md);
+
+    return output_md;
 }
 
 // --------------------------------------------------------------------------
@@ -589,6 +1092,8 @@ const_p_teca_dataset teca_algorithm::request_data(
     p_teca_algorithm &alg = get_algorithm(current);
     unsigned int port = get_port(current);
 
+    teca_trace_span span("request_data", alg.get(), port, request);
+
     // check for cached data
     teca_metadata key = alg->get_cache_key(port, request);
     const_p_teca_dataset out_data = alg->get_output_data(port, key);
@@ -604,8 +1109,11 @@ const_p_teca_dataset teca_algorithm::request_data(
         }
 
         // get requests for upstream data
-        vector<teca_metadata> up_reqs
-            = alg->get_upstream_request(port, input_md, request);
+        vector<teca_metadata> up_reqs;
+        {
+        teca_trace_span span("get_upstream_request", alg.get(), port, request);
+        up_reqs = alg->get_upstream_request(port, input_md, request);
+        }
 
         // get the upstream data mapping the requests round-robbin
         // on to the inputs
@@ -624,12 +1132,18 @@ const_p_teca_dataset teca_algorithm::request_data(
         }
 
         // execute override
+        {
+        teca_trace_span span("execute", alg.get(), port, request);
         out_data = alg->execute(port, input_data, request);
+        span.set_output(out_data);
+        }
 
         // cache
         alg->cache_output_data(port, key, out_data);
     }
 
+    span.set_output(out_data);
+
     return out_data;
 }
 
@@ -681,6 +1195,7 @@ int teca_algorithm::update(unsigned int port_id)
 
     // initialize the executive
     p_teca_algorithm_executive exec = this->internals->get_executive();
+    exec->set_communicator(this->get_communicator());
     if (exec->initialize(this->get_output_metadata(port)))
     {
         TECA_ERROR("failed to initialize the executive")
@@ -2,6 +2,7 @@
 #define teca_algorithm_h
 
 #include "teca_config.h"
+#include "teca_mpi.h"
 
 // forward delcaration of ref counted types
 #include "teca_dataset_fwd.h"
@@ -61,14 +62,14 @@ public:
     void clear_input_connections();
 
     // access the cached data produced by this algorithm. when no
-    // request is specified the dataset on the top(most recent) of
-    // the cache is returned. When a request is specified it may
+    // request is specified the dataset on the top(most recently used)
+    // of the cache is returned. When a request is specified it may
     // optionally be filtered by the implementations cache key filter.
     // see also get_cache_key (threadsafe)
     const_p_teca_dataset get_output_data(unsigned int port = 0);
 
     // remove a dataset from the top/bottom of the cache. the
-    // top of the cache has the most recently created dataset.
+    // top of the cache has the most recently used dataset.
     // top or bottom is selected via the boolean argument.
     // (threadsafe)
     void pop_cache(unsigned int port = 0, int top = 0);
@@ -76,6 +77,31 @@ public:
     // set the cache size. the default is 1. (threadsafe)
     void set_cache_size(unsigned int n);
 
+    // set the maximum number of bytes held by this algorithm's cached
+    // datasets, summed over its output ports. datasets are sized by
+    // teca_dataset::get_memory_usage. when the budget is exceeded the
+    // least recently used datasets are evicted. the limit applies in
+    // addition to the cache size. a negative value, the default,
+    // disables the limit. (threadsafe)
+    void set_cache_memory_budget(long n_bytes);
+    long get_cache_memory_budget() const;
+
+    // get the number of bytes held by this algorithm's cached
+    // datasets. (threadsafe)
+    unsigned long get_cache_memory_usage() const;
+
+    // set the maximum number of bytes held by the cached datasets
+    // of all algorithms in the process. when exceeded the least
+    // recently used datasets are evicted, regardless of which
+    // algorithm holds them. a negative value, the default, disables
+    // the limit. (threadsafe)
+    static void set_global_cache_memory_budget(long n_bytes);
+    static long get_global_cache_memory_budget();
+
+    // get the number of bytes held by the cached datasets of all
+    // algorithms in the process. (threadsafe)
+    static unsigned long get_global_cache_memory_usage();
+
     // execute the pipeline from this instance up.
     virtual int update();
     virtual int update(unsigned int port);
@@ -87,6 +113,14 @@ public:
     void set_executive(p_teca_algorithm_executive exe);
     p_teca_algorithm_executive get_executive();
 
+    // set the MPI communicator used by this algorithm and by all of
+    // the algorithms upstream of it. the pipeline's executive is
+    // given the communicator of the algorithm that is updated.
+    // independent pipelines may be run concurrently on disjoint
+    // communicators. the default is MPI_COMM_WORLD.
+    void set_communicator(MPI_Comm comm);
+    MPI_Comm get_communicator() const;
+
     // serialize the configuration to a stream. this should
     // store the public user modifiable properties so that
     // runtime configuration may be saved and restored..
@@ -151,7 +185,8 @@ protected:
 
     // implementations may choose to override this method
     // to gain control of keys used in the cache. By default
-    // the passed in request is used as the key. This overide
+    // the passed in request, less the __request_priority
+    // scheduling hint, is used as the key. This overide
     // gives implementor the chance to filter the passed in
     // request.
     virtual
@@ -165,7 +200,9 @@ protected:
 // of algorithms.
 
     // driver function that manage meta data reporting  phase
-    // of pipeline execution.
+    // of pipeline execution. the report is cached per output
+    // port and reused until this algorithm or one upstream of
+    // it is modified.
     virtual
     teca_metadata get_output_metadata(
         teca_algorithm_output_port &current);
@@ -217,11 +254,29 @@ protected:
     // return the output port's modified flag value
     int get_modified(unsigned int port) const;
 
+    // get the time of the most recent modification of this
+    // algorithm or any algorithm upstream of it. times are taken
+    // from a process wide counter each time the modified flags
+    // are set, such that they may be compared across algorithms.
+    unsigned long get_pipeline_modified_time();
+
+    // search the given port's metadata cache. returns 0 and sets
+    // md when the cached report was made at the given modified
+    // time. (threadsafe)
+    int get_cached_metadata(unsigned int port,
+        unsigned long modified_time, teca_metadata &md);
+
+    // update the given port's metadata cache (threadsafe)
+    void cache_metadata(unsigned int port,
+        unsigned long modified_time, const teca_metadata &md);
+
 private:
     teca_algorithm_internals *internals;
 
     friend class teca_threaded_algorithm;
     friend class teca_data_request;
+    friend class teca_prefetch;
+    friend class teca_disk_cache;
 };
 
 #endif
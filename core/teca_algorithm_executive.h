@@ -3,6 +3,7 @@
 
 #include "teca_algorithm_executive_fwd.h"
 #include "teca_metadata.h"
+#include "teca_mpi.h"
 
 // base class and default implementation for executives. algorithm
 // executives can control pipeline execution by providing a series
@@ -37,8 +38,13 @@ public:
     // processed. an empty request is returned.
     virtual teca_metadata get_next_request();
 
+    // set the communicator across which requests are partitioned.
+    // this is set from the pipeline before initialize is called.
+    void set_communicator(MPI_Comm comm) { m_comm = comm; }
+    MPI_Comm get_communicator() const { return m_comm; }
+
 protected:
-    teca_algorithm_executive() = default;
+    teca_algorithm_executive() : m_comm(MPI_COMM_WORLD) {}
     teca_algorithm_executive(const teca_algorithm_executive &) = default;
     teca_algorithm_executive(teca_algorithm_executive &&) = default;
     teca_algorithm_executive &operator=(const teca_algorithm_executive &) = default;
@@ -46,6 +52,7 @@ protected:
 
 private:
     teca_metadata m_md;
+    MPI_Comm m_comm;
 };
 
 #endif
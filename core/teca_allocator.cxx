@@ -0,0 +1,64 @@
+#include "teca_allocator.h"
+
+#include <cstdlib>
+#include <atomic>
+
+namespace {
+
+// --------------------------------------------------------------------------
+void *default_allocate(std::size_t n_bytes, std::size_t alignment)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, n_bytes ? n_bytes : alignment))
+        return nullptr;
+    return ptr;
+}
+
+// --------------------------------------------------------------------------
+void default_deallocate(void *ptr, std::size_t, std::size_t)
+{
+    free(ptr);
+}
+
+std::atomic<teca_allocator::allocate_t> allocate_fn(default_allocate);
+std::atomic<teca_allocator::deallocate_t> deallocate_fn(default_deallocate);
+}
+
+namespace teca_allocator
+{
+// --------------------------------------------------------------------------
+void set_functions(allocate_t alloc, deallocate_t dealloc)
+{
+    if (!alloc || !dealloc)
+    {
+        alloc = default_allocate;
+        dealloc = default_deallocate;
+    }
+
+    allocate_fn = alloc;
+    deallocate_fn = dealloc;
+}
+
+// --------------------------------------------------------------------------
+void get_functions(allocate_t &alloc, deallocate_t &dealloc)
+{
+    alloc = allocate_fn;
+    dealloc = deallocate_fn;
+}
+
+// --------------------------------------------------------------------------
+void *allocate(std::size_t n_bytes)
+{
+    void *ptr = allocate_fn.load()(n_bytes, alignment);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+// --------------------------------------------------------------------------
+void deallocate(void *ptr, std::size_t n_bytes) noexcept
+{
+    if (ptr)
+        deallocate_fn.load()(ptr, n_bytes, alignment);
+}
+}
@@ -0,0 +1,108 @@
+#ifndef teca_allocator_h
+#define teca_allocator_h
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// tag used to request storage that is not initialized. use it when
+// every element is written before it is read, for instance when an
+// array is passed to a reader or is the output of a stencil, to skip
+// the pass over memory that zero filling costs.
+struct teca_uninitialized_t {};
+constexpr teca_uninitialized_t teca_uninitialized{};
+
+// memory management for array storage. allocations are aligned
+// to a 64 byte boundary, a cache line and the width of the widest
+// SIMD registers, so that the compiler may use aligned vector loads
+// and arrays don't share cache lines across threads.
+//
+// the allocation functions can be replaced, for instance to route
+// array storage through a memory pool or a tracking allocator. the
+// replacement must be installed before arrays are allocated, and
+// remain in place while any of them are alive, since memory is
+// always returned to the functions that are current.
+namespace teca_allocator
+{
+// the alignment in bytes of array storage
+constexpr std::size_t alignment = 64;
+
+// allocate n_bytes aligned to alignment bytes. returns nullptr
+// on failure.
+using allocate_t = void *(*)(std::size_t n_bytes, std::size_t alignment);
+
+// release memory allocated by the matching allocate_t. n_bytes is
+// the size passed when the memory was allocated.
+using deallocate_t = void (*)(void *ptr, std::size_t n_bytes,
+    std::size_t alignment);
+
+// install the functions used to allocate array storage. passing
+// nullptr for either restores the defaults, which use
+// posix_memalign and free.
+void set_functions(allocate_t alloc, deallocate_t dealloc);
+
+// get the functions currently in use
+void get_functions(allocate_t &alloc, deallocate_t &dealloc);
+
+// allocate and release array storage with the functions in use.
+// allocate throws std::bad_alloc on failure.
+void *allocate(std::size_t n_bytes);
+void deallocate(void *ptr, std::size_t n_bytes) noexcept;
+}
+
+// a standard allocator for array storage. memory is aligned and
+// obtained through teca_allocator. elements constructed without
+// arguments are default initialized, so arrays of numbers are not
+// zero filled when they are sized. containers using it must pass
+// a value when zero filled storage is required.
+template <typename T>
+class teca_aligned_allocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = teca_aligned_allocator<U>; };
+
+    teca_aligned_allocator() noexcept = default;
+
+    template <typename U>
+    teca_aligned_allocator(const teca_aligned_allocator<U> &) noexcept {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T*>(teca_allocator::allocate(n*sizeof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept
+    {
+        teca_allocator::deallocate(ptr, n*sizeof(T));
+    }
+
+    // default initialize
+    template <typename U>
+    void construct(U *ptr)
+        noexcept(std::is_nothrow_default_constructible<U>::value)
+    {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+
+    template <typename U, typename ... args_t>
+    void construct(U *ptr, args_t &&... args)
+    {
+        ::new (static_cast<void*>(ptr)) U(std::forward<args_t>(args)...);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const teca_aligned_allocator<T> &,
+    const teca_aligned_allocator<U> &) noexcept
+{ return true; }
+
+template <typename T, typename U>
+bool operator!=(const teca_aligned_allocator<T> &,
+    const teca_aligned_allocator<U> &) noexcept
+{ return false; }
+
+#endif
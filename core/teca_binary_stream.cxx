@@ -1,13 +1,65 @@
 #include "teca_binary_stream.h"
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
 #if defined(TECA_HAS_MPI)
 #include <mpi.h>
 #endif
 
+#if defined(TECA_HAS_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace {
+
+// marks the start of a compressed stream. it is followed by the codec
+// and the size of the uncompressed data
+const unsigned char compression_magic[8] =
+    {0x89, 'T', 'E', 'C', 'A', 'Z', '\r', '\n'};
+
+constexpr unsigned long compression_header_size =
+    sizeof(compression_magic) + sizeof(int) + sizeof(unsigned long);
+
+// zlib counts bytes with unsigned int, larger buffers are passed in
+// pieces of this size
+constexpr unsigned long max_codec_chunk = 1ul << 30;
+
+// the default codec and level
+struct codec_defaults
+{
+    codec_defaults() : codec(teca_binary_stream::codec_none), level(1)
+    {
+        const char *name = getenv("TECA_STREAM_CODEC");
+        if (name && (strcmp(name, "zlib") == 0))
+        {
+#if defined(TECA_HAS_ZLIB)
+            this->codec = teca_binary_stream::codec_zlib;
+#else
+            TECA_WARNING("TECA_STREAM_CODEC=zlib is ignored. TECA was"
+                " built without zlib, streams will not be compressed")
+#endif
+        }
+    }
+
+    std::atomic<int> codec;
+    std::atomic<int> level;
+};
+
+// --------------------------------------------------------------------------
+codec_defaults &get_codec_defaults()
+{
+    static codec_defaults defaults;
+    return defaults;
+}
+}
+
 //-----------------------------------------------------------------------------
 
 teca_binary_stream::teca_binary_stream()
-     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr)
+     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr),
+     m_gather_threshold(0)
 {}
 
 //-----------------------------------------------------------------------------
@@ -18,12 +70,14 @@ teca_binary_stream::~teca_binary_stream() noexcept
 
 //-----------------------------------------------------------------------------
 teca_binary_stream::teca_binary_stream(const teca_binary_stream &other)
-     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr)
+     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr),
+     m_gather_threshold(0)
 { *this = other; }
 
 //-----------------------------------------------------------------------------
 teca_binary_stream::teca_binary_stream(teca_binary_stream &&other) noexcept
-     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr)
+     : m_size(0), m_data(nullptr), m_read_p(nullptr), m_write_p(nullptr),
+     m_gather_threshold(0)
 { this->swap(other); }
 
 //-----------------------------------------------------------------------------
@@ -39,6 +93,9 @@ const teca_binary_stream &teca_binary_stream::operator=(
     m_write_p = m_data + in_use;
     m_read_p = m_data + (other.m_read_p - other.m_data);
 
+    m_gather_threshold = other.m_gather_threshold;
+    m_references = other.m_references;
+
     return *this;
 }
 
@@ -59,6 +116,7 @@ void teca_binary_stream::clear() noexcept
     m_read_p = nullptr;
     m_write_p = nullptr;
     m_size = 0;
+    m_references.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -104,13 +162,21 @@ void teca_binary_stream::grow(unsigned long n_bytes)
     unsigned long n_bytes_needed = this->size() + n_bytes;
     if (n_bytes_needed > m_size)
     {
-        unsigned long new_size = m_size + this->get_block_size();
-        while (new_size < n_bytes_needed)
-            new_size += this->get_block_size();
-        this->resize(new_size);
+        // double the size, so that the number of reallocations and
+        // bytes copied is linear in the final size
+        unsigned long new_size = std::max(2*m_size,
+            static_cast<unsigned long>(this->get_block_size()));
+        this->resize(std::max(new_size, n_bytes_needed));
     }
 }
 
+//-----------------------------------------------------------------------------
+void teca_binary_stream::reserve(unsigned long n_bytes)
+{
+    if (n_bytes > m_size)
+        this->resize(n_bytes);
+}
+
 //-----------------------------------------------------------------------------
 void teca_binary_stream::swap(teca_binary_stream &other) noexcept
 {
@@ -118,10 +184,77 @@ void teca_binary_stream::swap(teca_binary_stream &other) noexcept
     std::swap(m_write_p, other.m_write_p);
     std::swap(m_read_p, other.m_read_p);
     std::swap(m_size, other.m_size);
+    std::swap(m_gather_threshold, other.m_gather_threshold);
+    m_references.swap(other.m_references);
+}
+
+//-----------------------------------------------------------------------------
+unsigned long teca_binary_stream::get_total_size() const noexcept
+{
+    unsigned long n_bytes = this->size();
+    for (const reference &ref : m_references)
+        n_bytes += ref.data.n_bytes;
+    return n_bytes;
+}
+
+//-----------------------------------------------------------------------------
+void teca_binary_stream::get_segments(unsigned long first,
+    unsigned long n_bytes, std::vector<segment> &segs) const
+{
+    unsigned long last = first + n_bytes;
+    unsigned long pos = 0;
+
+    // add the part of a run that falls in [first, last)
+    auto add = [&](const unsigned char *data, unsigned long len)
+    {
+        unsigned long run_first = std::max(pos, first);
+        unsigned long run_last = std::min(pos + len, last);
+        if (run_first < run_last)
+            segs.push_back({data + (run_first - pos), run_last - run_first});
+        pos += len;
+    };
+
+    unsigned long offset = 0;
+    for (const reference &ref : m_references)
+    {
+        add(m_data + offset, ref.offset - offset);
+        add(ref.data.data, ref.data.n_bytes);
+        offset = ref.offset;
+    }
+
+    add(m_data + offset, this->size() - offset);
 }
 
 //-----------------------------------------------------------------------------
-int teca_binary_stream::broadcast(int root_rank)
+void teca_binary_stream::flatten()
+{
+    if (m_references.empty())
+        return;
+
+    std::vector<segment> segs;
+    this->get_segments(segs);
+
+    unsigned long n_bytes = this->get_total_size();
+    unsigned char *data = (unsigned char *)malloc(n_bytes);
+
+    unsigned char *p = data;
+    for (const segment &seg : segs)
+    {
+        memcpy(p, seg.data, seg.n_bytes);
+        p += seg.n_bytes;
+    }
+
+    free(m_data);
+    m_data = data;
+    m_size = n_bytes;
+    m_read_p = m_data;
+    m_write_p = m_data + n_bytes;
+
+    m_references.clear();
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::broadcast(MPI_Comm comm, int root_rank)
 {
 #if defined(TECA_HAS_MPI)
     int init = 0;
@@ -130,24 +263,264 @@ int teca_binary_stream::broadcast(int root_rank)
     if (init)
     {
         unsigned long nbytes = 0;
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_rank(comm, &rank);
         if (rank == root_rank)
         {
-            nbytes = this->size();
-            MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, root_rank, MPI_COMM_WORLD);
-            MPI_Bcast(this->get_data(), nbytes, MPI_BYTE, root_rank, MPI_COMM_WORLD);
+            // compress with the default codec, if one is set. the
+            // data is sent uncompressed if that fails
+            teca_binary_stream compressed;
+            if (this->compress_into(compressed))
+                compressed.clear();
+
+            teca_binary_stream &out = compressed ? compressed : *this;
+
+            nbytes = out.size();
+            MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, root_rank, comm);
+            MPI_Bcast(out.get_data(), nbytes, MPI_BYTE, root_rank, comm);
         }
         else
         {
-            MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, root_rank, MPI_COMM_WORLD);
+            MPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, root_rank, comm);
             this->resize(nbytes);
-            MPI_Bcast(this->get_data(), nbytes, MPI_BYTE, root_rank, MPI_COMM_WORLD);
+            MPI_Bcast(this->get_data(), nbytes, MPI_BYTE, root_rank, comm);
             this->set_read_pos(0);
             this->set_write_pos(nbytes);
+
+            if (this->decompress())
+                return -1;
         }
     }
 #else
+    (void)comm;
     (void)root_rank;
 #endif
     return 0;
 }
+
+//-----------------------------------------------------------------------------
+void teca_binary_stream::set_default_codec(int codec, int level)
+{
+#if !defined(TECA_HAS_ZLIB)
+    if (codec == codec_zlib)
+    {
+        TECA_WARNING("zlib is not available. TECA was built without"
+            " zlib, streams will not be compressed")
+        codec = codec_none;
+    }
+#endif
+    codec_defaults &defaults = get_codec_defaults();
+    defaults.codec = codec;
+    defaults.level = level;
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::get_default_codec()
+{
+    return get_codec_defaults().codec;
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::get_default_level()
+{
+    return get_codec_defaults().level;
+}
+
+//-----------------------------------------------------------------------------
+bool teca_binary_stream::compressed() const noexcept
+{
+    return (this->size() >= compression_header_size) &&
+        (memcmp(m_data, compression_magic, sizeof(compression_magic)) == 0);
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::compress(int codec, int level)
+{
+    teca_binary_stream out;
+    if (this->compress_into(out, codec, level))
+        return -1;
+
+    if (out)
+    {
+        out.m_gather_threshold = m_gather_threshold;
+        this->swap(out);
+    }
+
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::compress_into(teca_binary_stream &out, int codec,
+    int level) const
+{
+    out.clear();
+
+    if ((codec == codec_none) || this->compressed())
+        return 0;
+
+    if (codec != codec_zlib)
+    {
+        TECA_ERROR("Invalid codec " << codec)
+        return -1;
+    }
+
+#if defined(TECA_HAS_ZLIB)
+    unsigned long n_bytes = this->get_total_size();
+
+    std::vector<segment> segs;
+    this->get_segments(segs);
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
+    if (deflateInit(&zs, level) != Z_OK)
+    {
+        TECA_ERROR("Failed to initialize zlib. " << (zs.msg ? zs.msg : ""))
+        return -1;
+    }
+
+    out.reserve(compression_header_size + deflateBound(&zs, n_bytes));
+    out.pack(compression_magic, sizeof(compression_magic));
+    out.pack(codec);
+    out.pack(n_bytes);
+
+    // compress the segments in order, in pieces zlib can count
+    unsigned char *out_begin = out.m_write_p;
+    unsigned char *out_end = out.m_data + out.m_size;
+    zs.next_out = out_begin;
+
+    size_t n_segs = segs.size();
+    int ierr = Z_OK;
+    for (size_t i = 0; (i <= n_segs) && (ierr != Z_STREAM_END); ++i)
+    {
+        const unsigned char *in = i < n_segs ? segs[i].data : nullptr;
+        unsigned long n_in = i < n_segs ? segs[i].n_bytes : 0;
+        int flush = i < n_segs ? Z_NO_FLUSH : Z_FINISH;
+        do
+        {
+            unsigned long n = std::min(n_in, max_codec_chunk);
+            zs.next_in = const_cast<unsigned char*>(in);
+            zs.avail_in = n;
+
+            do
+            {
+                zs.avail_out = std::min(static_cast<unsigned long>(
+                    out_end - zs.next_out), max_codec_chunk);
+
+                ierr = deflate(&zs, (n == n_in) ? flush : Z_NO_FLUSH);
+                if ((ierr == Z_STREAM_ERROR) ||
+                    ((ierr == Z_BUF_ERROR) && (zs.next_out == out_end)))
+                {
+                    TECA_ERROR("Failed to compress the stream. "
+                        << (zs.msg ? zs.msg : ""))
+                    deflateEnd(&zs);
+                    out.clear();
+                    return -1;
+                }
+            }
+            while (zs.avail_in || ((n == n_in) && (flush == Z_FINISH) &&
+                (ierr != Z_STREAM_END)));
+
+            in += n;
+            n_in -= n;
+        }
+        while (n_in);
+    }
+
+    out.m_write_p = zs.next_out;
+    deflateEnd(&zs);
+
+    return 0;
+#else
+    (void)level;
+    TECA_ERROR("Failed to compress the stream. TECA was built without zlib")
+    return -1;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+int teca_binary_stream::decompress()
+{
+    if (!this->compressed())
+        return 0;
+
+    int codec = codec_none;
+    unsigned long n_bytes = 0;
+
+    unsigned char *read_p = m_read_p;
+    m_read_p = m_data + sizeof(compression_magic);
+    this->unpack(codec);
+    this->unpack(n_bytes);
+    m_read_p = read_p;
+
+    if (codec != codec_zlib)
+    {
+        TECA_ERROR("Failed to decompress the stream. Invalid codec " << codec)
+        return -1;
+    }
+
+    // an empty stream has nothing to inflate, and zlib rejects the
+    // null output buffer an empty stream would give it
+    if (n_bytes == 0)
+    {
+        this->clear();
+        return 0;
+    }
+
+#if defined(TECA_HAS_ZLIB)
+    z_stream zs;
+    memset(&zs, 0, sizeof(z_stream));
+    if (inflateInit(&zs) != Z_OK)
+    {
+        TECA_ERROR("Failed to initialize zlib. " << (zs.msg ? zs.msg : ""))
+        return -1;
+    }
+
+    teca_binary_stream out;
+    out.resize(n_bytes);
+
+    unsigned char *in = m_data + compression_header_size;
+    unsigned char *in_end = m_write_p;
+    unsigned char *out_end = out.m_data + n_bytes;
+    zs.next_out = out.m_data;
+
+    int ierr = Z_OK;
+    while (ierr != Z_STREAM_END)
+    {
+        zs.next_in = in;
+        zs.avail_in = std::min(static_cast<unsigned long>(in_end - in),
+            max_codec_chunk);
+
+        zs.avail_out = std::min(static_cast<unsigned long>(
+            out_end - zs.next_out), max_codec_chunk);
+
+        ierr = inflate(&zs, Z_NO_FLUSH);
+        if ((ierr != Z_OK) && (ierr != Z_STREAM_END))
+        {
+            TECA_ERROR("Failed to decompress the stream. "
+                << (zs.msg ? zs.msg : ""))
+            inflateEnd(&zs);
+            return -1;
+        }
+
+        in = zs.next_in;
+    }
+
+    inflateEnd(&zs);
+
+    if (zs.next_out != out_end)
+    {
+        TECA_ERROR("Failed to decompress the stream. Expected "
+            << n_bytes << " bytes but found " << (zs.next_out - out.m_data))
+        return -1;
+    }
+
+    out.m_write_p = out_end;
+    out.m_read_p = out.m_data;
+    out.m_gather_threshold = m_gather_threshold;
+    this->swap(out);
+
+    return 0;
+#else
+    TECA_ERROR("Failed to decompress the stream. TECA was built without zlib")
+    return -1;
+#endif
+}
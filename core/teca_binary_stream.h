@@ -2,17 +2,43 @@
 #define teca_binary_stream_h
 
 #include "teca_common.h"
+#include "teca_mpi.h"
 
 #include <cstdlib>
 #include <cstring>
 #include <string>
 #include <map>
 #include <vector>
+#include <memory>
 
 // Serialize objects into a binary stream.
+//
+// The stream can be put in a scatter-gather mode where the payload of
+// large arrays is not copied into the stream. Instead a reference to
+// the array's buffer is recorded, and the stream is made of segments,
+// runs of the stream's own bytes interleaved with the referenced
+// buffers. Such a stream can be sent or written without staging copies
+// by passing its segments to writev or an MPI derived datatype, see
+// get_segments. It can't be read from or accessed through get_data
+// until it is flattened.
 class teca_binary_stream
 {
 public:
+    // a run of contiguous bytes
+    struct segment
+    {
+        const unsigned char *data;
+        unsigned long n_bytes;
+    };
+
+    // arrays of this size or larger are referenced when scatter-gather
+    // mode is enabled with the default threshold
+    static constexpr unsigned long default_gather_threshold = 1ul << 16;
+
+    // codecs for compressing streams. zlib is available when TECA is
+    // built with it
+    enum {codec_none = 0, codec_zlib = 1};
+
     // construct
     teca_binary_stream();
     ~teca_binary_stream() noexcept;
@@ -36,9 +62,14 @@ public:
     // Alolocate n_bytes for the stream.
     void resize(unsigned long n_bytes);
 
-    // ensures space for n_bytes more to the stream.
+    // ensures space for n_bytes more to the stream. the buffer is
+    // grown geometrically so that packing n bytes costs O(n)
     void grow(unsigned long n_bytes);
 
+    // ensure the capacity is at least n_bytes. use it when the size
+    // of the serialized data is known or can be estimated in advance
+    void reserve(unsigned long n_bytes);
+
     // Get a pointer to the stream internal representation.
     unsigned char *get_data() noexcept
     { return m_data; }
@@ -67,6 +98,75 @@ public:
     // swap the two objects
     void swap(teca_binary_stream &other) noexcept;
 
+    // enable scatter-gather mode. arrays of n_bytes or more packed with
+    // pack_reference are referenced rather than copied. 0, the default,
+    // disables it.
+    void set_gather_threshold(unsigned long n_bytes) noexcept
+    { m_gather_threshold = n_bytes; }
+
+    unsigned long get_gather_threshold() const noexcept
+    { return m_gather_threshold; }
+
+    // returns true when the stream holds references to arrays
+    bool has_references() const noexcept
+    { return !m_references.empty(); }
+
+    // get the size of the stream including referenced arrays
+    unsigned long get_total_size() const noexcept;
+
+    // get the segments holding the n_bytes starting at first, or all
+    // of the stream, in order.
+    void get_segments(unsigned long first, unsigned long n_bytes,
+        std::vector<segment> &segs) const;
+
+    void get_segments(std::vector<segment> &segs) const
+    { this->get_segments(0, this->get_total_size(), segs); }
+
+    // copy referenced arrays into the stream and release them
+    void flatten();
+
+    // replace the contents of the stream with a compressed copy. the
+    // compressed stream starts with a header naming the codec and the
+    // size of the data, so that the receiver can tell how to decompress
+    // it. level trades speed for size, 1 is the fastest. a stream in
+    // scatter-gather mode is compressed from its segments. returns
+    // zero if successful.
+    int compress(int codec, int level = 1);
+
+    // as above but the compressed copy is placed in out and this
+    // stream is left as it is. the data is read from the stream's
+    // segments, a stream in scatter-gather mode is not flattened.
+    // out is left empty when codec is codec_none or the stream is
+    // already compressed. returns zero if successful.
+    int compress_into(teca_binary_stream &out, int codec,
+        int level = 1) const;
+
+    // decompress the stream if it starts with a compression header.
+    // streams that are not compressed are left as they are. returns
+    // zero if successful.
+    int decompress();
+
+    // returns true if the stream starts with a compression header
+    bool compressed() const noexcept;
+
+    // set/get the codec and level used when datasets are sent between
+    // ranks or written to disk. the default is codec_none, unless the
+    // environment variable TECA_STREAM_CODEC names a codec ("zlib").
+    // when TECA is built without zlib, asking for it issues a warning
+    // and streams are not compressed.
+    // receivers and readers detect compressed streams by their header,
+    // so the setting needs only to be made where data is sent.
+    static void set_default_codec(int codec, int level = 1);
+    static int get_default_codec();
+    static int get_default_level();
+
+    // compress with the default codec, if one is set
+    int compress() { return this->compress(get_default_codec(),
+        get_default_level()); }
+
+    int compress_into(teca_binary_stream &out) const
+    { return this->compress_into(out, get_default_codec(), get_default_level()); }
+
     // Insert/Extract to/from the stream.
     template <typename T> void pack(T *val);
     template <typename T> void pack(const T &val);
@@ -74,18 +174,42 @@ public:
     template <typename T> void pack(const T *val, unsigned long n);
     template <typename T> void unpack(T *val, unsigned long n);
 
+    // pack n values from a buffer held by owner. in scatter-gather mode
+    // large buffers are referenced and owner is kept until the stream
+    // is cleared or flattened. the values must not be modified in the
+    // mean time.
+    template <typename T>
+    void pack_reference(const T *val, unsigned long n,
+        const std::shared_ptr<const void> &owner);
+
+    // strings are always copied
+    void pack_reference(const std::string *val, unsigned long n,
+        const std::shared_ptr<const void> &)
+    { this->pack(val, n); }
+
     // specializations
     void pack(const std::string &str);
     void unpack(std::string &str);
 
-    void pack(const std::vector<std::string> &v);
-    void unpack(std::vector<std::string> &v);
+    void pack(const std::string *v, unsigned long n);
+    void unpack(std::string *v, unsigned long n);
+
+    template<typename A> void pack(const std::vector<std::string, A> &v);
+    template<typename A> void unpack(std::vector<std::string, A> &v);
 
-    template<typename T> void pack(const std::vector<T> &v);
-    template<typename T> void unpack(std::vector<T> &v);
+    template<typename T, typename A> void pack(const std::vector<T, A> &v);
+    template<typename T, typename A> void unpack(std::vector<T, A> &v);
 
-    // broadcast the stream from the root process to all other processes
-    int broadcast(int root_rank=0);
+    // broadcast the stream from the root process to all other
+    // processes in the communicator. the root must be given, since
+    // where MPI_Comm is an integer a default would make the call
+    // with a communicator alone resolve to the overload below.
+    int broadcast(MPI_Comm comm, int root_rank);
+
+    // broadcast the stream from the root process to all other
+    // processes in MPI_COMM_WORLD
+    int broadcast(int root_rank=0)
+    { return this->broadcast(MPI_COMM_WORLD, root_rank); }
 
 private:
     // re-allocation size
@@ -94,10 +218,21 @@ private:
     { return 512; }
 
 private:
+    // an array referenced in scatter-gather mode. it follows the
+    // first offset bytes of the stream's own data
+    struct reference
+    {
+        unsigned long offset;
+        segment data;
+        std::shared_ptr<const void> owner;
+    };
+
     unsigned long m_size;
     unsigned char *m_data;
     unsigned char *m_read_p;
     unsigned char *m_write_p;
+    unsigned long m_gather_threshold;
+    std::vector<reference> m_references;
 };
 
 //-----------------------------------------------------------------------------
@@ -146,6 +281,22 @@ void teca_binary_stream::unpack(T *val, unsigned long n)
     m_read_p += nn;
 }
 
+//-----------------------------------------------------------------------------
+template <typename T>
+void teca_binary_stream::pack_reference(const T *val, unsigned long n,
+    const std::shared_ptr<const void> &owner)
+{
+    unsigned long n_bytes = n*sizeof(T);
+    if (!m_gather_threshold || (n_bytes < m_gather_threshold))
+    {
+        this->pack(val, n);
+        return;
+    }
+
+    m_references.push_back({this->size(),
+        {reinterpret_cast<const unsigned char*>(val), n_bytes}, owner});
+}
+
 //-----------------------------------------------------------------------------
 inline
 void teca_binary_stream::pack(const std::string &str)
@@ -170,29 +321,43 @@ void teca_binary_stream::unpack(std::string &str)
 
 //-----------------------------------------------------------------------------
 inline
-void teca_binary_stream::pack(const std::vector<std::string> &v)
+void teca_binary_stream::pack(const std::string *v, unsigned long n)
 {
-    unsigned long vlen = v.size();
-    this->pack(vlen);
-    for (unsigned long i = 0; i < vlen; ++i)
+    for (unsigned long i = 0; i < n; ++i)
         this->pack(v[i]);
 }
 
 //-----------------------------------------------------------------------------
 inline
-void teca_binary_stream::unpack(std::vector<std::string> &v)
+void teca_binary_stream::unpack(std::string *v, unsigned long n)
+{
+    for (unsigned long i = 0; i < n; ++i)
+        this->unpack(v[i]);
+}
+
+//-----------------------------------------------------------------------------
+template<typename A>
+void teca_binary_stream::pack(const std::vector<std::string, A> &v)
+{
+    unsigned long vlen = v.size();
+    this->pack(vlen);
+    this->pack(v.data(), vlen);
+}
+
+//-----------------------------------------------------------------------------
+template<typename A>
+void teca_binary_stream::unpack(std::vector<std::string, A> &v)
 {
     unsigned long vlen;
     this->unpack(vlen);
 
     v.resize(vlen);
-    for (unsigned long i = 0; i < vlen; ++i)
-        this->unpack(v[i]);
+    this->unpack(v.data(), vlen);
 }
 
 //-----------------------------------------------------------------------------
-template<typename T>
-void teca_binary_stream::pack(const std::vector<T> &v)
+template<typename T, typename A>
+void teca_binary_stream::pack(const std::vector<T, A> &v)
 {
     const unsigned long vlen = v.size();
     this->pack(vlen);
@@ -200,8 +365,8 @@ void teca_binary_stream::pack(const std::vector<T> &v)
 }
 
 //-----------------------------------------------------------------------------
-template<typename T>
-void teca_binary_stream::unpack(std::vector<T> &v)
+template<typename T, typename A>
+void teca_binary_stream::unpack(std::vector<T, A> &v)
 {
     unsigned long vlen;
     this->unpack(vlen);
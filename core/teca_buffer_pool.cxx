@@ -0,0 +1,376 @@
+#include "teca_buffer_pool.h"
+#include "teca_allocator.h"
+
+#include <cstdlib>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <ostream>
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace {
+
+// four size classes per power of two, from the smallest block size
+// 2^16 up to 2^40. larger blocks are not pooled.
+constexpr unsigned int min_block_log2 = 16;
+constexpr unsigned int max_block_log2 = 40;
+constexpr unsigned int classes_per_log2 = 4;
+constexpr unsigned int n_classes =
+    (max_block_log2 - min_block_log2)*classes_per_log2;
+
+// the number of blocks of each size class a thread may keep
+constexpr unsigned int thread_cache_blocks = 2;
+
+static_assert(teca_buffer_pool::min_block_size == (1ul << min_block_log2),
+    "min_block_size must match min_block_log2");
+
+// --------------------------------------------------------------------------
+unsigned int log2_floor(std::size_t n)
+{
+    unsigned int k = 0;
+    while (n >>= 1)
+        ++k;
+    return k;
+}
+
+// --------------------------------------------------------------------------
+// get the size class of an allocation and the size of its blocks.
+// returns false if the allocation is not pooled.
+bool get_size_class(std::size_t n_bytes, unsigned int &size_class,
+    std::size_t &block_size)
+{
+    if (n_bytes < teca_buffer_pool::min_block_size)
+        return false;
+
+    unsigned int k = log2_floor(n_bytes);
+    std::size_t base = std::size_t(1) << k;
+    std::size_t step = base/classes_per_log2;
+
+    std::size_t j = (n_bytes - base + step - 1)/step;
+    if (j == classes_per_log2)
+    {
+        ++k;
+        j = 0;
+        base <<= 1;
+        step <<= 1;
+    }
+
+    if (k >= max_block_log2)
+        return false;
+
+    size_class = (k - min_block_log2)*classes_per_log2 + j;
+    block_size = base + j*step;
+    return true;
+}
+
+// --------------------------------------------------------------------------
+std::size_t get_block_size(unsigned int size_class)
+{
+    unsigned int k = min_block_log2 + size_class/classes_per_log2;
+    std::size_t base = std::size_t(1) << k;
+    return base + (size_class % classes_per_log2)*(base/classes_per_log2);
+}
+
+// --------------------------------------------------------------------------
+void *heap_allocate(std::size_t n_bytes, std::size_t alignment)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, n_bytes ? n_bytes : alignment))
+        return nullptr;
+    return ptr;
+}
+
+// --------------------------------------------------------------------------
+// returns true if the heap block at ptr holds at least n_bytes. blocks
+// allocated before the pool was enabled are only as large as the array
+// they held and may be too small for their size class. the heap knows
+// the size of each of its blocks, so no lock is needed to tell
+bool holds(void *ptr, std::size_t n_bytes)
+{
+#if defined(__APPLE__)
+    return malloc_size(ptr) >= n_bytes;
+#else
+    return malloc_usable_size(ptr) >= n_bytes;
+#endif
+}
+
+// the pool's shared state
+struct teca_buffer_pool_state
+{
+    teca_buffer_pool_state() : enabled(false), capacity(0),
+        n_bytes_cached(0), hits(0), misses(0), returns(0), releases(0)
+    {}
+
+    std::atomic<bool> enabled;
+    std::atomic<std::size_t> capacity;
+    std::atomic<std::size_t> n_bytes_cached;
+    std::atomic<unsigned long> hits;
+    std::atomic<unsigned long> misses;
+    std::atomic<unsigned long> returns;
+    std::atomic<unsigned long> releases;
+    std::mutex mutex;
+    std::vector<void*> blocks[n_classes];
+};
+
+// --------------------------------------------------------------------------
+teca_buffer_pool_state &get_state()
+{
+    // never destroyed, arrays may be released during static destruction
+    static teca_buffer_pool_state *state = new teca_buffer_pool_state;
+    return *state;
+}
+
+// --------------------------------------------------------------------------
+// free the blocks, and remove them from the count of cached bytes
+void release_blocks(std::vector<void*> *blocks)
+{
+    teca_buffer_pool_state &state = get_state();
+    for (unsigned int i = 0; i < n_classes; ++i)
+    {
+        std::size_t n = blocks[i].size();
+        if (!n)
+            continue;
+
+        for (void *ptr : blocks[i])
+            free(ptr);
+
+        blocks[i].clear();
+        state.n_bytes_cached -= n*get_block_size(i);
+        state.releases += n;
+    }
+}
+
+// a thread's blocks. when the thread exits they are moved to the
+// shared cache
+struct teca_buffer_pool_thread_cache
+{
+    teca_buffer_pool_thread_cache();
+    ~teca_buffer_pool_thread_cache();
+
+    std::vector<void*> blocks[n_classes];
+};
+
+thread_local bool thread_cache_destroyed = false;
+
+// --------------------------------------------------------------------------
+teca_buffer_pool_thread_cache::teca_buffer_pool_thread_cache()
+{
+    // so that returning a block doesn't allocate
+    for (unsigned int i = 0; i < n_classes; ++i)
+        this->blocks[i].reserve(thread_cache_blocks);
+}
+
+// --------------------------------------------------------------------------
+teca_buffer_pool_thread_cache::~teca_buffer_pool_thread_cache()
+{
+    thread_cache_destroyed = true;
+
+    teca_buffer_pool_state &state = get_state();
+    if (!state.enabled)
+    {
+        release_blocks(this->blocks);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (unsigned int i = 0; i < n_classes; ++i)
+        state.blocks[i].insert(state.blocks[i].end(),
+            this->blocks[i].begin(), this->blocks[i].end());
+}
+
+// --------------------------------------------------------------------------
+teca_buffer_pool_thread_cache *get_thread_cache()
+{
+    // arrays may be released after the thread's cache is destroyed,
+    // those blocks go to the shared cache
+    if (thread_cache_destroyed)
+        return nullptr;
+
+    static thread_local teca_buffer_pool_thread_cache cache;
+    return &cache;
+}
+}
+
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::enable(std::size_t capacity)
+{
+    teca_buffer_pool_state &state = get_state();
+    state.capacity = capacity;
+    state.enabled = true;
+
+    teca_allocator::set_functions(teca_buffer_pool::allocate,
+        teca_buffer_pool::deallocate);
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::disable()
+{
+    teca_allocator::set_functions(nullptr, nullptr);
+
+    teca_buffer_pool_state &state = get_state();
+    state.enabled = false;
+    teca_buffer_pool::release();
+}
+
+// --------------------------------------------------------------------------
+bool teca_buffer_pool::enabled() noexcept
+{
+    return get_state().enabled;
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::set_capacity(std::size_t capacity) noexcept
+{
+    get_state().capacity = capacity;
+}
+
+// --------------------------------------------------------------------------
+std::size_t teca_buffer_pool::get_capacity() noexcept
+{
+    return get_state().capacity;
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::release()
+{
+    teca_buffer_pool_thread_cache *cache = get_thread_cache();
+    if (cache)
+        release_blocks(cache->blocks);
+
+    teca_buffer_pool_state &state = get_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    release_blocks(state.blocks);
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::get_stats(stats &s) noexcept
+{
+    teca_buffer_pool_state &state = get_state();
+    s.hits = state.hits;
+    s.misses = state.misses;
+    s.returns = state.returns;
+    s.releases = state.releases;
+    s.n_bytes_cached = state.n_bytes_cached;
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::reset_stats() noexcept
+{
+    teca_buffer_pool_state &state = get_state();
+    state.hits = 0;
+    state.misses = 0;
+    state.returns = 0;
+    state.releases = 0;
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::to_stream(std::ostream &os)
+{
+    stats s;
+    teca_buffer_pool::get_stats(s);
+
+    unsigned long n_alloc = s.hits + s.misses;
+    os << "buffer pool hits " << s.hits << " misses " << s.misses
+        << " hit rate " << (n_alloc ? (100.0*s.hits)/n_alloc : 0.0)
+        << "% returns " << s.returns << " releases " << s.releases
+        << " cached " << s.n_bytes_cached << " of "
+        << teca_buffer_pool::get_capacity() << " bytes";
+}
+
+// --------------------------------------------------------------------------
+void *teca_buffer_pool::allocate(std::size_t n_bytes, std::size_t alignment)
+{
+    unsigned int size_class = 0;
+    std::size_t block_size = 0;
+    if (!get_size_class(n_bytes, size_class, block_size))
+        return heap_allocate(n_bytes, alignment);
+
+    teca_buffer_pool_state &state = get_state();
+
+    // look in this thread's cache, then in the shared cache
+    void *ptr = nullptr;
+    teca_buffer_pool_thread_cache *cache = get_thread_cache();
+    if (cache && !cache->blocks[size_class].empty())
+    {
+        ptr = cache->blocks[size_class].back();
+        cache->blocks[size_class].pop_back();
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.blocks[size_class].empty())
+        {
+            ptr = state.blocks[size_class].back();
+            state.blocks[size_class].pop_back();
+        }
+    }
+
+    if (ptr)
+    {
+        state.n_bytes_cached -= block_size;
+        ++state.hits;
+        return ptr;
+    }
+
+    ++state.misses;
+    return heap_allocate(block_size, alignment);
+}
+
+// --------------------------------------------------------------------------
+void teca_buffer_pool::deallocate(void *ptr, std::size_t n_bytes,
+    std::size_t)
+{
+    unsigned int size_class = 0;
+    std::size_t block_size = 0;
+    if (!get_size_class(n_bytes, size_class, block_size))
+    {
+        free(ptr);
+        return;
+    }
+
+    // memory allocated before the pool was enabled may be too small
+    // to serve other sizes in the class, return it to the heap
+    if (!holds(ptr, block_size))
+    {
+        free(ptr);
+        return;
+    }
+
+    // return the block to the heap when the pool is full
+    teca_buffer_pool_state &state = get_state();
+    if ((state.n_bytes_cached.fetch_add(block_size) + block_size) > state.capacity)
+    {
+        state.n_bytes_cached -= block_size;
+        ++state.releases;
+        free(ptr);
+        return;
+    }
+
+    ++state.returns;
+
+    teca_buffer_pool_thread_cache *cache = get_thread_cache();
+    if (cache && (cache->blocks[size_class].size() < thread_cache_blocks))
+    {
+        cache->blocks[size_class].push_back(ptr);
+        return;
+    }
+
+    try
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.blocks[size_class].push_back(ptr);
+    }
+    catch (...)
+    {
+        state.n_bytes_cached -= block_size;
+        --state.returns;
+        ++state.releases;
+        free(ptr);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef teca_buffer_pool_h
+#define teca_buffer_pool_h
+
+#include <cstddef>
+#include <iosfwd>
+
+/// a pool recycling the storage of large arrays
+/**
+Each time step allocates and releases the same set of large arrays,
+reader outputs and the results of algorithms. When the pool is enabled
+it is installed as teca_allocator's functions and the storage of those
+arrays is kept when the last reference to it is dropped, then handed
+out again the next time an array of about the same size is needed,
+rather than being returned to the heap.
+
+Sizes are rounded up to one of four size classes per power of two, so
+at most a quarter of a block is unused. Each thread keeps a small
+cache of blocks that it can take from and return to without locking,
+blocks that don't fit there go to a shared cache. The total size of
+the cached blocks is limited by the capacity, blocks released when the
+pool is full are returned to the heap. Arrays smaller than the
+smallest size class are not pooled.
+
+The pool can be enabled by setting the environment variable
+TECA_BUFFER_POOL to the capacity in megabytes, teca_mpi_manager then
+enables it at startup, or by calling enable. Storage of arrays allocated
+before the pool was enabled is kept only when the heap block is large
+enough for its size class, otherwise it is returned to the heap when
+released.
+*/
+class teca_buffer_pool
+{
+public:
+    // pool statistics
+    struct stats
+    {
+        unsigned long hits;         // allocations served from the pool
+        unsigned long misses;       // allocations served by the heap
+        unsigned long returns;      // blocks kept for reuse
+        unsigned long releases;     // blocks returned to the heap
+        unsigned long n_bytes_cached; // bytes currently held
+    };
+
+    // the size of the smallest pooled block in bytes
+    static constexpr std::size_t min_block_size = 65536;
+
+    // enable the pool by installing it as teca_allocator's functions.
+    // capacity is the maximum number of bytes held for reuse.
+    static void enable(std::size_t capacity);
+
+    // restore teca_allocator's default functions and release the
+    // cached blocks. memory allocated by the pool may still be in use
+    // and will be returned to the heap.
+    static void disable();
+
+    // returns true when the pool is enabled
+    static bool enabled() noexcept;
+
+    // set/get the maximum number of bytes held for reuse. lowering the
+    // capacity does not release blocks, see release.
+    static void set_capacity(std::size_t capacity) noexcept;
+    static std::size_t get_capacity() noexcept;
+
+    // return the blocks in the shared cache and the calling thread's
+    // cache to the heap
+    static void release();
+
+    // get and reset the statistics
+    static void get_stats(stats &s) noexcept;
+    static void reset_stats() noexcept;
+
+    // send a summary of the statistics to the stream
+    static void to_stream(std::ostream &os);
+
+    // allocate and release memory. these are installed as teca_allocator's
+    // functions when the pool is enabled.
+    static void *allocate(std::size_t n_bytes, std::size_t alignment);
+    static void deallocate(void *ptr, std::size_t n_bytes,
+        std::size_t alignment);
+};
+
+#endif
@@ -0,0 +1,405 @@
+#include "teca_config.h"
+#include "teca_checkpoint.h"
+#include "teca_dataset.h"
+#include "teca_common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// identifies the files
+const char *file_header = "teca_checkpoint";
+
+// --------------------------------------------------------------------------
+void split_path(const std::string &file_name, std::string &dir,
+    std::string &base)
+{
+    size_t pos = file_name.rfind('/');
+    if (pos == std::string::npos)
+    {
+        dir = ".";
+        base = file_name;
+    }
+    else
+    {
+        dir = pos ? file_name.substr(0, pos) : "/";
+        base = file_name.substr(pos + 1);
+    }
+}
+
+// --------------------------------------------------------------------------
+int read_file(const std::string &file_name, teca_binary_stream &stream)
+{
+    FILE *fh = fopen(file_name.c_str(), "rb");
+    if (!fh)
+    {
+        const char *estr = strerror(errno);
+        TECA_ERROR("Failed to open \"" << file_name << "\". " << estr)
+        return -1;
+    }
+
+    fseek(fh, 0, SEEK_END);
+    long n_bytes = ftell(fh);
+    fseek(fh, 0, SEEK_SET);
+
+    unsigned long header_len = strlen(file_header);
+    std::vector<char> header(header_len);
+
+    if ((n_bytes < static_cast<long>(header_len)) ||
+        (fread(header.data(), 1, header_len, fh) != header_len) ||
+        strncmp(header.data(), file_header, header_len))
+    {
+        fclose(fh);
+        TECA_ERROR("\"" << file_name << "\" is not a checkpoint")
+        return -1;
+    }
+
+    unsigned long n_data = n_bytes - header_len;
+    stream.resize(n_data);
+    if (fread(stream.get_data(), 1, n_data, fh) != n_data)
+    {
+        const char *estr = (ferror(fh) ? strerror(errno) : "");
+        fclose(fh);
+        TECA_ERROR("Failed to read \"" << file_name << "\". " << estr)
+        return -1;
+    }
+    fclose(fh);
+
+    stream.set_write_pos(n_data);
+    stream.set_read_pos(0);
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int write_file(const std::string &file_name, const teca_binary_stream &record,
+    bool append)
+{
+    // a new file is written to a temporary file and moved into place
+    // once it is on disk, the previous checkpoint is replaced only
+    // when this succeeds. a record appended to an existing file is
+    // prefixed by its length, a run killed while appending leaves an
+    // incomplete record at the end which is ignored on restore.
+    std::string tmp_name = append ? file_name : file_name + ".tmp";
+
+    int fd = append ? open(file_name.c_str(), O_WRONLY|O_APPEND) :
+        open(tmp_name.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        const char *estr = strerror(errno);
+        TECA_ERROR("Failed to open \"" << tmp_name << "\". " << estr)
+        return -1;
+    }
+
+    unsigned long record_len = record.size();
+
+    const char *bufs[3] = {file_header,
+        reinterpret_cast<const char*>(&record_len),
+        reinterpret_cast<const char*>(record.get_data())};
+
+    size_t lens[3] = {append ? 0 : strlen(file_header),
+        sizeof(record_len), record.size()};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        size_t n_wrote = 0;
+        while (n_wrote < lens[i])
+        {
+            ssize_t n = write(fd, bufs[i] + n_wrote, lens[i] - n_wrote);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                const char *estr = strerror(errno);
+                TECA_ERROR("Failed to write \"" << tmp_name << "\". " << estr)
+                close(fd);
+                if (!append)
+                    unlink(tmp_name.c_str());
+                return -1;
+            }
+            n_wrote += n;
+        }
+    }
+
+    if (fsync(fd) || close(fd) ||
+        (!append && rename(tmp_name.c_str(), file_name.c_str())))
+    {
+        const char *estr = strerror(errno);
+        TECA_ERROR("Failed to write \"" << file_name << "\". " << estr)
+        if (!append)
+            unlink(tmp_name.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// serialize the time steps and the dataset, which may be null
+void pack_record(teca_binary_stream &record,
+    const std::vector<unsigned long> &steps,
+    const const_p_teca_dataset &data)
+{
+    // the arrays make up most of the stream, size it for them up front
+    if (data)
+        record.reserve(data->get_memory_usage());
+
+    record.pack(steps);
+
+    int has_data = data ? 1 : 0;
+    record.pack(has_data);
+    if (data)
+        data->to_stream(record);
+}
+};
+
+// --------------------------------------------------------------------------
+teca_checkpoint::teca_checkpoint() : m_comm(MPI_COMM_WORLD),
+    m_interval(1), m_n_pending(0), m_written(false)
+{}
+
+// --------------------------------------------------------------------------
+void teca_checkpoint::set_communicator(MPI_Comm comm)
+{
+    m_comm = comm;
+}
+
+// --------------------------------------------------------------------------
+void teca_checkpoint::get_rank(int &rank, int &n_ranks) const
+{
+    rank = 0;
+    n_ranks = 1;
+#if defined(TECA_HAS_MPI)
+    int is_init = 0;
+    MPI_Initialized(&is_init);
+    if (is_init)
+    {
+        MPI_Comm_rank(m_comm, &rank);
+        MPI_Comm_size(m_comm, &n_ranks);
+    }
+#endif
+}
+
+// --------------------------------------------------------------------------
+void teca_checkpoint::set_file_name(const std::string &file_name)
+{
+    m_file_name = file_name;
+}
+
+// --------------------------------------------------------------------------
+void teca_checkpoint::set_interval(long n)
+{
+    m_interval = n;
+}
+
+// --------------------------------------------------------------------------
+std::string teca_checkpoint::get_file_name(int rank) const
+{
+    return m_file_name + "." + std::to_string(rank);
+}
+
+// --------------------------------------------------------------------------
+int teca_checkpoint::restore(std::vector<unsigned long> &completed)
+{
+    completed.clear();
+
+    m_n_pending = 0;
+    m_written = false;
+    m_steps.clear();
+    m_new_steps.clear();
+    m_restored_files.clear();
+    m_restored_data.clear();
+
+    if (m_file_name.empty())
+        return 0;
+
+    int rank = 0;
+    int n_ranks = 1;
+    this->get_rank(rank, n_ranks);
+
+    // locate the files written by the earlier run. these are named
+    // by the rank that wrote them, this rank reads its share.
+    std::string dir_name;
+    std::string base_name;
+    split_path(m_file_name, dir_name, base_name);
+    base_name += ".";
+
+    int ierr = 0;
+    if (DIR *dir = opendir(dir_name.c_str()))
+    {
+        size_t base_len = base_name.size();
+        while (struct dirent *ent = readdir(dir))
+        {
+            const char *name = ent->d_name;
+            if (strncmp(name, base_name.c_str(), base_len))
+                continue;
+
+            const char *suffix = name + base_len;
+            char *end = nullptr;
+            long file_rank = strtol(suffix, &end, 10);
+            if ((end == suffix) || *end || (file_rank < 0) ||
+                ((file_rank % n_ranks) != rank))
+                continue;
+
+            std::string file_name = m_file_name + "." + suffix;
+
+            teca_binary_stream stream;
+            if (read_file(file_name, stream))
+            {
+                ierr = -1;
+                continue;
+            }
+
+            // the file holds a sequence of records, each listing time
+            // steps and optionally holding a partial result
+            unsigned long pos = 0;
+            unsigned long n_bytes = stream.size();
+            while (pos < n_bytes)
+            {
+                unsigned long record_len = 0;
+                if (n_bytes - pos >= sizeof(record_len))
+                {
+                    stream.set_read_pos(pos);
+                    stream.unpack(record_len);
+                    pos += sizeof(record_len);
+                }
+
+                if ((record_len == 0) || (n_bytes - pos < record_len))
+                {
+                    TECA_WARNING("\"" << file_name << "\" ends with an "
+                        "incomplete record, it is ignored")
+                    break;
+                }
+
+                teca_binary_stream record;
+                record.resize(record_len);
+                memcpy(record.get_data(), stream.get_data() + pos, record_len);
+                record.set_write_pos(record_len);
+                record.set_read_pos(0);
+                pos += record_len;
+
+                std::vector<unsigned long> steps;
+                record.unpack(steps);
+                m_steps.insert(m_steps.end(), steps.begin(), steps.end());
+
+                int has_data = 0;
+                record.unpack(has_data);
+                if (has_data)
+                    m_restored_data.push_back(std::move(record));
+            }
+
+            m_restored_files.push_back(file_name);
+        }
+        closedir(dir);
+    }
+
+    // share the list of completed steps
+    completed = m_steps;
+#if defined(TECA_HAS_MPI)
+    if (n_ranks > 1)
+    {
+        int n_local = m_steps.size();
+        std::vector<int> counts(n_ranks);
+        MPI_Allgather(&n_local, 1, MPI_INT, counts.data(), 1, MPI_INT,
+            m_comm);
+
+        std::vector<int> displs(n_ranks, 0);
+        for (int i = 1; i < n_ranks; ++i)
+            displs[i] = displs[i-1] + counts[i-1];
+
+        completed.resize(displs[n_ranks-1] + counts[n_ranks-1]);
+
+        MPI_Allgatherv(m_steps.data(), n_local, MPI_UNSIGNED_LONG,
+            completed.data(), counts.data(), displs.data(), MPI_UNSIGNED_LONG,
+            m_comm);
+
+        MPI_Allreduce(MPI_IN_PLACE, &ierr, 1, MPI_INT, MPI_MIN, m_comm);
+    }
+#endif
+
+    std::sort(completed.begin(), completed.end());
+    completed.erase(std::unique(completed.begin(), completed.end()),
+        completed.end());
+
+    return ierr;
+}
+
+// --------------------------------------------------------------------------
+bool teca_checkpoint::complete(unsigned long step)
+{
+    m_steps.push_back(step);
+    m_new_steps.push_back(step);
+    ++m_n_pending;
+    return (m_interval > 0) && (m_n_pending >= m_interval);
+}
+
+// --------------------------------------------------------------------------
+int teca_checkpoint::save(const const_p_teca_dataset &data)
+{
+    if (m_file_name.empty())
+        return 0;
+
+    int rank = 0;
+    int n_ranks = 1;
+    this->get_rank(rank, n_ranks);
+
+    std::sort(m_steps.begin(), m_steps.end());
+    m_steps.erase(std::unique(m_steps.begin(), m_steps.end()), m_steps.end());
+
+    teca_binary_stream record;
+    pack_record(record, m_steps, data);
+
+    std::string file_name = this->get_file_name(rank);
+    if (write_file(file_name, record, false))
+        return -1;
+
+    // our file now covers the files restored from
+    size_t n_files = m_restored_files.size();
+    for (size_t i = 0; i < n_files; ++i)
+    {
+        if (m_restored_files[i] != file_name)
+            unlink(m_restored_files[i].c_str());
+    }
+    m_restored_files.clear();
+
+    m_new_steps.clear();
+    m_n_pending = 0;
+    m_written = true;
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_checkpoint::append(const const_p_teca_dataset &data)
+{
+    if (m_file_name.empty())
+        return 0;
+
+    // the file must first cover what was restored
+    if (!m_written)
+        return this->save(data);
+
+    int rank = 0;
+    int n_ranks = 1;
+    this->get_rank(rank, n_ranks);
+
+    teca_binary_stream record;
+    pack_record(record, m_new_steps, data);
+
+    if (write_file(this->get_file_name(rank), record, true))
+        return -1;
+
+    m_new_steps.clear();
+    m_n_pending = 0;
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#ifndef teca_checkpoint_h
+#define teca_checkpoint_h
+
+#include "teca_shared_object.h"
+#include "teca_dataset_fwd.h"
+#include "teca_binary_stream.h"
+#include "teca_mpi.h"
+
+#include <string>
+#include <vector>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_checkpoint)
+
+/// records the time steps a run has completed so that a restart can skip them
+/**
+Each MPI rank writes the time steps it has completed, and optionally
+a partial result, to its own file named file_name.<rank>. The file
+is written under a temporary name, flushed to disk and renamed into
+place, thus a run killed while writing leaves the previous checkpoint
+intact. Later checkpoints may instead be appended to the file, each
+adding the time steps completed since and their partial result.
+
+On restart the files written by the earlier run are read, the earlier
+run may have used a different number of ranks. File i is read by rank
+i modulo the number of ranks, and the time steps listed in all of the
+files are shared with every rank. Distinct file names must be used
+by pipelines that run concurrently on different communicators. The
+time steps and partial results a rank restores are carried into the
+checkpoints it writes, once the first of these is written the other
+files it restored from are removed. restore is collective over the
+communicator.
+*/
+class teca_checkpoint
+{
+public:
+    static p_teca_checkpoint New()
+    { return p_teca_checkpoint(new teca_checkpoint); }
+
+    ~teca_checkpoint() {}
+
+    teca_checkpoint(const teca_checkpoint &) = delete;
+    void operator=(const teca_checkpoint &) = delete;
+
+    // set the prefix of the file names. the rank is appended.
+    void set_file_name(const std::string &file_name);
+
+    const std::string &get_file_name() const
+    { return m_file_name; }
+
+    // set the communicator whose ranks write the files. the
+    // default is MPI_COMM_WORLD.
+    void set_communicator(MPI_Comm comm);
+
+    // set the number of time steps completed between checkpoints.
+    // when 0 or less a checkpoint is never due. default is 1.
+    void set_interval(long n);
+
+    // read the checkpoints of an earlier run. completed is set to
+    // the sorted list of time steps completed by all ranks. it is
+    // not an error when there are no files. this is collective.
+    int restore(std::vector<unsigned long> &completed);
+
+    // get the partial results restored by this rank, there may be
+    // several per file. the read position of each stream is at the
+    // dataset.
+    std::vector<teca_binary_stream> &get_restored_data()
+    { return m_restored_data; }
+
+    // record a completed time step. returns true when a checkpoint
+    // is due.
+    bool complete(unsigned long step);
+
+    // write this rank's checkpoint listing the time steps completed
+    // and restored, along with the partial result. data may be null.
+    int save(const const_p_teca_dataset &data);
+
+    // add the time steps completed since the last write, and the
+    // partial result of those steps, to this rank's checkpoint. the
+    // cost depends only on the new data, the partial results of a
+    // file are merged when it is restored. when nothing has been
+    // written since restore this is the same as save, in that case
+    // data must include the partial results restored.
+    int append(const const_p_teca_dataset &data);
+
+    // returns true if this rank's checkpoint has been written since
+    // restore was called
+    bool written() const
+    { return m_written; }
+
+protected:
+    teca_checkpoint();
+
+private:
+    // get the name of the file written by the given rank
+    std::string get_file_name(int rank) const;
+
+    // get this rank and the number of ranks in the communicator
+    void get_rank(int &rank, int &n_ranks) const;
+
+private:
+    std::string m_file_name;
+    MPI_Comm m_comm;
+    long m_interval;
+    long m_n_pending;
+    bool m_written;
+    std::vector<unsigned long> m_steps;
+    std::vector<unsigned long> m_new_steps;
+    std::vector<std::string> m_restored_files;
+    std::vector<teca_binary_stream> m_restored_data;
+};
+
+#endif
@@ -78,3 +78,9 @@ void teca_dataset::to_stream(std::ostream &os) const
 // --------------------------------------------------------------------------
 void teca_dataset::from_stream(std::istream &)
 {}
+
+// --------------------------------------------------------------------------
+unsigned long teca_dataset::get_memory_usage() const noexcept
+{
+    return 0;
+}
@@ -55,6 +55,12 @@ public:
     virtual void to_stream(std::ostream &) const;
     virtual void from_stream(std::istream &);
 
+    // return the number of bytes used by the dataset's arrays.
+    // this is used to account for memory held by the pipeline.
+    // datasets holding array data should override. the default
+    // returns 0.
+    virtual unsigned long get_memory_usage() const noexcept;
+
 protected:
     teca_dataset();
 
@@ -0,0 +1,363 @@
+#include "teca_config.h"
+#include "teca_dynamic_scheduler.h"
+#include "teca_common.h"
+
+#include <algorithm>
+
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#endif
+
+// the state needed for the shared counter
+class teca_dynamic_scheduler_internals
+{
+public:
+    teca_dynamic_scheduler_internals() : next_chunk(0), end_chunk(0)
+#if defined(TECA_HAS_MPI)
+        , comm(MPI_COMM_NULL), window(MPI_WIN_NULL), counter(0),
+        coordinated(0), rank(0), n_workers(0)
+#endif
+    {}
+
+    // the chunks not yet handed out, when the counter is local or
+    // held by the coordinator. the other ranks are given chunks from
+    // the front, the coordinator takes them from the back.
+    unsigned long next_chunk;
+    unsigned long end_chunk;
+
+#if defined(TECA_HAS_MPI)
+    // claim the next chunk from the coordinator
+    int request_chunk(unsigned long &chunk);
+
+    // answer the pending requests of the other ranks. when wait is
+    // set, block until every rank has been told the work is done.
+    // n_chunks is sent once the work is done
+    int serve_chunks(bool wait, unsigned long n_chunks);
+
+    // a duplicate of the caller's communicator that reports errors
+    // rather than aborting, and the window exposing the counter on
+    // rank 0
+    MPI_Comm comm;
+    MPI_Win window;
+    unsigned long counter;
+
+    // set when rank 0 hands out the chunks with point to point
+    // messages, the rank in comm, and on rank 0 the number of ranks
+    // it has yet to tell that the work is done
+    int coordinated;
+    int rank;
+    int n_workers;
+#endif
+};
+
+#if defined(TECA_HAS_MPI)
+namespace {
+// tags of the messages to and from the coordinator
+enum { chunk_request_tag = 1, chunk_reply_tag = 2 };
+}
+
+// --------------------------------------------------------------------------
+int teca_dynamic_scheduler_internals::request_chunk(unsigned long &chunk)
+{
+    if (MPI_Send(nullptr, 0, MPI_BYTE, 0, chunk_request_tag, this->comm) ||
+        MPI_Recv(&chunk, 1, MPI_UNSIGNED_LONG, 0, chunk_reply_tag,
+            this->comm, MPI_STATUS_IGNORE))
+    {
+        TECA_ERROR("failed to request a chunk from the coordinator")
+        return -1;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_dynamic_scheduler_internals::serve_chunks(bool wait,
+    unsigned long n_chunks)
+{
+    while (this->n_workers)
+    {
+        if (!wait)
+        {
+            int pending = 0;
+            if (MPI_Iprobe(MPI_ANY_SOURCE, chunk_request_tag, this->comm,
+                &pending, MPI_STATUS_IGNORE))
+            {
+                TECA_ERROR("failed to check for requests for a chunk")
+                return -1;
+            }
+
+            if (!pending)
+                return 0;
+        }
+
+        MPI_Status stat;
+        if (MPI_Recv(nullptr, 0, MPI_BYTE, MPI_ANY_SOURCE,
+            chunk_request_tag, this->comm, &stat))
+        {
+            TECA_ERROR("failed to receive a request for a chunk")
+            return -1;
+        }
+
+        // once the work is exhausted every request is answered with
+        // the number of chunks, and the rank stops asking
+        unsigned long chunk = n_chunks;
+        if (this->next_chunk < this->end_chunk)
+            chunk = this->next_chunk++;
+        else
+            --this->n_workers;
+
+        if (MPI_Send(&chunk, 1, MPI_UNSIGNED_LONG, stat.MPI_SOURCE,
+            chunk_reply_tag, this->comm))
+        {
+            TECA_ERROR("failed to send a chunk")
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+// --------------------------------------------------------------------------
+teca_dynamic_scheduler::teca_dynamic_scheduler()
+    : internals(new teca_dynamic_scheduler_internals)
+{}
+
+// --------------------------------------------------------------------------
+teca_dynamic_scheduler::~teca_dynamic_scheduler()
+{
+#if defined(TECA_HAS_MPI)
+    // freeing the window is collective, if it is still in use here
+    // some rank did not finish its work.
+    if (this->internals->window != MPI_WIN_NULL)
+        TECA_WARNING("the shared counter was not released")
+#endif
+    delete this->internals;
+}
+
+// --------------------------------------------------------------------------
+int teca_dynamic_scheduler::initialize(MPI_Comm comm, unsigned long n_indices,
+    unsigned long min_chunk_size, unsigned long chunk_factor)
+{
+    if (this->finalize())
+        return -1;
+
+    int rank = 0;
+    int n_ranks = 1;
+#if defined(TECA_HAS_MPI)
+    int is_init = 0;
+    MPI_Initialized(&is_init);
+    if (is_init)
+    {
+        MPI_Comm_size(comm, &n_ranks);
+        MPI_Comm_rank(comm, &rank);
+    }
+#endif
+
+    // compute the guided schedule. every rank arrives at the same
+    // chunks, thus only the index of the next chunk is shared.
+    m_chunks.clear();
+    m_offsets.clear();
+
+    min_chunk_size = std::max(1ul, min_chunk_size);
+    unsigned long div = std::max(1ul, chunk_factor)*n_ranks;
+
+    unsigned long remaining = n_indices;
+    while (remaining)
+    {
+        unsigned long n = std::min(remaining,
+            std::max(min_chunk_size, (remaining + div - 1)/div));
+
+        m_offsets.push_back(n_indices - remaining);
+        m_chunks.push_back(n);
+        remaining -= n;
+    }
+
+    this->internals->next_chunk = 0;
+    this->internals->end_chunk = m_chunks.size();
+
+#if defined(TECA_HAS_MPI)
+    if (is_init && (n_ranks > 1))
+    {
+        // errors are returned on a duplicate of the communicator so
+        // that a failure to create the window can be detected
+        MPI_Comm_dup(comm, &this->internals->comm);
+        MPI_Comm_set_errhandler(this->internals->comm, MPI_ERRORS_RETURN);
+
+        // Open MPI before version 5 names the shared memory backing a
+        // window after the context id of its communicator. context ids
+        // are only unique within a group, thus windows created at the
+        // same time on disjoint groups sharing a node, for instance the
+        // halves of a split MPI_COMM_WORLD, use the same memory and the
+        // run crashes. rank 0 hands out the chunks instead.
+#if defined(OMPI_MAJOR_VERSION) && (OMPI_MAJOR_VERSION < 5)
+        int congruent = MPI_IDENT;
+        MPI_Comm_compare(comm, MPI_COMM_WORLD, &congruent);
+        if ((congruent != MPI_IDENT) && (congruent != MPI_CONGRUENT))
+        {
+            if (rank == 0)
+            {
+                TECA_WARNING("one-sided communication on communicators "
+                    "other than MPI_COMM_WORLD is not safe with this version "
+                    "of Open MPI, chunks are handed out by rank 0")
+            }
+
+            this->internals->coordinated = 1;
+            this->internals->rank = rank;
+            this->internals->n_workers = rank ? 0 : n_ranks - 1;
+
+            return 0;
+        }
+#endif
+
+        // the counter lives on rank 0, other ranks expose nothing
+        MPI_Aint win_size = rank ? 0 : sizeof(unsigned long);
+
+        int win_ok = MPI_Win_create(&this->internals->counter, win_size,
+            sizeof(unsigned long), MPI_INFO_NULL, this->internals->comm,
+            &this->internals->window) == MPI_SUCCESS;
+
+        if (win_ok)
+            MPI_Win_set_errhandler(this->internals->window, MPI_ERRORS_RETURN);
+        else
+            this->internals->window = MPI_WIN_NULL;
+
+        // the failure need not be reported on every rank
+        int all_ok = 0;
+        MPI_Allreduce(&win_ok, &all_ok, 1, MPI_INT, MPI_MIN,
+            this->internals->comm);
+
+        // some MPI installs can not create windows, for instance when
+        // no one-sided component supports the network. rank 0 hands
+        // out the chunks instead.
+        if (!all_ok)
+        {
+            if (rank == 0)
+            {
+                TECA_WARNING("failed to create the shared counter, chunks "
+                    "are handed out by rank 0")
+            }
+
+            if (win_ok)
+                MPI_Win_free(&this->internals->window);
+
+            this->internals->window = MPI_WIN_NULL;
+            this->internals->coordinated = 1;
+            this->internals->rank = rank;
+            this->internals->n_workers = rank ? 0 : n_ranks - 1;
+
+            return 0;
+        }
+
+        if (rank == 0)
+        {
+            MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, this->internals->window);
+            this->internals->counter = 0;
+            MPI_Win_unlock(0, this->internals->window);
+        }
+
+        // the counter must be initialized before it is used
+        MPI_Barrier(this->internals->comm);
+    }
+#else
+    (void)comm;
+    (void)rank;
+#endif
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_dynamic_scheduler::get_next_chunk(unsigned long &first,
+    unsigned long &n)
+{
+    unsigned long chunk = 0;
+    unsigned long n_chunks = m_chunks.size();
+
+#if defined(TECA_HAS_MPI)
+    if (this->internals->window != MPI_WIN_NULL)
+    {
+        // claim a chunk by atomically incrementing the counter
+        unsigned long one = 1;
+        MPI_Win window = this->internals->window;
+        if (MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window) ||
+            MPI_Fetch_and_op(&one, &chunk, MPI_UNSIGNED_LONG, 0, 0,
+                MPI_SUM, window) || MPI_Win_unlock(0, window))
+        {
+            TECA_ERROR("failed to update the shared counter")
+            return -1;
+        }
+    }
+    else if (this->internals->coordinated && this->internals->rank)
+    {
+        // ask the coordinator
+        if (this->internals->request_chunk(chunk))
+            return -1;
+    }
+    else if (this->internals->coordinated)
+    {
+        // the coordinator answers the other ranks before claiming a
+        // chunk for itself. it takes the chunks from the back, these
+        // are the smallest, so that it answers often.
+        if (this->internals->serve_chunks(false, n_chunks))
+            return -1;
+
+        chunk = this->internals->next_chunk < this->internals->end_chunk ?
+            --this->internals->end_chunk : n_chunks;
+    }
+    else
+#endif
+    {
+        chunk = this->internals->next_chunk < this->internals->end_chunk ?
+            this->internals->next_chunk++ : n_chunks;
+    }
+
+    if (chunk >= n_chunks)
+    {
+        // all work has been handed out. the coordinator waits until
+        // the other ranks know. further calls are answered locally.
+        first = 0;
+        n = 0;
+
+#if defined(TECA_HAS_MPI)
+        if (this->internals->coordinated &&
+            this->internals->serve_chunks(true, n_chunks))
+            return -1;
+#endif
+        this->internals->next_chunk = n_chunks;
+        this->internals->end_chunk = n_chunks;
+
+        if (this->finalize())
+            return -1;
+
+        return 1;
+    }
+
+    first = m_offsets[chunk];
+    n = m_chunks[chunk];
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_dynamic_scheduler::finalize()
+{
+#if defined(TECA_HAS_MPI)
+    if (this->internals->window != MPI_WIN_NULL)
+    {
+        if (MPI_Win_free(&this->internals->window))
+        {
+            TECA_ERROR("failed to release the shared counter")
+            return -1;
+        }
+        this->internals->window = MPI_WIN_NULL;
+        this->internals->counter = 0;
+    }
+
+    if (this->internals->comm != MPI_COMM_NULL)
+        MPI_Comm_free(&this->internals->comm);
+
+    this->internals->coordinated = 0;
+    this->internals->rank = 0;
+    this->internals->n_workers = 0;
+#endif
+    return 0;
+}
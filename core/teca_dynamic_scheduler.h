@@ -0,0 +1,83 @@
+#ifndef teca_dynamic_scheduler_h
+#define teca_dynamic_scheduler_h
+
+#include "teca_shared_object.h"
+#include "teca_mpi.h"
+
+#include <vector>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_dynamic_scheduler)
+
+class teca_dynamic_scheduler_internals;
+
+/// hands out a range of indices in chunks on demand across MPI ranks
+/**
+Chunk sizes follow a guided schedule, each chunk is a fraction of
+the indices remaining when it is handed out, such that early chunks
+are large to keep the overhead low and later chunks are small to
+balance the load at the end of the run. Ranks that process their
+chunks faster claim more of them.
+
+Chunks are claimed by incrementing a counter that lives on rank 0
+with MPI one-sided atomics, no rank has to act as a coordinator.
+Every rank computes the same schedule, thus the counter holds the
+index of the next chunk. When MPI is not in use chunks are handed
+out from a local counter. When the MPI install can not create the
+window holding the counter, or with Open MPI before version 5 on
+communicators other than MPI_COMM_WORLD, where windows on disjoint
+groups may share memory, rank 0 instead holds the counter and
+answers requests for chunks sent to it. It does so each time it
+claims a chunk for itself, and takes its own chunks from the end of
+the schedule where they are smallest, so that it answers often.
+
+initialize is collective. Once all chunks have been handed out the
+counter is released, which is also collective, so every rank must
+call get_next_chunk until it reports that no work remains.
+*/
+class teca_dynamic_scheduler
+{
+public:
+    static p_teca_dynamic_scheduler New()
+    { return p_teca_dynamic_scheduler(new teca_dynamic_scheduler); }
+
+    ~teca_dynamic_scheduler();
+
+    teca_dynamic_scheduler(const teca_dynamic_scheduler &) = delete;
+    void operator=(const teca_dynamic_scheduler &) = delete;
+
+    // compute the schedule for n_indices indices and set up the
+    // counter shared by the ranks of comm. chunks are no smaller than
+    // min_chunk_size. each chunk is the number of indices remaining
+    // divided by chunk_factor times the number of ranks. this is
+    // collective over comm.
+    int initialize(MPI_Comm comm, unsigned long n_indices,
+        unsigned long min_chunk_size = 1, unsigned long chunk_factor = 2);
+
+    // claim the next chunk of indices. returns 0 and sets first and
+    // n when a chunk was claimed. returns 1 when there is no more
+    // work, and a negative value if an error occurred. the call that
+    // finds the work exhausted releases the shared counter, which is
+    // collective over comm. thus every rank must keep calling until
+    // 1 is returned, and may block in that call until the others do.
+    // when rank 0 holds the counter the other ranks may wait in this
+    // call until rank 0 calls it.
+    int get_next_chunk(unsigned long &first, unsigned long &n);
+
+    // get the number of chunks in the schedule
+    unsigned long get_number_of_chunks() const
+    { return m_chunks.size(); }
+
+protected:
+    teca_dynamic_scheduler();
+
+private:
+    // release the shared counter, this is collective.
+    int finalize();
+
+private:
+    std::vector<unsigned long> m_chunks;
+    std::vector<unsigned long> m_offsets;
+    teca_dynamic_scheduler_internals *internals;
+};
+
+#endif
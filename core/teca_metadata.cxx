@@ -1,29 +1,139 @@
 #include <teca_metadata.h>
 #include <utility>
 #include <ostream>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+#include <mutex>
 
 using std::string;
-using std::map;
 using std::pair;
 using std::vector;
 using std::ostream;
 using std::endl;
 
+namespace {
+
+// the number of properties that may be inserted into a copy
+// before its storage is reallocated. requests are made by copying
+// a base request and inserting a few keys.
+constexpr size_t copy_spare_props = 4;
+
 // --------------------------------------------------------------------------
-teca_metadata::teca_metadata() noexcept
+// get the interned copy of the name. the copy lives as long as the
+// process does. each thread keeps the names it has looked up, so
+// that the lock is only taken the first time a thread sees a name.
+const std::string *intern(const std::string &name)
+{
+    thread_local std::unordered_map<std::string, const std::string*> cache;
+
+    auto it = cache.find(name);
+    if (it != cache.end())
+        return it->second;
+
+    // never destroyed, objects may be destroyed during static destruction
+    static std::mutex *mutex = new std::mutex;
+    static std::unordered_set<std::string> *names =
+        new std::unordered_set<std::string>;
+
+    const std::string *interned = nullptr;
+    {
+    std::lock_guard<std::mutex> lock(*mutex);
+    interned = &*names->insert(name).first;
+    }
+
+    cache.emplace(name, interned);
+    return interned;
+}
+
+// 64 bit FNV-1a over n bytes, continuing from h
+unsigned long long hash_bytes(const void *data, size_t n,
+    unsigned long long h = 14695981039346656037ull)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// the splitmix64 finalizer. spreads the bits of the per property
+// hashes before they are summed.
+unsigned long long mix(unsigned long long h)
+{
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
+// hash the type and the values held in the array
+unsigned long long hash_array(const teca_variant_array *a)
+{
+    if (!a)
+        return 0;
+
+    unsigned int type_code = a->type_code();
+    unsigned long n = a->size();
+
+    unsigned long long h = hash_bytes(&type_code, sizeof(type_code));
+    h = hash_bytes(&n, sizeof(n), h);
+
+    TEMPLATE_DISPATCH_CASE(const teca_variant_array_impl, std::string, a,
+        const TT *va = static_cast<const TT*>(a);
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            const std::string &str = va->get(i);
+            size_t len = str.size();
+            h = hash_bytes(&len, sizeof(len), h);
+            h = hash_bytes(str.data(), len, h);
+        }
+        )
+    else TEMPLATE_DISPATCH_CASE(const teca_variant_array_impl, teca_metadata, a,
+        const TT *va = static_cast<const TT*>(a);
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            unsigned long long elem = va->get(i).get_digest();
+            h = hash_bytes(&elem, sizeof(elem), h);
+        }
+        )
+    else TEMPLATE_DISPATCH_CASE(const teca_variant_array_impl,
+        p_teca_variant_array, a,
+        const TT *va = static_cast<const TT*>(a);
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            unsigned long long elem = hash_array(va->get(i).get());
+            h = hash_bytes(&elem, sizeof(elem), h);
+        }
+        )
+    else TEMPLATE_DISPATCH(const teca_variant_array_impl, a,
+        const TT *va = static_cast<const TT*>(a);
+        if (n)
+            h = hash_bytes(va->get(), n*sizeof(NT), h);
+        )
+
+    return h;
+}
+};
+
+// --------------------------------------------------------------------------
+teca_metadata::teca_metadata() noexcept : digest(0), digest_valid(true)
 {
     this->id = this->get_next_id();
 }
 
 // --------------------------------------------------------------------------
 teca_metadata::teca_metadata(const teca_metadata &other)
+    : digest(0), digest_valid(true)
 {
     *this = other;
 }
 
 // --------------------------------------------------------------------------
 teca_metadata::teca_metadata(teca_metadata &&other) noexcept
-    : id(other.id), props(std::move(other.props))
+    : id(other.id), props(std::move(other.props)),
+    digest(other.digest.load()), digest_valid(other.digest_valid.load())
 {}
 
 // --------------------------------------------------------------------------
@@ -39,16 +149,33 @@ teca_metadata &teca_metadata::operator=(const teca_metadata &other)
         return *this;
 
     this->id = other.id;
-    this->clear();
 
-    prop_map_t::const_iterator it = other.props.begin();
-    prop_map_t::const_iterator end = other.props.end();
-    for ( ; it != end; ++it)
+    // the values are shared, and copied when either object
+    // modifies them. values that may be held elsewhere could
+    // be modified without the objects knowing, they are copied
+    this->props.clear();
+    this->props.reserve(other.props.size() + copy_spare_props);
+
+    bool escaped = false;
+    prop_vector_t::const_iterator it = other.props.begin();
+    prop_vector_t::const_iterator end = other.props.end();
+    for (; it != end; ++it)
     {
-        this->props[it->first]
-             = it->second ? it->second->new_copy() : it->second;
+        prop_t prop = {it->name, it->value, false};
+        if (it->escaped && it->value)
+        {
+            prop.value = it->value->new_copy();
+            escaped = true;
+        }
+        this->props.push_back(std::move(prop));
     }
 
+    // the cached digest does not include values that may be held
+    // elsewhere, those held by this object now are
+    bool valid = !escaped && other.digest_valid.load(std::memory_order_acquire);
+    this->digest = valid ? other.digest.load(std::memory_order_relaxed) : 0;
+    this->digest_valid = valid;
+
     return *this;
 }
 
@@ -60,6 +187,8 @@ teca_metadata &teca_metadata::operator=(teca_metadata &&other) noexcept
 
     this->id = other.id;
     this->props = std::move(other.props);
+    this->digest = other.digest.load();
+    this->digest_valid = other.digest_valid.load();
     return *this;
 }
 
@@ -67,6 +196,63 @@ teca_metadata &teca_metadata::operator=(teca_metadata &&other) noexcept
 void teca_metadata::clear()
 {
     this->props.clear();
+    this->digest = 0;
+    this->digest_valid = true;
+}
+
+// --------------------------------------------------------------------------
+teca_metadata::prop_vector_t::iterator
+teca_metadata::lower_bound(const std::string &name) noexcept
+{
+    return std::lower_bound(this->props.begin(), this->props.end(), name,
+        [](const prop_t &prop, const std::string &n) { return *prop.name < n; });
+}
+
+// --------------------------------------------------------------------------
+teca_metadata::prop_vector_t::const_iterator
+teca_metadata::lower_bound(const std::string &name) const noexcept
+{
+    return std::lower_bound(this->props.begin(), this->props.end(), name,
+        [](const prop_t &prop, const std::string &n) { return *prop.name < n; });
+}
+
+// --------------------------------------------------------------------------
+teca_metadata::prop_vector_t::iterator
+teca_metadata::find(const std::string &name) noexcept
+{
+    prop_vector_t::iterator it = this->lower_bound(name);
+    if ((it != this->props.end()) && (*it->name == name))
+        return it;
+    return this->props.end();
+}
+
+// --------------------------------------------------------------------------
+teca_metadata::prop_vector_t::const_iterator
+teca_metadata::find(const std::string &name) const noexcept
+{
+    prop_vector_t::const_iterator it = this->lower_bound(name);
+    if ((it != this->props.end()) && (*it->name == name))
+        return it;
+    return this->props.end();
+}
+
+// --------------------------------------------------------------------------
+teca_metadata::prop_vector_t::iterator
+teca_metadata::find_for_write(const std::string &name)
+{
+    prop_vector_t::iterator it = this->find(name);
+    if (it == this->props.end())
+        return it;
+
+    // the value is shared with a copy of this object or held by
+    // the caller of get. once copied it is held only here
+    if (it->value && (it->value.use_count() > 1))
+        it->value = it->value->new_copy();
+
+    it->escaped = false;
+    this->digest_valid = false;
+
+    return it;
 }
 
 // --------------------------------------------------------------------------
@@ -74,7 +260,33 @@ void teca_metadata::insert(
     const std::string &name,
     p_teca_variant_array prop_val)
 {
-    this->props[name] = prop_val;
+    // the caller may keep and modify the array
+    this->insert_value(name, prop_val, true);
+}
+
+// --------------------------------------------------------------------------
+void teca_metadata::insert_value(const std::string &name,
+    p_teca_variant_array prop_val, bool escaped)
+{
+    prop_vector_t::iterator it = this->lower_bound(name);
+    if ((it == this->props.end()) || (*it->name != name))
+    {
+        prop_t prop = {intern(name), nullptr, false};
+        it = this->props.insert(it, std::move(prop));
+    }
+
+    // update the digest, replacing the old value's contribution
+    if (this->digest_valid)
+    {
+        if (it->value && !it->escaped)
+            this->digest -= teca_metadata::get_digest(name, it->value);
+
+        if (!escaped)
+            this->digest += teca_metadata::get_digest(name, prop_val);
+    }
+
+    it->value = prop_val;
+    it->escaped = escaped;
 }
 
 // --------------------------------------------------------------------------
@@ -82,10 +294,16 @@ int teca_metadata::set(
     const std::string &name,
     p_teca_variant_array prop_val)
 {
-    pair<prop_map_t::iterator, bool> ret
-        = this->props.insert(make_pair(name, prop_val));
+    // the caller may keep and modify the array
+    return this->set_value(name, prop_val, true);
+}
 
-    if (!ret.second)
+// --------------------------------------------------------------------------
+int teca_metadata::set_value(const std::string &name,
+    p_teca_variant_array prop_val, bool escaped)
+{
+    prop_vector_t::iterator it = this->lower_bound(name);
+    if ((it != this->props.end()) && (*it->name == name))
     {
         TECA_ERROR(
             << "attempt to access non-existant property \""
@@ -93,41 +311,50 @@ int teca_metadata::set(
         return -1;
     }
 
+    prop_t prop = {intern(name), prop_val, escaped};
+    this->props.insert(it, std::move(prop));
+
+    if (this->digest_valid && !escaped)
+        this->digest += teca_metadata::get_digest(name, prop_val);
+
     return 0;
 }
 
 // --------------------------------------------------------------------------
 p_teca_variant_array teca_metadata::get(const std::string &name)
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    // the caller may keep and modify the array
+    prop_vector_t::iterator it = this->find_for_write(name);
 
     if (it == this->props.end())
         return nullptr;
 
-    return it->second;
+    it->escaped = true;
+
+    return it->value;
 }
 
 // --------------------------------------------------------------------------
 const_p_teca_variant_array teca_metadata::get(const std::string &name) const
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return nullptr;
 
-    return it->second;
+    return it->value;
 }
 
 // --------------------------------------------------------------------------
 int teca_metadata::get(
     const std::string &name, p_teca_variant_array vals) const
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
-    vals->copy(it->second);
+    vals->copy(it->value);
 
     return 0;
 }
@@ -137,12 +364,12 @@ int teca_metadata::size(
     const std::string &name,
     unsigned int &n) const noexcept
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
-    n = it->second->size();
+    n = it->value->size();
 
     return 0;
 }
@@ -150,23 +377,26 @@ int teca_metadata::size(
 // --------------------------------------------------------------------------
 void teca_metadata::resize(const std::string &name, unsigned int n)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         TECA_ERROR("attempt to access a non-existant property ignored!")
         return;
     }
-    it->second->resize(n);
+    it->value->resize(n);
 }
 
 // --------------------------------------------------------------------------
 int teca_metadata::remove(const std::string &name) noexcept
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
+    if (this->digest_valid && !it->escaped)
+        this->digest -= teca_metadata::get_digest(name, it->value);
+
     this->props.erase(it);
 
     return 0;
@@ -175,7 +405,7 @@ int teca_metadata::remove(const std::string &name) noexcept
 // --------------------------------------------------------------------------
 int teca_metadata::has(const std::string &name) const noexcept
 {
-    return this->props.count(name);
+    return this->find(name) != this->props.end();
 }
 
 // --------------------------------------------------------------------------
@@ -184,6 +414,55 @@ int teca_metadata::empty() const noexcept
     return this->props.empty();
 }
 
+// --------------------------------------------------------------------------
+unsigned long long teca_metadata::get_digest(const std::string &name,
+    const const_p_teca_variant_array &val)
+{
+    // the name and value are hashed together, the digests of
+    // the properties are summed so that insertion order does
+    // not matter and properties can be added and removed
+    // independently
+    unsigned long long h = hash_bytes(name.data(), name.size());
+    h = hash_bytes(&h, sizeof(h), hash_array(val.get()));
+    return mix(h);
+}
+
+// --------------------------------------------------------------------------
+unsigned long long teca_metadata::get_digest() const
+{
+    // the digest of the values held only here is cached. threads
+    // that find it invalid compute and store the same value
+    unsigned long long d = 0;
+    if (this->digest_valid.load(std::memory_order_acquire))
+    {
+        d = this->digest.load(std::memory_order_relaxed);
+    }
+    else
+    {
+        prop_vector_t::const_iterator it = this->props.begin();
+        prop_vector_t::const_iterator end = this->props.end();
+        for (; it != end; ++it)
+        {
+            if (!it->escaped)
+                d += teca_metadata::get_digest(*it->name, it->value);
+        }
+
+        this->digest.store(d, std::memory_order_relaxed);
+        this->digest_valid.store(true, std::memory_order_release);
+    }
+
+    // values that may be held elsewhere could have been modified
+    prop_vector_t::const_iterator it = this->props.begin();
+    prop_vector_t::const_iterator end = this->props.end();
+    for (; it != end; ++it)
+    {
+        if (it->escaped)
+            d += teca_metadata::get_digest(*it->name, it->value);
+    }
+
+    return d;
+}
+
 // --------------------------------------------------------------------------
 unsigned long long teca_metadata::get_next_id() const noexcept
 {
@@ -197,13 +476,13 @@ void teca_metadata::to_stream(teca_binary_stream &s) const
     unsigned int n_props = this->props.size();
     s.pack(n_props);
 
-    teca_metadata::prop_map_t::const_iterator it = this->props.cbegin();
-    teca_metadata::prop_map_t::const_iterator end = this->props.cend();
+    teca_metadata::prop_vector_t::const_iterator it = this->props.cbegin();
+    teca_metadata::prop_vector_t::const_iterator end = this->props.cend();
     for (; it != end; ++it)
     {
-        s.pack(it->first);
-        s.pack(it->second->type_code());
-        it->second->to_stream(s);
+        s.pack(*it->name);
+        s.pack(it->value->type_code());
+        it->value->to_stream(s);
     }
 }
 
@@ -215,6 +494,8 @@ void teca_metadata::from_stream(teca_binary_stream &s)
     unsigned int n_props;
     s.unpack(n_props);
 
+    this->props.reserve(n_props);
+
     for (unsigned int i = 0; i < n_props; ++i)
     {
         string key;
@@ -228,35 +509,35 @@ void teca_metadata::from_stream(teca_binary_stream &s)
 
         val->from_stream(s);
 
-        this->set(key, val);
+        this->set_value(key, val, false);
     }
 }
 
 // --------------------------------------------------------------------------
 void teca_metadata::to_stream(ostream &os) const
 {
-    prop_map_t::const_iterator it = this->props.cbegin();
-    prop_map_t::const_iterator end = this->props.cend();
+    prop_vector_t::const_iterator it = this->props.cbegin();
+    prop_vector_t::const_iterator end = this->props.cend();
     for (; it != end; ++it)
     {
-        os << it->first << " = " << "{";
+        os << *it->name << " = " << "{";
         TEMPLATE_DISPATCH_CASE(
-            teca_variant_array_impl, std::string, it->second.get(),
-            const TT *val = static_cast<const TT*>(it->second.get());
+            teca_variant_array_impl, std::string, it->value.get(),
+            const TT *val = static_cast<const TT*>(it->value.get());
             val->to_stream(os);
             )
         TEMPLATE_DISPATCH_CASE(
-            teca_variant_array_impl, teca_metadata, it->second.get(),
-            const TT *val = static_cast<const TT*>(it->second.get());
+            teca_variant_array_impl, teca_metadata, it->value.get(),
+            const TT *val = static_cast<const TT*>(it->value.get());
             val->to_stream(os);
             )
         TEMPLATE_DISPATCH_CASE(
-            teca_variant_array_impl, p_teca_variant_array, it->second.get(),
-            const TT *val = static_cast<const TT*>(it->second.get());
+            teca_variant_array_impl, p_teca_variant_array, it->value.get(),
+            const TT *val = static_cast<const TT*>(it->value.get());
             val->to_stream(os);
             )
-        TEMPLATE_DISPATCH(teca_variant_array_impl, it->second.get(),
-            const TT *val = static_cast<const TT*>(it->second.get());
+        TEMPLATE_DISPATCH(teca_variant_array_impl, it->value.get(),
+            const TT *val = static_cast<const TT*>(it->value.get());
             val->to_stream(os);
             )
         os << "}" << endl;
@@ -272,13 +553,18 @@ bool operator<(const teca_metadata &lhs, const teca_metadata &rhs) noexcept
 // --------------------------------------------------------------------------
 bool operator==(const teca_metadata &lhs, const teca_metadata &rhs) noexcept
 {
-    teca_metadata::prop_map_t::const_iterator rit = rhs.props.begin();
-    teca_metadata::prop_map_t::const_iterator rend = rhs.props.end();
-    teca_metadata::prop_map_t::const_iterator lend = lhs.props.end();
-    for (; rit != rend; ++rit)
+    if (lhs.props.size() != rhs.props.size())
+        return false;
+
+    // both are sorted by name, and interned names are compared by
+    // address
+    teca_metadata::prop_vector_t::const_iterator lit = lhs.props.begin();
+    teca_metadata::prop_vector_t::const_iterator rit = rhs.props.begin();
+    teca_metadata::prop_vector_t::const_iterator rend = rhs.props.end();
+    for (; rit != rend; ++rit, ++lit)
     {
-        teca_metadata::prop_map_t::const_iterator lit = lhs.props.find(rit->first);
-        if ((lit == lend) || !(*lit->second == *rit->second))
+        if ((lit->name != rit->name) || ((lit->value != rit->value) &&
+            !(*lit->value == *rit->value)))
             return false;
     }
     return true;
@@ -288,15 +574,29 @@ bool operator==(const teca_metadata &lhs, const teca_metadata &rhs) noexcept
 teca_metadata operator&(const teca_metadata &lhs, const teca_metadata &rhs)
 {
     teca_metadata isect;
-    teca_metadata::prop_map_t::const_iterator rit = rhs.props.begin();
-    teca_metadata::prop_map_t::const_iterator rend = rhs.props.end();
-    teca_metadata::prop_map_t::const_iterator lend = lhs.props.end();
-    for (; rit != rend; ++rit)
+    teca_metadata::prop_vector_t::const_iterator lit = lhs.props.begin();
+    teca_metadata::prop_vector_t::const_iterator lend = lhs.props.end();
+    teca_metadata::prop_vector_t::const_iterator rit = rhs.props.begin();
+    teca_metadata::prop_vector_t::const_iterator rend = rhs.props.end();
+    while ((lit != lend) && (rit != rend))
     {
-        teca_metadata::prop_map_t::const_iterator lit = lhs.props.find(rit->first);
-        if ((lit != lend) && (*lit->second == *rit->second))
+        if (lit->name == rit->name)
+        {
+            // the result shares the value, unless it may be held
+            // elsewhere
+            if ((lit->value == rit->value) || (*lit->value == *rit->value))
+                isect.set_value(*rit->name, rit->escaped ?
+                    rit->value->new_copy() : rit->value, false);
+            ++lit;
+            ++rit;
+        }
+        else if (*lit->name < *rit->name)
+        {
+            ++lit;
+        }
+        else
         {
-            isect.set(rit->first, rit->second->new_copy());
+            ++rit;
         }
     }
     return isect;
@@ -2,17 +2,26 @@
 #define teca_metadata_h
 
 #include <iosfwd>
-#include <map>
 #include <string>
 #include <initializer_list>
 #include <vector>
 #include <set>
+#include <atomic>
 #include "teca_variant_array.h"
 
 // a generic container for meta data in the form
 // of name=value pairs. value arrays are supported.
 // see meta data producer-consumer documentation for
 // information about what names are valid.
+//
+// the properties are kept in a vector sorted by name. names
+// are interned, each distinct name is stored once and shared
+// by all objects. values are shared between copies, and a
+// value shared is copied before it is modified in place. values
+// that may be held elsewhere, arrays passed to insert and set
+// and those returned by the non-const get, are copied when the
+// object is copied, so that changes made through them don't
+// show up in the copy.
 class teca_metadata
 {
 public:
@@ -171,6 +180,15 @@ public:
     explicit operator bool() const noexcept
     { return !empty(); }
 
+    // get a digest of the contents. objects with the same
+    // keys and values have the same digest, regardless of the
+    // order in which the keys were inserted. the digest of the
+    // values held only by this object is kept up to date as
+    // properties are inserted, removed, and modified. values
+    // that may be held elsewhere are hashed each time. it is
+    // safe to call from multiple threads.
+    unsigned long long get_digest() const;
+
     // serialize to/from binary
     void to_stream(teca_binary_stream &s) const;
     void from_stream(teca_binary_stream &s);
@@ -182,10 +200,50 @@ public:
 private:
     unsigned long long get_next_id() const noexcept;
 
+    // get the digest of a single property
+    static unsigned long long get_digest(const std::string &name,
+        const const_p_teca_variant_array &val);
+
+    // insert or replace, and add, the named property. escaped is
+    // set when the value may be held elsewhere
+    void insert_value(const std::string &name,
+        p_teca_variant_array prop_val, bool escaped);
+
+    int set_value(const std::string &name,
+        p_teca_variant_array prop_val, bool escaped);
+
+    // a property. the name points to the interned copy. escaped
+    // is set when the value may be held elsewhere, then it is
+    // copied when the object is copied and is not included in
+    // the cached digest.
+    struct prop_t
+    {
+        const std::string *name;
+        p_teca_variant_array value;
+        bool escaped;
+    };
+
+    using prop_vector_t = std::vector<prop_t>;
+
+    // get the first property whose name is not less than the
+    // given name
+    prop_vector_t::iterator lower_bound(const std::string &name) noexcept;
+    prop_vector_t::const_iterator lower_bound(const std::string &name) const noexcept;
+
+    // get the named property or end
+    prop_vector_t::iterator find(const std::string &name) noexcept;
+    prop_vector_t::const_iterator find(const std::string &name) const noexcept;
+
+    // get the named property or end, such that its value may be
+    // modified in place. a value that is shared or held elsewhere
+    // is copied first. the digest is invalidated.
+    prop_vector_t::iterator find_for_write(const std::string &name);
+
 private:
     unsigned long long id;
-    using prop_map_t = std::map<std::string, p_teca_variant_array>;
-    prop_map_t props;
+    prop_vector_t props;
+    mutable std::atomic<unsigned long long> digest;
+    mutable std::atomic<bool> digest_valid;
 
     friend bool operator<(const teca_metadata &, const teca_metadata &) noexcept;
     friend bool operator==(const teca_metadata &, const teca_metadata &) noexcept;
@@ -198,7 +256,7 @@ bool operator<(const teca_metadata &lhs, const teca_metadata &rhs) noexcept;
 
 // compare meta data objects. two objects are considered
 // equal if both have the same set of keys and all of the values
-// are equal
+// are equal.
 bool operator==(const teca_metadata &lhs, const teca_metadata &rhs) noexcept;
 
 inline
@@ -216,7 +274,7 @@ void teca_metadata::declare(const std::string &name)
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New();
 
-    this->set(name, prop_val);
+    this->set_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
@@ -226,20 +284,20 @@ void teca_metadata::declare(const std::string &name, unsigned int n)
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New(n);
 
-    this->set(name, prop_val);
+    this->set_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
 template<typename T>
 int teca_metadata::append(const std::string &name, const T &val)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         return -1;
     }
 
-    it->second->append(val);
+    it->value->append(val);
 
     return 0;
 }
@@ -251,7 +309,7 @@ void teca_metadata::insert(const std::string &name, const T &val)
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New(&val, 1);
 
-    this->props[name] = prop_val;
+    this->insert_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
@@ -264,7 +322,7 @@ void teca_metadata::insert(
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New(vals, n_vals);
 
-    this->props[name] = prop_val;
+    this->insert_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
@@ -279,7 +337,7 @@ void teca_metadata::insert(
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New(tmp.data(), n);
 
-    this->props[name] = prop_val;
+    this->insert_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
@@ -302,7 +360,7 @@ void teca_metadata::insert(
     p_teca_variant_array prop_val
         = teca_variant_array_impl<T>::New(vals.data(), n);
 
-    this->props[name] = prop_val;
+    this->insert_value(name, prop_val, false);
 }
 
 // --------------------------------------------------------------------------
@@ -323,7 +381,7 @@ void teca_metadata::insert(
         prop_vals->append(prop_val);
     }
 
-    this->props[name] = prop_vals;
+    this->insert_value(name, prop_vals, false);
 }
 
 
@@ -331,7 +389,7 @@ void teca_metadata::insert(
 template<typename T>
 int teca_metadata::set(const std::string &name, unsigned int i, const T &val)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         TECA_ERROR(
@@ -340,7 +398,7 @@ int teca_metadata::set(const std::string &name, unsigned int i, const T &val)
         return -1;
     }
 
-    it->second->set(i, val);
+    it->value->set(i, val);
 
     return 0;
 }
@@ -352,7 +410,7 @@ int teca_metadata::set(
     const T *vals,
     unsigned int n_vals)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         TECA_ERROR(
@@ -361,7 +419,7 @@ int teca_metadata::set(
         return -1;
     }
 
-    it->second->set(0, n_vals-1, vals);
+    it->value->set(0, n_vals-1, vals);
 
     return 0;
 }
@@ -372,7 +430,7 @@ int teca_metadata::set(
     const std::string &name,
     const std::vector<T> &vals)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         TECA_ERROR(
@@ -381,7 +439,7 @@ int teca_metadata::set(
         return -1;
     }
 
-    it->second->set(vals);
+    it->value->set(vals);
 
     return 0;
 }
@@ -401,7 +459,7 @@ int teca_metadata::set(
     const std::string &name,
     const std::set<T> &vals)
 {
-    prop_map_t::iterator it = this->props.find(name);
+    prop_vector_t::iterator it = this->find_for_write(name);
     if (it == this->props.end())
     {
         TECA_ERROR(
@@ -411,7 +469,7 @@ int teca_metadata::set(
     }
 
     std::vector<T> tmp(vals.begin(), vals.end());
-    it->second->set(tmp);
+    it->value->set(tmp);
 
     return 0;
 }
@@ -420,12 +478,12 @@ int teca_metadata::set(
 template<typename T>
 int teca_metadata::get(const std::string &name, unsigned int i, T &val) const
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
-    it->second->get(i, val);
+    it->value->get(i, val);
 
     return 0;
 }
@@ -436,12 +494,12 @@ int teca_metadata::get(
     const std::string &name,
     std::vector<T> &vals) const
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
-    it->second->get(vals);
+    it->value->get(vals);
 
     return 0;
 }
@@ -467,12 +525,12 @@ int teca_metadata::get(
     const std::string &name,
     T *vals, unsigned int n) const
 {
-    prop_map_t::const_iterator it = this->props.find(name);
+    prop_vector_t::const_iterator it = this->find(name);
 
     if (it == this->props.end())
         return -1;
 
-    it->second->get(0, n-1, vals);
+    it->value->get(0, n-1, vals);
 
     return 0;
 }
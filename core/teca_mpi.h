@@ -0,0 +1,22 @@
+#ifndef teca_mpi_h
+#define teca_mpi_h
+
+#include "teca_config.h"
+
+// include MPI when it's available. otherwise declare the types and
+// constants used in TECA's API, so that code passing communicators
+// around compiles either way.
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#else
+using MPI_Comm = void*;
+#define MPI_COMM_WORLD nullptr
+#define MPI_COMM_SELF nullptr
+#define MPI_COMM_NULL nullptr
+#define MPI_THREAD_SINGLE 0
+#define MPI_THREAD_FUNNELED 1
+#define MPI_THREAD_SERIALIZED 2
+#define MPI_THREAD_MULTIPLE 3
+#endif
+
+#endif
@@ -1,37 +1,53 @@
 #include "teca_mpi_manager.h"
 #include "teca_config.h"
 #include "teca_common.h"
+#include "teca_tracer.h"
+#include "teca_buffer_pool.h"
+#include "teca_thread_pool.h"
 
 #include <cstdlib>
 
-#if defined(TECA_HAS_MPI)
-#include <mpi.h>
-#endif
-
 // --------------------------------------------------------------------------
-teca_mpi_manager::teca_mpi_manager(int &argc, char **&argv)
-    : m_rank(0),  m_size(1)
+teca_mpi_manager::teca_mpi_manager(int &argc, char **&argv,
+    int thread_level) : m_rank(0),  m_size(1), m_thread_level(thread_level)
 {
 #if defined(TECA_HAS_MPI)
-    int mpi_thread_required = MPI_THREAD_SERIALIZED;
+    int mpi_thread_required = thread_level;
     int mpi_thread_provided = 0;
     MPI_Init_thread(&argc, &argv, mpi_thread_required, &mpi_thread_provided);
     if (mpi_thread_provided < mpi_thread_required)
     {
-        TECA_ERROR("This MPI does not support thread serialized");
+        TECA_ERROR("This MPI does not support thread level "
+            << mpi_thread_required << ", it provides "
+            << mpi_thread_provided);
         abort();
     }
+    m_thread_level = mpi_thread_provided;
     MPI_Comm_rank(MPI_COMM_WORLD, &m_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &m_size);
+
+    // find the ranks sharing each node once, here where all ranks
+    // are known to participate, so that thread pools can be sized
+    // without collective operations
+    internal::init_node_layout(MPI_COMM_WORLD);
 #else
     (void)argc;
     (void)argv;
 #endif
+
+    // the pool is installed before any arrays are allocated. the
+    // capacity is given in megabytes
+    const char *pool_capacity = getenv("TECA_BUFFER_POOL");
+    if (pool_capacity && (atol(pool_capacity) > 0))
+        teca_buffer_pool::enable(atol(pool_capacity)*1024ul*1024ul);
 }
 
 // --------------------------------------------------------------------------
 teca_mpi_manager::~teca_mpi_manager()
 {
+    // the trace is merged across ranks before MPI goes away
+    teca_tracer::write();
+
 #if defined(TECA_HAS_MPI)
     int ok = 0;
     MPI_Initialized(&ok);
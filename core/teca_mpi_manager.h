@@ -1,9 +1,17 @@
 #ifndef teca_mpi_manager_h
 #define teca_mpi_manager_h
 
+#include "teca_mpi.h"
+
 /// A RAII class to ease MPI initalization and finalization
 // MPI_Init is handled in the constructor, MPI_Finalize is
-// handled in the destructor.
+// handled in the destructor. By default MPI_THREAD_SERIALIZED
+// is requested. Applications that make MPI calls from several
+// threads concurrently, for instance by running pipelines on
+// different communicators in different threads, must request
+// MPI_THREAD_MULTIPLE. Note that some MPI implementations do not
+// support the one-sided communication used by the dynamic
+// schedules at this level.
 class teca_mpi_manager
 {
 public:
@@ -11,15 +19,20 @@ public:
     teca_mpi_manager(const teca_mpi_manager &) = delete;
     void operator=(const teca_mpi_manager &) = delete;
 
-    teca_mpi_manager(int &argc, char **&argv);
+    teca_mpi_manager(int &argc, char **&argv,
+        int thread_level = MPI_THREAD_SERIALIZED);
     ~teca_mpi_manager();
 
     int get_comm_rank(){ return m_rank; }
     int get_comm_size(){ return m_size; }
 
+    // get the level of thread support provided by MPI
+    int get_thread_level(){ return m_thread_level; }
+
 private:
     int m_rank;
     int m_size;
+    int m_thread_level;
 };
 
 #endif
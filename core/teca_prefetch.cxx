@@ -0,0 +1,372 @@
+#include "teca_prefetch.h"
+#include "teca_metadata.h"
+#include "teca_tracer.h"
+
+#include <string>
+#include <vector>
+#include <list>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <exception>
+
+#if defined(TECA_HAS_BOOST)
+#include <boost/program_options.hpp>
+#endif
+
+// data prefetched or being prefetched for a single request. if reading
+// the data failed the exception is held in error
+struct teca_prefetch_entry
+{
+    enum {queued, running, ready, dropped};
+
+    teca_prefetch_entry(const teca_algorithm_output_port &c,
+        const teca_metadata &req, unsigned long t) : conn(c),
+        request(req), modified_time(t), state(queued), claimed(false)
+    {}
+
+    teca_algorithm_output_port conn;
+    teca_metadata request;
+    unsigned long modified_time;
+    int state;
+    bool claimed;
+    const_p_teca_dataset data;
+    std::exception_ptr error;
+};
+
+// state shared by the consumer and the I/O thread
+class teca_prefetch_internals
+{
+public:
+    teca_prefetch_internals() : shutdown(false), last_step(-1),
+        stride(0), last_bytes(0), n_hits(0), n_misses(0) {}
+
+    // find the entry for the given request
+    std::list<teca_prefetch_entry>::iterator find(const teca_metadata &req,
+        unsigned long modified_time);
+
+    // find the first entry that is waiting to be read
+    std::list<teca_prefetch_entry>::iterator find_queued();
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::list<teca_prefetch_entry> entries;
+    std::thread io_thread;
+    bool shutdown;
+    long last_step;
+    long stride;
+    unsigned long last_bytes;
+    std::atomic<unsigned long> n_hits;
+    std::atomic<unsigned long> n_misses;
+};
+
+// --------------------------------------------------------------------------
+std::list<teca_prefetch_entry>::iterator teca_prefetch_internals::find(
+    const teca_metadata &req, unsigned long modified_time)
+{
+    std::list<teca_prefetch_entry>::iterator it = this->entries.begin();
+    std::list<teca_prefetch_entry>::iterator end = this->entries.end();
+    for (; it != end; ++it)
+    {
+        if ((it->state != teca_prefetch_entry::dropped) && !it->claimed
+            && (it->modified_time == modified_time) && (it->request == req))
+            return it;
+    }
+    return end;
+}
+
+// --------------------------------------------------------------------------
+std::list<teca_prefetch_entry>::iterator teca_prefetch_internals::find_queued()
+{
+    std::list<teca_prefetch_entry>::iterator it = this->entries.begin();
+    std::list<teca_prefetch_entry>::iterator end = this->entries.end();
+    for (; it != end; ++it)
+    {
+        if (it->state == teca_prefetch_entry::queued)
+            return it;
+    }
+    return end;
+}
+
+
+
+// --------------------------------------------------------------------------
+teca_prefetch::teca_prefetch() : prefetch_depth(2), memory_budget(-1),
+    internals(new teca_prefetch_internals)
+{
+    this->set_number_of_input_connections(1);
+    this->set_number_of_output_ports(1);
+}
+
+// --------------------------------------------------------------------------
+teca_prefetch::~teca_prefetch() noexcept
+{
+    {
+    std::lock_guard<std::mutex> lock(this->internals->mutex);
+    this->internals->shutdown = true;
+    }
+    this->internals->cond.notify_all();
+
+    if (this->internals->io_thread.joinable())
+        this->internals->io_thread.join();
+
+    delete this->internals;
+}
+
+#if defined(TECA_HAS_BOOST)
+// --------------------------------------------------------------------------
+void teca_prefetch::get_properties_description(
+    const std::string &prefix, options_description &global_opts)
+{
+    options_description opts("Options for "
+        + (prefix.empty()?"teca_prefetch":prefix));
+
+    opts.add_options()
+        TECA_POPTS_GET(int, prefix, prefetch_depth,
+            "number of time steps to read ahead. when n < 1 time steps "
+            "are not read ahead (2)")
+        TECA_POPTS_GET(long, prefix, memory_budget,
+            "maximum number of bytes of data read ahead. when n < 0 "
+            "the amount is not limited (-1)")
+        ;
+
+    global_opts.add(opts);
+}
+
+// --------------------------------------------------------------------------
+void teca_prefetch::set_properties(const std::string &prefix,
+    variables_map &opts)
+{
+    TECA_POPTS_SET(opts, int, prefix, prefetch_depth)
+    TECA_POPTS_SET(opts, long, prefix, memory_budget)
+}
+#endif
+
+// --------------------------------------------------------------------------
+unsigned long teca_prefetch::get_number_of_prefetch_hits() const
+{
+    return this->internals->n_hits;
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_prefetch::get_number_of_prefetch_misses() const
+{
+    return this->internals->n_misses;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_prefetch::request_data(
+    teca_algorithm_output_port &current, const teca_metadata &request)
+{
+    unsigned int port = get_port(current);
+
+    teca_trace_span span("request_data", this, port, request);
+
+    teca_algorithm_output_port &conn = this->get_input_connection(0);
+
+    // prefetching is disabled, pass the request through
+    if (this->prefetch_depth < 1)
+    {
+        const_p_teca_dataset data
+            = get_algorithm(conn)->request_data(conn, request);
+        span.set_output(data);
+        return data;
+    }
+
+    teca_prefetch_internals *inter = this->internals;
+    unsigned long modified_time = this->get_pipeline_modified_time();
+
+    // take the data if it was prefetched. if it is being read
+    // wait for it.
+    const_p_teca_dataset data;
+    bool hit = false;
+    {
+    std::unique_lock<std::mutex> lock(inter->mutex);
+
+    std::list<teca_prefetch_entry>::iterator it
+        = inter->find(request, modified_time);
+
+    if (it != inter->entries.end())
+    {
+        if (it->state == teca_prefetch_entry::queued)
+        {
+            // not started, it is read here instead
+            inter->entries.erase(it);
+        }
+        else
+        {
+            it->claimed = true;
+
+            inter->cond.wait(lock,
+                [&]() { return it->state == teca_prefetch_entry::ready; });
+
+            data = it->data;
+            std::exception_ptr error = it->error;
+            inter->entries.erase(it);
+
+            // pass the failure of the read ahead on, as if the
+            // time step had been read here
+            if (error)
+                std::rethrow_exception(error);
+
+            ++inter->n_hits;
+            hit = true;
+        }
+    }
+    }
+
+    if (!hit)
+    {
+        ++inter->n_misses;
+        data = get_algorithm(conn)->request_data(conn, request);
+    }
+
+    // predict the time steps that come next
+    unsigned long step = 0;
+    unsigned long n_steps = 0;
+    teca_metadata md = this->get_output_metadata(conn);
+    bool predict = !request.get("time_step", step)
+        && !md.get("number_of_time_steps", n_steps);
+
+    std::vector<teca_metadata> next_reqs;
+    {
+    std::lock_guard<std::mutex> lock(inter->mutex);
+
+    if (data)
+        inter->last_bytes = data->get_memory_usage();
+
+    if (predict)
+    {
+        if ((inter->last_step >= 0) && (long(step) != inter->last_step))
+            inter->stride = long(step) - inter->last_step;
+
+        inter->last_step = step;
+
+        int n_next = inter->stride ? this->prefetch_depth : 0;
+        for (int i = 1; i <= n_next; ++i)
+        {
+            long next = long(step) + i*inter->stride;
+            if ((next < 0) || (next >= long(n_steps)))
+                break;
+
+            next_reqs.push_back(request);
+            next_reqs.back().insert("time_step", static_cast<unsigned long>(next));
+        }
+    }
+
+    // discard data for time steps that are no longer expected. data
+    // being read is discarded by the I/O thread when it arrives.
+    std::list<teca_prefetch_entry>::iterator it = inter->entries.begin();
+    while (it != inter->entries.end())
+    {
+        bool keep = it->claimed || (it->state == teca_prefetch_entry::dropped)
+            || ((it->modified_time == modified_time)
+                && (std::find(next_reqs.begin(), next_reqs.end(), it->request)
+                    != next_reqs.end()));
+
+        if (keep)
+        {
+            ++it;
+        }
+        else if (it->state == teca_prefetch_entry::running)
+        {
+            it->state = teca_prefetch_entry::dropped;
+            ++it;
+        }
+        else
+        {
+            it = inter->entries.erase(it);
+        }
+    }
+
+    // queue the time steps not already prefetched, while the data
+    // held and the estimated size of the data pending fit within
+    // the budget
+    unsigned long n_bytes = 0;
+    unsigned long n_pending = 0;
+    for (const teca_prefetch_entry &ent : inter->entries)
+    {
+        if (ent.state == teca_prefetch_entry::ready)
+            n_bytes += ent.data ? ent.data->get_memory_usage() : 0;
+        else if (ent.state != teca_prefetch_entry::dropped)
+            ++n_pending;
+    }
+
+    size_t n_next = next_reqs.size();
+    for (size_t i = 0; i < n_next; ++i)
+    {
+        if (inter->find(next_reqs[i], modified_time) != inter->entries.end())
+            continue;
+
+        if ((this->memory_budget >= 0) && (n_bytes
+            + (n_pending + 1)*inter->last_bytes > (unsigned long)this->memory_budget))
+            break;
+
+        inter->entries.emplace_back(conn, next_reqs[i], modified_time);
+        ++n_pending;
+    }
+
+    // start the I/O thread
+    if (n_pending && !inter->io_thread.joinable())
+    {
+        inter->io_thread = std::thread([this,inter]()
+        {
+            std::unique_lock<std::mutex> lock(inter->mutex);
+            while (!inter->shutdown)
+            {
+                std::list<teca_prefetch_entry>::iterator it = inter->find_queued();
+                if (it == inter->entries.end())
+                {
+                    inter->cond.wait(lock);
+                    continue;
+                }
+
+                it->state = teca_prefetch_entry::running;
+
+                teca_algorithm_output_port up_conn = it->conn;
+                teca_metadata up_req = it->request;
+
+                lock.unlock();
+
+                // an exception must not leave the thread, it is kept
+                // for the consumer waiting on the entry
+                const_p_teca_dataset up_data;
+                std::exception_ptr up_error;
+                try
+                {
+                    teca_trace_span span("prefetch", this, 0, up_req);
+                    up_data = get_algorithm(up_conn)->request_data(up_conn, up_req);
+                    span.set_output(up_data);
+                }
+                catch (...)
+                {
+                    up_error = std::current_exception();
+                }
+
+                lock.lock();
+
+                if (it->state == teca_prefetch_entry::dropped)
+                {
+                    inter->entries.erase(it);
+                }
+                else
+                {
+                    it->data = up_data;
+                    it->error = up_error;
+                    it->state = teca_prefetch_entry::ready;
+                }
+
+                inter->cond.notify_all();
+            }
+        });
+    }
+    }
+
+    inter->cond.notify_all();
+
+    span.set_output(data);
+
+    return data;
+}
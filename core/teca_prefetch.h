@@ -0,0 +1,76 @@
+#ifndef teca_prefetch_h
+#define teca_prefetch_h
+
+#include "teca_algorithm.h"
+#include "teca_dataset.h"
+#include "teca_shared_object.h"
+#include "teca_algorithm_output_port.h"
+
+class teca_metadata;
+class teca_prefetch_internals;
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_prefetch)
+
+// an algorithm that reads ahead. placed after a reader that is
+// driven one time step at a time, for instance by a writer and
+// the teca_time_step_executive, the next prefetch_depth time steps
+// are requested from upstream on a dedicated I/O thread while the
+// current one is processed downstream. the stride between time
+// steps is taken from the two most recent requests, such that time
+// steps are read ahead from the third request on. other than the
+// time step the predicted requests are the same as the current one.
+//
+// a prefetched dataset is handed to the consumer and released. it
+// is not kept in the cache. datasets that were prefetched for time
+// steps that were not requested are discarded at the next request.
+//
+// meta data keys:
+//      requires:
+//          number_of_time_steps - the number of time steps available
+//
+//      consumes:
+//          time_step
+class teca_prefetch : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(teca_prefetch)
+    TECA_ALGORITHM_DELETE_COPY_ASSIGN(teca_prefetch)
+    virtual ~teca_prefetch() noexcept;
+
+    // report/initialize to/from Boost program options
+    // objects.
+    TECA_GET_ALGORITHM_PROPERTIES_DESCRIPTION()
+    TECA_SET_ALGORITHM_PROPERTIES()
+
+    // set/get the number of time steps to read ahead. 0 disables
+    // prefetching. Default is 2.
+    TECA_ALGORITHM_PROPERTY(int, prefetch_depth)
+
+    // set/get the limit in bytes on the data prefetched. the size
+    // of data not yet read is estimated from the most recent
+    // dataset. fewer time steps than prefetch_depth are read ahead
+    // when the budget would be exceeded. -1 for no limit. Default
+    // is -1.
+    TECA_ALGORITHM_PROPERTY(long, memory_budget)
+
+    // get the number of requests that were served by data that
+    // was prefetched, and the number of requests that were not.
+    unsigned long get_number_of_prefetch_hits() const;
+    unsigned long get_number_of_prefetch_misses() const;
+
+protected:
+    teca_prefetch();
+
+    // overrides the driver to hand over prefetched data and
+    // issue the requests for the time steps that come next.
+    const_p_teca_dataset request_data(teca_algorithm_output_port &port,
+        const teca_metadata &request) override;
+
+private:
+    int prefetch_depth;
+    long memory_budget;
+
+    teca_prefetch_internals *internals;
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "teca_config.h"
+#include "teca_spatial_executive.h"
+
+#include "teca_common.h"
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+using std::vector;
+using std::string;
+using std::cerr;
+using std::endl;
+
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#endif
+
+//#define TECA_SPATIAL_EXECUTIVE_DEBUG
+
+// --------------------------------------------------------------------------
+teca_spatial_executive::teca_spatial_executive()
+    : first_step(0), last_step(-1), stride(1), n_tiles_i(1), n_tiles_j(0),
+    halo(0)
+{
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_first_step(long s)
+{
+    this->first_step = std::max(0l, s);
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_last_step(long s)
+{
+    this->last_step = s;
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_stride(long s)
+{
+    this->stride = std::max(1l, s);
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_extent(const std::vector<unsigned long> &ext)
+{
+    this->extent = ext;
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_arrays(const std::vector<std::string> &v)
+{
+    this->arrays = v;
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_number_of_tiles(unsigned long n_i,
+    unsigned long n_j)
+{
+    this->n_tiles_i = std::max(1ul, n_i);
+    this->n_tiles_j = n_j;
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::set_halo(unsigned long n)
+{
+    this->halo = n;
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::partition(const unsigned long *ext,
+    unsigned long n_i, unsigned long n_j,
+    std::vector<std::vector<unsigned long>> &tiles)
+{
+    tiles.clear();
+
+    unsigned long n_x = ext[1] - ext[0] + 1;
+    unsigned long n_y = ext[3] - ext[2] + 1;
+
+    n_i = std::max(1ul, std::min(n_i, n_x));
+    n_j = std::max(1ul, std::min(n_j, n_y));
+
+    // the first n%n_tiles tiles get an extra point
+    unsigned long bs_i = n_x/n_i;
+    unsigned long nl_i = n_x%n_i;
+    unsigned long bs_j = n_y/n_j;
+    unsigned long nl_j = n_y%n_j;
+
+    for (unsigned long j = 0; j < n_j; ++j)
+    {
+        unsigned long j0 = ext[2] + j*bs_j + std::min(j, nl_j);
+        unsigned long j1 = j0 + bs_j + (j < nl_j ? 1 : 0) - 1;
+
+        for (unsigned long i = 0; i < n_i; ++i)
+        {
+            unsigned long i0 = ext[0] + i*bs_i + std::min(i, nl_i);
+            unsigned long i1 = i0 + bs_i + (i < nl_i ? 1 : 0) - 1;
+
+            tiles.push_back({i0, i1, j0, j1, ext[4], ext[5]});
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+void teca_spatial_executive::add_halo(const unsigned long *tile,
+    unsigned long halo, const unsigned long *whole_extent, unsigned long *ext)
+{
+    for (int q = 0; q < 4; q += 2)
+    {
+        ext[q] = tile[q] > whole_extent[q] + halo ?
+            tile[q] - halo : whole_extent[q];
+
+        ext[q+1] = std::min(tile[q+1] + halo, whole_extent[q+1]);
+    }
+
+    ext[4] = tile[4];
+    ext[5] = tile[5];
+}
+
+// --------------------------------------------------------------------------
+int teca_spatial_executive::initialize(const teca_metadata &md)
+{
+    this->requests.clear();
+
+    // locate available times
+    long n_times = 1;
+    if (md.get("number_of_time_steps", n_times))
+    {
+        TECA_ERROR("metadata is missing \"number_of_time_steps\"")
+        return -1;
+    }
+
+    // apply restriction
+    long last
+        = this->last_step >= 0 ? this->last_step : n_times - 1;
+
+    long first
+        = ((this->first_step >= 0) && (this->first_step <= last))
+            ? this->first_step : 0;
+
+    vector<unsigned long> steps;
+    for (long step = first; step <= last; ++step)
+    {
+        if ((step % this->stride) == 0)
+            steps.push_back(step);
+    }
+
+    // get the extent to split
+    vector<unsigned long> whole_extent(6, 0l);
+    if (md.get("whole_extent", whole_extent))
+    {
+        TECA_ERROR("metadata is missing \"whole_extent\"")
+        return -1;
+    }
+
+    vector<unsigned long> ext = this->extent.empty() ?
+        whole_extent : this->extent;
+
+    if (ext.size() != 6)
+    {
+        TECA_ERROR("invalid extent with " << ext.size() << " values")
+        return -1;
+    }
+
+    size_t rank = 0;
+    size_t n_ranks = 1;
+#if defined(TECA_HAS_MPI)
+    int is_init = 0;
+    MPI_Initialized(&is_init);
+    if (is_init)
+    {
+        int tmp = 0;
+        MPI_Comm_size(this->get_communicator(), &tmp);
+        n_ranks = tmp;
+        MPI_Comm_rank(this->get_communicator(), &tmp);
+        rank = tmp;
+    }
+#endif
+
+    // split the extent
+    unsigned long n_j = this->n_tiles_j ? this->n_tiles_j : n_ranks;
+
+    vector<vector<unsigned long>> tiles;
+    teca_spatial_executive::partition(ext.data(), this->n_tiles_i,
+        n_j, tiles);
+
+    // partition the tiles of all time steps across MPI ranks.
+    // each rank will end up with a unique block of work.
+    size_t n_tiles = tiles.size();
+    size_t n_work = steps.size()*n_tiles;
+    size_t n_big_blocks = n_work%n_ranks;
+    size_t block_size = 1;
+    size_t block_start = 0;
+    if (rank < n_big_blocks)
+    {
+        block_size = n_work/n_ranks + 1;
+        block_start = block_size*rank;
+    }
+    else
+    {
+        block_size = n_work/n_ranks;
+        block_start = block_size*rank + n_big_blocks;
+    }
+
+    // requests are taken from the back
+    for (size_t i = block_start + block_size; i > block_start; --i)
+    {
+        size_t q = i - 1;
+        size_t tile_id = q%n_tiles;
+        const vector<unsigned long> &tile = tiles[tile_id];
+
+        vector<unsigned long> tile_ext(6);
+        teca_spatial_executive::add_halo(tile.data(), this->halo,
+            whole_extent.data(), tile_ext.data());
+
+        teca_metadata req;
+        req.insert("arrays", this->arrays);
+        req.insert("time_step", steps[q/n_tiles]);
+        req.insert("extent", tile_ext);
+        req.insert("tile_extent", tile);
+        req.insert("tile_id", tile_id);
+
+        this->requests.push_back(req);
+    }
+
+#if defined(TECA_SPATIAL_EXECUTIVE_DEBUG)
+    cerr << teca_parallel_id()
+        << " teca_spatial_executive::initialize first="
+        << first << " last=" << last << " stride=" << this->stride
+        << " n_tiles=" << n_tiles << " halo=" << this->halo << endl;
+#endif
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+teca_metadata teca_spatial_executive::get_next_request()
+{
+    teca_metadata req;
+    if (!this->requests.empty())
+    {
+        req = this->requests.back();
+        this->requests.pop_back();
+
+#if defined(TECA_SPATIAL_EXECUTIVE_DEBUG)
+        vector<unsigned long> ext;
+        req.get("extent", ext);
+
+        unsigned long time_step;
+        req.get("time_step", time_step);
+
+        cerr << teca_parallel_id()
+            << " teca_spatial_executive::get_next_request time_step="
+            << time_step << " extent=" << ext[0] << ", " << ext[1] << ", "
+            << ext[2] << ", " << ext[3] << ", " << ext[4] << ", " << ext[5]
+            << endl;
+#endif
+    }
+
+    return req;
+}
@@ -0,0 +1,104 @@
+#ifndef teca_spatial_executive_h
+#define teca_spatial_executive_h
+
+#include "teca_shared_object.h"
+#include "teca_algorithm_executive.h"
+#include "teca_metadata.h"
+
+#include <vector>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_spatial_executive)
+
+///
+/**
+An executive that generates requests for a series of time steps
+with the extent of each split into tiles. The tiles of all of the
+time steps are partitioned across MPI ranks in contiguous blocks,
+such that jobs with fewer time steps than ranks, or time steps too
+large for a single rank, can be distributed.
+
+By default the extent is split in the j direction only, into one
+tile per rank. Splitting in the i direction is supported but
+algorithms that treat longitude as periodic will then see a
+boundary that is not there.
+
+Stencil algorithms need data from outside of the tile to compute
+the values on its edges. When a halo is set each tile is grown by
+that many points in i and j, clamped to the whole extent. The
+requested extent includes the halo and the tile proper is passed in
+the request as "tile_extent". When teca_spatial_reduce is in the
+pipeline it adds the halo required for its own tiles, and the halo
+here should be left at 0.
+
+Requests have the following keys:
+
+    time_step   - the time step
+    extent      - the tile, grown by the halo
+    tile_extent - the tile
+    tile_id     - the index of the tile in the extent
+    arrays      - the arrays to process
+*/
+class teca_spatial_executive : public teca_algorithm_executive
+{
+public:
+    TECA_ALGORITHM_EXECUTIVE_STATIC_NEW(teca_spatial_executive)
+
+    int initialize(const teca_metadata &md) override;
+    teca_metadata get_next_request() override;
+
+    // set the first time step in the series to process.
+    // default is 0.
+    void set_first_step(long s);
+
+    // set the last time step in the series to process.
+    // default is -1. negative number results in the last
+    // available time step being used.
+    void set_last_step(long s);
+
+    // set the stride to process time steps at. default
+    // is 1
+    void set_stride(long s);
+
+    // set the extent to split into tiles. the default is the
+    // whole_extent.
+    void set_extent(const std::vector<unsigned long> &ext);
+
+    // set the list of arrays to process
+    void set_arrays(const std::vector<std::string> &arrays);
+
+    // set the number of tiles in the i and j directions. a value
+    // of 0 in j results in a tile per MPI rank. the defaults are
+    // 1 and 0.
+    void set_number_of_tiles(unsigned long n_i, unsigned long n_j);
+
+    // set the number of points to grow each tile by. default is 0.
+    void set_halo(unsigned long n);
+
+    // split the extent into n_i by n_j tiles. the sizes of the
+    // tiles in each direction differ by at most one point. when
+    // the extent has fewer points than tiles in a direction, the
+    // number of tiles in that direction is reduced.
+    static void partition(const unsigned long *extent, unsigned long n_i,
+        unsigned long n_j, std::vector<std::vector<unsigned long>> &tiles);
+
+    // grow the tile by halo points in the i and j directions,
+    // clamping to the whole extent.
+    static void add_halo(const unsigned long *tile, unsigned long halo,
+        const unsigned long *whole_extent, unsigned long *extent);
+
+protected:
+    teca_spatial_executive();
+
+private:
+    std::vector<teca_metadata> requests;
+    long first_step;
+    long last_step;
+    long stride;
+    unsigned long n_tiles_i;
+    unsigned long n_tiles_j;
+    unsigned long halo;
+    std::vector<unsigned long> extent;
+    std::vector<std::string> arrays;
+};
+
+#endif
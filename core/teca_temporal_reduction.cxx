@@ -1,7 +1,10 @@
 #include "teca_temporal_reduction.h"
 #include "teca_binary_stream.h"
+#include "teca_dynamic_scheduler.h"
+#include "teca_tracer.h"
 
 #include <sstream>
+#include <algorithm>
 
 #if defined(TECA_HAS_MPI)
 #include <mpi.h>
@@ -11,63 +14,223 @@
 #include <boost/program_options.hpp>
 #endif
 
-// TODO
-// handle large messages, ie work around int in MPI api
 namespace internal {
 #if defined(TECA_HAS_MPI)
-// helper for sending binary data over MPI
+// messages are split into chunks of this size. this keeps the counts
+// passed to MPI within the range of an int, for messages over 2GB, and
+// lets the transfer of one chunk overlap with the next.
+constexpr unsigned long chunk_size = 1ul << 26;
+
+// the maximum number of chunks in flight per message
+constexpr int max_chunks_in_flight = 4;
+
+// tags for the message size and message chunks. chunks are matched
+// in the order they are sent.
+constexpr int size_tag = 3210;
+constexpr int chunk_tag = 3211;
+
+// --------------------------------------------------------------------------
+unsigned long get_number_of_chunks(unsigned long n_bytes)
+{
+    return n_bytes/chunk_size + (n_bytes%chunk_size ? 1 : 0);
+}
+
+// --------------------------------------------------------------------------
+int get_chunk_length(unsigned long n_bytes, unsigned long chunk)
+{
+    return std::min(chunk_size, n_bytes - chunk*chunk_size);
+}
+
+// --------------------------------------------------------------------------
+// send the n_bytes of the stream starting at first. when the stream
+// references arrays, a datatype describing the segments is used such
+// that they are sent without being copied
+int isend_chunk(MPI_Comm comm, int dest, teca_binary_stream &s,
+    unsigned long first, int n_bytes, MPI_Request *req)
+{
+    if (!s.has_references())
+        return MPI_Isend(s.get_data() + first, n_bytes,
+            MPI_UNSIGNED_CHAR, dest, chunk_tag, comm, req);
+
+    std::vector<teca_binary_stream::segment> segs;
+    s.get_segments(first, n_bytes, segs);
+
+    int n_segs = segs.size();
+    std::vector<int> lengths(n_segs);
+    std::vector<MPI_Aint> displs(n_segs);
+    for (int i = 0; i < n_segs; ++i)
+    {
+        lengths[i] = segs[i].n_bytes;
+        MPI_Get_address(segs[i].data, &displs[i]);
+    }
+
+    // the type may be freed once the send is posted
+    MPI_Datatype chunk_type;
+    int ierr = 0;
+    if ((ierr = MPI_Type_create_hindexed(n_segs, lengths.data(),
+        displs.data(), MPI_UNSIGNED_CHAR, &chunk_type)) ||
+        (ierr = MPI_Type_commit(&chunk_type)))
+        return ierr;
+
+    ierr = MPI_Isend(MPI_BOTTOM, 1, chunk_type, dest, chunk_tag, comm, req);
+    MPI_Type_free(&chunk_type);
+
+    return ierr;
+}
+
+// helper for sending binary data over MPI. the message is sent in
+// chunks, with up to max_chunks_in_flight outstanding at once.
 int send(MPI_Comm comm, int dest, teca_binary_stream &s)
 {
-    unsigned long long n = s.size();
-    if (MPI_Send(&n, 1, MPI_UNSIGNED_LONG_LONG, dest, 3210, comm))
+    unsigned long long n_bytes = s.get_total_size();
+
+    MPI_Request size_req;
+    if (MPI_Isend(&n_bytes, 1, MPI_UNSIGNED_LONG_LONG, dest,
+        size_tag, comm, &size_req))
     {
-        TECA_ERROR("failed to send send message size")
+        TECA_ERROR("failed to send message size")
         return -1;
     }
 
-    if (n)
+    MPI_Request reqs[max_chunks_in_flight];
+    std::fill(reqs, reqs + max_chunks_in_flight, MPI_REQUEST_NULL);
+
+    unsigned long n_chunks = get_number_of_chunks(n_bytes);
+    for (unsigned long i = 0; i < n_chunks; ++i)
     {
-        if (MPI_Send(s.get_data(), n, MPI_UNSIGNED_CHAR,
-                dest, 3211, MPI_COMM_WORLD))
+        // reuse the slot once the chunk sent from it completes
+        MPI_Request &req = reqs[i%max_chunks_in_flight];
+
+        if (MPI_Wait(&req, MPI_STATUS_IGNORE) ||
+            isend_chunk(comm, dest, s, i*chunk_size,
+                get_chunk_length(n_bytes, i), &req))
         {
-            TECA_ERROR("failed to send message")
+            TECA_ERROR("failed to send message chunk " << i
+                << " of " << n_chunks)
             return -2;
         }
     }
 
+    if (MPI_Wait(&size_req, MPI_STATUS_IGNORE) ||
+        MPI_Waitall(max_chunks_in_flight, reqs, MPI_STATUSES_IGNORE))
+    {
+        TECA_ERROR("failed to complete the send")
+        return -2;
+    }
+
     return 0;
 }
 
-// helper for receiving data over MPI
-int recv(MPI_Comm comm, int src, teca_binary_stream &s)
+// helper for receiving binary data over MPI without blocking. the
+// caller waits on the requests of one or more receivers, and calls
+// progress for the receiver that owns a completed request. the
+// message size is received first, after which up to
+// max_chunks_in_flight chunk receives are kept posted.
+class recv
 {
-    size_t n = 0;
-    MPI_Status stat;
-    if (MPI_Recv(&n, 1, MPI_UNSIGNED_LONG_LONG, src, 3210, comm, &stat))
+public:
+    recv() : m_comm(MPI_COMM_NULL), m_src(-1), m_n_bytes(0),
+        m_n_chunks(0), m_n_posted(0), m_n_recvd(0), m_have_size(false),
+        m_reqs(nullptr)
+    {}
+
+    // post the receive of the message size. reqs must point to
+    // max_chunks_in_flight requests owned by the caller.
+    int start(MPI_Comm comm, int src, MPI_Request *reqs);
+
+    // called when the request in slot i has completed. posts the
+    // next receives
+    int progress(int i);
+
+    // returns true when the entire message has arrived
+    bool complete() const
+    { return m_have_size && (m_n_recvd == m_n_chunks); }
+
+    teca_binary_stream &get_stream() { return m_stream; }
+
+private:
+    // post the next chunk's receive in slot i
+    int post(int i);
+
+private:
+    MPI_Comm m_comm;
+    int m_src;
+    unsigned long long m_n_bytes;
+    unsigned long m_n_chunks;
+    unsigned long m_n_posted;
+    unsigned long m_n_recvd;
+    bool m_have_size;
+    MPI_Request *m_reqs;
+    teca_binary_stream m_stream;
+};
+
+// --------------------------------------------------------------------------
+int recv::start(MPI_Comm comm, int src, MPI_Request *reqs)
+{
+    m_comm = comm;
+    m_src = src;
+    m_reqs = reqs;
+
+    std::fill(m_reqs, m_reqs + max_chunks_in_flight, MPI_REQUEST_NULL);
+
+    if (MPI_Irecv(&m_n_bytes, 1, MPI_UNSIGNED_LONG_LONG, m_src,
+        size_tag, m_comm, m_reqs))
     {
         TECA_ERROR("failed to receive message size")
-        return -2;
+        return -1;
     }
 
-    s.resize(n);
+    return 0;
+}
 
-    if (n)
+// --------------------------------------------------------------------------
+int recv::post(int i)
+{
+    if (m_n_posted < m_n_chunks)
     {
-        if (MPI_Recv(s.get_data(), n, MPI_UNSIGNED_CHAR, src, 3211, comm, &stat))
+        unsigned long chunk = m_n_posted;
+        if (MPI_Irecv(m_stream.get_data() + chunk*chunk_size,
+            get_chunk_length(m_n_bytes, chunk), MPI_UNSIGNED_CHAR,
+            m_src, chunk_tag, m_comm, m_reqs + i))
         {
-            TECA_ERROR("failed to receive message")
-            return -2;
+            TECA_ERROR("failed to receive message chunk " << chunk
+                << " of " << m_n_chunks)
+            return -1;
         }
+        ++m_n_posted;
     }
-
     return 0;
 }
+
+// --------------------------------------------------------------------------
+int recv::progress(int i)
+{
+    if (!m_have_size)
+    {
+        // the size arrived, allocate and post the chunk receives
+        m_have_size = true;
+        m_n_chunks = get_number_of_chunks(m_n_bytes);
+        m_stream.resize(m_n_bytes);
+        m_stream.set_write_pos(m_n_bytes);
+
+        for (int j = 0; j < max_chunks_in_flight; ++j)
+        {
+            if (this->post(j))
+                return -1;
+        }
+        return 0;
+    }
+
+    // a chunk arrived, reuse its slot for the next one
+    ++m_n_recvd;
+    return this->post(i);
+}
 #endif
 
 // --------------------------------------------------------------------------
-void block_decompose(unsigned long n_indices, unsigned long n_ranks,
-    unsigned long rank, unsigned long &block_size, unsigned long &block_start,
-    bool verbose)
+void block_decompose(MPI_Comm comm, unsigned long n_indices,
+    unsigned long n_ranks, unsigned long rank, unsigned long &block_size,
+    unsigned long &block_start, bool verbose)
 {
     unsigned long n_big_blocks = n_indices%n_ranks;
     if (rank < n_big_blocks)
@@ -88,12 +251,14 @@ void block_decompose(unsigned long n_indices, unsigned long n_ranks,
             decomp.resize(2*n_ranks);
 #if defined(TECA_HAS_MPI)
             MPI_Gather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, decomp.data(),
-                2, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+                2, MPI_UNSIGNED_LONG, 0, comm);
         }
         else
         {
             MPI_Gather(decomp.data(), 2, MPI_UNSIGNED_LONG, nullptr,
-                0, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+                0, MPI_DATATYPE_NULL, 0, comm);
+#else
+            (void)comm;
 #endif
         }
         if (rank == 0)
@@ -115,8 +280,11 @@ void block_decompose(unsigned long n_indices, unsigned long n_ranks,
 
 // --------------------------------------------------------------------------
 teca_temporal_reduction::teca_temporal_reduction()
-    : first_step(0), last_step(-1)
-{}
+    : first_step(0), last_step(-1), dynamic_schedule(0), min_chunk_size(1),
+    checkpoint_interval(10)
+{
+    this->set_stream_size(2);
+}
 
 #if defined(TECA_HAS_BOOST)
 // --------------------------------------------------------------------------
@@ -132,6 +300,16 @@ void teca_temporal_reduction::get_properties_description(const std::string &pref
         TECA_POPTS_GET(long, prefix, first_step, "first time step to process (0)")
         TECA_POPTS_GET(long, prefix, last_step, "last time step to process. "
             "If set to -1 all steps are processed. (-1)")
+        TECA_POPTS_GET(int, prefix, dynamic_schedule, "when set time steps are "
+            "handed out to MPI ranks in chunks on demand, otherwise each rank "
+            "processes a contiguous block (0)")
+        TECA_POPTS_GET(long, prefix, min_chunk_size, "smallest chunk of time "
+            "steps handed out by the dynamic schedule (1)")
+        TECA_POPTS_GET(std::string, prefix, checkpoint_file, "prefix of the "
+            "files partial results are saved in. when set time steps reduced "
+            "by an earlier run are skipped (\"\")")
+        TECA_POPTS_GET(long, prefix, checkpoint_interval, "number of time "
+            "steps reduced between checkpoints (10)")
         ;
 
     global_opts.add(opts);
@@ -145,6 +323,10 @@ void teca_temporal_reduction::set_properties(const std::string &prefix,
 
     TECA_POPTS_SET(opts, long, prefix, first_step)
     TECA_POPTS_SET(opts, long, prefix, last_step)
+    TECA_POPTS_SET(opts, int, prefix, dynamic_schedule)
+    TECA_POPTS_SET(opts, long, prefix, min_chunk_size)
+    TECA_POPTS_SET(opts, std::string, prefix, checkpoint_file)
+    TECA_POPTS_SET(opts, long, prefix, checkpoint_interval)
 }
 #endif
 
@@ -169,7 +351,61 @@ std::vector<teca_metadata> teca_temporal_reduction::get_upstream_request(
     long first = ((this->first_step >= 0) && (this->first_step <= last))
         ? this->first_step : 0;
 
-    n_times = last - first + 1;
+    // skip the time steps reduced by an earlier run
+    std::vector<unsigned long> completed;
+    this->checkpoint = nullptr;
+    this->issued_steps.clear();
+    this->restored_data.clear();
+    this->unsaved_data.clear();
+    if (!this->checkpoint_file.empty())
+    {
+        this->checkpoint = teca_checkpoint::New();
+        this->checkpoint->set_file_name(this->checkpoint_file);
+        this->checkpoint->set_communicator(this->get_communicator());
+        this->checkpoint->set_interval(this->checkpoint_interval);
+
+        if (this->checkpoint->restore(completed))
+        {
+            TECA_ERROR("failed to restore the checkpoint \""
+                << this->checkpoint_file << "\"")
+            return up_req;
+        }
+    }
+
+    // the time steps to process
+    this->steps.clear();
+    for (long step = first; step <= last; ++step)
+    {
+        if (!std::binary_search(completed.begin(), completed.end(),
+            static_cast<unsigned long>(step)))
+            this->steps.push_back(step);
+    }
+
+    n_times = this->steps.size();
+
+    // optional per time step scheduling priorities
+    this->step_priority.clear();
+    input_md[0].get("time_step_priority", this->step_priority);
+
+    // get the filters basic request
+    std::vector<teca_metadata> base_req
+        = this->initialize_upstream_request(port, input_md, request);
+
+    if (this->dynamic_schedule)
+    {
+        // time steps are handed out in chunks on demand, see
+        // get_next_upstream_request
+        this->dynamic_base_req = base_req;
+
+        if (!this->scheduler)
+            this->scheduler = teca_dynamic_scheduler::New();
+
+        if (this->scheduler->initialize(this->get_communicator(),
+            n_times, this->min_chunk_size))
+            TECA_ERROR("failed to initialize the dynamic schedule")
+
+        return up_req;
+    }
 
     // partition time across MPI ranks. each rank
     // will end up with a unique block of times
@@ -182,33 +418,89 @@ std::vector<teca_metadata> teca_temporal_reduction::get_upstream_request(
     if (is_init)
     {
         int tmp = 0;
-        MPI_Comm_size(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_size(this->get_communicator(), &tmp);
         n_ranks = tmp;
-        MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_rank(this->get_communicator(), &tmp);
         rank = tmp;
     }
 #endif
     unsigned long block_size = 1;
     unsigned long block_start = 0;
 
-    internal::block_decompose(n_times, n_ranks, rank, block_size,
-        block_start, this->get_verbose());
-
-    // get the filters basic request
-    std::vector<teca_metadata> base_req
-        = this->initialize_upstream_request(port, input_md, request);
+    internal::block_decompose(this->get_communicator(), n_times,
+        n_ranks, rank, block_size, block_start, this->get_verbose());
 
     // apply the base request to local times.
     // requests are mapped onto inputs round robbin
     for (size_t i = 0; i < block_size; ++i)
     {
-        size_t step = i + block_start + first;
+        unsigned long step = this->steps[i + block_start];
         size_t n_reqs = base_req.size();
         for (size_t j = 0; j < n_reqs; ++j)
         {
             up_req.push_back(base_req[j]);
             up_req.back().insert("time_step", step);
+            this->set_priority(up_req.back(), step);
+        }
+
+        if (this->checkpoint)
+            this->issued_steps.push_back(step);
+    }
+
+    return up_req;
+}
+
+// --------------------------------------------------------------------------
+void teca_temporal_reduction::set_priority(teca_metadata &req,
+    unsigned long step) const
+{
+    if (step < this->step_priority.size())
+        req.insert("__request_priority", this->step_priority[step]);
+}
+
+// --------------------------------------------------------------------------
+std::vector<teca_metadata> teca_temporal_reduction::get_next_upstream_request(
+    unsigned int port, const std::vector<teca_metadata> &input_md,
+    const teca_metadata &request)
+{
+    (void)port;
+    (void)input_md;
+    (void)request;
+
+    std::vector<teca_metadata> up_req;
+
+    if (!this->dynamic_schedule || !this->scheduler)
+        return up_req;
+
+    // claim the next chunk of time steps. when all have been
+    // handed out an empty set of requests is returned
+    unsigned long block_start = 0;
+    unsigned long block_size = 0;
+    if (this->scheduler->get_next_chunk(block_start, block_size))
+        return up_req;
+
+    if (this->get_verbose())
+    {
+        TECA_STATUS("processing time steps "
+            << this->steps[block_start] << " - "
+            << this->steps[block_start + block_size - 1])
+    }
+
+    // apply the base request to the chunk's times.
+    // requests are mapped onto inputs round robbin
+    size_t n_reqs = this->dynamic_base_req.size();
+    for (size_t i = 0; i < block_size; ++i)
+    {
+        unsigned long step = this->steps[i + block_start];
+        for (size_t j = 0; j < n_reqs; ++j)
+        {
+            up_req.push_back(this->dynamic_base_req[j]);
+            up_req.back().insert("time_step", step);
+            this->set_priority(up_req.back(), step);
         }
+
+        if (this->checkpoint)
+            this->issued_steps.push_back(step);
     }
 
     return up_req;
@@ -239,10 +531,16 @@ const_p_teca_dataset teca_temporal_reduction::reduce_local(
     if (n_in == 1)
         return input_data[0];
 
+    // neighbors are reduced so that the datasets stay in the order
+    // that they were requested
     while (n_in > 1)
     {
         if (n_in % 2)
-            input_data[0] = this->reduce(input_data[0], input_data[n_in-1]);
+        {
+            input_data[n_in-2] = this->reduce(input_data[n_in-2],
+                input_data[n_in-1]);
+            --n_in;
+        }
 
         size_t n = n_in/2;
         for (size_t i = 0; i < n; ++i)
@@ -261,16 +559,19 @@ const_p_teca_dataset teca_temporal_reduction::reduce_remote(
     const_p_teca_dataset local_data) // pass by value is intentional
 {
 #if defined(TECA_HAS_MPI)
+    teca_trace_span span("reduce_remote", this, 0);
+
     int is_init = 0;
     MPI_Initialized(&is_init);
     if (is_init)
     {
+        MPI_Comm comm = this->get_communicator();
         size_t rank = 0;
         size_t n_ranks = 1;
         int tmp = 0;
-        MPI_Comm_size(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_size(comm, &tmp);
         n_ranks = tmp;
-        MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_rank(comm, &tmp);
         rank = tmp;
 
         // special case 1 rank, nothing to do
@@ -283,57 +584,85 @@ const_p_teca_dataset teca_temporal_reduction::reduce_remote(
         size_t left_id = 2*id;
         size_t right_id = left_id + 1;
 
-        teca_binary_stream bstr;
+        // post the receives from both children up front and reduce
+        // the data of each as it arrives, in whichever order that is
+        int n_children = 0;
+        internal::recv children[2];
+        MPI_Request reqs[2*internal::max_chunks_in_flight];
+        std::fill(reqs, reqs + 2*internal::max_chunks_in_flight,
+            MPI_REQUEST_NULL);
 
-        // recv from left
-        if (left_id <= n_ranks)
+        size_t child_ids[2] = {left_id, right_id};
+        for (int i = 0; i < 2; ++i)
         {
-            if (internal::recv(MPI_COMM_WORLD, left_id-1, bstr))
+            if ((child_ids[i] <= n_ranks) &&
+                children[i].start(comm, child_ids[i]-1,
+                    reqs + n_children*internal::max_chunks_in_flight))
             {
-                TECA_ERROR("failed to recv from left")
+                TECA_ERROR("failed to recv from child " << i)
                 return p_teca_dataset();
             }
+            n_children += child_ids[i] <= n_ranks ? 1 : 0;
+        }
 
-            p_teca_dataset left_data;
-            if (local_data && bstr)
+        int n_reqs = n_children*internal::max_chunks_in_flight;
+        int n_recvd = 0;
+        while (n_recvd < n_children)
+        {
+            int idx = MPI_UNDEFINED;
+            if (MPI_Waitany(n_reqs, reqs, &idx, MPI_STATUS_IGNORE) ||
+                (idx == MPI_UNDEFINED))
             {
-                left_data = local_data->new_instance();
-                left_data->from_stream(bstr);
+                TECA_ERROR("failed to recv from children")
+                return p_teca_dataset();
             }
 
-            local_data = this->reduce(local_data, left_data);
-
-            bstr.resize(0);
-        }
+            int child = idx/internal::max_chunks_in_flight;
+            int slot = idx%internal::max_chunks_in_flight;
 
-        // recv from right
-        if (right_id <= n_ranks)
-        {
-            if (internal::recv(MPI_COMM_WORLD, right_id-1,  bstr))
+            if (children[child].progress(slot))
             {
-                TECA_ERROR("failed to recv from right")
+                TECA_ERROR("failed to recv from child " << child)
                 return p_teca_dataset();
             }
 
-            p_teca_dataset right_data;
-            if (local_data && bstr)
+            if (children[child].complete())
             {
-                right_data = local_data->new_instance();
-                right_data->from_stream(bstr);
+                teca_binary_stream &bstr = children[child].get_stream();
+
+                // the sender may have compressed the data
+                if (bstr.decompress())
+                {
+                    TECA_ERROR("failed to decompress data from child " << child)
+                    return p_teca_dataset();
+                }
+
+                p_teca_dataset child_data;
+                if (local_data && bstr)
+                {
+                    child_data = local_data->new_instance();
+                    child_data->from_stream(bstr);
+                }
+
+                local_data = this->reduce(local_data, child_data);
+
+                bstr.resize(0);
+                ++n_recvd;
             }
-
-            local_data = this->reduce(local_data, right_data);
-
-            bstr.resize(0);
         }
 
         // send up
         if (rank)
         {
+            teca_binary_stream bstr;
+            bstr.set_gather_threshold(teca_binary_stream::default_gather_threshold);
             if (local_data)
                 local_data->to_stream(bstr);
 
-            if (internal::send(MPI_COMM_WORLD, up_id-1, bstr))
+            if (bstr.compress())
+                TECA_ERROR("failed to compress")
+
+            if (internal::send(comm, up_id-1, bstr))
                 TECA_ERROR("failed to send up")
 
             // all but root returns an empty dataset
@@ -357,5 +686,138 @@ const_p_teca_dataset teca_temporal_reduction::execute(
     // noet: it is not an error to have no input data.
     // this can occur if there are fewer time steps
     // to process than there are MPI ranks.
-    return this->reduce_remote(this->reduce_local(input_data));
+    return this->reduce_remote(
+        this->reduce_checkpoint(this->reduce_local(input_data)));
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_temporal_reduction::execute(
+    unsigned int port,
+    const std::vector<const_p_teca_dataset> &input_data,
+    const teca_metadata &request,
+    int streaming)
+{
+    (void)port;
+    (void)request;
+
+    // reduce what has arrived, the result is passed back to
+    // us with data from later time steps.
+    const_p_teca_dataset local_data = this->reduce_local(input_data);
+    if (streaming)
+        return local_data;
+
+    // this is the last call, all local data is reduced
+    return this->reduce_remote(this->reduce_checkpoint(local_data));
+}
+
+// --------------------------------------------------------------------------
+void teca_temporal_reduction::get_restored_data(
+    const const_p_teca_dataset &prototype,
+    std::vector<const_p_teca_dataset> &data)
+{
+    // deserialize once the type is known
+    std::vector<teca_binary_stream> &streams =
+        this->checkpoint->get_restored_data();
+
+    size_t n_streams = streams.size();
+    for (size_t i = 0; i < n_streams; ++i)
+    {
+        p_teca_dataset ds = this->new_reduction_dataset();
+        if (!ds && prototype)
+            ds = prototype->new_instance();
+
+        if (!ds)
+            break;
+
+        ds->from_stream(streams[i]);
+        this->restored_data.push_back(ds);
+        streams[i].clear();
+    }
+
+    if (!this->restored_data.empty())
+        streams.clear();
+
+    data.insert(data.end(), this->restored_data.begin(),
+        this->restored_data.end());
+}
+
+// --------------------------------------------------------------------------
+void teca_temporal_reduction::stream_progress(unsigned int port,
+    const std::vector<teca_metadata> &up_reqs,
+    const const_p_teca_dataset &arrived,
+    const std::vector<const_p_teca_dataset> &partials,
+    const teca_metadata &request)
+{
+    (void)port;
+    (void)partials;
+    (void)request;
+
+    if (!this->checkpoint)
+        return;
+
+    // data reduced since the last checkpoint
+    if (arrived)
+        this->unsaved_data.push_back(arrived);
+
+    bool save = false;
+    size_t n_reqs = up_reqs.size();
+    for (size_t i = 0; i < n_reqs; ++i)
+    {
+        unsigned long step = 0;
+        if (up_reqs[i].get("time_step", step) == 0)
+            save |= this->checkpoint->complete(step);
+    }
+
+    if (!save)
+        return;
+
+    // only the data reduced since the last checkpoint is written, it
+    // is appended to the checkpoint. the first checkpoint also holds
+    // the partial results restored from the earlier run.
+    std::vector<const_p_teca_dataset> data;
+    data.swap(this->unsaved_data);
+
+    if (!this->checkpoint->written())
+        this->get_restored_data(data.empty() ? nullptr : data[0], data);
+
+    teca_trace_span span("checkpoint", this, 0);
+
+    if (this->checkpoint->append(this->reduce_local(data)))
+        TECA_ERROR("failed to write the checkpoint")
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_temporal_reduction::reduce_checkpoint(
+    const_p_teca_dataset local_data) // pass by value is intentional
+{
+    if (!this->checkpoint)
+        return local_data;
+
+    // merge the partial results of the earlier run
+    std::vector<const_p_teca_dataset> data;
+    if (local_data)
+        data.push_back(local_data);
+
+    this->get_restored_data(local_data, data);
+
+    if (!this->checkpoint->get_restored_data().empty())
+    {
+        TECA_ERROR("the partial results saved in the checkpoint could not be"
+            " restored because the dataset type is unknown")
+    }
+
+    local_data = this->reduce_local(data);
+
+    // all of the time steps this rank was given are reduced
+    size_t n_steps = this->issued_steps.size();
+    for (size_t i = 0; i < n_steps; ++i)
+        this->checkpoint->complete(this->issued_steps[i]);
+
+    if (this->checkpoint->save(local_data))
+        TECA_ERROR("failed to write the checkpoint")
+
+    this->checkpoint = nullptr;
+    this->unsaved_data.clear();
+
+    return local_data;
 }
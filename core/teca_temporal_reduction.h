@@ -6,19 +6,45 @@
 
 #include "teca_threaded_algorithm.h"
 #include "teca_metadata.h"
+#include "teca_dynamic_scheduler.h"
+#include "teca_checkpoint.h"
 
 #include <vector>
+#include <string>
 
 // base class for MPI+threads temporal reduction over
 // time. the available time steps  are partitioned
-// across MPI ranks and threads. one can restrict
+// across MPI ranks and threads, either statically in
+// contiguous blocks or dynamically in chunks handed
+// out on demand. one can restrict
 // operation to a range of time steps by setting
-// first and last steps to process.
+// first and last steps to process. datasets are
+// reduced as they arrive, see stream_size in
+// teca_threaded_algorithm, which bounds the number
+// held at once. datasets that arrive early are held
+// until those requested before them arrive, thus
+// they are reduced in the order they were requested.
+// by default pairs of datasets are reduced. setting
+// stream_size to 0 reduces the datasets once all of
+// a rank's time steps have arrived.
+//
+// when a checkpoint file is set each rank periodically writes
+// its partial result along with the time steps it holds, see
+// teca_checkpoint. if the run is killed and restarted with the
+// same checkpoint file only the missing time steps are requested
+// and the saved partial results are merged into the result.
+// checkpoints are written as data arrives, every
+// checkpoint_interval time steps, with or without streaming.
 //
 // meta data keys:
 //      requires:
 //          number_of_time_steps - the number of time steps available
 //
+//      optional:
+//          time_step_priority - a scheduling priority per time step,
+//                               requests for time steps with larger
+//                               values are executed first
+//
 //      consumes:
 //          time_step
 class teca_temporal_reduction : public teca_threaded_algorithm
@@ -39,6 +65,24 @@ public:
     TECA_ALGORITHM_PROPERTY(long, first_step)
     TECA_ALGORITHM_PROPERTY(long, last_step)
 
+    // set the time step partitioning across MPI ranks. when
+    // dynamic_schedule is set chunks of time steps are handed out
+    // to ranks as they need more work, see teca_dynamic_scheduler.
+    // this balances the load when the cost of time steps varies.
+    // otherwise each rank processes a contiguous block. chunks are
+    // no smaller than min_chunk_size. the defaults are 0 and 1.
+    TECA_ALGORITHM_PROPERTY(int, dynamic_schedule)
+    TECA_ALGORITHM_PROPERTY(long, min_chunk_size)
+
+    // set the prefix of the checkpoint files. the default is empty,
+    // which disables checkpointing. remove the files to start over.
+    TECA_ALGORITHM_PROPERTY(std::string, checkpoint_file)
+
+    // set the number of time steps reduced between checkpoints.
+    // a checkpoint is also written once the local data has been
+    // reduced. the default is 10.
+    TECA_ALGORITHM_PROPERTY(long, checkpoint_interval)
+
 protected:
     teca_temporal_reduction();
 
@@ -63,6 +107,15 @@ protected:
     virtual teca_metadata initialize_output_metadata(unsigned int port,
         const std::vector<teca_metadata> &input_md) = 0;
 
+    // override that returns an empty dataset of the type produced
+    // by the reduction. this is used to restore partial results
+    // from a checkpoint. the default returns nullptr, in which case
+    // the type is taken from the upstream data, thus when every time
+    // step was completed by an earlier run the partial results can
+    // not be restored.
+    virtual p_teca_dataset new_reduction_dataset() const
+    { return nullptr; }
+
 
 protected:
 // customized pipeline behavior and parallel code.
@@ -75,6 +128,12 @@ protected:
         unsigned int port, const std::vector<teca_metadata> &input_md,
         const teca_metadata &request) override;
 
+    // hands out chunks of time steps when the dynamic schedule
+    // is used.
+    std::vector<teca_metadata> get_next_upstream_request(
+        unsigned int port, const std::vector<teca_metadata> &input_md,
+        const teca_metadata &request) override;
+
     // uses MPI communication to collect remote data for
     // required for the reduction. calls "reduce" with
     // each pair of datasets until the datasets across
@@ -84,6 +143,20 @@ protected:
         const std::vector<const_p_teca_dataset> &input_data,
         const teca_metadata &request) override;
 
+    // streaming variant of the above. datasets are reduced
+    // locally as they arrive, the MPI communication takes
+    // place during the last call.
+    const_p_teca_dataset execute(unsigned int port,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request, int streaming) override;
+
+    // records the time steps reduced and writes checkpoints.
+    void stream_progress(unsigned int port,
+        const std::vector<teca_metadata> &up_reqs,
+        const const_p_teca_dataset &arrived,
+        const std::vector<const_p_teca_dataset> &partials,
+        const teca_metadata &request) override;
+
     // consumes time metadata, partitions time's across
     // MPI ranks.
     teca_metadata get_output_metadata(unsigned int port,
@@ -97,9 +170,37 @@ private:
 
     const_p_teca_dataset reduce_remote(const_p_teca_dataset local_data);
 
+    // merges the partial results restored from the checkpoint into
+    // the local data and writes the final checkpoint.
+    const_p_teca_dataset reduce_checkpoint(const_p_teca_dataset local_data);
+
+    // appends the partial results restored from the checkpoint. the
+    // prototype gives the type of dataset when the reduction does
+    // not report it.
+    void get_restored_data(const const_p_teca_dataset &prototype,
+        std::vector<const_p_teca_dataset> &data);
+
+    // tags the request with the time step's scheduling priority
+    // when the upstream reports them.
+    void set_priority(teca_metadata &req, unsigned long step) const;
+
 private:
     long first_step;
     long last_step;
+    int dynamic_schedule;
+    long min_chunk_size;
+    std::string checkpoint_file;
+    long checkpoint_interval;
+
+    p_teca_dynamic_scheduler scheduler;
+    std::vector<teca_metadata> dynamic_base_req;
+    std::vector<unsigned long> steps;
+    std::vector<long> step_priority;
+
+    p_teca_checkpoint checkpoint;
+    std::vector<unsigned long> issued_steps;
+    std::vector<const_p_teca_dataset> restored_data;
+    std::vector<const_p_teca_dataset> unsaved_data;
 };
 
 #endif
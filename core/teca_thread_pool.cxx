@@ -5,7 +5,11 @@
 #include <utility>
 #include <cstdint>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
+#include <string>
+#include <map>
+#include <dirent.h>
 #if defined(TECA_HAS_MPI)
 #include <mpi.h>
 #endif
@@ -13,65 +17,58 @@
 
 namespace internal
 {
-#if defined(_GNU_SOURCE)
-struct closest_core
+// the MPI ranks on this node, and the cpu each one's main thread
+// runs on, as recorded by init_node_layout
+struct node_layout
 {
-    closest_core(int base_id, int n_cores)
-        : m_base_id(base_id%n_cores) {}
-
-    int operator()(int qq) const
-    { return std::abs(m_base_id-qq); }
+    node_layout() : valid(false), n_procs(1), proc_id(0) {}
 
-    int m_base_id;
+    bool valid;
+    int n_procs;
+    int proc_id;
+    std::vector<int> base_core_ids;
 };
 
-struct closest_hyperthread
+// **************************************************************************
+node_layout &get_node_layout()
 {
-    closest_hyperthread(int base_id, int n_cores)
-        : m_base_id(base_id%n_cores), m_n_cores(n_cores) {}
+    static node_layout layout;
+    return layout;
+}
 
-    int operator()(int qq) const
-    { return std::abs(m_base_id-(qq%m_n_cores)); }
+// **************************************************************************
+void init_node_layout(MPI_Comm comm)
+{
+#if defined(_GNU_SOURCE) && defined(TECA_HAS_MPI)
+    int ok = 0;
+    MPI_Initialized(&ok);
+    if (!ok)
+        return;
 
-    int m_base_id;
-    int m_n_cores;
-};
+    node_layout &layout = get_node_layout();
 
-struct least_used_hyperthread
-{
-    least_used_hyperthread(int *hyperthreads) :
-        m_hyperthreads(hyperthreads) {}
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED,
+        0, MPI_INFO_NULL, &node_comm);
 
-    int operator()(int qq) const
-    { return m_hyperthreads[qq]; }
+    MPI_Comm_size(node_comm, &layout.n_procs);
+    MPI_Comm_rank(node_comm, &layout.proc_id);
 
-    int *m_hyperthreads;
-};
+    layout.base_core_ids.resize(layout.n_procs);
+    layout.base_core_ids[layout.proc_id] = sched_getcpu();
 
-// **************************************************************************
-int select(int n_slots, int *slots, bool any_slot,
-    const std::function<int(int)> &dist_to)
-{
-    // scan for empy core, compute the distance, select the closest
-    int q = std::numeric_limits<int>::max();
-    int d = std::numeric_limits<int>::max();
-    for (int qq = 0; qq < n_slots; ++qq)
-    {
-        if (any_slot || !slots[qq])
-        {
-            // this core is empty, prefer the closest
-            int dd = dist_to(qq);
-            if (dd <= d)
-            {
-                d = dd;
-                q = qq;
-            }
-        }
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+        layout.base_core_ids.data(), 1, MPI_INT, node_comm);
 
-    }
-    return q;
+    MPI_Comm_free(&node_comm);
+
+    layout.valid = true;
+#else
+    (void)comm;
+#endif
 }
 
+#if defined(_GNU_SOURCE)
 // **************************************************************************
 int cpuid(uint64_t leaf, uint64_t level, uint64_t& ra, uint64_t& rb,
     uint64_t& rc, uint64_t& rd)
@@ -88,13 +85,160 @@ int cpuid(uint64_t leaf, uint64_t level, uint64_t& ra, uint64_t& rb,
 }
 
 // **************************************************************************
-int detect_cpu_topology(int &n_threads, int &n_threads_per_core)
+int read_value(const std::string &file_name, int &val)
+{
+    std::ifstream ifs(file_name);
+    return (ifs >> val) ? 0 : -1;
+}
+
+// **************************************************************************
+int read_list(const std::string &file_name, std::vector<int> &vals)
+{
+    // parse a list of the form 0-3,8,10-11
+    std::ifstream ifs(file_name);
+    std::string str;
+    if (!(ifs >> str))
+        return -1;
+
+    std::istringstream iss(str);
+    std::string range;
+    while (std::getline(iss, range, ','))
+    {
+        int first = 0;
+        int last = 0;
+        int n = sscanf(range.c_str(), "%d-%d", &first, &last);
+        if (n == 1)
+            last = first;
+        else if (n != 2)
+            return -1;
+
+        for (int i = first; i <= last; ++i)
+            vals.push_back(i);
+    }
+
+    return 0;
+}
+
+// **************************************************************************
+int detect_cpu_topology_sysfs(cpu_topology &topo)
 {
-    // TODO: to do this correctly we need to detect number of chips per
-    // board, and if hyperthreading has been enabled. for more info:
-    // https://software.intel.com/en-us/articles/intel-64-architecture-processor-topology-enumeration/
-    // see specifically table A3.
+    std::string cpu_dir = "/sys/devices/system/cpu/";
+
+    std::vector<int> cpus;
+    if (read_list(cpu_dir + "online", cpus) || cpus.empty())
+        return -1;
+
+    // only the cpus that this process may run on are used, the job
+    // scheduler or taskset may have restricted it to some of them
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+            [&allowed](int cpu) -> bool
+            { return (cpu >= CPU_SETSIZE) || !CPU_ISSET(cpu, &allowed); }),
+            cpus.end());
+
+        if (cpus.empty())
+            return -1;
+    }
+
+    int n_cpus = *std::max_element(cpus.begin(), cpus.end()) + 1;
+
+    std::vector<bool> cpu_used(n_cpus, false);
+    for (int cpu : cpus)
+        cpu_used[cpu] = true;
+
+    // the NUMA node of each cpu
+    std::vector<int> cpu_numa(n_cpus, 0);
+    std::map<int, int> numa_ids;
+    std::string node_dir = "/sys/devices/system/node/";
+    if (DIR *dir = opendir(node_dir.c_str()))
+    {
+        while (struct dirent *ent = readdir(dir))
+        {
+            int node = 0;
+            if (sscanf(ent->d_name, "node%d", &node) != 1)
+                continue;
+
+            std::vector<int> node_cpus;
+            if (read_list(node_dir + ent->d_name + "/cpulist", node_cpus))
+                continue;
+
+            // nodes without cpus that are used are skipped
+            for (int cpu : node_cpus)
+            {
+                if ((cpu < n_cpus) && cpu_used[cpu])
+                {
+                    cpu_numa[cpu] = node;
+                    numa_ids[node] = 0;
+                }
+            }
+        }
+        closedir(dir);
+    }
+
+    int n_numa = 0;
+    for (auto &it : numa_ids)
+        it.second = n_numa++;
+
+    // cores are identified by package and core id, L3 caches by the
+    // first cpu that shares them
+    std::map<std::pair<int,int>, int> core_ids;
+    std::map<int, int> l3_ids;
+    topo.cores.clear();
+    topo.cpu_core_id.assign(n_cpus, -1);
+    for (int cpu : cpus)
+    {
+        std::string dir = cpu_dir + "cpu" + std::to_string(cpu) + "/";
+
+        int package = 0;
+        int core = cpu;
+        read_value(dir + "topology/physical_package_id", package);
+        read_value(dir + "topology/core_id", core);
+
+        int l3 = package;
+        for (int i = 0; i < 8; ++i)
+        {
+            std::string cache_dir = dir + "cache/index" + std::to_string(i) + "/";
+            int level = 0;
+            std::vector<int> shared;
+            if (read_value(cache_dir + "level", level))
+                break;
+            if ((level == 3) && !read_list(cache_dir + "shared_cpu_list",
+                shared) && !shared.empty())
+            {
+                l3 = *std::min_element(shared.begin(), shared.end());
+                break;
+            }
+        }
+
+        auto l3_it = l3_ids.insert(std::make_pair(l3, l3_ids.size())).first;
+
+        auto core_it = core_ids.insert(std::make_pair(
+            std::make_pair(package, core), topo.cores.size())).first;
+
+        if (core_it->second == static_cast<int>(topo.cores.size()))
+        {
+            topo.cores.emplace_back();
+            topo.cores.back().l3 = l3_it->second;
+            topo.cores.back().numa = numa_ids.empty() ? 0 :
+                numa_ids[cpu_numa[cpu]];
+        }
+
+        topo.cores[core_it->second].cpus.push_back(cpu);
+        topo.cpu_core_id[cpu] = core_it->second;
+    }
+
+    topo.n_l3 = std::max<int>(l3_ids.size(), 1);
+    topo.n_numa = std::max(n_numa, 1);
+
+    return 0;
+}
 
+// **************************************************************************
+int detect_cpu_topology_cpuid(int &n_threads, int &n_threads_per_core)
+{
     // defaults should cpuid fail on this platform. hyperthreads are
     // treated as cores. this will lead to poor performance but without
     // cpuid we can't distinguish physical cores from hyperthreads.
@@ -126,10 +270,115 @@ int detect_cpu_topology(int &n_threads, int &n_threads_per_core)
 }
 
 // **************************************************************************
-int generate_report(bool local, int local_proc, int base_id,
-    const std::deque<int> &afin)
+int detect_cpu_topology(cpu_topology &topo)
+{
+    if (detect_cpu_topology_sysfs(topo) == 0)
+        return 0;
+
+    // fall back to cpuid. the hyperthreads of core q are numbered
+    // q + p*n_cores, there is one L3 and one NUMA node.
+    int threads_per_chip = 1;
+    int threads_per_core = 1;
+    int ierr = detect_cpu_topology_cpuid(threads_per_chip, threads_per_core);
+
+    int n_cpus = std::max(1u, std::thread::hardware_concurrency());
+    threads_per_core = std::max(1, threads_per_core);
+    int n_cores = std::max(1, n_cpus/threads_per_core);
+
+    topo.cores.assign(n_cores, cpu_core());
+    topo.cpu_core_id.assign(n_cpus, -1);
+    for (int cpu = 0; cpu < n_cpus; ++cpu)
+    {
+        int q = cpu % n_cores;
+        topo.cores[q].cpus.push_back(cpu);
+        topo.cpu_core_id[cpu] = q;
+    }
+    topo.n_l3 = 1;
+    topo.n_numa = 1;
+
+    return ierr;
+}
+
+// **************************************************************************
+void get_core_order(const cpu_topology &topo, int base_cpu, bool spread,
+    std::vector<int> &order)
+{
+    order.clear();
+
+    int n_cores = topo.cores.size();
+    int base_core = ((base_cpu >= 0) &&
+        (base_cpu < static_cast<int>(topo.cpu_core_id.size()))) ?
+            std::max(0, topo.cpu_core_id[base_cpu]) : 0;
+
+    // within each NUMA node deal the cores out round robin across the
+    // L3 caches, starting with the cache of the base core
+    int n_numa = topo.n_numa;
+    int n_l3 = topo.n_l3;
+    std::vector<std::vector<int>> numa_cores(n_numa);
+    std::vector<std::vector<std::vector<int>>> l3_cores(n_numa,
+        std::vector<std::vector<int>>(n_l3));
+
+    int base_l3 = n_cores ? topo.cores[base_core].l3 : 0;
+    for (int i = 0; i < n_cores; ++i)
+    {
+        const cpu_core &core = topo.cores[i];
+        l3_cores[core.numa][(core.l3 - base_l3 + n_l3) % n_l3].push_back(i);
+    }
+
+    for (int k = 0; k < n_numa; ++k)
+    {
+        std::vector<std::vector<int>> &groups = l3_cores[k];
+        bool more = true;
+        for (size_t j = 0; more; ++j)
+        {
+            more = false;
+            for (int i = 0; i < n_l3; ++i)
+            {
+                if (j < groups[i].size())
+                {
+                    numa_cores[k].push_back(groups[i][j]);
+                    more = true;
+                }
+            }
+        }
+    }
+
+    // the NUMA nodes starting with that of the base core, either one
+    // after the other or interleaved
+    int base_numa = n_cores ? topo.cores[base_core].numa : 0;
+    if (spread)
+    {
+        bool more = true;
+        for (size_t j = 0; more; ++j)
+        {
+            more = false;
+            for (int i = 0; i < n_numa; ++i)
+            {
+                std::vector<int> &cores = numa_cores[(base_numa + i) % n_numa];
+                if (j < cores.size())
+                {
+                    order.push_back(cores[j]);
+                    more = true;
+                }
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n_numa; ++i)
+        {
+            std::vector<int> &cores = numa_cores[(base_numa + i) % n_numa];
+            order.insert(order.end(), cores.begin(), cores.end());
+        }
+    }
+}
+
+// **************************************************************************
+int generate_report(MPI_Comm comm, bool local, int local_proc,
+    int base_id, const std::deque<int> &afin)
 {
 #if !defined(TECA_HAS_MPI)
+    (void)comm;
     (void)local;
 #endif
     int rank = 0;
@@ -137,8 +386,8 @@ int generate_report(bool local, int local_proc, int base_id,
 #if defined(TECA_HAS_MPI)
     if (!local)
     {
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-        MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &n_ranks);
     }
 #endif
 
@@ -152,13 +401,13 @@ int generate_report(bool local, int local_proc, int base_id,
         if (!local)
         {
             MPI_Gather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, local_procs.data(),
-                1, MPI_INT, 0, MPI_COMM_WORLD);
+                1, MPI_INT, 0, comm);
         }
     }
     else if (!local)
     {
         MPI_Gather(&local_proc, 1, MPI_INT, nullptr,
-            0, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+            0, MPI_DATATYPE_NULL, 0, comm);
 #endif
     }
 
@@ -172,13 +421,13 @@ int generate_report(bool local, int local_proc, int base_id,
         if (!local)
         {
             MPI_Gather(MPI_IN_PLACE, 1, MPI_INT, base_ids.data(),
-                1, MPI_INT, 0, MPI_COMM_WORLD);
+                1, MPI_INT, 0, comm);
         }
     }
     else if (!local)
     {
         MPI_Gather(&base_id, 1, MPI_INT, nullptr,
-            0, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+            0, MPI_DATATYPE_NULL, 0, comm);
 #endif
     }
 
@@ -194,7 +443,7 @@ int generate_report(bool local, int local_proc, int base_id,
         if (!local)
         {
             MPI_Gather(MPI_IN_PLACE, 64, MPI_BYTE, hosts.data(),
-                64, MPI_BYTE, 0, MPI_COMM_WORLD);
+                64, MPI_BYTE, 0, comm);
         }
     }
     else if (!local)
@@ -203,7 +452,7 @@ int generate_report(bool local, int local_proc, int base_id,
         gethostname(host, 64);
         host[63] = '\0';
         MPI_Gather(host, 64, MPI_BYTE, nullptr,
-            0, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+            0, MPI_DATATYPE_NULL, 0, comm);
 #endif
     }
 
@@ -217,14 +466,14 @@ int generate_report(bool local, int local_proc, int base_id,
         if (!local)
         {
             MPI_Gather(MPI_IN_PLACE, 1, MPI_INT, recv_cnt.data(),
-                1, MPI_INT, 0, MPI_COMM_WORLD);
+                1, MPI_INT, 0, comm);
         }
     }
     else if (!local)
     {
         int cnt = afin.size();
         MPI_Gather(&cnt, 1, MPI_INT, nullptr,
-            0, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+            0, MPI_DATATYPE_NULL, 0, comm);
 #endif
     }
 
@@ -246,14 +495,14 @@ int generate_report(bool local, int local_proc, int base_id,
         if (!local)
         {
             MPI_Gatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, afins.data(),
-                recv_cnt.data(), displ.data(), MPI_INT, 0, MPI_COMM_WORLD);
+                recv_cnt.data(), displ.data(), MPI_INT, 0, comm);
         }
     }
     else if (!local)
     {
         afins.assign(afin.begin(), afin.end());
         MPI_Gatherv(afins.data(), afins.size(), MPI_INT, nullptr,
-            nullptr, nullptr, MPI_DATATYPE_NULL, 0, MPI_COMM_WORLD);
+            nullptr, nullptr, MPI_DATATYPE_NULL, 0, comm);
 #endif
     }
 
@@ -279,8 +528,8 @@ int generate_report(bool local, int local_proc, int base_id,
 }
 
 // **************************************************************************
-int thread_parameters(int base_core_id, int n_req, bool local,
-    bool bind, bool verbose, std::deque<int> &affinity)
+int thread_parameters(MPI_Comm comm, int base_core_id, int n_req,
+    bool local, bool bind, bool verbose, std::deque<int> &affinity)
 {
     std::vector<int> base_core_ids;
 
@@ -290,42 +539,62 @@ int thread_parameters(int base_core_id, int n_req, bool local,
     int n_procs = 1;
     int proc_id = 0;
 
+    // set when the ranks were recorded at start up, in that case
+    // there is no communication
+    bool recorded = false;
+
     if (local)
     {
         base_core_ids.push_back(base_core_id);
     }
+    else if (get_node_layout().valid)
+    {
+        const node_layout &layout = get_node_layout();
+        n_procs = layout.n_procs;
+        proc_id = layout.proc_id;
+        base_core_ids = layout.base_core_ids;
+        base_core_id = base_core_ids[proc_id];
+        recorded = true;
+    }
     else
     {
 #if defined(TECA_HAS_MPI)
-        MPI_Comm comm;
-        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED,
-            0, MPI_INFO_NULL, &comm);
+        MPI_Comm node_comm;
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED,
+            0, MPI_INFO_NULL, &node_comm);
 
-        MPI_Comm_size(comm, &n_procs);
-        MPI_Comm_rank(comm, &proc_id);
+        MPI_Comm_size(node_comm, &n_procs);
+        MPI_Comm_rank(node_comm, &proc_id);
 
         base_core_ids.resize(n_procs);
         base_core_ids[proc_id] = base_core_id;
 
         MPI_Allgather(MPI_IN_PLACE,0,MPI_DATATYPE_NULL,
-            base_core_ids.data(), 1, MPI_UNSIGNED, comm);
+            base_core_ids.data(), 1, MPI_UNSIGNED, node_comm);
 
-        MPI_Comm_free(&comm);
+        MPI_Comm_free(&node_comm);
 #else
+        (void)comm;
         base_core_ids.push_back(base_core_id);
 #endif
     }
 
-    // get the number of cores on this cpu
-    int threads_per_chip = 1;
-    int hw_threads_per_core = 1;
-    if (internal::detect_cpu_topology(threads_per_chip, hw_threads_per_core))
+    // get the number of cores on this node
+    cpu_topology topo;
+    if (internal::detect_cpu_topology(topo))
     {
         TECA_WARNING("failed to detect cpu topology. Assuming "
-            << threads_per_chip/hw_threads_per_core << " physical cores.")
+            << topo.cores.size() << " physical cores.")
+    }
+    int threads_per_node = topo.cpu_core_id.size();
+    int cores_per_node = topo.cores.size();
+
+    if (verbose)
+    {
+        TECA_STATUS("cpu topology: " << threads_per_node << " threads "
+            << cores_per_node << " cores " << topo.n_l3 << " L3 caches "
+            << topo.n_numa << " NUMA nodes")
     }
-    int threads_per_node = std::thread::hardware_concurrency();
-    int cores_per_node = threads_per_node/hw_threads_per_core;
 
     // thread pool size is based on core and process count
     int nlg = 0;
@@ -350,17 +619,15 @@ int thread_parameters(int base_core_id, int n_req, bool local,
         return n_threads;
     }
 
-    // track which threads/cores are in use
-    // using two maps, the first track use of cores, the second hyperthreads
-    // the hyper thread map is 2d with core id on first dim and hyperthread id
-    // on the second.
-    long map_bytes = threads_per_node*sizeof(int);
-    int *thread_use = static_cast<int*>(malloc(map_bytes));
-    memset(thread_use, 0, map_bytes);
+    // track which cores and hyperthreads are in use
+    std::vector<int> core_use(cores_per_node, 0);
+    std::vector<int> thread_use(threads_per_node, 0);
 
-    map_bytes = cores_per_node*sizeof(int);
-    int *core_use = static_cast<int*>(malloc(map_bytes));
-    memset(core_use, 0, map_bytes);
+    auto core_of = [&topo, threads_per_node](int cpu) -> int
+    {
+        return (cpu >= 0) && (cpu < threads_per_node) ?
+            topo.cpu_core_id[cpu] : -1;
+    };
 
     // there are enough cores that each thread can have it's own core
     // mark the cores which have the root thread as used so that we skip them.
@@ -371,74 +638,89 @@ int thread_parameters(int base_core_id, int n_req, bool local,
         for (int i = 0; i < n_procs; ++i)
         {
             int bcid = base_core_ids[i];
-            core_use[bcid%cores_per_node] = 1;
-            thread_use[bcid] = 1;
+            int q = core_of(bcid);
+            if (q >= 0)
+            {
+                core_use[q] = 1;
+                thread_use[bcid] = 1;
+            }
         }
     }
 
+    // when there are fewer processes than NUMA nodes each process
+    // spreads its threads across the nodes to make use of all of the
+    // memory bandwidth. otherwise the threads stay on the node of the
+    // process' main thread.
+    bool spread = n_procs < topo.n_numa;
+
     // mark resources used by other processes, up to and including this process.
     // also record the core ids we will bind to.
+    std::vector<int> order;
     for (int i = 0; i <= proc_id; ++i)
     {
-        int proc_base = base_core_ids[i];
+        get_core_order(topo, base_core_ids[i], spread, order);
+
         int proc_n_threads = n_req > 0 ? n_req : cores_per_node/n_procs + (i < nlg ? 1 : 0);
         for (int j = 0; j < proc_n_threads; ++j)
         {
-            // scan for empty core
-            int q = select(cores_per_node, core_use, false,
-                closest_core(proc_base, cores_per_node));
-
-            if (q < cores_per_node)
+            // the first empty core in this process' order
+            int cpu = -1;
+            for (int q : order)
             {
-                // found one, mark core as used
-                core_use[q] = 1;
-
-                // now find an empty hyperthread on this core and
-                // mark it as taken. if this is for us record the id
-                // for later use
-                int p = 0;
-                while (thread_use[q+p*cores_per_node] && (p < hw_threads_per_core)) ++p;
+                if (!core_use[q])
+                {
+                    // found one, mark core as used and take an empty
+                    // hyperthread on it
+                    core_use[q] = 1;
+                    const std::vector<int> &cpus = topo.cores[q].cpus;
+                    cpu = cpus[0];
+                    for (int c : cpus)
+                    {
+                        if (!thread_use[c])
+                        {
+                            cpu = c;
+                            break;
+                        }
+                    }
+                    break;
+                }
+            }
 
-                int pp = q+p*cores_per_node;
+            // if we are here it means all the cores have at least one
+            // hyperthread assigned. find the first empty hyperthread,
+            // if that fails then find the least used hyperthread.
+            if (cpu < 0)
+            {
+                int min_use = std::numeric_limits<int>::max();
+                for (int q : order)
+                {
+                    for (int c : topo.cores[q].cpus)
+                    {
+                        if (thread_use[c] < min_use)
+                        {
+                            min_use = thread_use[c];
+                            cpu = c;
+                        }
+                    }
+                    if (min_use == 0)
+                        break;
+                }
+            }
 
-                // mark hyperthread as used
-                thread_use[pp] = 1;
+            if (cpu >= 0)
+            {
+                thread_use[cpu] += 1;
 
                 // store the core id we will bind one of our threads to it
                 if (i == proc_id)
-                    affinity.push_back(pp);
-            }
-            else
-            {
-                // if we are here it means all the cores have at least one
-                // hyperthread assigned. find the first empty hyperthread on
-                // any core. if that fails then find the least used hyperthread.
-                // if this for us record the id for later use
-                int q = select(threads_per_node, thread_use, false,
-                    closest_hyperthread(proc_base, cores_per_node));
-
-                if (q >= threads_per_node)
-                    q = select(threads_per_node, thread_use, true,
-                        least_used_hyperthread(thread_use));
-
-                if (q < threads_per_node)
-                {
-                    // found one. increment usage
-                    thread_use[q] += 1;
-
-                    // store the core id we will bind one of our threads to it
-                    if (i == proc_id)
-                        affinity.push_back(q);
-                }
+                    affinity.push_back(cpu);
             }
         }
     }
 
-    free(core_use);
-    free(thread_use);
-
     if (verbose)
-        generate_report(local, proc_id, base_core_id, affinity);
+        generate_report(comm, local || recorded, proc_id,
+            base_core_id, affinity);
 
     return n_threads;
 }
@@ -2,6 +2,7 @@
 #define teca_thread_pool_h
 
 #include "teca_common.h"
+#include "teca_mpi.h"
 #include "teca_algorithm_fwd.h"
 #include "teca_threadsafe_queue.h"
 
@@ -10,20 +11,70 @@
 #include <atomic>
 #include <mutex>
 #include <future>
+#include <chrono>
+#include <memory>
+#include <limits>
+#include <condition_variable>
 #include <algorithm>
+#include <map>
+#include <functional>
 #if defined(_GNU_SOURCE)
 #include <pthread.h>
 #include <sched.h>
 #include <deque>
-#if defined(TECA_HAS_MPI)
-#include <mpi.h>
-#endif
 #endif
 
 namespace internal
 {
-int thread_parameters(int base_core_id, int n_req, bool local,
-    bool bind, bool verbose, std::deque<int> &affinity);
+// the hardware threads of a physical core, and the L3 cache (the CCX
+// on AMD) and NUMA node the core belongs to
+struct cpu_core
+{
+    cpu_core() : l3(0), numa(0) {}
+
+    std::vector<int> cpus;
+    int l3;
+    int numa;
+};
+
+// the cores of a node
+struct cpu_topology
+{
+    cpu_topology() : n_l3(1), n_numa(1) {}
+
+    std::vector<cpu_core> cores;
+    std::vector<int> cpu_core_id; // the core of each logical cpu, or -1
+    int n_l3;
+    int n_numa;
+};
+
+// detect the node's topology from /sys/devices/system/cpu and
+// /sys/devices/system/node. when these are not available cpuid is
+// used, which only works on Intel processors, failing that each
+// logical cpu is treated as a core. returns 0 if the topology was
+// detected.
+int detect_cpu_topology(cpu_topology &topo);
+
+// get the order in which a process whose main thread runs on base_cpu
+// claims cores. the cores of the NUMA node of base_cpu come first,
+// then those of the other nodes. when spread is set consecutive cores
+// are taken from different nodes instead. within a node consecutive
+// cores are taken from different L3 caches.
+void get_core_order(const cpu_topology &topo, int base_cpu, bool spread,
+    std::vector<int> &order);
+
+// record the MPI ranks of comm on this node and the cpu their main
+// threads run on. this is collective over comm. teca_mpi_manager
+// calls it once after MPI is initialized so that thread pools created
+// later need not communicate.
+void init_node_layout(MPI_Comm comm);
+
+// determine the number of threads and the cpu each is bound to. when
+// local is false the ranks on the same node share the cores. the
+// ranks recorded by init_node_layout are used when it has been
+// called, otherwise this is collective over comm.
+int thread_parameters(MPI_Comm comm, int base_core_id, int n_req,
+    bool local, bool bind, bool verbose, std::deque<int> &affinity);
 }
 
 template <typename task_t, typename data_t>
@@ -32,8 +83,21 @@ class teca_thread_pool;
 template <typename task_t, typename data_t>
 using p_teca_thread_pool = std::shared_ptr<teca_thread_pool<task_t, data_t>>;
 
-// a class to manage a fixed size pool of threads that dispatch
-// I/O work
+// a class to manage a pool of threads that dispatch I/O work. each
+// thread owns a work queue, tasks are distributed round robin across
+// the queues, and a thread whose queue is empty steals work from the
+// others. when there is no work anywhere threads park on a condition
+// variable so that an idle pool does not consume CPU cycles needed by
+// MPI, I/O, or other processes on the node. the pool may be resized
+// at run time, existing threads are kept when the pool grows and only
+// the surplus threads are retired when it shrinks. a thread waiting
+// on its requests executes queued tasks until they are ready, so that
+// nested use of the pool neither deadlocks nor leaves cores idle.
+// tasks may be given a priority. tasks with a positive priority run
+// before the others, those with a negative priority after, in order
+// of decreasing priority and in the order they were pushed when
+// priorities are equal. tasks without a priority take the work
+// stealing path, which does not order them strictly.
 template <typename task_t, typename data_t>
 class teca_thread_pool
 {
@@ -42,66 +106,172 @@ public:
 
     // construct/destruct the thread pool.
     // arguments:
+    //   comm     the communicator whose ranks share the nodes' cores
+    //
     //   n        number of threads to create for the pool. -1 will
     //            create 1 thread per physical CPU core. If local is false
-    //            all MPI ranks running on the same node are taken into
-    //            account, resulting in 1 thread per core node wide.
+    //            all MPI ranks of comm running on the same node are
+    //            taken into account, resulting in 1 thread per core node
+    //            wide.
     //
-    //   local    consider other MPI ranks on the node. This introduces
-    //            MPI collective operations, so all ranks in comm world
-    //            must call it.
+    //   local    when false consider other MPI ranks on the node. This
+    //            introduces MPI collective operations over comm, unless
+    //            the node layout was recorded by teca_mpi_manager, in
+    //            which case the recorded ranks are used instead.
     //
     //   bind     bind each thread to a specific core.
     //
     //   verbose  print a report of the thread to core bindings
-    teca_thread_pool(int n, bool local, bool bind, bool verbose);
+    teca_thread_pool(MPI_Comm comm, int n, bool local, bool bind,
+        bool verbose);
     ~teca_thread_pool() noexcept;
 
     // get rid of copy and asignment
     TECA_ALGORITHM_DELETE_COPY_ASSIGN(teca_thread_pool)
 
+    // change the number of threads in the pool. the arguments have
+    // the same meaning as in the constructor. threads that already
+    // exist keep running, when growing new threads are added, when
+    // shrinking the surplus threads exit once their current task
+    // completes. this is collective over comm when local is false.
+    void resize(MPI_Comm comm, int n, bool local, bool bind, bool verbose);
+
     // add a data request task to the queue, returns a future
-    // from which the generated dataset can be accessed.
-    void push_task(task_t &task);
+    // from which the generated dataset can be accessed. see the
+    // class description for the meaning of priority.
+    std::future<data_t> push_task(task_t &task, long priority = 0);
 
     // wait for all of the requests to execute and transfer
-    // datasets in the order that corresponding requests
-    // were added to the queue.
+    // datasets in the order that corresponding futures
+    // were passed in. while waiting the calling thread
+    // executes queued tasks.
     template <template <typename ... > class container_t, typename ... args>
-    void wait_data(container_t<data_t, args ...> &data);
+    void wait_data(std::vector<std::future<data_t>> &futures,
+        container_t<data_t, args ...> &data);
+
+    // wait for the future to become ready. while waiting the calling
+    // thread executes queued tasks. run_deferred is a callable
+    // returning bool. it is given the first chance to make progress,
+    // and may directly execute work backing the future that has been
+    // held back from the pool. it returns true if it did so.
+    template <typename deferred_t>
+    void wait(std::future<data_t> &f, deferred_t run_deferred);
+
+    // as above but waits until the callable ready returns true.
+    // ready is evaluated each time a task completes.
+    template <typename ready_t, typename deferred_t>
+    void wait_until(ready_t ready, deferred_t run_deferred);
+
+    // wake the threads waiting in wait_until so that they test
+    // their condition. for use when the condition is changed by
+    // something other than the completion of a pool task.
+    void notify();
 
     // get the number of threads
     unsigned int size() const noexcept
-    { return m_threads.size(); }
+    { return m_n_threads.load(); }
+
+    // returns true if the calling thread is one of this
+    // pool's threads
+    bool is_pool_thread() const noexcept
+    { return t_pool == this; }
 
 private:
-    // create n threads for the pool
-    void create_threads(int n_threads, bool local, bool bind, bool verbose);
+    // start threads first through last-1 binding them to
+    // the given cores
+    void create_threads(int first, int last, bool bind,
+        std::deque<int> &core_ids);
+
+    // get the next task for the thread with the given id. tasks
+    // with a positive priority are taken first, then the thread's
+    // own queue is checked, if it is empty the other queues are
+    // searched, and finally tasks with a negative priority are
+    // taken. returns false if no work was found.
+    bool pop_task(unsigned int id, task_t &task);
+
+    // take the task with the highest priority if that priority is
+    // at least min_priority. returns false if there is none.
+    bool pop_priority_task(long min_priority, task_t &task);
+
+    // block the calling thread until there is work, the thread
+    // is retired, or the pool is shutting down.
+    void park(unsigned int id);
+
+    // execute the task and wake threads waiting on results
+    void run_task(task_t &task);
+
+    // returns true if the thread with the given id should keep
+    // running
+    bool active(unsigned int id) const noexcept
+    { return m_live.load() && (id < m_n_threads.load()); }
 
 private:
     std::atomic<bool> m_live;
-    teca_threadsafe_queue<task_t> m_queue;
+    std::atomic<unsigned int> m_n_threads;
+    std::atomic<unsigned int> m_next_queue;
+    std::atomic<unsigned int> m_n_queues_used;
+    std::atomic<long> m_queued;
+    long m_waiting;
+    std::mutex m_park_mutex;
+    std::condition_variable m_park;
+    std::mutex m_resize_mutex;
 
-    std::vector<std::future<data_t>>
-        m_futures;
+    // queues are allocated once so that threads may safely scan
+    // them for work while the pool is resized. only the first
+    // m_n_queues_used, the largest size the pool has had, have
+    // ever been given work, the steal scan is limited to these.
+    std::vector<std::unique_ptr<teca_threadsafe_queue<task_t>>>
+        m_queues;
 
     std::vector<std::thread> m_threads;
+
+    // tasks with a priority, keyed by the priority. tasks with equal
+    // priority are kept in the order they were pushed.
+    std::multimap<long, task_t, std::greater<long>> m_priority_tasks;
+    std::mutex m_priority_mutex;
+    std::atomic<long> m_n_priority_tasks;
+
+    static thread_local teca_thread_pool<task_t, data_t> *t_pool;
+    static thread_local unsigned int t_id;
 };
 
 // --------------------------------------------------------------------------
 template <typename task_t, typename data_t>
-teca_thread_pool<task_t, data_t>::teca_thread_pool(int n, bool local,
-    bool bind, bool verbose) : m_live(true)
+thread_local teca_thread_pool<task_t, data_t>
+    *teca_thread_pool<task_t, data_t>::t_pool = nullptr;
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+thread_local unsigned int teca_thread_pool<task_t, data_t>::t_id = 0;
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+teca_thread_pool<task_t, data_t>::teca_thread_pool(MPI_Comm comm, int n,
+    bool local, bool bind, bool verbose) : m_live(true), m_n_threads(0),
+    m_next_queue(0), m_n_queues_used(0), m_queued(0), m_waiting(0),
+    m_n_priority_tasks(0)
 {
-    this->create_threads(n, local, bind, verbose);
+    // reserve queues for the largest pool we expect to manage.
+    // a pool may be grown up to this size without disturbing
+    // the threads that are running.
+    unsigned int n_queues = std::max(4u*std::thread::hardware_concurrency(),
+        n > 0 ? static_cast<unsigned int>(n) : 1u);
+
+    for (unsigned int i = 0; i < n_queues; ++i)
+        m_queues.emplace_back(new teca_threadsafe_queue<task_t>);
+
+    this->resize(comm, n, local, bind, verbose);
 }
 
 // --------------------------------------------------------------------------
 template <typename task_t, typename data_t>
-void teca_thread_pool<task_t, data_t>::create_threads(int n, bool local,
-    bool bind, bool verbose)
+void teca_thread_pool<task_t, data_t>::resize(MPI_Comm comm, int n,
+    bool local, bool bind, bool verbose)
 {
+    std::lock_guard<std::mutex> lock(m_resize_mutex);
+
 #if !defined(_GNU_SOURCE)
+    (void)comm;
     (void)bind;
     (void)verbose;
     (void)local;
@@ -112,46 +282,115 @@ void teca_thread_pool<task_t, data_t>::create_threads(int n, bool local,
         n = 1;
     }
     int n_threads = n;
+    std::deque<int> core_ids;
 #else
     int base_core_id = sched_getcpu();
     std::deque<int> core_ids;
     int n_threads = internal::thread_parameters
-        (base_core_id, n, local, bind, verbose, core_ids);
+        (comm, base_core_id, n, local, bind, verbose, core_ids);
 #endif
 
-    // allocate the threads
-    for (int i = 0; i < n_threads; ++i)
+    // there must be at least one thread to service the queues. this
+    // can occur when there are more MPI ranks on the node than cores
+    int n_max = m_queues.size();
+    if (n_threads > n_max)
+    {
+        TECA_WARNING("thread pool size limited to " << n_max << " threads")
+    }
+    n_threads = std::min(std::max(n_threads, 1), n_max);
+
+    int n_cur = m_threads.size();
+    if (n_threads > n_cur)
+    {
+        // grow. the new threads take the bindings not in use by the
+        // existing threads
+        for (int i = 0; (i < n_cur) && !core_ids.empty(); ++i)
+            core_ids.pop_front();
+
+        if (static_cast<unsigned int>(n_threads) > m_n_queues_used.load())
+            m_n_queues_used = n_threads;
+
+        m_n_threads = n_threads;
+        this->create_threads(n_cur, n_threads, bind, core_ids);
+    }
+    else if (n_threads < n_cur)
     {
-        m_threads.push_back(std::thread([this]()
+        // shrink. the surplus threads exit when they see the new
+        // size. any work left in their queues will be stolen by
+        // the remaining threads.
         {
-            // "main" for each thread in the pool
-            while (m_live.load())
-            {
-                task_t task;
-                if (m_queue.try_pop(task))
-                    task();
-                else
-                    std::this_thread::yield();
-            }
-        }));
+        std::lock_guard<std::mutex> lock(m_park_mutex);
+        m_n_threads = n_threads;
+        }
+        m_park.notify_all();
+
+        for (int i = n_threads; i < n_cur; ++i)
+            m_threads[i].join();
+
+        m_threads.resize(n_threads);
+
+        // wake the remaining threads so that orphaned tasks are found
+        m_park.notify_all();
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+void teca_thread_pool<task_t, data_t>::create_threads(int first, int last,
+    bool bind, std::deque<int> &core_ids)
+{
+#if !defined(_GNU_SOURCE)
+    (void)bind;
+    (void)core_ids;
+#endif
+    // allocate the threads
+    for (int i = first; i < last; ++i)
+    {
+        int core_id = -1;
 #if defined(_GNU_SOURCE)
-        // bind each to a hyperthread
-        if (bind)
+        if (bind && !core_ids.empty())
         {
-            int core_id = core_ids.front();
+            core_id = core_ids.front();
             core_ids.pop_front();
+        }
+#endif
+        m_threads.push_back(std::thread([this, i, core_id]()
+        {
+#if defined(_GNU_SOURCE)
+            // bind to a hyperthread before doing anything else, such
+            // that the memory this thread touches first, including
+            // the data generated by the tasks it runs, is placed on
+            // its NUMA node
+            if (core_id >= 0)
+            {
+                cpu_set_t core_mask;
+                CPU_ZERO(&core_mask);
+                CPU_SET(core_id, &core_mask);
 
-            cpu_set_t core_mask;
-            CPU_ZERO(&core_mask);
-            CPU_SET(core_id, &core_mask);
+                if (pthread_setaffinity_np(pthread_self(),
+                    sizeof(cpu_set_t), &core_mask))
+                {
+                    TECA_WARNING("Failed to set thread affinity.")
+                }
+            }
+#else
+            (void)core_id;
+#endif
+            t_pool = this;
+            t_id = i;
 
-            if (pthread_setaffinity_np(m_threads[i].native_handle(),
-                sizeof(cpu_set_t), &core_mask))
+            // "main" for each thread in the pool
+            while (this->active(i))
             {
-                TECA_WARNING("Failed to set thread affinity.")
+                task_t task;
+                if (this->pop_task(i, task))
+                    this->run_task(task);
+                else
+                    this->park(i);
             }
-        }
-#endif
+
+            t_pool = nullptr;
+        }));
     }
 }
 
@@ -159,32 +398,199 @@ void teca_thread_pool<task_t, data_t>::create_threads(int n, bool local,
 template <typename task_t, typename data_t>
 teca_thread_pool<task_t, data_t>::~teca_thread_pool() noexcept
 {
+    {
+    std::lock_guard<std::mutex> lock(m_park_mutex);
     m_live = false;
+    }
+    m_park.notify_all();
+
     std::for_each(m_threads.begin(), m_threads.end(),
         [](std::thread &t) { t.join(); });
 }
 
 // --------------------------------------------------------------------------
 template <typename task_t, typename data_t>
-void teca_thread_pool<task_t, data_t>::push_task(task_t &task)
+bool teca_thread_pool<task_t, data_t>::pop_task(unsigned int id, task_t &task)
+{
+    // urgent work first
+    if (this->pop_priority_task(1, task))
+        return true;
+
+    // the thread's own queue is served in FIFO order
+    if (m_queues[id]->try_pop(task))
+    {
+        --m_queued;
+        return true;
+    }
+
+    // steal from the others. queues past the high water mark
+    // have never been pushed to and are skipped
+    unsigned int n_queues = m_n_queues_used.load();
+    for (unsigned int i = 1; i <= n_queues; ++i)
+    {
+        unsigned int q = (id + i) % n_queues;
+        if ((q != id) && m_queues[q]->try_steal(task))
+        {
+            --m_queued;
+            return true;
+        }
+    }
+
+    // work that may be deferred
+    return this->pop_priority_task(std::numeric_limits<long>::min(), task);
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+bool teca_thread_pool<task_t, data_t>::pop_priority_task(long min_priority,
+    task_t &task)
+{
+    // the count is tested first so that the lock is not taken
+    // when priorities are not in use
+    if (m_n_priority_tasks.load() < 1)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_priority_mutex);
+    if (m_priority_tasks.empty() ||
+        (m_priority_tasks.begin()->first < min_priority))
+        return false;
+
+    auto it = m_priority_tasks.begin();
+    task = std::move(it->second);
+    m_priority_tasks.erase(it);
+
+    --m_n_priority_tasks;
+    --m_queued;
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+void teca_thread_pool<task_t, data_t>::park(unsigned int id)
+{
+    std::unique_lock<std::mutex> lock(m_park_mutex);
+    m_park.wait(lock, [this, id]() { return !this->active(id) || (m_queued > 0); });
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+void teca_thread_pool<task_t, data_t>::run_task(task_t &task)
 {
-    m_futures.push_back(task.get_future());
-    m_queue.push(std::move(task));
+    task();
+
+    // the result is ready, wake any threads waiting on it. the
+    // lock orders this with a waiter testing its future.
+    std::lock_guard<std::mutex> lock(m_park_mutex);
+    if (m_waiting)
+        m_park.notify_all();
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+void teca_thread_pool<task_t, data_t>::notify()
+{
+    std::lock_guard<std::mutex> lock(m_park_mutex);
+    if (m_waiting)
+        m_park.notify_all();
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+template <typename deferred_t>
+void teca_thread_pool<task_t, data_t>::wait(std::future<data_t> &f,
+    deferred_t run_deferred)
+{
+    this->wait_until([&f]() -> bool
+        { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+        run_deferred);
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+template <typename ready_t, typename deferred_t>
+void teca_thread_pool<task_t, data_t>::wait_until(ready_t ready,
+    deferred_t run_deferred)
+{
+    // threads outside of the pool start their search for work
+    // at the next queue in the round robin order
+    unsigned int id = this->is_pool_thread() ? t_id :
+        m_next_queue.load() % m_queues.size();
+
+    while (!ready())
+    {
+        // prefer the work being waited on, this keeps the stack
+        // shallow and can't be blocked by work suspended below us
+        if (run_deferred())
+            continue;
+
+        // help with whatever is queued
+        task_t task;
+        if (this->pop_task(id, task))
+        {
+            this->run_task(task);
+            continue;
+        }
+
+        // nothing to do. sleep until a task completes or
+        // new work arrives
+        std::unique_lock<std::mutex> lock(m_park_mutex);
+        ++m_waiting;
+        m_park.wait(lock, [this, &ready]()
+            { return !m_live || (m_queued > 0) || ready(); });
+        --m_waiting;
+    }
+}
+
+// --------------------------------------------------------------------------
+template <typename task_t, typename data_t>
+std::future<data_t> teca_thread_pool<task_t, data_t>::push_task(task_t &task,
+    long priority)
+{
+    std::future<data_t> f = task.get_future();
+
+    if (priority)
+    {
+        // ordered by priority. inserts go after equal keys
+        std::lock_guard<std::mutex> lock(m_priority_mutex);
+        m_priority_tasks.emplace(priority, std::move(task));
+        ++m_n_priority_tasks;
+    }
+    else
+    {
+        // distribute round robin, idle threads will steal
+        // to balance the load
+        unsigned int id = m_next_queue++ % std::max(1u, m_n_threads.load());
+        m_queues[id]->push(std::move(task));
+    }
+
+    // wake a parked thread. the count is updated under the lock
+    // so that the wake up can't be missed.
+    {
+    std::lock_guard<std::mutex> lock(m_park_mutex);
+    ++m_queued;
+    }
+    m_park.notify_one();
+
+    return f;
 }
 
 // --------------------------------------------------------------------------
 template <typename task_t, typename data_t>
 template <template <typename ... > class container_t, typename ... args>
-void teca_thread_pool<task_t, data_t>::wait_data(container_t<data_t, args ...> &data)
+void teca_thread_pool<task_t, data_t>::wait_data(
+    std::vector<std::future<data_t>> &futures,
+    container_t<data_t, args ...> &data)
 {
     // wait on all pending requests and gather the generated
     // datasets
-    std::for_each(m_futures.begin(), m_futures.end(),
-        [&data] (std::future<data_t> &f)
+    std::for_each(futures.begin(), futures.end(),
+        [this, &data] (std::future<data_t> &f)
         {
+            this->wait(f, []() -> bool { return false; });
             data.push_back(f.get());
         });
-    m_futures.clear();
+    futures.clear();
 }
 
 #endif
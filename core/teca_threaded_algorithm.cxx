@@ -1,6 +1,7 @@
 #include "teca_threaded_algorithm.h"
 #include "teca_metadata.h"
 #include "teca_thread_pool.h"
+#include "teca_tracer.h"
 
 
 #include <memory>
@@ -10,12 +11,36 @@
 #include <atomic>
 #include <mutex>
 #include <future>
+#include <exception>
+#include <deque>
+#include <unordered_map>
+#include <map>
+#include <functional>
+#include <utility>
+#include <algorithm>
 #include <cstdlib>
 
 #if defined(TECA_HAS_BOOST)
 #include <boost/program_options.hpp>
 #endif
 
+// counts of the requests made by a stage that were served by
+// another request for the same data
+struct teca_single_flight_counters
+{
+    teca_single_flight_counters() : n_deduplicated(0), n_not_deduplicated(0) {}
+
+    // requests that waited for the result of an identical
+    // request being computed
+    std::atomic<unsigned long> n_deduplicated;
+
+    // requests that found an identical request being computed
+    // but computed the data themselves, see teca_single_flight
+    std::atomic<unsigned long> n_not_deduplicated;
+};
+
+using p_teca_single_flight_counters = std::shared_ptr<teca_single_flight_counters>;
+
 // function that executes the data request and returns the
 // requested dataset
 class teca_data_request
@@ -24,49 +49,896 @@ public:
     teca_data_request(const p_teca_algorithm &alg,
         const teca_algorithm_output_port up_port,
         const teca_metadata &up_req) : m_alg(alg),
-        m_up_port(up_port), m_up_req(up_req)
+        m_up_port(up_port), m_up_req(up_req), m_may_wait(false)
     {}
 
-    const_p_teca_dataset operator()()
-    { return m_alg->request_data(m_up_port, m_up_req); }
+    // enable deduplication of the request. counts are accumulated
+    // in the passed object.
+    void set_deduplicate(const p_teca_single_flight_counters &counters);
+
+    const_p_teca_dataset operator()();
 
 public:
     p_teca_algorithm m_alg;
     teca_algorithm_output_port m_up_port;
     teca_metadata m_up_req;
+    p_teca_single_flight_counters m_counters;
+    bool m_may_wait;
 };
 
 // task
 using teca_data_request_task = std::packaged_task<const_p_teca_dataset()>;
+using p_teca_data_request_task = std::shared_ptr<teca_data_request_task>;
 
 using teca_data_request_queue =
     teca_thread_pool<teca_data_request_task, const_p_teca_dataset>;
 
 using p_teca_data_request_queue = std::shared_ptr<teca_data_request_queue>;
 
+// a data request task managed by a stage throttle. held is set
+// while the task is waiting for a free slot and is guarded by the
+// throttle's mutex. the priority orders the task in the throttle
+// and in the thread pool.
+struct teca_throttled_task
+{
+    teca_throttled_task(teca_data_request_task &&t, long p) :
+        task(std::move(t)), priority(p), held(false)
+    {}
+
+    teca_data_request_task task;
+    long priority;
+    bool held;
+};
+
+using p_teca_throttled_task = std::shared_ptr<teca_throttled_task>;
+
+// limits the number of tasks a single stage may have executing
+// in the shared thread pool. tasks submitted while the stage is
+// at its limit are held here and handed to the pool as running
+// tasks complete, so that the stage never occupies more threads
+// than it was configured for. a thread waiting on a held task may
+// claim and execute it directly since it is already occupying a
+// core. this is required when stages are nested, the waiter may
+// be suspended above one of the stage's running tasks. held tasks
+// are released in order of decreasing priority.
+class teca_stage_throttle
+    : public std::enable_shared_from_this<teca_stage_throttle>
+{
+public:
+    teca_stage_throttle(const p_teca_data_request_queue &pool) :
+        m_limit(0), m_running(0), m_pool(pool)
+    {}
+
+    // set/get the maximum number of concurrently executing
+    // tasks. 0 means no limit beyond the size of the pool.
+    void set_limit(unsigned int n);
+    unsigned int get_limit() const noexcept { return m_limit; }
+
+    // queue a task for execution. returns a future from which
+    // the task's result can be accessed
+    std::future<const_p_teca_dataset> push_task(
+        const p_teca_throttled_task &task);
+
+    // if the task is held back by the limit, claim it and
+    // execute it on the calling thread. returns true if the
+    // task was executed.
+    bool run_pending(const p_teca_throttled_task &task);
+
+    // as above but of the tasks in the range [first, last) the
+    // held task with the highest priority is executed.
+    template <typename it_t>
+    bool run_pending(it_t first, it_t last);
+
+private:
+    // hand the task to the thread pool
+    void submit(const p_teca_throttled_task &task);
+
+    // get the next held task. claimed tasks are skipped.
+    // returns nullptr if there are none. the caller must
+    // hold the mutex.
+    p_teca_throttled_task next_held();
+
+    // called when a task completes, submits the next
+    // pending task if any
+    void release();
+
+private:
+    std::mutex m_mutex;
+    std::atomic<unsigned int> m_limit;
+    unsigned int m_running;
+    std::multimap<long, p_teca_throttled_task, std::greater<long>> m_pending;
+    p_teca_data_request_queue m_pool;
+};
+
+using p_teca_stage_throttle = std::shared_ptr<teca_stage_throttle>;
+
+// --------------------------------------------------------------------------
+void teca_stage_throttle::set_limit(unsigned int n)
+{
+    std::deque<p_teca_throttled_task> ready;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_limit = n;
+    // if the limit was raised some of the pending work may start now
+    p_teca_throttled_task task;
+    while ((!n || (m_running < n)) && (task = this->next_held()))
+    {
+        ready.push_back(task);
+        ++m_running;
+    }
+    }
+
+    std::for_each(ready.begin(), ready.end(),
+        [this](const p_teca_throttled_task &task) { this->submit(task); });
+}
+
+// --------------------------------------------------------------------------
+std::future<const_p_teca_dataset> teca_stage_throttle::push_task(
+    const p_teca_throttled_task &task)
+{
+    std::future<const_p_teca_dataset> f = task->task.get_future();
+
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unsigned int limit = m_limit;
+    if (limit && (m_running >= limit))
+    {
+        // the stage is at its limit, queue the work rather
+        // than oversubscribe the cores
+        task->held = true;
+        m_pending.emplace(task->priority, task);
+        return f;
+    }
+    ++m_running;
+    }
+
+    this->submit(task);
+
+    return f;
+}
+
+// --------------------------------------------------------------------------
+bool teca_stage_throttle::run_pending(const p_teca_throttled_task &task)
+{
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!task->held)
+        return false;
+    // the entry is left in the queue and skipped later
+    task->held = false;
+    }
+
+    task->task();
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+template <typename it_t>
+bool teca_stage_throttle::run_pending(it_t first, it_t last)
+{
+    p_teca_throttled_task task;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (; first != last; ++first)
+    {
+        const p_teca_throttled_task &t = *first;
+        if (t && t->held && (!task || (t->priority > task->priority)))
+            task = t;
+    }
+    if (!task)
+        return false;
+    // the entry is left in the queue and skipped later
+    task->held = false;
+    }
+
+    task->task();
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+p_teca_throttled_task teca_stage_throttle::next_held()
+{
+    while (!m_pending.empty())
+    {
+        p_teca_throttled_task task = m_pending.begin()->second;
+        m_pending.erase(m_pending.begin());
+        if (task->held)
+        {
+            task->held = false;
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+// --------------------------------------------------------------------------
+void teca_stage_throttle::submit(const p_teca_throttled_task &task)
+{
+    // the wrapper keeps the throttle alive until the task completes.
+    // exceptions are captured by the inner task and reported through
+    // the caller's future.
+    p_teca_stage_throttle throttle = this->shared_from_this();
+    teca_data_request_task wrapper([throttle, task]() -> const_p_teca_dataset
+        {
+            task->task();
+            throttle->release();
+            return nullptr;
+        });
+
+    m_pool->push_task(wrapper, task->priority);
+}
+
+// --------------------------------------------------------------------------
+void teca_stage_throttle::release()
+{
+    p_teca_throttled_task task;
+    {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unsigned int limit = m_limit;
+    // the slot is handed directly to the next pending task
+    if (!limit || (m_running <= limit))
+        task = this->next_held();
+
+    if (!task)
+        --m_running;
+    }
+
+    if (task)
+        this->submit(task);
+}
+
+
+
+// manages the upstream requests made by a single call to request_data.
+// requests are issued to the stage throttle as the data of earlier
+// requests is consumed, such that the number of requests and the
+// amount of data in flight stay within the configured limits. a
+// request is in flight from the time it is issued until its data
+// is consumed. in streaming mode consumed data is released by the
+// caller, otherwise it is held until execute and continues to count
+// against the memory budget. in both modes data is consumed in the
+// order it was requested. in streaming mode data that arrives early
+// is held, still in flight, until the data before it is consumed.
+class teca_request_window
+{
+public:
+    // max_requests and max_bytes limit the number of requests and
+    // the amount of data in flight. values less than 1 disable the
+    // corresponding limit.
+    teca_request_window(const p_teca_stage_throttle &throttle,
+        const p_teca_data_request_queue &pool, bool streaming,
+        long max_requests, long max_bytes);
+
+    // add a request. it is issued when the limits allow.
+    void push_request(teca_data_request dreq);
+
+    // issue requests up to the limits.
+    void issue();
+
+    // wait for the data of the next request in the order that
+    // the requests were pushed. not for use in streaming mode.
+    const_p_teca_dataset wait_next();
+
+    // wait for the data of the next request, and append it along with
+    // that of the requests after it that have arrived, up to n datasets,
+    // to data and the corresponding requests to reqs. for use in
+    // streaming mode. an exception thrown while generating the data of
+    // any of the requests is rethrown here.
+    void wait_some(size_t n, std::vector<const_p_teca_dataset> &data,
+        std::vector<teca_metadata> &reqs);
+
+    // get the number of requests whose data has not been consumed
+    size_t get_number_remaining() const
+    { return m_tasks.size() - m_n_consumed; }
+
+    // get the number of requests issued whose data has not been
+    // consumed
+    size_t get_number_in_flight() const
+    { return m_n_issued - m_n_consumed; }
+
+    // returns true if all of the requests pushed have been issued
+    bool issued_all() const
+    { return m_n_issued == m_tasks.size(); }
+
+    // get the largest number of requests and number of bytes that
+    // were in flight at once. the byte count includes only data
+    // that had been generated.
+    size_t get_max_requests_in_flight() const
+    { return m_max_requests_in_flight; }
+
+    unsigned long get_max_bytes_in_flight() const
+    { return m_state->max_bytes_ready; }
+
+private:
+    // returns true if another request can be issued
+    bool can_issue() const;
+
+    // account for data consumed by the caller and release the task
+    // that generated it
+    void consume(const const_p_teca_dataset &ds, size_t task);
+
+    // execute any of our own issued requests that are held
+    // back by the stage's concurrency limit
+    bool run_held();
+
+    // the outcome of a request in streaming mode. task is the index
+    // of the task that ran it. when generating the data failed the
+    // exception is passed on to the caller in error.
+    struct completion
+    {
+        size_t task;
+        teca_metadata request;
+        const_p_teca_dataset data;
+        std::exception_ptr error;
+    };
+
+    // state shared with the tasks. updated as tasks complete.
+    struct shared_state
+    {
+        shared_state() : n_completed(0), bytes_completed(0),
+            bytes_consumed(0), max_bytes_ready(0) {}
+
+        void complete(const const_p_teca_dataset &ds);
+
+        teca_threadsafe_queue<completion> completed;
+        std::atomic<size_t> n_completed;
+        std::atomic<unsigned long> bytes_completed;
+        std::atomic<unsigned long> bytes_consumed;
+        std::atomic<unsigned long> max_bytes_ready;
+    };
+
+private:
+    p_teca_stage_throttle m_throttle;
+    p_teca_data_request_queue m_pool;
+    bool m_streaming;
+    long m_max_requests;
+    long m_max_bytes;
+    std::shared_ptr<shared_state> m_state;
+    std::vector<p_teca_throttled_task> m_tasks;
+    std::vector<std::future<const_p_teca_dataset>> m_futures;
+    size_t m_n_issued;
+    size_t m_n_consumed;
+    size_t m_first_live;
+    size_t m_next_held;
+    size_t m_max_requests_in_flight;
+    bool m_prioritized;
+    std::map<size_t, completion> m_arrived;
+};
+
+// --------------------------------------------------------------------------
+void teca_request_window::shared_state::complete(const const_p_teca_dataset &ds)
+{
+    unsigned long n_bytes = ds ? ds->get_memory_usage() : 0;
+    unsigned long ready = (this->bytes_completed += n_bytes)
+        - this->bytes_consumed;
+
+    unsigned long max_ready = this->max_bytes_ready;
+    while ((ready > max_ready) &&
+        !this->max_bytes_ready.compare_exchange_weak(max_ready, ready));
+
+    ++this->n_completed;
+}
+
+// --------------------------------------------------------------------------
+teca_request_window::teca_request_window(const p_teca_stage_throttle &throttle,
+    const p_teca_data_request_queue &pool, bool streaming, long max_requests,
+    long max_bytes) : m_throttle(throttle), m_pool(pool),
+    m_streaming(streaming), m_max_requests(max_requests),
+    m_max_bytes(max_bytes), m_state(std::make_shared<shared_state>()),
+    m_n_issued(0), m_n_consumed(0), m_first_live(0), m_next_held(0),
+    m_max_requests_in_flight(0), m_prioritized(false)
+{}
+
+// --------------------------------------------------------------------------
+void teca_request_window::push_request(teca_data_request dreq)
+{
+    // the data is accounted for before it is made available to
+    // the caller. in streaming mode it is passed through the
+    // completion queue rather than the future.
+    std::shared_ptr<shared_state> state = m_state;
+    bool streaming = m_streaming;
+    size_t task = m_tasks.size();
+
+    long priority = 0;
+    dreq.m_up_req.get("__request_priority", priority);
+    m_prioritized = m_prioritized || priority;
+
+    m_tasks.push_back(std::make_shared<teca_throttled_task>(
+        teca_data_request_task([dreq, state, streaming, task]() mutable
+            -> const_p_teca_dataset
+            {
+                if (!streaming)
+                {
+                    const_p_teca_dataset ds = dreq();
+                    state->complete(ds);
+                    return ds;
+                }
+
+                // the caller waits on the completion queue, thus an
+                // exception left in the future would never be seen
+                completion elem{task, dreq.m_up_req, nullptr, nullptr};
+                try
+                {
+                    elem.data = dreq();
+                }
+                catch (...)
+                {
+                    elem.error = std::current_exception();
+                }
+                state->complete(elem.data);
+                state->completed.push(std::move(elem));
+                return nullptr;
+            }), priority));
+}
+
+// --------------------------------------------------------------------------
+bool teca_request_window::can_issue() const
+{
+    size_t n_in_flight = m_n_issued - m_n_consumed;
+
+    // always allow one request so that progress is made
+    if (n_in_flight == 0)
+        return true;
+
+    if ((m_max_requests > 0) &&
+        (n_in_flight >= static_cast<size_t>(m_max_requests)))
+        return false;
+
+    if (m_max_bytes > 0)
+    {
+        // the size of data not yet generated is estimated from
+        // the average size of the data generated so far.
+        size_t n_completed = m_state->n_completed;
+        unsigned long bytes_completed = m_state->bytes_completed;
+        unsigned long bytes_ready = bytes_completed - m_state->bytes_consumed;
+
+        unsigned long avg_bytes = n_completed ? bytes_completed/n_completed : 0;
+        size_t n_running = m_n_issued - n_completed;
+
+        if (bytes_ready + (n_running + 1)*avg_bytes
+            > static_cast<unsigned long>(m_max_bytes))
+            return false;
+    }
+
+    return true;
+}
+
+// --------------------------------------------------------------------------
+void teca_request_window::issue()
+{
+    size_t n_tasks = m_tasks.size();
+    while ((m_n_issued < n_tasks) && this->can_issue())
+    {
+        m_futures.push_back(m_throttle->push_task(m_tasks[m_n_issued]));
+        ++m_n_issued;
+
+        m_max_requests_in_flight = std::max(m_max_requests_in_flight,
+            m_n_issued - m_n_consumed);
+    }
+}
+
+// --------------------------------------------------------------------------
+void teca_request_window::consume(const const_p_teca_dataset &ds,
+    size_t task)
+{
+    if (m_streaming && ds)
+        m_state->bytes_consumed += ds->get_memory_usage();
+
+    // release our reference to the task, it holds the request. a
+    // failed task is released out of order, thus the earliest task
+    // not yet released is tracked for run_held
+    m_tasks[task].reset();
+    ++m_n_consumed;
+
+    while ((m_first_live < m_n_issued) && !m_tasks[m_first_live])
+        ++m_first_live;
+
+    this->issue();
+}
+
+// --------------------------------------------------------------------------
+bool teca_request_window::run_held()
+{
+    // the most important of the held tasks is run first
+    if (m_prioritized)
+        return m_throttle->run_pending(m_tasks.begin() + m_first_live,
+            m_tasks.begin() + m_n_issued);
+
+    // a task that is not held now never will be, so the scan
+    // for held tasks is done only once
+    for (; m_next_held < m_n_issued; ++m_next_held)
+    {
+        const p_teca_throttled_task &task = m_tasks[m_next_held];
+        if (task && m_throttle->run_pending(task))
+            return true;
+    }
+    return false;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_request_window::wait_next()
+{
+    this->issue();
+
+    std::future<const_p_teca_dataset> &f = m_futures[m_n_consumed];
+
+    m_pool->wait(f, [this]() -> bool { return this->run_held(); });
+
+    const_p_teca_dataset ds = f.get();
+
+    this->consume(ds, m_n_consumed);
+
+    return ds;
+}
+
+// --------------------------------------------------------------------------
+void teca_request_window::wait_some(size_t n,
+    std::vector<const_p_teca_dataset> &data, std::vector<teca_metadata> &reqs)
+{
+    this->issue();
+
+    // the task's completion is queued before its future is ready
+    std::future<const_p_teca_dataset> &f = m_futures[m_n_consumed];
+
+    m_pool->wait(f, [this]() -> bool { return this->run_held(); });
+
+    // sort what has arrived by the order it was requested in
+    completion elem;
+    while (m_state->completed.try_pop(elem))
+    {
+        if (elem.error)
+        {
+            this->consume(nullptr, elem.task);
+            std::rethrow_exception(elem.error);
+        }
+
+        size_t task = elem.task;
+        m_arrived.emplace(task, std::move(elem));
+    }
+
+    // pass on the contiguous run starting at the next request
+    std::map<size_t, completion>::iterator it;
+    for (size_t i = 0; (i < n) &&
+        ((it = m_arrived.find(m_n_consumed)) != m_arrived.end()); ++i)
+    {
+        this->consume(it->second.data, it->second.task);
+
+        reqs.push_back(std::move(it->second.request));
+        data.push_back(std::move(it->second.data));
+
+        m_arrived.erase(it);
+    }
+}
+
+
+
 // internals for teca threaded algorithm
 class teca_threaded_algorithm_internals
 {
 public:
     teca_threaded_algorithm_internals() :
-        thread_pool(new teca_data_request_queue(-1, false, true, false))
-     {}
+        thread_pool(get_thread_pool()),
+        throttle(std::make_shared<teca_stage_throttle>(thread_pool)),
+        counters(std::make_shared<teca_single_flight_counters>())
+    {}
+
+    // set the stage's concurrency limit. the shared pool is
+    // grown if the limit exceeds its size. -1 removes the limit.
+    void set_thread_pool_size(int n, bool bind, bool verbose);
 
-    void thread_pool_resize(int n, bool local, bool bind, bool verbose);
+    unsigned int get_thread_pool_size() const noexcept;
 
-    unsigned int get_thread_pool_size() const noexcept
-    { return this->thread_pool->size(); }
+    // get the process wide thread pool. the pool is created
+    // by the first call. when teca_mpi_manager has recorded the
+    // ranks on the node it is sized such that they together have
+    // 1 thread per core, otherwise it has 1 thread per core. this
+    // is never collective, the first call may come from a
+    // constructor on any one rank.
+    static p_teca_data_request_queue get_thread_pool();
 
 public:
     p_teca_data_request_queue thread_pool;
+    p_teca_stage_throttle throttle;
+    p_teca_single_flight_counters counters;
+};
+
+// --------------------------------------------------------------------------
+p_teca_data_request_queue teca_threaded_algorithm_internals::get_thread_pool()
+{
+    static std::mutex pool_mutex;
+    static p_teca_data_request_queue pool;
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (!pool)
+        pool = std::make_shared<teca_data_request_queue>(
+            MPI_COMM_SELF, -1, false, true, false);
+
+    return pool;
+}
+
+
+
+// tracks the upstream requests that are being computed, so that a
+// request for data already being computed waits for the result
+// rather than computing it again.
+//
+// waiting on work done by another thread can deadlock, because
+// threads help with queued work while they wait. the work a thread
+// picks up is nested above the frames it is suspended in, and these
+// can't complete until the nested work does. should the nested work,
+// or the work it requests, wait on one of the suspended frames no
+// progress is made. for this reason only requests that execute at
+// the bottom of a thread's stack, and that were made by such
+// requests, wait on others. the rest compute the data themselves.
+class teca_single_flight
+{
+public:
+    using promise_t = std::promise<const_p_teca_dataset>;
+    using p_promise_t = std::shared_ptr<promise_t>;
+    using future_t = std::shared_future<const_p_teca_dataset>;
+
+    // get the process wide instance
+    static teca_single_flight &get();
+
+    // look for the request in the table. if it is found the future
+    // delivering its data is returned in f, and true is returned.
+    // otherwise it is added, the caller is responsible for computing
+    // the data and passing it to complete.
+    bool find_or_insert(const teca_algorithm *alg, unsigned int port,
+        const teca_metadata &key, future_t &f, p_promise_t &p);
+
+    // remove the request from the table, and pass the data to any
+    // requests waiting on it
+    void complete(const teca_algorithm *alg, unsigned int port,
+        const teca_metadata &key, const p_promise_t &p,
+        const const_p_teca_dataset &data);
+
+    // as above but passes the exception
+    void complete(const teca_algorithm *alg, unsigned int port,
+        const teca_metadata &key, const p_promise_t &p,
+        std::exception_ptr err);
+
+    // returns true if requests executing on the calling thread may
+    // wait on others
+    static bool may_wait() { return t_may_wait; }
+
+    // marks the extent of a request executing on the calling
+    // thread. may_wait is false if the request was made by one that
+    // may not wait.
+    class frame
+    {
+    public:
+        frame(bool may_wait) : m_prev(t_may_wait)
+        {
+            t_may_wait = may_wait && (t_depth == 0);
+            ++t_depth;
+        }
+
+        ~frame()
+        {
+            --t_depth;
+            t_may_wait = m_prev;
+        }
+
+    private:
+        bool m_prev;
+    };
+
+private:
+    struct entry
+    {
+        const teca_algorithm *alg;
+        unsigned int port;
+        teca_metadata key;
+        p_promise_t promise;
+        future_t future;
+    };
+
+    using table_t = std::unordered_multimap<unsigned long long, entry>;
+
+    static unsigned long long get_hash(const teca_algorithm *alg,
+        unsigned int port, const teca_metadata &key);
+
+    // remove the request from the table
+    void erase(const teca_algorithm *alg, unsigned int port,
+        const teca_metadata &key, const p_promise_t &p);
+
+private:
+    std::mutex m_mutex;
+    table_t m_table;
+
+    static thread_local unsigned int t_depth;
+    static thread_local bool t_may_wait;
 };
 
 // --------------------------------------------------------------------------
-void teca_threaded_algorithm_internals::thread_pool_resize(int n, bool local,
+thread_local unsigned int teca_single_flight::t_depth = 0;
+thread_local bool teca_single_flight::t_may_wait = true;
+
+// --------------------------------------------------------------------------
+teca_single_flight &teca_single_flight::get()
+{
+    static teca_single_flight table;
+    return table;
+}
+
+// --------------------------------------------------------------------------
+unsigned long long teca_single_flight::get_hash(const teca_algorithm *alg,
+    unsigned int port, const teca_metadata &key)
+{
+    unsigned long long h = key.get_digest();
+    h ^= std::hash<const void*>()(alg) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h ^= port + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// --------------------------------------------------------------------------
+bool teca_single_flight::find_or_insert(const teca_algorithm *alg,
+    unsigned int port, const teca_metadata &key, future_t &f, p_promise_t &p)
+{
+    unsigned long long h = teca_single_flight::get_hash(alg, port, key);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto range = m_table.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const entry &e = it->second;
+        if ((e.alg == alg) && (e.port == port) && (e.key == key))
+        {
+            f = e.future;
+            return true;
+        }
+    }
+
+    p = std::make_shared<promise_t>();
+    m_table.emplace(h, entry{alg, port, key, p, p->get_future().share()});
+
+    return false;
+}
+
+// --------------------------------------------------------------------------
+void teca_single_flight::erase(const teca_algorithm *alg, unsigned int port,
+    const teca_metadata &key, const p_promise_t &p)
+{
+    unsigned long long h = teca_single_flight::get_hash(alg, port, key);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto range = m_table.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.promise == p)
+        {
+            m_table.erase(it);
+            break;
+        }
+    }
+}
+
+// --------------------------------------------------------------------------
+void teca_single_flight::complete(const teca_algorithm *alg, unsigned int port,
+    const teca_metadata &key, const p_promise_t &p,
+    const const_p_teca_dataset &data)
+{
+    // requests arriving after this find the data in the cache
+    this->erase(alg, port, key, p);
+
+    p->set_value(data);
+
+    // the waiters test the future when woken
+    teca_threaded_algorithm_internals::get_thread_pool()->notify();
+}
+
+// --------------------------------------------------------------------------
+void teca_single_flight::complete(const teca_algorithm *alg, unsigned int port,
+    const teca_metadata &key, const p_promise_t &p, std::exception_ptr err)
+{
+    this->erase(alg, port, key, p);
+
+    p->set_exception(err);
+
+    teca_threaded_algorithm_internals::get_thread_pool()->notify();
+}
+
+
+
+// --------------------------------------------------------------------------
+void teca_data_request::set_deduplicate(
+    const p_teca_single_flight_counters &counters)
+{
+    m_counters = counters;
+
+    // the request may wait on others if the request making it may
+    m_may_wait = teca_single_flight::may_wait();
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_data_request::operator()()
+{
+    teca_single_flight::frame frame(m_may_wait);
+
+    if (!m_counters)
+        return m_alg->request_data(m_up_port, m_up_req);
+
+    unsigned int port = get_port(m_up_port);
+    teca_metadata key = m_alg->get_cache_key(port, m_up_req);
+
+    teca_single_flight &table = teca_single_flight::get();
+
+    teca_single_flight::future_t f;
+    teca_single_flight::p_promise_t p;
+    if (table.find_or_insert(m_alg.get(), port, key, f, p))
+    {
+        if (!teca_single_flight::may_wait())
+        {
+            // waiting could deadlock, compute the data here
+            ++m_counters->n_not_deduplicated;
+            return m_alg->request_data(m_up_port, m_up_req);
+        }
+
+        // wait for the data, executing queued work in the meantime
+        ++m_counters->n_deduplicated;
+        {
+        teca_trace_span span("wait", m_alg.get(), port, m_up_req);
+        teca_threaded_algorithm_internals::get_thread_pool()->wait_until(
+            [&f]() -> bool { return f.wait_for(std::chrono::seconds(0))
+                == std::future_status::ready; },
+            []() -> bool { return false; });
+        }
+        return f.get();
+    }
+
+    const_p_teca_dataset data;
+    try
+    {
+        data = m_alg->request_data(m_up_port, m_up_req);
+    }
+    catch (...)
+    {
+        table.complete(m_alg.get(), port, key, p, std::current_exception());
+        throw;
+    }
+
+    table.complete(m_alg.get(), port, key, p, data);
+
+    return data;
+}
+
+// --------------------------------------------------------------------------
+void teca_threaded_algorithm_internals::set_thread_pool_size(int n,
     bool bind, bool verbose)
 {
-    this->thread_pool = std::make_shared<teca_data_request_queue>(n,
-        local, bind, verbose);
+    if (n < 1)
+    {
+        this->throttle->set_limit(0);
+        return;
+    }
+
+    // grow the shared pool when a stage asks for more threads than
+    // it has. the existing threads are not disturbed. this is not
+    // collective, since stages may be configured independently on
+    // each rank.
+    if (static_cast<unsigned int>(n) > this->thread_pool->size())
+        this->thread_pool->resize(MPI_COMM_SELF, n, true, bind, verbose);
+
+    this->throttle->set_limit(n);
+
+    if (verbose)
+    {
+        TECA_STATUS("stage concurrency limit " << n << " shared pool size "
+            << this->thread_pool->size())
+    }
+}
+
+// --------------------------------------------------------------------------
+unsigned int teca_threaded_algorithm_internals::get_thread_pool_size() const noexcept
+{
+    unsigned int n_pool = this->thread_pool->size();
+    unsigned int n_lim = this->throttle->get_limit();
+    return n_lim ? std::min(n_lim, n_pool) : n_pool;
 }
 
 
@@ -74,7 +946,8 @@ void teca_threaded_algorithm_internals::thread_pool_resize(int n, bool local,
 
 // --------------------------------------------------------------------------
 teca_threaded_algorithm::teca_threaded_algorithm() : verbose(0),
-    bind_threads(1), internals(new teca_threaded_algorithm_internals)
+    bind_threads(1), stream_size(-1), max_in_flight(-1), memory_budget(-1),
+    deduplicate_requests(0), internals(new teca_threaded_algorithm_internals)
 {
 }
 
@@ -99,6 +972,18 @@ void teca_threaded_algorithm::get_properties_description(
             "print a run time report of settings (0)")
         TECA_POPTS_GET(int, prefix, thread_pool_size,
             "number of threads in pool. When n == -1, 1 thread per core is created (-1)")
+        TECA_POPTS_GET(int, prefix, stream_size,
+            "number of datasets to gather per call to execute. when n < 1 "
+            "execute is called once all data is available (-1)")
+        TECA_POPTS_GET(long, prefix, max_in_flight,
+            "maximum number of upstream requests in flight. when n < 1 "
+            "the number is not limited (-1)")
+        TECA_POPTS_GET(long, prefix, memory_budget,
+            "maximum number of bytes of upstream data in flight. when n < 1 "
+            "the amount is not limited (-1)")
+        TECA_POPTS_GET(int, prefix, deduplicate_requests,
+            "when set an upstream request for data that is already being "
+            "computed waits for the result rather than computing it again (0)")
         ;
 
     global_opts.add(opts);
@@ -110,6 +995,10 @@ void teca_threaded_algorithm::set_properties(const std::string &prefix,
 {
     TECA_POPTS_SET(opts, int, prefix, bind_threads)
     TECA_POPTS_SET(opts, int, prefix, verbose)
+    TECA_POPTS_SET(opts, int, prefix, stream_size)
+    TECA_POPTS_SET(opts, long, prefix, max_in_flight)
+    TECA_POPTS_SET(opts, long, prefix, memory_budget)
+    TECA_POPTS_SET(opts, int, prefix, deduplicate_requests)
 
     std::string opt_name = (prefix.empty()?"":prefix+"::") + "thread_pool_size";
     if (opts.count(opt_name))
@@ -120,7 +1009,7 @@ void teca_threaded_algorithm::set_properties(const std::string &prefix,
 // --------------------------------------------------------------------------
 void teca_threaded_algorithm::set_thread_pool_size(int n)
 {
-    this->internals->thread_pool_resize(n, false, this->bind_threads, this->verbose);
+    this->internals->set_thread_pool_size(n, this->bind_threads, this->verbose);
 }
 
 // --------------------------------------------------------------------------
@@ -129,6 +1018,51 @@ unsigned int teca_threaded_algorithm::get_thread_pool_size() const noexcept
     return this->internals->get_thread_pool_size();
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_threaded_algorithm::get_number_of_deduplicated_requests() const
+{
+    return this->internals->counters->n_deduplicated;
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_threaded_algorithm::get_number_of_duplicated_requests() const
+{
+    return this->internals->counters->n_not_deduplicated;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_threaded_algorithm::execute(unsigned int port,
+    const std::vector<const_p_teca_dataset> &input_data,
+    const teca_metadata &request, int)
+{
+    return this->execute(port, input_data, request);
+}
+
+// --------------------------------------------------------------------------
+std::vector<teca_metadata> teca_threaded_algorithm::get_next_upstream_request(
+    unsigned int port, const std::vector<teca_metadata> &input_md,
+    const teca_metadata &request)
+{
+    (void)port;
+    (void)input_md;
+    (void)request;
+    return std::vector<teca_metadata>();
+}
+
+// --------------------------------------------------------------------------
+void teca_threaded_algorithm::stream_progress(unsigned int port,
+    const std::vector<teca_metadata> &up_reqs,
+    const const_p_teca_dataset &arrived,
+    const std::vector<const_p_teca_dataset> &partials,
+    const teca_metadata &request)
+{
+    (void)port;
+    (void)up_reqs;
+    (void)arrived;
+    (void)partials;
+    (void)request;
+}
+
 // --------------------------------------------------------------------------
 const_p_teca_dataset teca_threaded_algorithm::request_data(
     teca_algorithm_output_port &current,
@@ -139,6 +1073,8 @@ const_p_teca_dataset teca_threaded_algorithm::request_data(
     p_teca_algorithm alg = get_algorithm(current);
     unsigned int port = get_port(current);
 
+    teca_trace_span span("request_data", alg.get(), port, request);
+
     // check for cached data
     teca_metadata key = alg->get_cache_key(port, request);
     const_p_teca_dataset out_data = alg->get_output_data(port, key);
@@ -154,38 +1090,172 @@ const_p_teca_dataset teca_threaded_algorithm::request_data(
         }
 
         // get requests for upstream data
-        std::vector<teca_metadata> up_reqs
-            = alg->get_upstream_request(port, input_md, request);
+        std::vector<teca_metadata> up_reqs;
+        {
+        teca_trace_span span("get_upstream_request", alg.get(), port, request);
+        up_reqs = alg->get_upstream_request(port, input_md, request);
+        }
 
         // push data requests on to the thread pool's work
         // queue. mapping the requests round-robbin on to
-        // the inputs
-        size_t n_up_reqs = up_reqs.size();
+        // the inputs. requests are issued as the limits on
+        // data in flight allow.
+        bool streaming = this->stream_size > 0;
+
+        teca_request_window window(this->internals->throttle,
+            this->internals->thread_pool, streaming,
+            this->max_in_flight, this->memory_budget);
+
+        // outside of streaming mode the data arrives in the order that
+        // it was requested, the requests are kept for stream_progress
+        std::vector<teca_metadata> pushed_reqs;
+
+        auto push_requests = [&](const std::vector<teca_metadata> &reqs)
+        {
+            size_t n_reqs = reqs.size();
+            for (size_t i = 0; i < n_reqs; ++i)
+            {
+                if (!reqs[i].empty())
+                {
+                    teca_algorithm_output_port &up_port
+                        = alg->get_input_connection(i%n_inputs);
+
+                    teca_data_request dreq(get_algorithm(up_port),
+                        up_port, reqs[i]);
+
+                    if (this->deduplicate_requests)
+                        dreq.set_deduplicate(this->internals->counters);
+
+                    window.push_request(dreq);
+
+                    if (!streaming)
+                        pushed_reqs.push_back(reqs[i]);
+                }
+            }
+        };
+
+        push_requests(up_reqs);
 
-        for (unsigned int i = 0; i < n_up_reqs; ++i)
+        // when work is handed out on demand, ask for more once all
+        // of the requests in hand have been issued and the threads
+        // are about to run out of work
+        bool more_reqs = true;
+        size_t n_threads = this->get_thread_pool_size();
+        auto next_requests = [&]() -> bool
         {
-            if (!up_reqs[i].empty())
+            while (more_reqs && window.issued_all() &&
+                (window.get_number_in_flight() < n_threads))
             {
-                teca_algorithm_output_port &up_port
-                    = alg->get_input_connection(i%n_inputs);
+                std::vector<teca_metadata> reqs =
+                    this->get_next_upstream_request(port, input_md, request);
 
-                teca_data_request dreq(get_algorithm(up_port), up_port, up_reqs[i]);
-                teca_data_request_task task(dreq);
+                more_reqs = !reqs.empty();
 
-                this->internals->thread_pool->push_task(task);
+                push_requests(reqs);
             }
+            return window.get_number_remaining();
+        };
+
+        if (streaming)
+        {
+            // process the data as it arrives. the results of earlier
+            // calls are folded pairwise, as in a binary counter, into
+            // a set of partial results one per level. this bounds the
+            // number of live datasets while keeping the work done by
+            // the reduction the same as a tree.
+            std::vector<const_p_teca_dataset> partials;
+            size_t n_stream = this->stream_size;
+            while (next_requests())
+            {
+                // wait for some data. while waiting this thread executes
+                // queued work and any of its own requests held back by
+                // the concurrency limit.
+                std::vector<const_p_teca_dataset> input_data;
+                std::vector<teca_metadata> input_reqs;
+                {
+                teca_trace_span span("wait", alg.get(), port, request);
+                window.wait_some(n_stream, input_data, input_reqs);
+                }
+
+                teca_trace_span span("execute", alg.get(), port, request);
+
+                const_p_teca_dataset arrived =
+                    this->execute(port, input_data, request, 1);
+
+                // carry
+                const_p_teca_dataset partial = arrived;
+                size_t level = 0;
+                size_t n_levels = partials.size();
+                for (; (level < n_levels) && partials[level]; ++level)
+                {
+                    partial = this->execute(port,
+                        {partials[level], partial}, request, 1);
+
+                    partials[level] = nullptr;
+                }
+
+                if (level < n_levels)
+                    partials[level] = partial;
+                else
+                    partials.push_back(partial);
+
+                this->stream_progress(port, input_reqs, arrived,
+                    partials, request);
+            }
+
+            // the last call combines the remaining partial results
+            std::vector<const_p_teca_dataset> input_data;
+            std::for_each(partials.rbegin(), partials.rend(),
+                [&input_data](const const_p_teca_dataset &p)
+                { if (p) input_data.push_back(p); });
+
+            teca_trace_span span("execute", alg.get(), port, request);
+            out_data = this->execute(port, input_data, request, 0);
+            span.set_output(out_data);
         }
+        else
+        {
+            // get the requested data. while the requests are pending
+            // this thread executes queued work, and any of its own
+            // requests held back by the concurrency limit. this is
+            // what keeps nested threaded stages from stalling the
+            // shared pool.
+            std::vector<const_p_teca_dataset> input_data;
+            input_data.reserve(window.get_number_remaining());
+            {
+            teca_trace_span span("wait", alg.get(), port, request);
+            while (next_requests())
+            {
+                input_data.push_back(window.wait_next());
 
-        // get the requested data. will block until it's ready.
-        std::vector<const_p_teca_dataset> input_data;
-        this->internals->thread_pool->wait_data(input_data);
+                size_t i = input_data.size() - 1;
+                this->stream_progress(port, {pushed_reqs[i]},
+                    input_data[i], input_data, request);
+            }
+            }
 
-        // execute override
-        out_data = alg->execute(port, input_data, request);
+            // execute override
+            teca_trace_span span("execute", alg.get(), port, request);
+            out_data = alg->execute(port, input_data, request);
+            span.set_output(out_data);
+        }
+
+        if (this->verbose)
+        {
+            TECA_STATUS("in flight high water mark "
+                << window.get_max_requests_in_flight() << " requests "
+                << window.get_max_bytes_in_flight() << " bytes, "
+                << this->get_number_of_deduplicated_requests()
+                << " requests deduplicated "
+                << this->get_number_of_duplicated_requests()
+                << " duplicated")
+        }
 
         // cache the output
         alg->cache_output_data(port, key, out_data);
     }
 
+    span.set_output(out_data);
+
     return out_data;
 }
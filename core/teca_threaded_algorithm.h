@@ -11,7 +11,20 @@ class teca_threaded_algorithm_internals;
 
 // this is the base class defining a threaded algorithm.
 // the stratgey employed is to parallelize over upstream
-// data requests using a thread pool.
+// data requests using a thread pool. the thread pool is
+// shared by all threaded algorithms in the process, each
+// algorithm may limit the number of its requests that
+// execute concurrently. because the pool is shared by the
+// pipelines of all communicators, it is created per process
+// over MPI_COMM_SELF when the first threaded algorithm is
+// constructed. creating it is never collective.
+//
+// upstream requests may carry a scheduling priority in the
+// __request_priority key (long). requests with larger values
+// are executed first, both when queued by the algorithm's limit
+// and in the shared pool. use it to start the work on the
+// critical path early, for instance the longest storm tracks.
+// the key is not part of the default cache key.
 class teca_threaded_algorithm : public teca_algorithm
 {
 public:
@@ -24,9 +37,13 @@ public:
     TECA_GET_ALGORITHM_PROPERTIES_DESCRIPTION()
     TECA_SET_ALGORITHM_PROPERTIES()
 
-    // set/get the number of threads in the pool. setting
-    // to -1 results in a thread per core factoring in all MPI
-    // ranks running on the node. the default is -1.
+    // set/get the number of threads this algorithm may use.
+    // requests in excess of the limit are queued until one of
+    // the algorithm's running requests completes. the shared
+    // pool is grown if needed. setting to -1 results in using
+    // all of the shared pool's threads, which has a thread per
+    // core factoring in all MPI ranks running on the node. the
+    // default is -1.
     void set_thread_pool_size(int n_threads);
     unsigned int get_thread_pool_size() const noexcept;
 
@@ -38,6 +55,39 @@ public:
     // likely degrade performance. Default is 1.
     TECA_ALGORITHM_PROPERTY(int, bind_threads);
 
+    // set/get the streaming batch size. when greater than 0 the
+    // streaming execute override is called each time this many
+    // upstream datasets have arrived, rather than once after all
+    // of them have. derived classes must implement the streaming
+    // execute override to enable this. Default is -1.
+    TECA_ALGORITHM_PROPERTY(int, stream_size);
+
+    // set/get the limits on upstream data in flight. requests are
+    // issued as the data of earlier requests arrives, such that at
+    // most max_in_flight requests are outstanding, and the data
+    // generated plus the estimated size of the data pending stays
+    // within memory_budget bytes. outside of streaming mode all of
+    // the data is held until execute, and the budget caps the data
+    // gathered before requests are issued one at a time. at least
+    // one request is always issued. values less than 1 disable the
+    // limit. Default is -1.
+    TECA_ALGORITHM_PROPERTY(long, max_in_flight);
+    TECA_ALGORITHM_PROPERTY(long, memory_budget);
+
+    // set/get request deduplication. when set, an upstream request
+    // made while an identical request is being computed waits for
+    // its result rather than computing the data again. requests
+    // made from work picked up by a thread while it waits can't
+    // safely wait on others, these compute the data themselves.
+    // Default is 0.
+    TECA_ALGORITHM_PROPERTY(int, deduplicate_requests);
+
+    // get the number of upstream requests made by this algorithm
+    // that were served by an identical request, and the number that
+    // found an identical request but computed the data themselves.
+    unsigned long get_number_of_deduplicated_requests() const;
+    unsigned long get_number_of_duplicated_requests() const;
+
 protected:
     teca_threaded_algorithm();
 
@@ -47,9 +97,53 @@ protected:
     const_p_teca_dataset request_data(teca_algorithm_output_port &port,
         const teca_metadata &request) override;
 
+    // streaming execute override. called as upstream datasets
+    // arrive when stream_size is greater than 0. input_data holds
+    // either up to stream_size newly arrived datasets, or values
+    // returned by earlier calls which are to be combined. streaming
+    // is non-zero on all but the last call, the value returned from
+    // the last call is the algorithm's output. the default
+    // implementation passes the data to the non-streaming execute
+    // override.
+    using teca_algorithm::execute;
+    virtual const_p_teca_dataset execute(unsigned int port,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request, int streaming);
+
+    // hands out upstream requests on demand. called during
+    // request_data once the requests returned by
+    // get_upstream_request have been issued and the stage is about
+    // to run out of work. the requests returned are processed in
+    // the same way. returning an empty vector signals that there is
+    // no more work, after which the method is not called again
+    // for the current request. the default implementation returns
+    // an empty vector.
+    virtual std::vector<teca_metadata> get_next_upstream_request(
+        unsigned int port, const std::vector<teca_metadata> &input_md,
+        const teca_metadata &request);
+
+    // called after newly arrived upstream data has been processed.
+    // in streaming mode it has been passed to the streaming execute
+    // override and folded into the partial results, and arrived is
+    // the value the streaming execute override returned for it.
+    // otherwise arrived is the upstream data of a single request,
+    // and partials the data gathered so far. up_reqs holds the
+    // requests for the newly arrived data. the non-null entries of
+    // partials together hold the data of every request reported so
+    // far. the default implementation does nothing.
+    virtual void stream_progress(unsigned int port,
+        const std::vector<teca_metadata> &up_reqs,
+        const const_p_teca_dataset &arrived,
+        const std::vector<const_p_teca_dataset> &partials,
+        const teca_metadata &request);
+
 private:
     int verbose;
     int bind_threads;
+    int stream_size;
+    long max_in_flight;
+    long memory_budget;
+    int deduplicate_requests;
     teca_threaded_algorithm_internals *internals;
 };
 
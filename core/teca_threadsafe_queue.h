@@ -2,7 +2,7 @@
 #define teca_threadsafe_queue_h
 
 #include <mutex>
-#include <queue>
+#include <deque>
 #include <condition_variable>
 
 template<typename T>
@@ -14,7 +14,7 @@ public:
     void operator=(const teca_threadsafe_queue<T> &other);
 
     // report current size
-    typename std::queue<T>::size_type size() const;
+    typename std::deque<T>::size_type size() const;
 
     // push a value onto the queue
     void push(const T &val);
@@ -27,6 +27,12 @@ public:
     // false if no data is in the queue.
     bool try_pop(T &val);
 
+    // pop a value from the back of the queue if data is present,
+    // will return false if no data is in the queue. this is used
+    // by other threads to steal work, taking from the opposite end
+    // as the owner reduces contention.
+    bool try_steal(T &val);
+
     // swap the contents
     void swap(teca_threadsafe_queue<T> &other);
 
@@ -35,9 +41,8 @@ public:
 
 private:
     mutable std::mutex m_mutex;
-    std::queue<T> m_queue;
+    std::deque<T> m_queue;
     std::condition_variable m_ready;
-    std::condition_variable m_empty;
 };
 
 // --------------------------------------------------------------------------
@@ -46,7 +51,7 @@ teca_threadsafe_queue<T>::teca_threadsafe_queue(
     const teca_threadsafe_queue<T> &other)
 {
     std::lock_guard<std::mutex> lock(other.m_mutex);
-    std::queue<T> tmp(other.m_queue);
+    std::deque<T> tmp(other.m_queue);
     m_queue.swap(tmp);
 }
 
@@ -58,7 +63,7 @@ void teca_threadsafe_queue<T>::operator=(
     std::lock(m_mutex, other.m_mutex);
     std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
     std::lock_guard<std::mutex> lock_other(other.m_mutex, std::adopt_lock);
-    std::queue<T> tmp(other.m_queue);
+    std::deque<T> tmp(other.m_queue);
     m_queue.swap(tmp);
 }
 
@@ -74,7 +79,7 @@ void teca_threadsafe_queue<T>::swap(teca_threadsafe_queue<T> &other)
 
 // --------------------------------------------------------------------------
 template<typename T>
-typename std::queue<T>::size_type teca_threadsafe_queue<T>::size() const
+typename std::deque<T>::size_type teca_threadsafe_queue<T>::size() const
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     return m_queue.size();
@@ -85,7 +90,7 @@ template<typename T>
 void teca_threadsafe_queue<T>::push(const T &val)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_queue.push(val);
+    m_queue.push_back(val);
     m_ready.notify_one();
 }
 
@@ -94,7 +99,7 @@ template<typename T>
 void teca_threadsafe_queue<T>::push(T &&val)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_queue.push(std::move(val));
+    m_queue.push_back(std::move(val));
     m_ready.notify_one();
 }
 
@@ -105,7 +110,7 @@ void teca_threadsafe_queue<T>::pop(T &val)
     std::unique_lock<std::mutex> lock(m_mutex);
     m_ready.wait(lock, [this] { return !m_queue.empty(); });
     val = std::move(m_queue.front());
-    m_queue.pop();
+    m_queue.pop_front();
 }
 
 // --------------------------------------------------------------------------
@@ -116,7 +121,19 @@ bool teca_threadsafe_queue<T>::try_pop(T &val)
     if (m_queue.empty())
         return false;
     val = std::move(m_queue.front());
-    m_queue.pop();
+    m_queue.pop_front();
+    return true;
+}
+
+// --------------------------------------------------------------------------
+template<typename T>
+bool teca_threadsafe_queue<T>::try_steal(T &val)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_queue.empty())
+        return false;
+    val = std::move(m_queue.back());
+    m_queue.pop_back();
     return true;
 }
 
@@ -6,6 +6,7 @@
 #include <string>
 #include <iostream>
 #include <utility>
+#include <algorithm>
 
 using std::vector;
 using std::string;
@@ -20,7 +21,8 @@ using std::endl;
 
 // --------------------------------------------------------------------------
 teca_time_step_executive::teca_time_step_executive()
-    : first_step(0), last_step(-1), stride(1)
+    : first_step(0), last_step(-1), stride(1), dynamic_schedule(0),
+    min_chunk_size(1), checkpoint_interval(1), current_step(-1)
 {
 }
 
@@ -67,10 +69,35 @@ void teca_time_step_executive::set_arrays(const std::vector<std::string> &v)
     this->arrays = v;
 }
 
+// --------------------------------------------------------------------------
+void teca_time_step_executive::set_dynamic_schedule(int s)
+{
+    this->dynamic_schedule = s;
+}
+
+// --------------------------------------------------------------------------
+void teca_time_step_executive::set_min_chunk_size(long s)
+{
+    this->min_chunk_size = std::max(1l, s);
+}
+
+// --------------------------------------------------------------------------
+void teca_time_step_executive::set_checkpoint_file(const std::string &file_name)
+{
+    this->checkpoint_file = file_name;
+}
+
+// --------------------------------------------------------------------------
+void teca_time_step_executive::set_checkpoint_interval(long n)
+{
+    this->checkpoint_interval = n;
+}
+
 // --------------------------------------------------------------------------
 int teca_time_step_executive::initialize(const teca_metadata &md)
 {
     this->requests.clear();
+    this->current_step = -1;
 
     // locate available times
     long n_times = 1;
@@ -88,7 +115,64 @@ int teca_time_step_executive::initialize(const teca_metadata &md)
         = ((this->first_step >= 0) && (this->first_step <= last))
             ? this->first_step : 0;
 
-    n_times = last - first + 1;
+    // consrtuct base request
+    teca_metadata base_req;
+    if (this->extent.empty())
+    {
+        vector<unsigned long> whole_extent(6, 0l);
+        md.get("whole_extent", whole_extent);
+        base_req.insert("extent", whole_extent);
+    }
+    else
+        base_req.insert("extent", this->extent);
+    base_req.insert("arrays", this->arrays);
+
+    // skip the time steps completed by an earlier run
+    vector<unsigned long> completed;
+    this->checkpoint = nullptr;
+    if (!this->checkpoint_file.empty())
+    {
+        this->checkpoint = teca_checkpoint::New();
+        this->checkpoint->set_file_name(this->checkpoint_file);
+        this->checkpoint->set_communicator(this->get_communicator());
+        this->checkpoint->set_interval(this->checkpoint_interval);
+
+        if (this->checkpoint->restore(completed))
+        {
+            TECA_ERROR("failed to restore the checkpoint \""
+                << this->checkpoint_file << "\"")
+            return -1;
+        }
+    }
+
+    // the time steps to process
+    this->steps.clear();
+    for (long step = first; step <= last; ++step)
+    {
+        if (((step % this->stride) == 0) &&
+            !std::binary_search(completed.begin(), completed.end(),
+                static_cast<unsigned long>(step)))
+            this->steps.push_back(step);
+    }
+
+    if (this->dynamic_schedule)
+    {
+        // time steps are handed out in chunks on demand, see
+        // get_next_request
+        this->base_req = base_req;
+
+        if (!this->scheduler)
+            this->scheduler = teca_dynamic_scheduler::New();
+
+        if (this->scheduler->initialize(this->get_communicator(),
+            this->steps.size(), this->min_chunk_size))
+        {
+            TECA_ERROR("failed to initialize the dynamic schedule")
+            return -1;
+        }
+
+        return 0;
+    }
 
     // partition time across MPI ranks. each rank
     // will end up with a unique block of times
@@ -101,47 +185,33 @@ int teca_time_step_executive::initialize(const teca_metadata &md)
     if (is_init)
     {
         int tmp = 0;
-        MPI_Comm_size(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_size(this->get_communicator(), &tmp);
         n_ranks = tmp;
-        MPI_Comm_rank(MPI_COMM_WORLD, &tmp);
+        MPI_Comm_rank(this->get_communicator(), &tmp);
         rank = tmp;
     }
 #endif
-    size_t n_big_blocks = n_times%n_ranks;
+    size_t n_steps = this->steps.size();
+    size_t n_big_blocks = n_steps%n_ranks;
     size_t block_size = 1;
     size_t block_start = 0;
     if (rank < n_big_blocks)
     {
-        block_size = n_times/n_ranks + 1;
+        block_size = n_steps/n_ranks + 1;
         block_start = block_size*rank;
     }
     else
     {
-        block_size = n_times/n_ranks;
+        block_size = n_steps/n_ranks;
         block_start = block_size*rank + n_big_blocks;
     }
 
-    // consrtuct base request
-    teca_metadata base_req;
-    if (this->extent.empty())
-    {
-        vector<unsigned long> whole_extent(6, 0l);
-        md.get("whole_extent", whole_extent);
-        base_req.insert("extent", whole_extent);
-    }
-    else
-        base_req.insert("extent", this->extent);
-    base_req.insert("arrays", this->arrays);
-
     // apply the base request to local times.
     for (size_t i = 0; i < block_size; ++i)
     {
-        size_t step = i + block_start + first;
-        if ((step % this->stride) == 0)
-        {
-            this->requests.push_back(base_req);
-            this->requests.back().insert("time_step", step);
-        }
+        this->requests.push_back(base_req);
+        this->requests.back().insert("time_step",
+            this->steps[i + block_start]);
     }
 
 #if defined(TECA_TIME_STEP_EXECUTIVE_DEBUG)
@@ -157,17 +227,44 @@ int teca_time_step_executive::initialize(const teca_metadata &md)
 // --------------------------------------------------------------------------
 teca_metadata teca_time_step_executive::get_next_request()
 {
+    // the time step requested last is complete
+    if (this->checkpoint && (this->current_step >= 0) &&
+        this->checkpoint->complete(this->current_step) &&
+        this->checkpoint->save(nullptr))
+        TECA_ERROR("failed to write the checkpoint")
+
+    this->current_step = -1;
+
+    // claim the next chunk of time steps
+    if (this->dynamic_schedule && this->requests.empty() && this->scheduler)
+    {
+        unsigned long first = 0;
+        unsigned long n = 0;
+        if (this->scheduler->get_next_chunk(first, n) == 0)
+        {
+            // requests are taken from the back
+            for (unsigned long i = first + n; i > first; --i)
+            {
+                this->requests.push_back(this->base_req);
+                this->requests.back().insert("time_step", this->steps[i-1]);
+            }
+        }
+    }
+
     teca_metadata req;
     if (!this->requests.empty())
     {
         req = this->requests.back();
         this->requests.pop_back();
 
+        if (this->checkpoint)
+            req.get("time_step", this->current_step);
+
 #if defined(TECA_TIME_STEP_EXECUTIVE_DEBUG)
         vector<unsigned long> ext;
         req.get("extent", ext);
 
-        unsigned long time_step;
+        unsigned long time_step = 0;
         req.get("time_step", time_step);
 
         cerr << teca_parallel_id()
@@ -177,6 +274,13 @@ teca_metadata teca_time_step_executive::get_next_request()
             << endl;
 #endif
     }
+    else if (this->checkpoint)
+    {
+        // the run is complete
+        if (this->checkpoint->save(nullptr))
+            TECA_ERROR("failed to write the checkpoint")
+        this->checkpoint = nullptr;
+    }
 
     return req;
 }
@@ -4,6 +4,8 @@
 #include "teca_shared_object.h"
 #include "teca_algorithm_executive.h"
 #include "teca_metadata.h"
+#include "teca_dynamic_scheduler.h"
+#include "teca_checkpoint.h"
 
 #include <vector>
 
@@ -13,6 +15,18 @@ TECA_SHARED_OBJECT_FORWARD_DECL(teca_time_step_executive)
 /**
 An executive that generates a request for a series of
 timesteps. an extent can be optionally set.
+
+By default the time steps are partitioned into contiguous blocks
+one per MPI rank. When the cost of time steps varies the slowest
+rank sets the run time. With dynamic scheduling enabled time steps
+are instead handed out in chunks on demand, see
+teca_dynamic_scheduler.
+
+When a checkpoint file is set the time steps that have been
+processed are recorded as the run progresses, see teca_checkpoint.
+A time step is complete when the request for the next one is made.
+If the run is killed and restarted with the same checkpoint file
+only the time steps that were not completed are requested.
 */
 class teca_time_step_executive : public teca_algorithm_executive
 {
@@ -46,6 +60,25 @@ public:
     // set the list of arrays to process
     void set_arrays(const std::vector<std::string> &arrays);
 
+    // enable dynamic scheduling. when set time steps are handed
+    // out to MPI ranks in chunks as they request more work.
+    // default is 0.
+    void set_dynamic_schedule(int s);
+
+    // set the smallest chunk of time steps handed out by the
+    // dynamic schedule. default is 1.
+    void set_min_chunk_size(long s);
+
+    // set the prefix of the checkpoint files. when set, time steps
+    // already completed by an earlier run are skipped. the default
+    // is empty, which disables checkpointing. remove the files to
+    // start over.
+    void set_checkpoint_file(const std::string &file_name);
+
+    // set the number of time steps completed between checkpoints.
+    // a checkpoint is also written when the run ends. default is 1.
+    void set_checkpoint_interval(long n);
+
 protected:
     teca_time_step_executive();
 
@@ -56,6 +89,15 @@ private:
     long stride;
     std::vector<unsigned long> extent;
     std::vector<std::string> arrays;
+    int dynamic_schedule;
+    long min_chunk_size;
+    p_teca_dynamic_scheduler scheduler;
+    std::vector<unsigned long> steps;
+    teca_metadata base_req;
+    std::string checkpoint_file;
+    long checkpoint_interval;
+    p_teca_checkpoint checkpoint;
+    long current_step;
 };
 
 #endif
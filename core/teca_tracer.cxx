@@ -0,0 +1,289 @@
+#include "teca_config.h"
+#include "teca_tracer.h"
+#include "teca_algorithm.h"
+#include "teca_dataset.h"
+#include "teca_metadata.h"
+#include "teca_common.h"
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <sstream>
+#include <fstream>
+#include <typeinfo>
+#include <cstdlib>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#endif
+
+namespace {
+
+// a recorded span
+struct teca_trace_event
+{
+    const char *phase;
+    std::string alg;
+    unsigned int port;
+    long time_step;
+    unsigned long n_bytes;
+    int thread;
+    teca_tracer::clock_t::time_point start;
+    teca_tracer::clock_t::time_point end;
+};
+
+// the tracer's state
+struct teca_tracer_state
+{
+    teca_tracer_state() : enabled(false), next_thread(0)
+    {
+        const char *file_name = getenv("TECA_TRACE");
+        if (file_name && file_name[0])
+        {
+            this->file_name = file_name;
+            this->enabled = true;
+        }
+    }
+
+    std::atomic<bool> enabled;
+    std::atomic<int> next_thread;
+    std::mutex mutex;
+    std::string file_name;
+    std::vector<teca_trace_event> events;
+};
+
+// --------------------------------------------------------------------------
+teca_tracer_state &get_state()
+{
+    static teca_tracer_state state;
+    return state;
+}
+
+// --------------------------------------------------------------------------
+int get_thread_index()
+{
+    // threads are numbered in the order they first record a span.
+    // the numbers are compact and stable for the run, unlike the
+    // values of std::thread::id
+    static thread_local int index = get_state().next_thread++;
+    return index;
+}
+
+// --------------------------------------------------------------------------
+std::string get_class_name(const teca_algorithm *alg)
+{
+    if (!alg)
+        return "";
+
+    const char *name = typeid(*alg).name();
+#if defined(__GNUC__)
+    int ierr = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &ierr);
+    if (demangled)
+    {
+        std::string class_name(demangled);
+        free(demangled);
+        return class_name;
+    }
+#endif
+    return name;
+}
+
+// --------------------------------------------------------------------------
+void write_events(std::ostream &os, int rank,
+    const std::vector<teca_trace_event> &events)
+{
+    // convert to wall clock time so that the spans of all ranks
+    // are placed on the same timeline
+    auto steady_now = teca_tracer::clock_t::now();
+    auto wall_now = std::chrono::system_clock::now();
+
+    auto to_us = [&](teca_tracer::clock_t::time_point t) -> long long
+    {
+        auto wall = wall_now - std::chrono::duration_cast<
+            std::chrono::system_clock::duration>(steady_now - t);
+
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            wall.time_since_epoch()).count();
+    };
+
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+        << ",\"args\":{\"name\":\"rank " << rank << "\"}},\n";
+
+    size_t n_events = events.size();
+    for (size_t i = 0; i < n_events; ++i)
+    {
+        const teca_trace_event &ev = events[i];
+
+        long long t0 = to_us(ev.start);
+        long long dt = std::chrono::duration_cast<std::chrono::microseconds>(
+            ev.end - ev.start).count();
+
+        os << "{\"name\":\"" << ev.alg << "::" << ev.phase
+            << "\",\"cat\":\"" << ev.phase << "\",\"ph\":\"X\",\"ts\":" << t0
+            << ",\"dur\":" << dt << ",\"pid\":" << rank << ",\"tid\":"
+            << ev.thread << ",\"args\":{\"algorithm\":\"" << ev.alg
+            << "\",\"port\":" << ev.port << ",\"time_step\":" << ev.time_step
+            << ",\"bytes\":" << ev.n_bytes << ",\"rank\":" << rank << "}},\n";
+    }
+}
+};
+
+// --------------------------------------------------------------------------
+void teca_tracer::set_file_name(const std::string &file_name)
+{
+    teca_tracer_state &state = get_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.file_name = file_name;
+    state.enabled = !file_name.empty();
+}
+
+// --------------------------------------------------------------------------
+std::string teca_tracer::get_file_name()
+{
+    teca_tracer_state &state = get_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.file_name;
+}
+
+// --------------------------------------------------------------------------
+bool teca_tracer::enabled() noexcept
+{
+    return get_state().enabled;
+}
+
+// --------------------------------------------------------------------------
+void teca_tracer::record(const char *phase, const teca_algorithm *alg,
+    unsigned int port, long time_step, unsigned long n_bytes,
+    clock_t::time_point start, clock_t::time_point end)
+{
+    teca_tracer_state &state = get_state();
+
+    teca_trace_event ev{phase, get_class_name(alg), port,
+        time_step, n_bytes, get_thread_index(), start, end};
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.events.push_back(std::move(ev));
+}
+
+// --------------------------------------------------------------------------
+int teca_tracer::write()
+{
+    teca_tracer_state &state = get_state();
+    if (!state.enabled)
+        return 0;
+
+    int rank = 0;
+    int n_ranks = 1;
+#if defined(TECA_HAS_MPI)
+    int is_init = 0;
+    MPI_Initialized(&is_init);
+    if (is_init)
+    {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+    }
+#endif
+
+    // serialize the local spans
+    std::vector<teca_trace_event> events;
+    std::string file_name;
+    {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    events.swap(state.events);
+    file_name = state.file_name;
+    }
+
+    std::ostringstream oss;
+    write_events(oss, rank, events);
+    std::string local = oss.str();
+
+    // gather to rank 0
+    std::string merged;
+#if defined(TECA_HAS_MPI)
+    if (n_ranks > 1)
+    {
+        int n_local = local.size();
+        std::vector<int> counts(n_ranks);
+        MPI_Gather(&n_local, 1, MPI_INT, counts.data(), 1, MPI_INT,
+            0, MPI_COMM_WORLD);
+
+        std::vector<int> displs(n_ranks, 0);
+        if (rank == 0)
+        {
+            for (int i = 1; i < n_ranks; ++i)
+                displs[i] = displs[i-1] + counts[i-1];
+            merged.resize(displs[n_ranks-1] + counts[n_ranks-1]);
+        }
+
+        MPI_Gatherv(&local[0], n_local, MPI_CHAR, &merged[0],
+            counts.data(), displs.data(), MPI_CHAR, 0, MPI_COMM_WORLD);
+    }
+    else
+#endif
+    {
+        merged.swap(local);
+    }
+
+    if (rank == 0)
+    {
+        std::ofstream ofs(file_name);
+        if (!ofs.good())
+        {
+            TECA_ERROR("Failed to open \"" << file_name << "\" for writing")
+            return -1;
+        }
+
+        // the trailing comma is dropped from the last event
+        size_t n = merged.size();
+        if (n > 1)
+            merged.resize(n - 2);
+
+        ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+            << merged << "\n]}\n";
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+teca_trace_span::teca_trace_span(const char *phase, const teca_algorithm *alg,
+    unsigned int port) : m_phase(phase), m_alg(alg), m_port(port),
+    m_time_step(-1), m_bytes(0)
+{
+    if (teca_tracer::enabled())
+        m_start = teca_tracer::clock_t::now();
+}
+
+// --------------------------------------------------------------------------
+teca_trace_span::teca_trace_span(const char *phase, const teca_algorithm *alg,
+    unsigned int port, const teca_metadata &request) : m_phase(phase),
+    m_alg(alg), m_port(port), m_time_step(-1), m_bytes(0)
+{
+    if (teca_tracer::enabled())
+    {
+        request.get("time_step", m_time_step);
+        m_start = teca_tracer::clock_t::now();
+    }
+}
+
+// --------------------------------------------------------------------------
+teca_trace_span::~teca_trace_span()
+{
+    if (teca_tracer::enabled() &&
+        (m_start != teca_tracer::clock_t::time_point()))
+    {
+        teca_tracer::record(m_phase, m_alg, m_port, m_time_step,
+            m_bytes, m_start, teca_tracer::clock_t::now());
+    }
+}
+
+// --------------------------------------------------------------------------
+void teca_trace_span::set_output(const const_p_teca_dataset &data)
+{
+    if (data && teca_tracer::enabled())
+        m_bytes = data->get_memory_usage();
+}
@@ -0,0 +1,77 @@
+#ifndef teca_tracer_h
+#define teca_tracer_h
+
+#include "teca_dataset_fwd.h"
+
+#include <string>
+#include <chrono>
+
+class teca_algorithm;
+class teca_metadata;
+
+/// an opt-in tracer recording the phases of pipeline execution
+/**
+When enabled each phase of pipeline execution, such as reporting
+metadata, generating upstream requests, waiting on upstream data
+and executing, is recorded as a span holding the algorithm's class,
+the port, the time step requested, the thread, the MPI rank and
+the size of the data produced. At the end of the run the spans from
+all ranks are gathered and written to a single file in the Chrome
+trace event format, which can be loaded in chrome://tracing or
+Perfetto to view all ranks and threads on one timeline.
+
+Tracing is enabled by setting the environment variable TECA_TRACE
+to the name of the file to write, or by calling set_file_name.
+teca_mpi_manager writes the trace before MPI is finalized.
+*/
+class teca_tracer
+{
+public:
+    using clock_t = std::chrono::steady_clock;
+
+    // enable tracing. the trace is written to the named file.
+    // passing an empty string disables tracing.
+    static void set_file_name(const std::string &file_name);
+    static std::string get_file_name();
+
+    // returns true if tracing is enabled
+    static bool enabled() noexcept;
+
+    // record a span
+    static void record(const char *phase, const teca_algorithm *alg,
+        unsigned int port, long time_step, unsigned long n_bytes,
+        clock_t::time_point start, clock_t::time_point end);
+
+    // gather the spans recorded on all ranks and write them to the
+    // file on rank 0. the spans are then discarded. this is collective.
+    static int write();
+};
+
+/// records a span from construction to destruction when tracing is enabled
+class teca_trace_span
+{
+public:
+    teca_trace_span(const char *phase, const teca_algorithm *alg,
+        unsigned int port);
+
+    teca_trace_span(const char *phase, const teca_algorithm *alg,
+        unsigned int port, const teca_metadata &request);
+
+    ~teca_trace_span();
+
+    teca_trace_span(const teca_trace_span &) = delete;
+    void operator=(const teca_trace_span &) = delete;
+
+    // set the data produced during the span. its size is recorded.
+    void set_output(const const_p_teca_dataset &data);
+
+private:
+    const char *m_phase;
+    const teca_algorithm *m_alg;
+    unsigned int m_port;
+    long m_time_step;
+    unsigned long m_bytes;
+    teca_tracer::clock_t::time_point m_start;
+};
+
+#endif
@@ -28,12 +28,16 @@ void teca_variant_array::append(const teca_variant_array &other)
 {
     TEMPLATE_DISPATCH_CLASS(
         teca_variant_array_impl, std::string, this, &other,
-        p1_tt->append(p2_tt->m_data);
+        auto &buffer = p1_tt->own();
+        buffer.insert(buffer.end(), p2_tt->data(),
+            p2_tt->data() + p2_tt->size());
         return;
         )
     TEMPLATE_DISPATCH_CLASS(
         teca_variant_array_impl, teca_metadata, this, &other,
-        p1_tt->append(p2_tt->m_data);
+        auto &buffer = p1_tt->own();
+        buffer.insert(buffer.end(), p2_tt->data(),
+            p2_tt->data() + p2_tt->size());
         return;
         )
     TEMPLATE_DISPATCH(teca_variant_array_impl, this,
@@ -9,8 +9,10 @@
 #include <algorithm>
 #include <type_traits>
 #include <utility>
+#include <memory>
 
 #include "teca_common.h"
+#include "teca_allocator.h"
 #include "teca_binary_stream.h"
 #include "teca_variant_array_fwd.h"
 
@@ -57,11 +59,27 @@ public:
     virtual p_teca_variant_array new_instance() const = 0;
     virtual p_teca_variant_array new_instance(size_t n) const = 0;
 
+    // as above but the elements of arrays of numbers are left
+    // uninitialized. use when every element will be written.
+    virtual p_teca_variant_array new_instance(size_t n,
+        teca_uninitialized_t) const = 0;
+
     // virtual copy construct. return a new'ly allocated object,
     // initialized copy from this. caller must delete.
     virtual p_teca_variant_array new_copy() const = 0;
     virtual p_teca_variant_array new_copy(size_t start, size_t end) const = 0;
 
+    // return a new'ly allocated view of the values in [start end]
+    // inclusive. the view shares this array's storage rather than
+    // copying it. writing to the view, or to this array through set,
+    // append, resize or get, first gives the one written its own copy.
+    // values written through a pointer taken from the non-const get
+    // before the view was made show up in the view. a view keeps all
+    // of this array's storage alive, but reports only the bytes of
+    // its own values in get_memory_usage, such that the views of an
+    // array's disjoint ranges add up to the array's usage.
+    virtual p_teca_variant_array new_view(size_t start, size_t end) const = 0;
+
     // return true if values are equal
     bool operator==(const teca_variant_array &other) const
     { return this->equal(other); }
@@ -107,8 +125,15 @@ public:
     // get the number of elements in the array
     virtual unsigned long size() const noexcept = 0;
 
-    // resize. allocates new storage and copies in existing values
+    // get the number of bytes used to store the elements
+    virtual unsigned long get_memory_usage() const noexcept = 0;
+
+    // resize. allocates new storage and copies in existing values.
+    // new elements are value initialized, unless teca_uninitialized
+    // is passed in which case new elements of arrays of numbers are
+    // left uninitialized.
     virtual void resize(unsigned long i) = 0;
+    virtual void resize(unsigned long i, teca_uninitialized_t) = 0;
 
     // reserve. reserves the requested ammount of space with out
     // constructing elements
@@ -258,6 +283,8 @@ struct pack_object
 template<typename T>
 class teca_variant_array_impl : public teca_variant_array
 {
+    using buffer_t = std::vector<T, teca_aligned_allocator<T>>;
+
 public:
     // construct
     TECA_VARIANT_ARRAY_STATIC_NEW(teca_variant_array_impl, T)
@@ -268,8 +295,11 @@ public:
     // virtual constructor
     virtual p_teca_variant_array new_copy() const override;
     virtual p_teca_variant_array new_copy(size_t start, size_t end) const override;
+    virtual p_teca_variant_array new_view(size_t start, size_t end) const override;
     virtual p_teca_variant_array new_instance() const override;
     virtual p_teca_variant_array new_instance(size_t n) const override;
+    virtual p_teca_variant_array new_instance(size_t n,
+        teca_uninitialized_t) const override;
 
     // copy
     const teca_variant_array_impl<T> &
@@ -287,10 +317,10 @@ public:
 
     // get the ith value
     T &get(unsigned long i)
-    { return m_data[i]; }
+    { return this->own()[i]; }
 
     const T &get(unsigned long i) const
-    { return m_data[i]; }
+    { return this->data()[i]; }
 
     // get the ith value
     template<typename U>
@@ -306,8 +336,10 @@ public:
     void get(std::vector<U> &val) const;
 
     // pointer to the data
-    T *get(){ return &m_data[0]; }
-    const T *get() const { return &m_data[0]; }
+    // when the data is shared with a view, the non-const overload
+    // first makes a copy of it
+    T *get(){ return this->own().data(); }
+    const T *get() const { return this->data(); }
 
     // set the ith value
     template<typename U>
@@ -334,8 +366,13 @@ public:
     // get the current size of the data
     virtual unsigned long size() const noexcept override;
 
+    // get the number of bytes used to store the data. a view reports
+    // the size of its own values
+    virtual unsigned long get_memory_usage() const noexcept override;
+
     // resize the data
     virtual void resize(unsigned long n) override;
+    virtual void resize(unsigned long n, teca_uninitialized_t) override;
     void resize(unsigned long n, const T &val);
 
     // reserve space
@@ -375,29 +412,52 @@ public:
 
 protected:
     // construct
-    teca_variant_array_impl() noexcept {}
+    teca_variant_array_impl() noexcept
+        : m_offset(0), m_size(0), m_view(false) {}
 
     // construct with preallocated size
     teca_variant_array_impl(unsigned long n)
-        : m_data(n) {}
+        : m_buffer(std::make_shared<buffer_t>(n, T())),
+        m_offset(0), m_size(0), m_view(false) {}
+
+    // construct with preallocated size, numbers are not initialized
+    teca_variant_array_impl(unsigned long n, teca_uninitialized_t)
+        : m_buffer(std::make_shared<buffer_t>(n)),
+        m_offset(0), m_size(0), m_view(false) {}
 
     // construct with preallocated size and initialized
     // to a specific value
     teca_variant_array_impl(unsigned long n, const T &v)
-        : m_data(n, v) {}
+        : m_buffer(std::make_shared<buffer_t>(n, v)),
+        m_offset(0), m_size(0), m_view(false) {}
 
     // construct from a c-array of length n
     teca_variant_array_impl(const T *vals, unsigned long n)
-        : teca_variant_array(), m_data(vals, vals+n) {}
+        : teca_variant_array(),
+        m_buffer(std::make_shared<buffer_t>(vals, vals+n)),
+        m_offset(0), m_size(0), m_view(false) {}
 
     // copy construct from an instance of different type
     template<typename U>
     teca_variant_array_impl(const teca_variant_array_impl<U> &other)
-        : teca_variant_array(), m_data(other.m_data) {}
+        : teca_variant_array(),
+        m_buffer(std::make_shared<buffer_t>(other.data(),
+            other.data() + other.size())),
+        m_offset(0), m_size(0), m_view(false) {}
 
     // copy construct from an instance of same type
     teca_variant_array_impl(const teca_variant_array_impl<T> &other)
-        : teca_variant_array(), m_data(other.m_data) {}
+        : teca_variant_array(),
+        m_buffer(other.m_buffer ? std::make_shared<buffer_t>(other.data(),
+            other.data() + other.size()) : nullptr),
+        m_offset(0), m_size(0), m_view(false) {}
+
+    // construct a view of the n values of other starting at
+    // first. the data is shared until one of the two is modified
+    teca_variant_array_impl(const teca_variant_array_impl<T> &other,
+        unsigned long first, unsigned long n)
+        : teca_variant_array(), m_buffer(other.m_buffer),
+        m_offset(other.m_offset + first), m_size(n), m_view(true) {}
 
 private:
     // tag dispatch c style array, and types that have overrides in
@@ -464,7 +524,24 @@ private:
     // for serializaztion
     virtual unsigned int type_code() const noexcept override;
 private:
-    std::vector<T> m_data;
+    // pointer to the first value
+    const T *data() const noexcept
+    { return m_buffer ? m_buffer->data() + m_offset : nullptr; }
+
+    // get the buffer for writing. when the buffer is shared with a
+    // view, or this is a view, the values are first copied into a
+    // buffer of its own
+    buffer_t &own();
+
+private:
+    // the buffer may be shared with views of this array. a view holds
+    // m_size values starting at m_offset, otherwise the values are the
+    // whole buffer. storage is aligned, and numbers are not zero filled
+    // unless a value is passed when sizing
+    std::shared_ptr<buffer_t> m_buffer;
+    unsigned long m_offset;
+    unsigned long m_size;
+    bool m_view;
 
     friend class teca_variant_array;
     template<typename U> friend class teca_variant_array_impl;
@@ -814,9 +891,41 @@ template<typename T>
 p_teca_variant_array teca_variant_array_impl<T>::new_copy(
     size_t start, size_t end) const
 {
-    p_teca_variant_array_impl<T> c = teca_variant_array_impl<T>::New(end-start+1);
-    this->get(start, end, c->get());
-    return c;
+    const T *first = this->data();
+    return p_teca_variant_array(
+        new teca_variant_array_impl<T>(first + start, end-start+1));
+}
+
+// --------------------------------------------------------------------------
+template<typename T>
+p_teca_variant_array teca_variant_array_impl<T>::new_view(
+    size_t start, size_t end) const
+{
+    return p_teca_variant_array(
+        new teca_variant_array_impl<T>(*this, start, end-start+1));
+}
+
+// --------------------------------------------------------------------------
+template<typename T>
+typename teca_variant_array_impl<T>::buffer_t &
+teca_variant_array_impl<T>::own()
+{
+    if (!m_buffer)
+    {
+        m_buffer = std::make_shared<buffer_t>();
+    }
+    else if (m_view || (m_buffer.use_count() > 1))
+    {
+        // copies don't share storage, only views do. making a view
+        // reads this array, so it can't overlap this write. a view
+        // released meanwhile costs at most an extra copy
+        const T *first = this->data();
+        m_buffer = std::make_shared<buffer_t>(first, first + this->size());
+        m_offset = 0;
+        m_size = 0;
+        m_view = false;
+    }
+    return *m_buffer;
 }
 
 // --------------------------------------------------------------------------
@@ -833,12 +942,28 @@ p_teca_variant_array teca_variant_array_impl<T>::new_instance(size_t n) const
     return p_teca_variant_array(new teca_variant_array_impl<T>(n));
 }
 
+// --------------------------------------------------------------------------
+template<typename T>
+p_teca_variant_array teca_variant_array_impl<T>::new_instance(size_t n,
+    teca_uninitialized_t) const
+{
+    return p_teca_variant_array(
+        new teca_variant_array_impl<T>(n, teca_uninitialized));
+}
+
 // --------------------------------------------------------------------------
 template<typename T>
 const teca_variant_array_impl<T> &
 teca_variant_array_impl<T>::operator=(const teca_variant_array_impl<T> &other)
 {
-    m_data.assign(other.m_data.begin(), other.m_data.end());
+    if (this == &other)
+        return *this;
+
+    m_buffer = other.m_buffer ? std::make_shared<buffer_t>(other.data(),
+        other.data() + other.size()) : nullptr;
+    m_offset = 0;
+    m_size = 0;
+    m_view = false;
     return *this;
 }
 
@@ -849,7 +974,11 @@ template<typename U>
 const teca_variant_array_impl<T> &
 teca_variant_array_impl<T>::operator=(const teca_variant_array_impl<U> &other)
 {
-    m_data.assign(other.m_data.begin(), other.m_data.end());
+    m_buffer = std::make_shared<buffer_t>(other.data(),
+        other.data() + other.size());
+    m_offset = 0;
+    m_size = 0;
+    m_view = false;
     return *this;
 }
 
@@ -857,15 +986,22 @@ teca_variant_array_impl<T>::operator=(const teca_variant_array_impl<U> &other)
 template<typename T>
 teca_variant_array_impl<T>::teca_variant_array_impl(
     teca_variant_array_impl<T> &&other)
-    : m_data(std::move(other.m_data))
-{}
+    : m_buffer(std::move(other.m_buffer)), m_offset(other.m_offset),
+    m_size(other.m_size), m_view(other.m_view)
+{
+    other.clear();
+}
 
 // --------------------------------------------------------------------------
 template<typename T>
 const teca_variant_array_impl<T> &teca_variant_array_impl<T>::operator=(
     teca_variant_array_impl<T> &&other)
 {
-    m_data = std::move(other.m_data);
+    m_buffer = std::move(other.m_buffer);
+    m_offset = other.m_offset;
+    m_size = other.m_size;
+    m_view = other.m_view;
+    other.clear();
     return *this;
 }
 
@@ -874,7 +1010,7 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::get(unsigned long i, U &val) const
 {
-    val = m_data[i];
+    val = this->data()[i];
 }
 
 // --------------------------------------------------------------------------
@@ -882,8 +1018,9 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::get(size_t start, size_t end, U *vals) const
 {
+    const T *pdata = this->data();
     for (size_t i = start, ii = 0; i <= end; ++i, ++ii)
-        vals[ii] = m_data[i];
+        vals[ii] = pdata[i];
 }
 
 // --------------------------------------------------------------------------
@@ -891,7 +1028,7 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::get(std::vector<U> &val) const
 {
-    val.assign(m_data.begin(), m_data.end());
+    val.assign(this->data(), this->data() + this->size());
 }
 
 // --------------------------------------------------------------------------
@@ -899,7 +1036,7 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::set(unsigned long i, const U &val)
 {
-    m_data[i] = val;
+    this->own()[i] = val;
 }
 
 // --------------------------------------------------------------------------
@@ -907,8 +1044,9 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::set(size_t start, size_t end, const U *vals)
 {
+    buffer_t &buffer = this->own();
     for (size_t i = start, ii = 0; i <= end; ++i, ++ii)
-        m_data[i] = vals[ii];
+        buffer[i] = vals[ii];
 }
 
 // --------------------------------------------------------------------------
@@ -917,9 +1055,12 @@ template<typename U>
 void teca_variant_array_impl<T>::set(const std::vector<U> &val)
 {
     size_t n = val.size();
-    m_data.resize(n);
+    // the values are replaced, don't copy them when shared
+    this->clear();
+    buffer_t &buffer = this->own();
+    buffer.resize(n);
     for (size_t i = 0; i < n; ++i)
-        m_data[i] = static_cast<T>(val[i]);
+        buffer[i] = static_cast<T>(val[i]);
 }
 
 // --------------------------------------------------------------------------
@@ -927,7 +1068,7 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::append(const std::vector<U> &val)
 {
-    std::copy(val.begin(), val.end(), std::back_inserter(m_data));
+    std::copy(val.begin(), val.end(), std::back_inserter(this->own()));
 }
 
 // --------------------------------------------------------------------------
@@ -935,40 +1076,60 @@ template<typename T>
 template<typename U>
 void teca_variant_array_impl<T>::append(const U &val)
 {
-    m_data.push_back(val);
+    this->own().push_back(val);
 }
 
 // --------------------------------------------------------------------------
 template<typename T>
 unsigned long teca_variant_array_impl<T>::size() const noexcept
-{ return m_data.size(); }
+{ return m_view ? m_size : (m_buffer ? m_buffer->size() : 0); }
+
+// --------------------------------------------------------------------------
+template<typename T>
+unsigned long teca_variant_array_impl<T>::get_memory_usage() const noexcept
+{ return sizeof(T)*this->size(); }
 
 // --------------------------------------------------------------------------
 template<typename T>
 void teca_variant_array_impl<T>::resize(unsigned long n)
 {
-    m_data.resize(n);
+    this->own().resize(n, T());
+}
+
+// --------------------------------------------------------------------------
+template<typename T>
+void teca_variant_array_impl<T>::resize(unsigned long n, teca_uninitialized_t)
+{
+    this->own().resize(n);
 }
 
 // --------------------------------------------------------------------------
 template<typename T>
 void teca_variant_array_impl<T>::resize(unsigned long n, const T &val)
 {
-    m_data.resize(n, val);
+    this->own().resize(n, val);
 }
 
 // --------------------------------------------------------------------------
 template<typename T>
 void teca_variant_array_impl<T>::reserve(unsigned long n)
 {
-    m_data.reserve(n);
+    this->own().reserve(n);
 }
 
 // --------------------------------------------------------------------------
 template<typename T>
 void teca_variant_array_impl<T>::clear() noexcept
 {
-    m_data.clear();
+    // keep the allocation when no other array uses it
+    if (m_buffer && !m_view && (m_buffer.use_count() == 1))
+        m_buffer->clear();
+    else
+        m_buffer = nullptr;
+
+    m_offset = 0;
+    m_size = 0;
+    m_view = false;
 }
 
 // --------------------------------------------------------------------------
@@ -989,10 +1150,12 @@ void teca_variant_array_impl<T>::append(const teca_variant_array &other)
 {
     TEMPLATE_DISPATCH(const teca_variant_array_impl, &other,
         TT *other_t = static_cast<TT*>(&other);
-        std::copy(
-            other_t->m_data.begin(),
-            other_t->m_data.end(),
-            std::back_inserter(this->m_data));
+        buffer_t &buffer = this->own();
+        size_t n = other_t->size();
+        buffer.reserve(buffer.size() + n);
+        const auto *pother = other_t->data();
+        for (size_t i = 0; i < n; ++i)
+            buffer.push_back(pother[i]);
         return;
         )
      throw std::bad_cast();
@@ -1006,7 +1169,10 @@ void teca_variant_array_impl<T>::swap(teca_variant_array &other)
     TT *other_t = dynamic_cast<TT*>(&other);
     if (other_t)
     {
-        this->m_data.swap(other_t->m_data);
+        std::swap(this->m_buffer, other_t->m_buffer);
+        std::swap(this->m_offset, other_t->m_offset);
+        std::swap(this->m_size, other_t->m_size);
+        std::swap(this->m_view, other_t->m_view);
         return;
     }
     throw std::bad_cast();
@@ -1020,7 +1186,9 @@ bool teca_variant_array_impl<T>::equal(const teca_variant_array &other) const
     const TT *other_t = dynamic_cast<const TT*>(&other);
     if (other_t)
     {
-        return this->m_data == other_t->m_data;
+        size_t n = this->size();
+        return (n == other_t->size()) &&
+            std::equal(this->data(), this->data() + n, other_t->data());
     }
     throw std::bad_cast();
     return false;
@@ -1033,7 +1201,10 @@ void teca_variant_array_impl<T>::to_binary(
     teca_binary_stream &s,
     typename std::enable_if<pack_array<U>::value, U>::type*) const
 {
-    s.pack(this->m_data);
+    const unsigned long n = this->size();
+    s.pack(n);
+    if (n)
+        s.pack_reference(this->data(), n, m_buffer);
 }
 
 // --------------------------------------------------------------------------
@@ -1043,7 +1214,11 @@ void teca_variant_array_impl<T>::from_binary(
     teca_binary_stream &s,
     typename std::enable_if<pack_array<U>::value, U>::type*)
 {
-    s.unpack(this->m_data);
+    unsigned long n = 0;
+    s.unpack(n);
+    this->clear();
+    this->resize(n, teca_uninitialized);
+    s.unpack(this->get(), n);
 }
 
 // --------------------------------------------------------------------------
@@ -1056,7 +1231,7 @@ void teca_variant_array_impl<T>::to_binary(
     unsigned long long n = this->size();
     s.pack(n);
     for (unsigned long long i=0; i<n; ++i)
-       this->m_data[i].to_stream(s);
+       this->data()[i].to_stream(s);
 }
 
 // --------------------------------------------------------------------------
@@ -1069,8 +1244,9 @@ void teca_variant_array_impl<T>::from_binary(
     unsigned long long n;
     s.unpack(n);
     this->resize(n);
+    T *pdata = this->get();
     for (unsigned long long i=0; i<n; ++i)
-       this->m_data[i].from_stream(s);
+       pdata[i].from_stream(s);
 }
 
 // --------------------------------------------------------------------------
@@ -1083,7 +1259,7 @@ void teca_variant_array_impl<T>::to_binary(
     unsigned long long n = this->size();
     s.pack(n);
     for (unsigned long long i=0; i<n; ++i)
-       this->m_data[i]->to_stream(s);
+       this->data()[i]->to_stream(s);
 }
 
 // --------------------------------------------------------------------------
@@ -1096,8 +1272,9 @@ void teca_variant_array_impl<T>::from_binary(
     unsigned long long n;
     s.unpack(n);
     this->resize(n);
+    T *pdata = this->get();
     for (unsigned long long i=0; i<n; ++i)
-       this->m_data[i]->from_stream(s);
+       pdata[i]->from_stream(s);
 }
 
 #define STR_DELIM(_a, _b) \
@@ -1110,15 +1287,15 @@ void teca_variant_array_impl<T>::to_ascii(
     std::ostream &s,
     typename std::enable_if<pack_array<U>::value, U>::type*) const
 {
-    size_t n = this->m_data.size();
+    size_t n = this->size();
     if (n)
     {
         s << STR_DELIM("\"", "")
-             << this->m_data[0] << STR_DELIM("\"", "");
+             << this->data()[0] << STR_DELIM("\"", "");
         for (size_t i = 1; i < n; ++i)
         {
             s << STR_DELIM(", \"", ", ")
-                << this->m_data[i] << STR_DELIM("\"", "");
+                << this->data()[i] << STR_DELIM("\"", "");
         }
     }
 }
@@ -1140,16 +1317,16 @@ void teca_variant_array_impl<T>::to_ascii(
     std::ostream &s,
     typename std::enable_if<pack_object<U>::value, U>::type*) const
 {
-    size_t n = this->m_data.size();
+    size_t n = this->size();
     if (n)
     {
         s << "{";
-        this->m_data[0].to_stream(s);
+        this->data()[0].to_stream(s);
         s << "}";
         for (size_t i = 1; i < n; ++i)
         {
             s << ", {";
-            this->m_data[i].to_stream(s);
+            this->data()[i].to_stream(s);
             s << "}";
         }
     }
@@ -1172,16 +1349,16 @@ void teca_variant_array_impl<T>::to_ascii(
     std::ostream &s,
     typename std::enable_if<pack_object_ptr<U>::value, U>::type*) const
 {
-    size_t n = this->m_data.size();
+    size_t n = this->size();
     if (n)
     {
         s << "{";
-        this->m_data[0]->to_stream(s);
+        this->data()[0]->to_stream(s);
         s << "}";
         for (size_t i = 1; i < n; ++i)
         {
             s << ", {";
-            this->m_data[i]->to_stream(s);
+            this->data()[i]->to_stream(s);
             s << "}";
         }
     }
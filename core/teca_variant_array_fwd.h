@@ -79,6 +79,11 @@ static std::shared_ptr<T<t>> New(size_t n)                              \
     return std::shared_ptr<T<t>>(new T<t>(n));                          \
 }                                                                       \
                                                                         \
+static std::shared_ptr<T<t>> New(size_t n, teca_uninitialized_t)        \
+{                                                                       \
+    return std::shared_ptr<T<t>>(new T<t>(n, teca_uninitialized));      \
+}                                                                       \
+                                                                        \
 static std::shared_ptr<T<t>> New(size_t n, const t &v)                  \
 {                                                                       \
     return std::shared_ptr<T<t>>(new T<t>(n, v));                       \
@@ -168,6 +168,19 @@ void teca_array_collection::swap(p_teca_array_collection &other)
     std::swap(m_arrays, other->m_arrays);
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_array_collection::get_memory_usage() const noexcept
+{
+    unsigned long n_bytes = 0;
+    unsigned int n_arrays = m_arrays.size();
+    for (unsigned int i = 0; i < n_arrays; ++i)
+    {
+        if (m_arrays[i])
+            n_bytes += m_arrays[i]->get_memory_usage();
+    }
+    return n_bytes;
+}
+
 // --------------------------------------------------------------------------
 void teca_array_collection::to_stream(teca_binary_stream &s) const
 {
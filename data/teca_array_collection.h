@@ -84,6 +84,9 @@ public:
     // swap
     void swap(p_teca_array_collection &other);
 
+    // return the number of bytes used by the arrays
+    unsigned long get_memory_usage() const noexcept;
+
     // serialize the data to/from the given stream
     // for I/O or communication
     void to_stream(teca_binary_stream &s) const;
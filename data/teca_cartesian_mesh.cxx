@@ -73,6 +73,13 @@ void teca_cartesian_mesh::swap(p_teca_dataset &dataset)
     m_coordinate_arrays->swap(other->m_coordinate_arrays);
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_cartesian_mesh::get_memory_usage() const noexcept
+{
+    return this->teca_mesh::get_memory_usage()
+        + m_coordinate_arrays->get_memory_usage();
+}
+
 // --------------------------------------------------------------------------
 void teca_cartesian_mesh::to_stream(teca_binary_stream &s) const
 {
@@ -103,6 +103,12 @@ void teca_database::swap(p_teca_dataset &o)
     other->tables = tmp;
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_database::get_memory_usage() const noexcept
+{
+    return this->tables->get_memory_usage();
+}
+
 // --------------------------------------------------------------------------
 void teca_database::to_stream(teca_binary_stream &s) const
 {
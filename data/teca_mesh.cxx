@@ -75,6 +75,16 @@ void teca_mesh::swap(p_teca_dataset &dataset)
     std::swap(m_impl, other->m_impl);
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_mesh::get_memory_usage() const noexcept
+{
+    return m_impl->point_arrays->get_memory_usage()
+        + m_impl->cell_arrays->get_memory_usage()
+        + m_impl->edge_arrays->get_memory_usage()
+        + m_impl->face_arrays->get_memory_usage()
+        + m_impl->info_arrays->get_memory_usage();
+}
+
 // --------------------------------------------------------------------------
 void teca_mesh::to_stream(teca_binary_stream &s) const
 {
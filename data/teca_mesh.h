@@ -58,6 +58,9 @@ public:
     // swap internals of the two objects
     void swap(p_teca_dataset &) override;
 
+    // return the number of bytes used by the mesh's arrays
+    unsigned long get_memory_usage() const noexcept override;
+
     // serialize the dataset to/from the given stream
     // for I/O or communication
     void to_stream(teca_binary_stream &) const override;
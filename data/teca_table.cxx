@@ -228,6 +228,12 @@ void teca_table::swap(p_teca_dataset &dataset)
     m_impl->active_column = 0;
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_table::get_memory_usage() const noexcept
+{
+    return m_impl->columns->get_memory_usage();
+}
+
 // --------------------------------------------------------------------------
 void teca_table::concatenate_rows(const const_p_teca_table &other)
 {
@@ -126,6 +126,9 @@ public:
     // swap internals of the two objects
     void swap(p_teca_dataset &other) override;
 
+    // return the number of bytes used by the columns
+    unsigned long get_memory_usage() const noexcept override;
+
     // append rows from the passed in table which must have identical
     // columns.
     void concatenate_rows(const const_p_teca_table &other);
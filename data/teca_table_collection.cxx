@@ -165,6 +165,19 @@ void teca_table_collection::swap(p_teca_table_collection &other)
     std::swap(m_tables, other->m_tables);
 }
 
+// --------------------------------------------------------------------------
+unsigned long teca_table_collection::get_memory_usage() const noexcept
+{
+    unsigned long n_bytes = 0;
+    unsigned int n_tables = m_tables.size();
+    for (unsigned int i = 0; i < n_tables; ++i)
+    {
+        if (m_tables[i])
+            n_bytes += m_tables[i]->get_memory_usage();
+    }
+    return n_bytes;
+}
+
 // --------------------------------------------------------------------------
 void teca_table_collection::to_stream(teca_binary_stream &s) const
 {
@@ -372,7 +372,7 @@ public:
         NC_DISPATCH_FP(var_type,
             size_t start = 0;
             p_teca_variant_array_impl<NC_T> var = teca_variant_array_impl<NC_T>::New();
-            var->resize(var_size);
+            var->resize(var_size, teca_uninitialized);
             if ((ierr = nc_get_vara(file_id, var_id, &start, &var_size, var->get())) != NC_NOERR)
             {
                 m_reader_internals->close_handle(m_file);
@@ -505,8 +505,8 @@ teca_metadata teca_cf_reader::get_output_metadata(
     MPI_Initialized(&is_init);
     if (is_init)
     {
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-        MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+        MPI_Comm_rank(this->get_communicator(), &rank);
+        MPI_Comm_size(this->get_communicator(), &n_ranks);
     }
 #endif
     teca_binary_stream stream;
@@ -769,7 +769,7 @@ teca_metadata teca_cf_reader::get_output_metadata(
             p_teca_variant_array x_axis;
             NC_DISPATCH_FP(x_t,
                 size_t x_0 = 0;
-                p_teca_variant_array_impl<NC_T> x = teca_variant_array_impl<NC_T>::New(n_x);
+                p_teca_variant_array_impl<NC_T> x = teca_variant_array_impl<NC_T>::New(n_x, teca_uninitialized);
                 if ((ierr = nc_get_vara(file_id, x_id, &x_0, &n_x, x->get())) != NC_NOERR)
                 {
                     this->clear_cached_metadata();
@@ -786,7 +786,7 @@ teca_metadata teca_cf_reader::get_output_metadata(
             {
                 NC_DISPATCH_FP(y_t,
                     size_t y_0 = 0;
-                    p_teca_variant_array_impl<NC_T> y = teca_variant_array_impl<NC_T>::New(n_y);
+                    p_teca_variant_array_impl<NC_T> y = teca_variant_array_impl<NC_T>::New(n_y, teca_uninitialized);
                     if ((ierr = nc_get_vara(file_id, y_id, &y_0, &n_y, y->get())) != NC_NOERR)
                     {
                         this->clear_cached_metadata();
@@ -812,7 +812,7 @@ teca_metadata teca_cf_reader::get_output_metadata(
             {
                 NC_DISPATCH_FP(z_t,
                     size_t z_0 = 0;
-                    p_teca_variant_array_impl<NC_T> z = teca_variant_array_impl<NC_T>::New(n_z);
+                    p_teca_variant_array_impl<NC_T> z = teca_variant_array_impl<NC_T>::New(n_z, teca_uninitialized);
                     if ((ierr = nc_get_vara(file_id, z_id, &z_0, &n_z, z->get())) != NC_NOERR)
                     {
                         this->clear_cached_metadata();
@@ -842,8 +842,8 @@ teca_metadata teca_cf_reader::get_output_metadata(
             // when procesing large numbers of files these issues kill
             // serial performance. hence we are reading time dimension
             // in parallel.
-            read_variable_queue_t thread_pool(this->thread_pool_size,
-                true, true, false);
+            read_variable_queue_t thread_pool(MPI_COMM_SELF,
+                this->thread_pool_size, true, true, false);
 
             std::vector<unsigned long> step_count;
             p_teca_variant_array t_axis;
@@ -851,18 +851,20 @@ teca_metadata teca_cf_reader::get_output_metadata(
             {
                 // assign the reads to threads
                 size_t n_files = files.size();
+                std::vector<std::future<read_variable_data_t>> futures;
+                futures.reserve(n_files);
                 for (size_t i = 0; i < n_files; ++i)
                 {
                     read_variable reader(this->internals, path,
                         files[i], i, this->t_axis_variable);
                     read_variable_task_t task(reader);
-                    thread_pool.push_task(task);
+                    futures.push_back(thread_pool.push_task(task));
                 }
 
                 // wait for the results
                 std::vector<read_variable_data_t> tmp;
                 tmp.reserve(n_files);
-                thread_pool.wait_data(tmp);
+                thread_pool.wait_data(futures, tmp);
 
                 // unpack the results. map is used to ensure the correct
                 // file to time association.
@@ -952,7 +954,7 @@ teca_metadata teca_cf_reader::get_output_metadata(
 #if defined(TECA_HAS_MPI)
         // broadcast the metadata to other ranks
         if (is_init)
-            stream.broadcast(root_rank);
+            stream.broadcast(this->get_communicator(), root_rank);
 #endif
     }
 #if defined(TECA_HAS_MPI)
@@ -960,7 +962,7 @@ teca_metadata teca_cf_reader::get_output_metadata(
     if (is_init)
     {
         // all other ranks receive the metadata from the root
-        stream.broadcast(root_rank);
+        stream.broadcast(this->get_communicator(), root_rank);
 
         this->internals->metadata.from_stream(stream);
 
@@ -1223,7 +1225,8 @@ const_p_teca_dataset teca_cf_reader::execute(unsigned int port,
         p_teca_variant_array array;
         NC_DISPATCH(type,
             std::lock_guard<std::mutex> lock(*file_mutex);
-            p_teca_variant_array_impl<NC_T> a = teca_variant_array_impl<NC_T>::New(mesh_size);
+            p_teca_variant_array_impl<NC_T> a =
+                teca_variant_array_impl<NC_T>::New(mesh_size, teca_uninitialized);
             if ((ierr = nc_get_vara(file_id,  id, &starts[0], &counts[0], a->get())) != NC_NOERR)
             {
                 TECA_ERROR("time_step=" << time_step
@@ -0,0 +1,550 @@
+#include "teca_disk_cache.h"
+
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_binary_stream.h"
+#include "teca_file_util.h"
+#include "teca_tracer.h"
+#include "teca_cartesian_mesh.h"
+#include "teca_uniform_cartesian_mesh.h"
+#include "teca_table.h"
+#include "teca_database.h"
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <typeinfo>
+#include <functional>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+#include <errno.h>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(TECA_HAS_BOOST)
+#include <boost/program_options.hpp>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// identifies our files
+const char *file_header = "teca_disk_cache";
+const char *file_ext = ".teca_cache";
+
+// get the name used to identify the dataset's type on disk.
+// returns an empty string for types that are not supported.
+string get_dataset_type(const const_p_teca_dataset &ds)
+{
+    if (dynamic_cast<const teca_uniform_cartesian_mesh*>(ds.get()))
+        return "teca_uniform_cartesian_mesh";
+    else if (dynamic_cast<const teca_cartesian_mesh*>(ds.get()))
+        return "teca_cartesian_mesh";
+    else if (dynamic_cast<const teca_table*>(ds.get()))
+        return "teca_table";
+    else if (dynamic_cast<const teca_database*>(ds.get()))
+        return "teca_database";
+    return "";
+}
+
+// construct a dataset of the named type
+p_teca_dataset new_dataset(const string &type)
+{
+    if (type == "teca_uniform_cartesian_mesh")
+        return teca_uniform_cartesian_mesh::New();
+    else if (type == "teca_cartesian_mesh")
+        return teca_cartesian_mesh::New();
+    else if (type == "teca_table")
+        return teca_table::New();
+    else if (type == "teca_database")
+        return teca_database::New();
+    return nullptr;
+}
+
+// get the modification time of the file in ns. returns 0
+// on success.
+int get_file_info(const string &file, long long &mtime,
+    unsigned long long &size)
+{
+    struct stat s;
+    if (stat(file.c_str(), &s))
+        return -1;
+
+#if defined(__APPLE__)
+    mtime = s.st_mtimespec.tv_sec*1000000000ll + s.st_mtimespec.tv_nsec;
+#else
+    mtime = s.st_mtim.tv_sec*1000000000ll + s.st_mtim.tv_nsec;
+#endif
+    size = s.st_size;
+
+    return 0;
+}
+
+// test for our file extension
+bool is_cache_file(const char *name)
+{
+    size_t n = strlen(name);
+    size_t n_ext = strlen(file_ext);
+    return (n > n_ext) && (strcmp(name + n - n_ext, file_ext) == 0);
+}
+};
+
+// the part of the key that depends on the pipeline, it is
+// updated when the pipeline is modified
+class teca_disk_cache_internals
+{
+public:
+    teca_disk_cache_internals() : state_time(0), state_valid(false),
+        n_hits(0), n_misses(0), warned(false), warned_state(false),
+        disk_usage_valid(false), disk_usage(0) {}
+
+    std::mutex mutex;
+    unsigned long state_time;
+    bool state_valid;
+    teca_metadata state;
+    vector<string> unserialized;
+    std::atomic<unsigned long> n_hits;
+    std::atomic<unsigned long> n_misses;
+    std::atomic<bool> warned;
+    std::atomic<bool> warned_state;
+
+    // the bytes in the cache directory, counted by a scan of the
+    // directory and updated as files are written
+    std::mutex disk_mutex;
+    bool disk_usage_valid;
+    string disk_usage_directory;
+    unsigned long long disk_usage;
+};
+
+
+
+// --------------------------------------------------------------------------
+teca_disk_cache::teca_disk_cache() : disk_budget(-1),
+    internals(new teca_disk_cache_internals)
+{
+    this->set_number_of_input_connections(1);
+    this->set_number_of_output_ports(1);
+}
+
+// --------------------------------------------------------------------------
+teca_disk_cache::~teca_disk_cache() noexcept
+{
+    delete this->internals;
+}
+
+#if defined(TECA_HAS_BOOST)
+// --------------------------------------------------------------------------
+void teca_disk_cache::get_properties_description(
+    const string &prefix, options_description &global_opts)
+{
+    options_description opts("Options for "
+        + (prefix.empty()?"teca_disk_cache":prefix));
+
+    opts.add_options()
+        TECA_POPTS_GET(string, prefix, cache_directory,
+            "directory where datasets are cached. when empty caching "
+            "is disabled ()")
+        TECA_POPTS_GET(long, prefix, disk_budget,
+            "maximum number of bytes of cached datasets. when n < 0 "
+            "the amount is not limited (-1)")
+        TECA_POPTS_GET(string, prefix, cache_tag,
+            "text included in the key identifying cached datasets ()")
+        ;
+
+    global_opts.add(opts);
+}
+
+// --------------------------------------------------------------------------
+void teca_disk_cache::set_properties(
+    const string &prefix, variables_map &opts)
+{
+    TECA_POPTS_SET(opts, string, prefix, cache_directory)
+    TECA_POPTS_SET(opts, long, prefix, disk_budget)
+    TECA_POPTS_SET(opts, string, prefix, cache_tag)
+}
+#endif
+
+// --------------------------------------------------------------------------
+unsigned long teca_disk_cache::get_number_of_cache_hits() const
+{
+    return this->internals->n_hits;
+}
+
+// --------------------------------------------------------------------------
+unsigned long teca_disk_cache::get_number_of_cache_misses() const
+{
+    return this->internals->n_misses;
+}
+
+// --------------------------------------------------------------------------
+void teca_disk_cache::get_pipeline_state(const p_teca_algorithm &alg,
+    std::vector<std::string> &state, std::vector<std::string> &unserialized)
+{
+    std::ostringstream props;
+    alg->to_stream(props);
+
+    if (props.str().empty())
+        unserialized.push_back(typeid(*alg).name());
+
+    state.push_back(typeid(*alg).name() + props.str());
+
+    unsigned int n_inputs = alg->get_number_of_input_connections();
+    for (unsigned int i = 0; i < n_inputs; ++i)
+    {
+        this->get_pipeline_state(get_algorithm(alg->get_input_connection(i)),
+            state, unserialized);
+    }
+}
+
+// --------------------------------------------------------------------------
+int teca_disk_cache::get_key(teca_algorithm_output_port &conn,
+    const teca_metadata &request, teca_metadata &key)
+{
+    teca_disk_cache_internals *inter = this->internals;
+    unsigned long modified_time = this->get_pipeline_modified_time();
+
+    std::lock_guard<std::mutex> lock(inter->mutex);
+
+    if (!inter->state_valid || (inter->state_time != modified_time))
+    {
+        teca_metadata state;
+
+        // the algorithms upstream
+        vector<string> pipeline;
+        inter->unserialized.clear();
+        this->get_pipeline_state(get_algorithm(conn), pipeline,
+            inter->unserialized);
+        state.insert("pipeline", pipeline);
+        state.insert("tag", this->cache_tag);
+
+        // the input files
+        teca_metadata md = this->get_output_metadata(conn);
+
+        string root;
+        vector<string> files;
+        if (!md.get("files", files))
+        {
+            md.get("root", root);
+
+            size_t n_files = files.size();
+            vector<long long> mtimes(n_files);
+            vector<unsigned long long> sizes(n_files);
+            for (size_t i = 0; i < n_files; ++i)
+            {
+                string file = root.empty() ? files[i] : root + PATH_SEP + files[i];
+                if (get_file_info(file, mtimes[i], sizes[i]))
+                {
+                    const char *estr = strerror(errno);
+                    TECA_ERROR("Failed to stat \"" << file << "\". " << estr)
+                    return -1;
+                }
+            }
+
+            state.insert("root", root);
+            state.insert("files", files);
+            state.insert("mtimes", mtimes);
+            state.insert("sizes", sizes);
+        }
+
+        inter->state = state;
+        inter->state_time = modified_time;
+        inter->state_valid = true;
+    }
+
+    // changes to the properties of algorithms that don't report them
+    // would go unnoticed and stale data would be served. unless the
+    // tag stands in for their settings the data is not cached.
+    if (!inter->unserialized.empty() && this->cache_tag.empty())
+    {
+        if (!inter->warned_state.exchange(true))
+        {
+            std::ostringstream oss;
+            std::copy(inter->unserialized.begin(), inter->unserialized.end(),
+                std::ostream_iterator<string>(oss, " "));
+
+            TECA_WARNING("Caching is disabled because the properties of "
+                << oss.str() << "are not reported by to_stream. Set "
+                "cache_tag to text identifying their settings to enable it.")
+        }
+        return 1;
+    }
+
+    key = inter->state;
+
+    // the scheduling priority doesn't change the data
+    teca_metadata req(request);
+    req.remove("__request_priority");
+    key.insert("request", req);
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_disk_cache::load(const teca_metadata &key, const_p_teca_dataset &data)
+{
+    std::ostringstream oss;
+    oss << this->cache_directory << PATH_SEP << std::hex << std::setfill('0')
+        << std::setw(16) << key.get_digest() << file_ext;
+    string file_name = oss.str();
+
+    if (!teca_file_util::file_exists(file_name.c_str()))
+        return -1;
+
+    teca_binary_stream stream;
+    if (teca_file_util::read_stream(file_name.c_str(), file_header, stream, false))
+        return -1;
+
+    // the digests of different keys may match
+    teca_metadata file_key;
+    file_key.from_stream(stream);
+    if (!(file_key == key))
+        return -1;
+
+    string type;
+    stream.unpack(type);
+
+    p_teca_dataset ds = new_dataset(type);
+    if (!ds)
+    {
+        TECA_ERROR("\"" << file_name << "\" holds an unknown dataset type \""
+            << type << "\"")
+        return -1;
+    }
+
+    ds->from_stream(stream);
+    data = ds;
+
+    // mark the file as recently used
+    utimensat(AT_FDCWD, file_name.c_str(), nullptr, 0);
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+int teca_disk_cache::save(const teca_metadata &key,
+    const const_p_teca_dataset &data)
+{
+    string type = get_dataset_type(data);
+    if (type.empty())
+    {
+        if (!this->internals->warned.exchange(true))
+        {
+            TECA_WARNING("Datasets of type " << typeid(*data).name()
+                << " are not cached")
+        }
+        return -1;
+    }
+
+    if (mkdir(this->cache_directory.c_str(), S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH)
+        && (errno != EEXIST))
+    {
+        const char *estr = strerror(errno);
+        TECA_ERROR("Failed to create \"" << this->cache_directory << "\". " << estr)
+        return -1;
+    }
+
+    // the arrays are written from the dataset rather than copied
+    // into the stream
+    teca_binary_stream stream;
+    stream.set_gather_threshold(teca_binary_stream::default_gather_threshold);
+    key.to_stream(stream);
+    stream.pack(type);
+    data->to_stream(stream);
+
+    std::ostringstream oss;
+    oss << this->cache_directory << PATH_SEP << std::hex << std::setfill('0')
+        << std::setw(16) << key.get_digest();
+    string file_name = oss.str() + file_ext;
+
+    // the file is written under a temporary name and renamed, such
+    // that threads and processes sharing the directory never read
+    // a partially written file
+    oss << "." << std::dec << getpid() << "."
+        << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+    string tmp_name = oss.str();
+
+    if (teca_file_util::write_stream(tmp_name.c_str(), file_header, stream))
+    {
+        remove(tmp_name.c_str());
+        return -1;
+    }
+
+    if (rename(tmp_name.c_str(), file_name.c_str()))
+    {
+        const char *estr = strerror(errno);
+        TECA_ERROR("Failed to rename \"" << tmp_name << "\" to \""
+            << file_name << "\". " << estr)
+        remove(tmp_name.c_str());
+        return -1;
+    }
+
+    long long mtime = 0;
+    unsigned long long n_bytes = 0;
+    get_file_info(file_name, mtime, n_bytes);
+
+    this->enforce_disk_budget(n_bytes);
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+void teca_disk_cache::enforce_disk_budget(unsigned long long n_bytes)
+{
+    if (this->disk_budget < 0)
+        return;
+
+    teca_disk_cache_internals *inter = this->internals;
+    std::lock_guard<std::mutex> lock(inter->disk_mutex);
+
+    // the directory is scanned the first time and when the running
+    // total exceeds the budget. the scan also picks up the files
+    // that other processes sharing the directory added or removed.
+    if (inter->disk_usage_valid &&
+        (inter->disk_usage_directory == this->cache_directory))
+    {
+        inter->disk_usage += n_bytes;
+        if (inter->disk_usage <=
+            static_cast<unsigned long long>(this->disk_budget))
+            return;
+    }
+
+    inter->disk_usage_valid = false;
+
+    DIR *dir = opendir(this->cache_directory.c_str());
+    if (!dir)
+        return;
+
+    // the files ordered from least to most recently used
+    struct file_info
+    {
+        long long mtime;
+        unsigned long long size;
+        string name;
+        bool operator<(const file_info &o) const { return mtime < o.mtime; }
+    };
+
+    vector<file_info> files;
+    unsigned long long total = 0;
+
+    struct dirent *ent = nullptr;
+    while ((ent = readdir(dir)))
+    {
+        if (!is_cache_file(ent->d_name))
+            continue;
+
+        file_info fi;
+        fi.name = this->cache_directory + PATH_SEP + ent->d_name;
+        if (get_file_info(fi.name, fi.mtime, fi.size))
+            continue;
+
+        total += fi.size;
+        files.push_back(fi);
+    }
+
+    closedir(dir);
+
+    inter->disk_usage_valid = true;
+    inter->disk_usage_directory = this->cache_directory;
+    inter->disk_usage = total;
+
+    if (total <= static_cast<unsigned long long>(this->disk_budget))
+        return;
+
+    std::sort(files.begin(), files.end());
+
+    // another process may have removed the file already
+    size_t n_files = files.size();
+    for (size_t i = 0; (i < n_files)
+        && (total > static_cast<unsigned long long>(this->disk_budget)); ++i)
+    {
+        remove(files[i].name.c_str());
+        total -= files[i].size;
+    }
+
+    inter->disk_usage = total;
+}
+
+// --------------------------------------------------------------------------
+int teca_disk_cache::clear_disk_cache()
+{
+    if (this->cache_directory.empty())
+        return 0;
+
+    {
+    std::lock_guard<std::mutex> lock(this->internals->disk_mutex);
+    this->internals->disk_usage_valid = false;
+    }
+
+    DIR *dir = opendir(this->cache_directory.c_str());
+    if (!dir)
+        return errno == ENOENT ? 0 : -1;
+
+    int ierr = 0;
+    struct dirent *ent = nullptr;
+    while ((ent = readdir(dir)))
+    {
+        if (!is_cache_file(ent->d_name))
+            continue;
+
+        string file_name = this->cache_directory + PATH_SEP + ent->d_name;
+        if (remove(file_name.c_str()))
+        {
+            const char *estr = strerror(errno);
+            TECA_ERROR("Failed to remove \"" << file_name << "\". " << estr)
+            ierr = -1;
+        }
+    }
+
+    closedir(dir);
+
+    return ierr;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset teca_disk_cache::request_data(
+    teca_algorithm_output_port &current, const teca_metadata &request)
+{
+    unsigned int port = get_port(current);
+
+    teca_trace_span span("request_data", this, port, request);
+
+    teca_algorithm_output_port &conn = this->get_input_connection(0);
+
+    const_p_teca_dataset data;
+
+    teca_metadata key;
+    if (this->cache_directory.empty() || this->get_key(conn, request, key))
+    {
+        // caching is disabled, pass the request through
+        data = get_algorithm(conn)->request_data(conn, request);
+    }
+    else if (!this->load(key, data))
+    {
+        ++this->internals->n_hits;
+    }
+    else
+    {
+        ++this->internals->n_misses;
+
+        data = get_algorithm(conn)->request_data(conn, request);
+
+        if (data)
+            this->save(key, data);
+    }
+
+    span.set_output(data);
+
+    return data;
+}
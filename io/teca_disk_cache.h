@@ -0,0 +1,120 @@
+#ifndef teca_disk_cache_h
+#define teca_disk_cache_h
+
+#include "teca_shared_object.h"
+#include "teca_algorithm.h"
+#include "teca_algorithm_output_port.h"
+#include "teca_metadata.h"
+
+#include <string>
+#include <vector>
+
+class teca_disk_cache_internals;
+
+TECA_SHARED_OBJECT_FORWARD_DECL(teca_disk_cache)
+
+/// a persistent cache of the data produced upstream
+/**
+an algorithm that saves the datasets produced upstream in a local
+directory and serves later requests for the same data from disk,
+including requests made by later runs, without executing the
+upstream pipeline.
+
+a dataset is found by a key made of the request, the class and
+properties of each algorithm upstream, and the modification time
+and size of each input file. algorithm properties are reported
+through to_stream. when an algorithm upstream reports nothing
+there, a change to its settings can't be detected, and data is
+only cached when cache_tag is set. the tag must then identify the
+settings of the pipeline. input files are taken from the "root"
+and "files" metadata keys reported by readers such as
+teca_cf_reader.
+
+datasets are serialized with teca_binary_stream. meshes, tables
+and databases are supported, other datasets are passed through
+without being cached. when the files in the directory exceed
+disk_budget bytes the least recently used are removed. the size of
+the directory is counted once and then kept up to date as files
+are written, files added by other processes sharing the directory
+are counted when the budget is next exceeded.
+
+caching is disabled when cache_directory is not set.
+*/
+class teca_disk_cache : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(teca_disk_cache)
+    TECA_ALGORITHM_DELETE_COPY_ASSIGN(teca_disk_cache)
+    ~teca_disk_cache() noexcept;
+
+    // report/initialize to/from Boost program options
+    // objects.
+    TECA_GET_ALGORITHM_PROPERTIES_DESCRIPTION()
+    TECA_SET_ALGORITHM_PROPERTIES()
+
+    // set the directory where datasets are stored. it is created
+    // if it does not exist. the default is empty, which disables
+    // the cache.
+    TECA_ALGORITHM_PROPERTY(std::string, cache_directory)
+
+    // set the limit in bytes on the size of the files in the
+    // cache directory. -1 for no limit. the default is -1.
+    TECA_ALGORITHM_PROPERTY(long, disk_budget)
+
+    // set text that is included in the key. it is required when
+    // an algorithm upstream doesn't report its properties through
+    // to_stream. the default is empty.
+    TECA_ALGORITHM_PROPERTY(std::string, cache_tag)
+
+    // remove all of the cached datasets from the directory.
+    // returns 0 on success.
+    int clear_disk_cache();
+
+    // get the number of requests served from disk, and the
+    // number that were not.
+    unsigned long get_number_of_cache_hits() const;
+    unsigned long get_number_of_cache_misses() const;
+
+protected:
+    teca_disk_cache();
+
+    // overrides the driver to serve requests from disk, only
+    // executing the upstream pipeline when the data is not found.
+    const_p_teca_dataset request_data(teca_algorithm_output_port &port,
+        const teca_metadata &request) override;
+
+private:
+    // get the key identifying the data for the request. returns 0
+    // if the data may be cached, 1 if the pipeline's settings can't
+    // be identified, and a negative value if an error occurred.
+    int get_key(teca_algorithm_output_port &conn,
+        const teca_metadata &request, teca_metadata &key);
+
+    // append the class and properties of the algorithm and those
+    // upstream of it to state. the classes of those that don't
+    // report their properties are appended to unserialized.
+    void get_pipeline_state(const p_teca_algorithm &alg,
+        std::vector<std::string> &state,
+        std::vector<std::string> &unserialized);
+
+    // read the dataset stored under the key. returns 0 if found.
+    int load(const teca_metadata &key, const_p_teca_dataset &data);
+
+    // write the dataset under the key and enforce the budget
+    int save(const teca_metadata &key, const const_p_teca_dataset &data);
+
+    // add the n_bytes just written to the running total of the bytes
+    // in the directory. when the total exceeds the budget the
+    // directory is scanned and the least recently used files are
+    // removed until the budget is met.
+    void enforce_disk_budget(unsigned long long n_bytes);
+
+private:
+    std::string cache_directory;
+    long disk_budget;
+    std::string cache_tag;
+
+    teca_disk_cache_internals *internals;
+};
+
+#endif
@@ -25,6 +25,8 @@
   #include <sys/types.h>
   #include <sys/stat.h>
   #include <unistd.h>
+  #include <sys/uio.h>
+  #include <climits>
 #else
   #include "win_windirent.h"
   #define opendir win_opendir
@@ -455,14 +457,30 @@ int read_stream(const char *file_name, const char *header,
         return -1;
     }
 
+    // the file may have been compressed when it was written
+    if (stream.decompress())
+    {
+        TECA_ERROR("Failed to decompress \"" << file_name << "\"")
+        return -1;
+    }
 
     return 0;
 }
 
 // **************************************************************************
 int write_stream(const char *file_name, const char *header,
-    const teca_binary_stream &stream, bool verbose)
+    const teca_binary_stream &in_stream, bool verbose)
 {
+    // compress with the default codec, if one is set
+    teca_binary_stream compressed;
+    if (in_stream.compress_into(compressed))
+    {
+        TECA_ERROR("Failed to compress \"" << file_name << "\"")
+        return -1;
+    }
+
+    const teca_binary_stream &stream = compressed ? compressed : in_stream;
+
     // open up a file
     int fd = creat(file_name, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
     if (fd == -1)
@@ -485,20 +503,42 @@ int write_stream(const char *file_name, const char *header,
         return -1;
     }
 
-    // now write the table
-    ssize_t n_wrote = 0;
-    ssize_t n_to_write = stream.size();
-    while (n_to_write > 0)
+    // now write the table. a stream in scatter-gather mode is written
+    // directly from the arrays it references
+    std::vector<teca_binary_stream::segment> segs;
+    stream.get_segments(segs);
+
+    std::vector<iovec> iov(segs.size());
+    for (size_t i = 0; i < segs.size(); ++i)
+    {
+        iov[i].iov_base = const_cast<unsigned char*>(segs[i].data);
+        iov[i].iov_len = segs[i].n_bytes;
+    }
+
+    size_t first = 0;
+    while (first < iov.size())
     {
-        ssize_t n = write(fd, stream.get_data() + n_wrote, n_to_write);
+        int n_iov = std::min(iov.size() - first, size_t(IOV_MAX));
+        ssize_t n = writev(fd, iov.data() + first, n_iov);
         if (n == -1)
         {
             const char *estr = strerror(errno);
             TECA_ERROR("Failed to write \"" << file_name << "\". " << estr)
             return -1;
         }
-        n_wrote += n;
-        n_to_write -= n;
+
+        // skip what was written, the last may have been written in part
+        while ((first < iov.size()) && (size_t(n) >= iov[first].iov_len))
+        {
+            n -= iov[first].iov_len;
+            ++first;
+        }
+
+        if (n)
+        {
+            iov[first].iov_base = (char*)iov[first].iov_base + n;
+            iov[first].iov_len -= n;
+        }
     }
 
     // and close the file out
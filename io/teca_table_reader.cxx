@@ -29,7 +29,7 @@ struct teca_table_reader::teca_table_reader_internals
 
     void clear();
 
-    static p_teca_table read_table(
+    static p_teca_table read_table(MPI_Comm comm,
         const std::string &file_name, bool distribute);
 
     p_teca_table table;
@@ -54,17 +54,18 @@ void teca_table_reader::teca_table_reader_internals::clear()
 // --------------------------------------------------------------------------
 p_teca_table
 teca_table_reader::teca_table_reader_internals::read_table(
-    const std::string &file_name, bool distribute)
+    MPI_Comm comm, const std::string &file_name, bool distribute)
 {
     teca_binary_stream stream;
 #if !defined(TECA_HAS_MPI)
+    (void)comm;
     (void)distribute;
 #else
     int init = 0;
     int rank = 0;
     MPI_Initialized(&init);
     if (init)
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_rank(comm, &rank);
 
     // rank 0 will read the data, must be rank 0 for the
     // case where using as a serial reader, but running in
@@ -84,12 +85,12 @@ teca_table_reader::teca_table_reader_internals::read_table(
         }
 #if defined(TECA_HAS_MPI)
         if (init && distribute)
-            stream.broadcast();
+            stream.broadcast(comm, 0);
     }
     else
     if (init && distribute)
     {
-        stream.broadcast();
+        stream.broadcast(comm, 0);
     }
     else
     {
@@ -185,7 +186,7 @@ teca_metadata teca_table_reader::get_output_metadata(unsigned int port,
 
     this->internals->table =
         teca_table_reader::teca_table_reader_internals::read_table(
-            this->file_name, distribute);
+            this->get_communicator(), this->file_name, distribute);
 
     // when no index column is specified  act like a serial reader
     if (!this->internals->table || !distribute)
@@ -264,7 +265,7 @@ const_p_teca_dataset teca_table_reader::execute(unsigned int port,
     int init = 0;
     MPI_Initialized(&init);
     if (init)
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_rank(this->get_communicator(), &rank);
     if ((rank == 0) && !this->internals->table)
     {
         TECA_ERROR("Failed to read data")
@@ -291,22 +292,18 @@ const_p_teca_dataset teca_table_reader::execute(unsigned int port,
     unsigned long nrows = this->internals->step_counts[step];
     unsigned long first_row = this->internals->step_offsets[step];
 
-    for (int j = 0; j < ncols; ++j)
+    // the columns are views into the table read from disk, the rows
+    // are copied only if they are modified downstream
+    if (nrows)
     {
-        p_teca_variant_array in_col =
-            this->internals->table->get_column(j);
-
-        p_teca_variant_array out_col =
-            out_table->get_column(j);
-
-        out_col->resize(nrows);
+        p_teca_array_collection out_cols = out_table->get_columns();
+        for (int j = 0; j < ncols; ++j)
+        {
+            const_p_teca_variant_array in_col =
+                this->internals->table->get_column(j);
 
-        TEMPLATE_DISPATCH(teca_variant_array_impl,
-            out_col.get(),
-            NT *pin_col = static_cast<TT*>(in_col.get())->get();
-            NT *pout_col = static_cast<TT*>(out_col.get())->get();
-            memcpy(pout_col, pin_col+first_row, nrows*sizeof(NT));
-            )
+            out_cols->set(j, in_col->new_view(first_row, first_row + nrows - 1));
+        }
     }
 
     if (this->generate_original_ids)
@@ -55,8 +55,10 @@ int write_csv(const_p_teca_table table, const std::string &file_name)
 // ********************************************************************************
 int write_bin(const_p_teca_table table, const std::string &file_name)
 {
-    // serialize the table to a binary representation
+    // serialize the table to a binary representation. the columns
+    // are written from the table rather than copied into the stream
     teca_binary_stream bs;
+    bs.set_gather_threshold(teca_binary_stream::default_gather_threshold);
     table->to_stream(bs);
 
     if (teca_file_util::write_stream(file_name.c_str(), "teca_table", bs))
@@ -160,7 +162,7 @@ const_p_teca_dataset teca_table_writer::execute(
     int init = 0;
     MPI_Initialized(&init);
     if (init)
-        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+        MPI_Comm_rank(this->get_communicator(), &rank);
 #endif
     if (!input_data[0])
     {
@@ -2,12 +2,22 @@
 #define teca_test_util_h
 
 #include "teca_config.h"
+#include "teca_common.h"
 #include "teca_table.h"
 
 #if defined(TECA_HAS_MPI)
 #include <mpi.h>
 #endif
 
+// report the failed condition and return -1 from the calling
+// function when the condition is false
+#define CHECK(_cond)                                \
+    if (!(_cond))                                   \
+    {                                               \
+        TECA_ERROR("check failed: " #_cond)         \
+        return -1;                                  \
+    }
+
 namespace teca_test_util
 {
 // This creates a TECA table containing some basic test data that
@@ -58,6 +58,10 @@ public:
     void copy_metadata(const const_p_teca_dataset &) override;
     void swap(p_teca_dataset &) override;
 
+    // return the number of bytes used by the data
+    unsigned long get_memory_usage() const noexcept override
+    { return sizeof(double)*this->data.size(); }
+
     // serialize the dataset to/from the given stream
     // for I/O or communication
     void to_stream(teca_binary_stream &s) const override;
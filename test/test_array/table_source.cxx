@@ -0,0 +1,90 @@
+#include "table_source.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// --------------------------------------------------------------------------
+table_source::table_source() :
+    number_of_time_steps(1),
+    number_of_rows(1),
+    failing_time_step(-1),
+    report_priority(0)
+{
+    this->set_number_of_input_connections(0);
+    this->set_number_of_output_ports(1);
+}
+
+// --------------------------------------------------------------------------
+table_source::~table_source()
+{}
+
+// --------------------------------------------------------------------------
+std::vector<unsigned long> table_source::get_steps()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->steps;
+}
+
+// --------------------------------------------------------------------------
+unsigned long table_source::get_number_alive()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return std::count_if(this->tables.begin(), this->tables.end(),
+        [](const std::weak_ptr<const teca_table> &t) -> bool
+        { return !t.expired(); });
+}
+
+// --------------------------------------------------------------------------
+teca_metadata table_source::get_output_metadata(unsigned int port,
+    const std::vector<teca_metadata> &input_md)
+{
+    (void) port;
+    (void) input_md;
+
+    teca_metadata md;
+    md.insert("number_of_time_steps", this->number_of_time_steps);
+
+    if (this->report_priority)
+    {
+        std::vector<long> priority(this->number_of_time_steps);
+        for (unsigned long i = 0; i < this->number_of_time_steps; ++i)
+            priority[i] = i + 1;
+
+        md.insert("time_step_priority", priority);
+    }
+
+    return md;
+}
+
+// --------------------------------------------------------------------------
+const_p_teca_dataset table_source::execute(unsigned int port,
+    const std::vector<const_p_teca_dataset> &input_data,
+    const teca_metadata &request)
+{
+    (void) port;
+    (void) input_data;
+
+    unsigned long step = 0;
+    request.get("time_step", step);
+
+    {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->steps.push_back(step);
+    }
+
+    if (static_cast<long>(step) == this->failing_time_step)
+        throw std::runtime_error("failed to generate the time step");
+
+    p_teca_table table = teca_table::New();
+    table->append_column("step",
+        teca_long_array::New(this->number_of_rows, long(step)));
+    table->append_column("value",
+        teca_double_array::New(this->number_of_rows, 2.0*step));
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->tables.push_back(table);
+
+    return table;
+}
@@ -0,0 +1,76 @@
+#ifndef table_source_h
+#define table_source_h
+
+#include "teca_shared_object.h"
+#include "teca_algorithm.h"
+#include "teca_table.h"
+
+#include <vector>
+#include <mutex>
+#include <memory>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(table_source)
+
+/** a source that generates a table for the requested time step.
+the table has number_of_rows rows, each holding the time step in
+the "step" column and twice the time step in the "value" column.
+the time steps generated are recorded, in the order that they were
+generated, as are the tables still alive. generating the failing
+time step throws a std::runtime_error.
+
+metadata keys:
+     number_of_time_steps
+     time_step_priority (when report_priority is set)
+
+request keys:
+     time_step (required)
+*/
+class table_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(table_source)
+    ~table_source();
+
+    // set the number of time steps to generate
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_time_steps)
+
+    // set the number of rows in each table
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_rows)
+
+    // set the time step that fails, or -1 for none
+    TECA_ALGORITHM_PROPERTY(long, failing_time_step)
+
+    // when set a priority is reported for each time step, the later
+    // time steps are the more important
+    TECA_ALGORITHM_PROPERTY(int, report_priority)
+
+    // get the time steps generated, in the order they were generated
+    std::vector<unsigned long> get_steps();
+
+    // get the number of tables generated that are still alive
+    unsigned long get_number_alive();
+
+protected:
+    table_source();
+
+private:
+    teca_metadata get_output_metadata(
+        unsigned int port,
+        const std::vector<teca_metadata> &input_md) override;
+
+    const_p_teca_dataset execute(
+        unsigned int port,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override;
+
+private:
+    unsigned long number_of_time_steps;
+    unsigned long number_of_rows;
+    long failing_time_step;
+    int report_priority;
+    std::mutex mutex;
+    std::vector<unsigned long> steps;
+    std::vector<std::weak_ptr<const teca_table>> tables;
+};
+
+#endif
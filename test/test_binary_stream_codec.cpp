@@ -0,0 +1,382 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_algorithm.h"
+#include "teca_binary_stream.h"
+#include "teca_variant_array.h"
+#include "teca_table.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_file_util.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <map>
+
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#endif
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+// a table like those holding storm candidates. coordinates are on a
+// 0.25 degree grid and the fields are stored at the precision they are
+// reported with
+p_teca_table make_candidates(unsigned long step, unsigned long n_rows)
+{
+    p_teca_unsigned_long_array steps = teca_unsigned_long_array::New(n_rows, step);
+    p_teca_int_array ids = teca_int_array::New(n_rows);
+    p_teca_double_array lon = teca_double_array::New(n_rows);
+    p_teca_double_array lat = teca_double_array::New(n_rows);
+    p_teca_float_array wind = teca_float_array::New(n_rows);
+    p_teca_float_array psl = teca_float_array::New(n_rows);
+
+    for (unsigned long i = 0; i < n_rows; ++i)
+    {
+        unsigned long q = (step*n_rows + i)*2654435761ul;
+        ids->set(i, i/8);
+        lon->set(i, 0.25*(q % 1440));
+        lat->set(i, 0.25*((q >> 11) % 720) - 90.0);
+        wind->set(i, 0.5f*(q % 120));
+        psl->set(i, 90000.0f + 10.0f*((q >> 7) % 2000));
+    }
+
+    p_teca_table table = teca_table::New();
+    table->append_column("step", steps);
+    table->append_column("storm_id", ids);
+    table->append_column("lon", lon);
+    table->append_column("lat", lat);
+    table->append_column("surface_wind", wind);
+    table->append_column("sea_level_pressure", psl);
+    return table;
+}
+}
+
+TECA_SHARED_OBJECT_FORWARD_DECL(candidate_source)
+
+// a source producing a table of candidates per time step
+class candidate_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(candidate_source)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_time_steps)
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_rows)
+
+protected:
+    candidate_source() : number_of_time_steps(1), number_of_rows(1)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    {
+        teca_metadata md;
+        md.insert("number_of_time_steps", this->number_of_time_steps);
+        return md;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        unsigned long step = 0;
+        request.get("time_step", step);
+        return make_candidates(step, this->number_of_rows);
+    }
+
+private:
+    unsigned long number_of_time_steps;
+    unsigned long number_of_rows;
+};
+
+namespace {
+
+// reduce the candidate tables of all time steps across ranks. returns
+// the time in milliseconds and the result on rank 0
+double time_reduction(unsigned long n_steps, unsigned long n_rows,
+    const_p_teca_table &result)
+{
+    p_candidate_source src = candidate_source::New();
+    src->set_number_of_time_steps(n_steps);
+    src->set_number_of_rows(n_rows);
+
+    p_teca_table_reduce red = teca_table_reduce::New();
+    red->set_thread_pool_size(1);
+    red->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(red->get_output_port());
+
+#if defined(TECA_HAS_MPI)
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    auto t0 = hr_clock_t::now();
+    cap->update();
+#if defined(TECA_HAS_MPI)
+    MPI_Barrier(MPI_COMM_WORLD);
+#endif
+    auto t1 = hr_clock_t::now();
+
+    result = std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// write a table to disk and read it back. returns the time in
+// milliseconds and the size of the file
+double time_cache_file(const const_p_teca_table &table, const char *file_name,
+    unsigned long &file_size, p_teca_table &table_in)
+{
+    auto t0 = hr_clock_t::now();
+
+    teca_binary_stream s;
+    s.set_gather_threshold(teca_binary_stream::default_gather_threshold);
+    table->to_stream(s);
+    teca_file_util::write_stream(file_name, "teca_table", s);
+
+    teca_binary_stream s_in;
+    teca_file_util::read_stream(file_name, "teca_table", s_in);
+    table_in = teca_table::New();
+    table_in->from_stream(s_in);
+
+    auto t1 = hr_clock_t::now();
+
+    FILE *fh = fopen(file_name, "rb");
+    fseek(fh, 0, SEEK_END);
+    file_size = ftell(fh);
+    fclose(fh);
+    remove(file_name);
+
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// returns true if the tables hold the same values
+bool equal(const const_p_teca_table &a, const const_p_teca_table &b)
+{
+    if (!a || !b || (a->get_number_of_columns() != b->get_number_of_columns()))
+        return false;
+
+    unsigned int n_cols = a->get_number_of_columns();
+    for (unsigned int i = 0; i < n_cols; ++i)
+    {
+        if (!(*a->get_column(i) == *b->get_column(i)))
+            return false;
+    }
+
+    return true;
+}
+
+// returns true if the tables hold the same time steps. the order that
+// the steps are reduced in varies from run to run
+bool equal_steps(const const_p_teca_table &a, const const_p_teca_table &b,
+    unsigned long n_rows)
+{
+    if (!a || !b || (a->get_number_of_rows() != b->get_number_of_rows()))
+        return false;
+
+    unsigned long n_steps = a->get_number_of_rows()/n_rows;
+    const unsigned long *step_a = std::static_pointer_cast
+        <const teca_unsigned_long_array>(a->get_column("step"))->get();
+    const unsigned long *step_b = std::static_pointer_cast
+        <const teca_unsigned_long_array>(b->get_column("step"))->get();
+
+    // the first row of each step in b
+    std::map<unsigned long, unsigned long> first_b;
+    for (unsigned long i = 0; i < n_steps; ++i)
+        first_b[step_b[i*n_rows]] = i*n_rows;
+
+    unsigned int n_cols = a->get_number_of_columns();
+    for (unsigned long i = 0; i < n_steps; ++i)
+    {
+        auto it = first_b.find(step_a[i*n_rows]);
+        if (it == first_b.end())
+            return false;
+
+        for (unsigned int j = 0; j < n_cols; ++j)
+        {
+            p_teca_variant_array col_a =
+                a->get_column(j)->new_copy(i*n_rows, (i + 1)*n_rows - 1);
+
+            p_teca_variant_array col_b =
+                b->get_column(j)->new_copy(it->second, it->second + n_rows - 1);
+
+            if (!(*col_a == *col_b))
+                return false;
+        }
+    }
+
+    return true;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    int rank = mpi_man.get_comm_rank();
+    int n_ranks = mpi_man.get_comm_size();
+
+    unsigned long n_rows = argc > 1 ? atol(argv[1]) : 100000;
+    unsigned long n_steps = argc > 2 ? atol(argv[2]) : 8;
+
+#if !defined(TECA_HAS_ZLIB)
+    (void)rank;
+    (void)n_ranks;
+    (void)n_rows;
+    (void)n_steps;
+    std::cerr << "built without zlib, nothing to test" << std::endl;
+    return 0;
+#else
+    if (rank == 0)
+    {
+    // a compressed stream round trips
+    {
+    p_teca_table table = make_candidates(0, n_rows);
+
+    teca_binary_stream s0;
+    table->to_stream(s0);
+    CHECK(!s0.compressed())
+
+    // streams that are not compressed are left as they are
+    teca_binary_stream s1(s0);
+    CHECK(s1.decompress() == 0)
+    CHECK(s1.size() == s0.size())
+
+    CHECK(s1.compress(teca_binary_stream::codec_zlib) == 0)
+    CHECK(s1.compressed())
+    double ratio = double(s0.size())/s1.size();
+
+    // compressing twice has no effect
+    unsigned long n_compressed = s1.size();
+    CHECK(s1.compress(teca_binary_stream::codec_zlib) == 0)
+    CHECK(s1.size() == n_compressed)
+
+    CHECK(s1.decompress() == 0)
+    CHECK(!s1.compressed())
+    CHECK(s1.size() == s0.size())
+    CHECK(memcmp(s1.get_data(), s0.get_data(), s0.size()) == 0)
+
+    // a stream in scatter-gather mode is compressed from its segments
+    teca_binary_stream s2;
+    s2.set_gather_threshold(teca_binary_stream::default_gather_threshold);
+    table->to_stream(s2);
+    CHECK(s2.has_references())
+    CHECK(s2.compress(teca_binary_stream::codec_zlib) == 0)
+    CHECK(!s2.has_references())
+    CHECK(s2.decompress() == 0)
+    CHECK(s2.size() == s0.size())
+    CHECK(memcmp(s2.get_data(), s0.get_data(), s0.size()) == 0)
+
+    // a compressed copy is made without modifying the source
+    teca_binary_stream s3;
+    s3.set_gather_threshold(teca_binary_stream::default_gather_threshold);
+    table->to_stream(s3);
+    unsigned long n_total = s3.get_total_size();
+
+    teca_binary_stream s4;
+    CHECK(s3.compress_into(s4, teca_binary_stream::codec_zlib) == 0)
+    CHECK(s3.has_references())
+    CHECK(s3.get_total_size() == n_total)
+    CHECK(s4.compressed())
+    CHECK(s4.decompress() == 0)
+    CHECK(s4.size() == s0.size())
+    CHECK(memcmp(s4.get_data(), s0.get_data(), s0.size()) == 0)
+
+    // without a codec the copy is left empty
+    CHECK(s3.compress_into(s4, teca_binary_stream::codec_none) == 0)
+    CHECK(s4.size() == 0)
+
+    std::cerr << "candidate table of " << n_rows << " rows " << s0.size()
+        << " bytes compressed " << n_compressed << " bytes ratio " << ratio
+        << std::endl;
+
+    CHECK(ratio > 2.0)
+    }
+
+    // an empty stream round trips. ranks with no data send these
+    {
+    teca_binary_stream s0;
+    CHECK(s0.compress(teca_binary_stream::codec_zlib) == 0)
+    CHECK(s0.compressed())
+    CHECK(s0.decompress() == 0)
+    CHECK(!s0.compressed())
+    CHECK(s0.size() == 0)
+
+    teca_binary_stream s1;
+    teca_binary_stream s2;
+    CHECK(s1.compress_into(s2, teca_binary_stream::codec_zlib) == 0)
+    CHECK(s2.compressed())
+    CHECK(s2.decompress() == 0)
+    CHECK(s2.size() == 0)
+    }
+
+    // cache files round trip with and without compression
+    {
+    p_teca_table table = make_candidates(1, n_rows);
+
+    p_teca_table table_raw;
+    unsigned long size_raw = 0;
+    teca_binary_stream::set_default_codec(teca_binary_stream::codec_none);
+    double t_raw = time_cache_file(table, "test_binary_stream_codec_raw.bin",
+        size_raw, table_raw);
+
+    p_teca_table table_zlib;
+    unsigned long size_zlib = 0;
+    teca_binary_stream::set_default_codec(teca_binary_stream::codec_zlib);
+    double t_zlib = time_cache_file(table, "test_binary_stream_codec_zlib.bin",
+        size_zlib, table_zlib);
+
+    std::cerr << "cache file round trip raw " << t_raw << " ms "
+        << size_raw << " bytes zlib " << t_zlib << " ms " << size_zlib
+        << " bytes" << std::endl;
+
+    CHECK(equal(table, table_raw))
+    CHECK(equal(table, table_zlib))
+    CHECK(size_zlib < size_raw)
+    }
+    }
+
+    // the MPI reduction with and without compression
+    if (n_ranks > 1)
+    {
+    const_p_teca_table result_raw;
+    teca_binary_stream::set_default_codec(teca_binary_stream::codec_none);
+    double t_raw = time_reduction(n_steps, n_rows, result_raw);
+
+    const_p_teca_table result_zlib;
+    teca_binary_stream::set_default_codec(teca_binary_stream::codec_zlib);
+    double t_zlib = time_reduction(n_steps, n_rows, result_zlib);
+
+    if (rank == 0)
+    {
+        std::cerr << "reduction of " << n_steps << " tables of " << n_rows
+            << " rows on " << n_ranks << " ranks raw " << t_raw << " ms zlib "
+            << t_zlib << " ms" << std::endl;
+
+        CHECK(result_raw && (result_raw->get_number_of_rows() == n_steps*n_rows))
+        CHECK(equal_steps(result_raw, result_zlib, n_rows))
+    }
+    }
+
+    teca_binary_stream::set_default_codec(teca_binary_stream::codec_none);
+
+    return 0;
+#endif
+}
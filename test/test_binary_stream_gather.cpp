@@ -0,0 +1,247 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_algorithm.h"
+#include "teca_binary_stream.h"
+#include "teca_variant_array.h"
+#include "teca_table.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_file_util.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+#include "table_source.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+// a table with a few large columns and a small one
+p_teca_table make_table(unsigned long n_rows)
+{
+    p_teca_double_array a = teca_double_array::New(n_rows);
+    p_teca_int_array b = teca_int_array::New(n_rows);
+    for (unsigned long i = 0; i < n_rows; ++i)
+    {
+        a->set(i, 0.5*i);
+        b->set(i, i%7);
+    }
+
+    p_teca_string_array c = teca_string_array::New();
+    c->append(std::string("one"));
+    c->append(std::string("two"));
+
+    p_teca_table table = teca_table::New();
+    table->append_column("a", a);
+    table->append_column("b", b);
+    table->append_column("c", c);
+    return table;
+}
+
+// get the bytes of the stream, following references
+std::vector<unsigned char> get_bytes(const teca_binary_stream &s)
+{
+    std::vector<teca_binary_stream::segment> segs;
+    s.get_segments(segs);
+
+    std::vector<unsigned char> bytes;
+    for (const teca_binary_stream::segment &seg : segs)
+        bytes.insert(bytes.end(), seg.data, seg.data + seg.n_bytes);
+
+    return bytes;
+}
+
+// time serializing and writing a table. returns the time in milliseconds
+double time_write(const const_p_teca_table &table, unsigned long threshold,
+    const char *file_name)
+{
+    auto t0 = hr_clock_t::now();
+    teca_binary_stream s;
+    s.set_gather_threshold(threshold);
+    table->to_stream(s);
+    teca_file_util::write_stream(file_name, "teca_table", s);
+    auto t1 = hr_clock_t::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    int rank = mpi_man.get_comm_rank();
+    int n_ranks = mpi_man.get_comm_size();
+
+    unsigned long n_rows = argc > 1 ? atol(argv[1]) : 4000000;
+
+    if (rank == 0)
+    {
+    // the buffer is grown geometrically
+    {
+    teca_binary_stream s;
+    int n_moves = 0;
+    const unsigned char *last = nullptr;
+
+    auto t0 = hr_clock_t::now();
+    for (int i = 0; i < (1 << 22); ++i)
+    {
+        s.pack(i);
+        if (s.get_data() != last)
+        {
+            last = s.get_data();
+            ++n_moves;
+        }
+    }
+    auto t1 = hr_clock_t::now();
+
+    CHECK(s.size() == (1ul << 22)*sizeof(int))
+    CHECK(s.capacity() < 2*s.size())
+    CHECK(n_moves <= 32)
+
+    std::cerr << "packed " << s.size() << " bytes in "
+        << std::chrono::duration<double, std::milli>(t1 - t0).count()
+        << " ms" << std::endl;
+    }
+
+    // reserving from a size hint
+    {
+    teca_binary_stream s;
+    s.reserve(1000*sizeof(double));
+    const unsigned char *data = s.get_data();
+    for (int i = 0; i < 1000; ++i)
+        s.pack(double(i));
+    CHECK(s.get_data() == data)
+    CHECK(s.capacity() == 1000*sizeof(double))
+    }
+
+    // in scatter-gather mode large arrays are referenced
+    {
+    p_teca_table table = make_table(100000);
+
+    teca_binary_stream s0;
+    table->to_stream(s0);
+    CHECK(!s0.has_references())
+
+    teca_binary_stream s1;
+    s1.set_gather_threshold(teca_binary_stream::default_gather_threshold);
+    table->to_stream(s1);
+
+    CHECK(s1.has_references())
+    CHECK(s1.size() < 1024)
+    CHECK(s1.get_total_size() == s0.size())
+
+    std::vector<unsigned char> bytes0(s0.get_data(), s0.get_data() + s0.size());
+    CHECK(get_bytes(s1) == bytes0)
+
+    // a part of the stream
+    std::vector<teca_binary_stream::segment> segs;
+    s1.get_segments(100, 800000, segs);
+    unsigned long n = 0;
+    for (auto &seg : segs)
+    {
+        CHECK(memcmp(seg.data, s0.get_data() + 100 + n, seg.n_bytes) == 0)
+        n += seg.n_bytes;
+    }
+    CHECK(n == 800000)
+
+    // modifying the table doesn't change the stream
+    std::static_pointer_cast<teca_double_array>(table->get_column("a"))->set(0, -1.0);
+    CHECK(get_bytes(s1) == bytes0)
+
+    // copies hold the references
+    teca_binary_stream s2(s1);
+    s1.clear();
+    CHECK(get_bytes(s2) == bytes0)
+
+    // flattening copies the arrays in
+    s2.flatten();
+    CHECK(!s2.has_references())
+    CHECK(s2.size() == s0.size())
+    CHECK(memcmp(s2.get_data(), s0.get_data(), s0.size()) == 0)
+
+    p_teca_table table2 = teca_table::New();
+    table2->from_stream(s2);
+    CHECK(table2->get_number_of_rows() == 100000)
+    double a0 = -1.0;
+    table2->get_column("a")->get(0, a0);
+    CHECK(a0 == 0.0)
+    CHECK(*table2->get_column("b") == *table->get_column("b"))
+    }
+
+    // writing a stream to disk from its segments
+    {
+    p_teca_table table = make_table(n_rows);
+
+    const char *file_copy = "test_binary_stream_gather_copy.bin";
+    const char *file_gather = "test_binary_stream_gather.bin";
+
+    double t_copy = time_write(table, 0, file_copy);
+    double t_gather = time_write(table, teca_binary_stream::default_gather_threshold,
+        file_gather);
+
+    std::cerr << "wrote a table of " << n_rows << " rows copied "
+        << t_copy << " ms gathered " << t_gather << " ms" << std::endl;
+
+    teca_binary_stream s0;
+    teca_binary_stream s1;
+    CHECK(teca_file_util::read_stream(file_copy, "teca_table", s0) == 0)
+    CHECK(teca_file_util::read_stream(file_gather, "teca_table", s1) == 0)
+    CHECK(s0.size() == s1.size())
+    CHECK(memcmp(s0.get_data(), s1.get_data(), s0.size()) == 0)
+
+    remove(file_copy);
+    remove(file_gather);
+    }
+    }
+
+    // reductions send tables over MPI from their segments
+    if (n_ranks > 1)
+    {
+    unsigned long n_steps = 8;
+    unsigned long n_step_rows = 100000;
+
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+    src->set_number_of_rows(n_step_rows);
+
+    p_teca_table_reduce red = teca_table_reduce::New();
+    red->set_thread_pool_size(1);
+    red->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(red->get_output_port());
+
+    CHECK(cap->update() == 0)
+
+    if (rank == 0)
+    {
+        const_p_teca_table table =
+            std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+
+        CHECK(table && (table->get_number_of_rows() == n_steps*n_step_rows))
+
+        const_p_teca_long_array col = std::static_pointer_cast
+            <const teca_long_array>(table->get_column("step"));
+
+        unsigned long sum = 0;
+        const long *pcol = col->get();
+        for (unsigned long i = 0; i < n_steps*n_step_rows; ++i)
+            sum += pcol[i];
+
+        CHECK(sum == n_step_rows*(n_steps*(n_steps - 1)/2))
+    }
+    }
+
+    return 0;
+}
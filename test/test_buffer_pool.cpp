@@ -0,0 +1,223 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_allocator.h"
+#include "teca_buffer_pool.h"
+#include "teca_variant_array.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+// emulate the arrays a time step allocates, a few reader outputs and
+// derived quantities, each written in full. returns the time in
+// milliseconds per step
+double time_steps(unsigned long nx, unsigned long ny, int n_steps)
+{
+    unsigned long n = nx*ny;
+    double sum = 0.0;
+
+    auto t0 = hr_clock_t::now();
+    for (int i = 0; i < n_steps; ++i)
+    {
+        std::vector<p_teca_variant_array> arrays;
+        for (int j = 0; j < 4; ++j)
+        {
+            p_teca_float_array a = teca_float_array::New(n, teca_uninitialized);
+            float *pa = a->get();
+            for (unsigned long q = 0; q < n; ++q)
+                pa[q] = j;
+            arrays.push_back(a);
+        }
+
+        p_teca_double_array d = teca_double_array::New(n, teca_uninitialized);
+        double *pd = d->get();
+        for (unsigned long q = 0; q < n; ++q)
+            pd[q] = i;
+        arrays.push_back(d);
+
+        p_teca_char_array m = teca_char_array::New(n, teca_uninitialized);
+        char *pm = m->get();
+        for (unsigned long q = 0; q < n; ++q)
+            pm[q] = q % 2;
+        arrays.push_back(m);
+
+        sum += pd[n - 1] + pm[n - 1];
+    }
+    auto t1 = hr_clock_t::now();
+
+    if (sum < 0.0)
+        std::cerr << sum << std::endl;
+
+    return std::chrono::duration<double, std::milli>(t1 - t0).count()/n_steps;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    // the default is a 0.25 degree grid
+    unsigned long nx = argc > 1 ? atol(argv[1]) : 1440;
+    unsigned long ny = argc > 2 ? atol(argv[2]) : 720;
+    int n_steps = argc > 3 ? atoi(argv[3]) : 20;
+
+    // the pool may have been enabled from the environment
+    teca_buffer_pool::disable();
+
+    double t_heap = time_steps(nx, ny, n_steps);
+
+    // memory allocated before the pool is enabled is not pooled
+    void *early = teca_allocator::allocate(65537);
+
+    teca_buffer_pool::enable(1024ul*1024ul*1024ul);
+    teca_buffer_pool::reset_stats();
+
+    {
+    teca_allocator::deallocate(early, 65537);
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.returns == 0)
+    CHECK(s.n_bytes_cached == 0)
+    }
+
+    // a block is reused for any size in its class
+    {
+    void *a = teca_allocator::allocate(100000);
+    teca_allocator::deallocate(a, 100000);
+
+    void *b = teca_allocator::allocate(98305);
+    CHECK(b == a)
+    teca_allocator::deallocate(b, 98305);
+
+    // the next class up
+    void *c = teca_allocator::allocate(114689);
+    CHECK(c != a)
+    teca_allocator::deallocate(c, 114689);
+
+    // small allocations are not pooled
+    void *d = teca_allocator::allocate(100);
+    teca_allocator::deallocate(d, 100);
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.hits == 1)
+    CHECK(s.misses == 2)
+    CHECK(s.returns == 3)
+    CHECK(s.n_bytes_cached == 245760)
+    }
+
+    // arrays return their storage when the last reference is dropped
+    {
+    teca_buffer_pool::release();
+    teca_buffer_pool::reset_stats();
+
+    p_teca_double_array a = teca_double_array::New(nx*ny);
+    const double *pa = a->get();
+    p_teca_variant_array b = a->new_view(0, nx*ny - 1);
+    a = nullptr;
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.returns == 0)
+
+    b = nullptr;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.returns == 1)
+
+    p_teca_double_array c = teca_double_array::New(nx*ny);
+    CHECK(c->get() == pa)
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.hits == 1)
+    }
+
+    // the capacity limits the cached bytes
+    {
+    teca_buffer_pool::release();
+    teca_buffer_pool::reset_stats();
+    teca_buffer_pool::set_capacity(4*65536);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 8; ++i)
+        blocks.push_back(teca_allocator::allocate(65536));
+    for (void *ptr : blocks)
+        teca_allocator::deallocate(ptr, 65536);
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.returns == 4)
+    CHECK(s.releases == 4)
+    CHECK(s.n_bytes_cached == 4*65536)
+
+    teca_buffer_pool::set_capacity(1024ul*1024ul*1024ul);
+    }
+
+    // threads share blocks
+    {
+    teca_buffer_pool::release();
+    teca_buffer_pool::reset_stats();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.push_back(std::thread([]()
+        {
+            for (int j = 0; j < 64; ++j)
+            {
+                p_teca_float_array a = teca_float_array::New(65536 + 4096*(j % 8));
+                p_teca_float_array b = teca_float_array::New(100000);
+                a->set(0, b->get(0));
+            }
+        }));
+    }
+
+    for (auto &t : threads)
+        t.join();
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.hits + s.misses == 4*2*64)
+    CHECK(s.returns == s.hits + s.misses)
+    CHECK(s.hits > s.misses)
+
+    // the exited threads' blocks are in the shared cache
+    teca_buffer_pool::release();
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.n_bytes_cached == 0)
+    }
+
+    // time steps with the pool
+    teca_buffer_pool::reset_stats();
+    double t_pool = time_steps(nx, ny, n_steps);
+
+    teca_buffer_pool::stats s;
+    teca_buffer_pool::get_stats(s);
+
+    std::cerr << nx << " x " << ny << " mesh, " << n_steps << " steps"
+        << std::endl << "    heap " << t_heap << " ms pool " << t_pool
+        << " ms" << std::endl << "    ";
+    teca_buffer_pool::to_stream(std::cerr);
+    std::cerr << std::endl;
+
+    // after the first step, every array is drawn from the pool
+    CHECK(s.misses <= 6)
+    CHECK(s.hits == 6ul*n_steps - s.misses)
+
+    teca_buffer_pool::disable();
+    teca_buffer_pool::get_stats(s);
+    CHECK(s.n_bytes_cached == 0)
+    CHECK(!teca_buffer_pool::enabled())
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_algorithm_executive.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(sized_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(list_executive)
+
+// a source that produces an array of a fixed size for each
+// requested time step and counts the number of times it executes
+class sized_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(sized_source)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, array_size)
+
+    unsigned long get_number_of_executions() const { return this->n_exec; }
+
+protected:
+    sized_source() : array_size(1), n_exec(0)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    { return teca_metadata(); }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        ++this->n_exec;
+
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        p_array out = array::New();
+        out->resize(this->array_size);
+        out->get(0) = step;
+        return out;
+    }
+
+private:
+    unsigned long array_size;
+    unsigned long n_exec;
+};
+
+// requests the time steps from the given list in order
+class list_executive : public teca_algorithm_executive
+{
+public:
+    TECA_ALGORITHM_EXECUTIVE_STATIC_NEW(list_executive)
+
+    void set_steps(const std::vector<unsigned long> &s) { this->steps = s; }
+
+    int initialize(const teca_metadata &) override
+    {
+        this->i = 0;
+        return 0;
+    }
+
+    teca_metadata get_next_request() override
+    {
+        teca_metadata req;
+        if (this->i < this->steps.size())
+            req.insert("time_step", this->steps[this->i++]);
+        return req;
+    }
+
+protected:
+    list_executive() : i(0) {}
+
+private:
+    size_t i;
+    std::vector<unsigned long> steps;
+};
+
+// request the listed time steps, returns the number of executions
+unsigned long run(const p_sized_source &src,
+    const std::vector<unsigned long> &steps)
+{
+    unsigned long n0 = src->get_number_of_executions();
+
+    p_list_executive exec = list_executive::New();
+    exec->set_steps(steps);
+    src->set_executive(exec);
+    src->update();
+
+    return src->get_number_of_executions() - n0;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 2))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> array size" << std::endl)
+        return -1;
+    }
+
+    unsigned long n = 1024;
+    if (argc == 2)
+        n = atol(argv[1]);
+
+    n = std::max(n, 1ul);
+
+    unsigned long n_bytes = n*sizeof(double);
+
+    // a per algorithm budget of 3 datasets. the count limit is
+    // not reached.
+    p_sized_source src = sized_source::New();
+    src->set_array_size(n);
+    src->set_cache_size(100);
+    src->set_cache_memory_budget(3*n_bytes);
+
+    // 0, 1 and 2 fill the cache, 0 is then used again so that
+    // inserting 3 evicts 1, the least recently used.
+    CHECK(run(src, {0, 1, 2, 0, 3}) == 4)
+    CHECK(src->get_cache_memory_usage() == 3*n_bytes)
+
+    // 0, 2 and 3 are cached, 1 is not
+    CHECK(run(src, {0, 2, 3}) == 0)
+    CHECK(run(src, {1}) == 1)
+    CHECK(src->get_cache_memory_usage() <= 3*n_bytes)
+
+    // lowering the budget evicts immediately
+    src->set_cache_memory_budget(n_bytes);
+    CHECK(src->get_cache_memory_usage() == n_bytes)
+
+    // a dataset larger than the budget is not cached
+    src->set_cache_memory_budget(n_bytes/2);
+    CHECK(run(src, {5, 5}) == 2)
+    CHECK(src->get_cache_memory_usage() == 0)
+
+    // no limit
+    src->set_cache_memory_budget(-1);
+    CHECK(run(src, {0, 1, 2, 3, 0, 1, 2, 3}) == 4)
+    CHECK(src->get_cache_memory_usage() == 4*n_bytes)
+
+    // a process wide budget of 4 datasets shared by two sources.
+    // the first source's datasets are the least recently used and
+    // are evicted as the second source's are cached.
+    p_sized_source src2 = sized_source::New();
+    src2->set_array_size(n);
+    src2->set_cache_size(100);
+
+    teca_algorithm::set_global_cache_memory_budget(4*n_bytes);
+    CHECK(teca_algorithm::get_global_cache_memory_usage() <= 4*n_bytes)
+
+    CHECK(run(src2, {0, 1, 2}) == 3)
+    CHECK(teca_algorithm::get_global_cache_memory_usage() <= 4*n_bytes)
+    CHECK(src->get_cache_memory_usage() == n_bytes)
+    CHECK(src2->get_cache_memory_usage() == 3*n_bytes)
+
+    // the second source's datasets are reused, the first source's
+    // remaining dataset is the least recently used
+    CHECK(run(src2, {0, 1, 2, 3}) == 1)
+    CHECK(src->get_cache_memory_usage() == 0)
+    CHECK(src2->get_cache_memory_usage() == 4*n_bytes)
+
+    teca_algorithm::set_global_cache_memory_budget(-1);
+
+    std::cerr << "cache memory budget " << n_bytes << " bytes per dataset, "
+        << teca_algorithm::get_global_cache_memory_usage() << " bytes cached"
+        << std::endl;
+
+    // a cache of size one holds the most recent dataset
+    p_sized_source src3 = sized_source::New();
+    src3->set_array_size(n);
+    src3->set_cache_size(1);
+
+    CHECK(run(src3, {0, 0}) == 1)
+    CHECK(src3->get_cache_memory_usage() == n_bytes)
+    CHECK(run(src3, {1, 1, 0}) == 2)
+    CHECK(src3->get_cache_memory_usage() == n_bytes)
+
+    // releasing the algorithms releases the memory
+    src = nullptr;
+    src2 = nullptr;
+    src3 = nullptr;
+    CHECK(teca_algorithm::get_global_cache_memory_usage() == 0)
+
+    return 0;
+}
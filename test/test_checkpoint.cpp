@@ -0,0 +1,254 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_time_step_executive.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_table.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+#include "table_source.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstdio>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(failing_sink)
+TECA_SHARED_OBJECT_FORWARD_DECL(failing_reduce)
+
+// a sink that throws, as though the job was killed, when asked
+// for its fail_at'th time step
+class failing_sink : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(failing_sink)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, fail_at)
+
+protected:
+    failing_sink() : fail_at(0), n_exec(0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &) override
+    {
+        if (++this->n_exec == this->fail_at)
+            throw std::runtime_error("killed");
+        return nullptr;
+    }
+
+private:
+    unsigned long fail_at;
+    unsigned long n_exec;
+};
+
+// a table reduction that throws, as though the job was killed,
+// once fail_at time steps have been reduced
+class failing_reduce : public teca_table_reduce
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(failing_reduce)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, fail_at)
+
+protected:
+    failing_reduce() : fail_at(0), n_reduced(0) {}
+
+    void stream_progress(unsigned int port,
+        const std::vector<teca_metadata> &up_reqs,
+        const const_p_teca_dataset &arrived,
+        const std::vector<const_p_teca_dataset> &partials,
+        const teca_metadata &request) override
+    {
+        this->teca_table_reduce::stream_progress(port,
+            up_reqs, arrived, partials, request);
+
+        this->n_reduced += up_reqs.size();
+        if (this->fail_at && (this->n_reduced >= this->fail_at))
+            throw std::runtime_error("killed");
+    }
+
+private:
+    unsigned long fail_at;
+    unsigned long n_reduced;
+};
+
+// runs source --> sink driven by the time step executive. returns
+// the time steps generated, and sets killed if the sink threw.
+std::vector<unsigned long> run_executive(const std::string &file,
+    unsigned long n_steps, unsigned long fail_at, bool &killed)
+{
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+
+    p_failing_sink sink = failing_sink::New();
+    sink->set_fail_at(fail_at);
+    sink->set_input_connection(src->get_output_port());
+
+    p_teca_time_step_executive exec = teca_time_step_executive::New();
+    exec->set_checkpoint_file(file);
+    exec->set_checkpoint_interval(1);
+    sink->set_executive(exec);
+
+    killed = false;
+    try
+    {
+        sink->update();
+    }
+    catch (std::runtime_error &)
+    {
+        killed = true;
+    }
+
+    return src->get_steps();
+}
+
+// runs source --> reduction, with stream_size left at its default
+// or with streaming disabled. returns the time steps generated, and
+// sets killed if the reduction threw.
+std::vector<unsigned long> run_reduction(const std::string &file,
+    bool streaming, unsigned long n_steps, unsigned long fail_at,
+    bool &killed, const_p_teca_table &result)
+{
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+
+    p_failing_reduce red = failing_reduce::New();
+    red->set_fail_at(fail_at);
+    red->set_thread_pool_size(1);
+    if (!streaming)
+        red->set_stream_size(0);
+    red->set_checkpoint_file(file);
+    red->set_checkpoint_interval(4);
+    red->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(red->get_output_port());
+
+    killed = false;
+    try
+    {
+        cap->update();
+    }
+    catch (std::runtime_error &)
+    {
+        killed = true;
+    }
+
+    result = std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+
+    return src->get_steps();
+}
+
+// check that the table holds each time step once
+bool check_table(const const_p_teca_table &table, unsigned long n_steps)
+{
+    if (!table || (table->get_number_of_rows() != n_steps))
+        return false;
+
+    std::set<long> steps;
+    const_p_teca_variant_array col = table->get_column("step");
+    for (unsigned long i = 0; i < n_steps; ++i)
+    {
+        long step = 0;
+        col->get(i, step);
+        steps.insert(step);
+    }
+
+    return (steps.size() == n_steps) && (*steps.begin() == 0) &&
+        (*steps.rbegin() == static_cast<long>(n_steps - 1));
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 2) && (argc != 3))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> checkpoint file prefix" << std::endl
+            << "arg 2 -> n time steps" << std::endl)
+        return -1;
+    }
+
+    std::string prefix = argv[1];
+    unsigned long n_steps = argc == 3 ? atol(argv[2]) : 32;
+    n_steps = std::max(n_steps, 16ul);
+
+    std::string exec_file = prefix + "_exec";
+    std::string red_file[2] = {prefix + "_reduce", prefix + "_reduce_stream"};
+
+    remove((exec_file + ".0").c_str());
+    remove((red_file[0] + ".0").c_str());
+    remove((red_file[1] + ".0").c_str());
+
+    bool killed = false;
+
+    // the executive. the run is killed while processing its 5th
+    // time step, the first 4 were completed.
+    std::vector<unsigned long> steps_1 =
+        run_executive(exec_file, n_steps, 5, killed);
+    CHECK(killed)
+    CHECK(steps_1.size() == 5)
+
+    // the restart processes the rest, including the one that was
+    // in progress
+    std::vector<unsigned long> steps_2 =
+        run_executive(exec_file, n_steps, 0, killed);
+    CHECK(!killed)
+    CHECK(steps_2.size() == n_steps - 4)
+
+    std::set<unsigned long> all_steps(steps_1.begin(), steps_1.begin() + 4);
+    all_steps.insert(steps_2.begin(), steps_2.end());
+    CHECK(all_steps.size() == n_steps)
+
+    // nothing is left to do
+    CHECK(run_executive(exec_file, n_steps, 0, killed).empty())
+
+    // the reduction, without and with streaming. it is killed after
+    // 10 time steps are reduced, by which time 8 were saved in a
+    // checkpoint
+    for (int streaming = 0; streaming < 2; ++streaming)
+    {
+        const std::string &file = red_file[streaming];
+
+        const_p_teca_table result;
+        steps_1 = run_reduction(file, streaming, n_steps, 10, killed, result);
+        CHECK(killed)
+
+        // the restart merges the saved partial result with the rest
+        steps_2 = run_reduction(file, streaming, n_steps, 0, killed, result);
+        CHECK(!killed)
+        CHECK(steps_2.size() <= n_steps - 8)
+        CHECK(check_table(result, n_steps))
+
+        std::cerr << "reduction restart " << (streaming ? "with" : "without")
+            << " streaming generated " << steps_2.size() << " of " << n_steps
+            << " time steps" << std::endl;
+
+        // the final checkpoint holds the entire result
+        steps_2 = run_reduction(file, streaming, n_steps, 0, killed, result);
+        CHECK(steps_2.empty())
+        CHECK(check_table(result, n_steps))
+    }
+
+    remove((exec_file + ".0").c_str());
+    remove((red_file[0] + ".0").c_str());
+    remove((red_file[1] + ".0").c_str());
+
+    return 0;
+}
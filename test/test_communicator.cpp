@@ -0,0 +1,239 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_time_step_executive.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_table.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+#include "table_source.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <thread>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(count_sink)
+
+// a sink that counts the time steps it is given
+class count_sink : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(count_sink)
+
+    unsigned long get_count() const { return this->count; }
+
+protected:
+    count_sink() : count(0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &) override
+    {
+        ++this->count;
+        return nullptr;
+    }
+
+private:
+    unsigned long count;
+};
+
+// get the rank and size of the communicator
+void get_rank(MPI_Comm comm, int &rank, int &n_ranks)
+{
+    rank = 0;
+    n_ranks = 1;
+#if defined(TECA_HAS_MPI)
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &n_ranks);
+#else
+    (void)comm;
+#endif
+}
+
+// sum a count over the ranks of the communicator
+unsigned long sum_over_ranks(MPI_Comm comm, unsigned long n)
+{
+#if defined(TECA_HAS_MPI)
+    unsigned long tot = 0;
+    MPI_Allreduce(&n, &tot, 1, MPI_UNSIGNED_LONG, MPI_SUM, comm);
+    return tot;
+#else
+    (void)comm;
+    return n;
+#endif
+}
+
+// check that the table holds each time step once
+bool check_table(const const_p_teca_table &table, unsigned long n_steps)
+{
+    if (!table || (table->get_number_of_rows() != n_steps))
+        return false;
+
+    std::set<long> steps;
+    const_p_teca_variant_array col = table->get_column("step");
+    for (unsigned long i = 0; i < n_steps; ++i)
+    {
+        long step = 0;
+        col->get(i, step);
+        steps.insert(step);
+    }
+
+    return (steps.size() == n_steps) && (*steps.begin() == 0) &&
+        (*steps.rbegin() == static_cast<long>(n_steps - 1));
+}
+
+// runs source --> sink driven by the time step executive on the
+// given communicator. the time steps are partitioned across its ranks
+int run_executive(MPI_Comm comm, unsigned long n_steps, int dynamic)
+{
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+
+    p_count_sink sink = count_sink::New();
+    sink->set_input_connection(src->get_output_port());
+    sink->set_communicator(comm);
+
+    p_teca_time_step_executive exec = teca_time_step_executive::New();
+    exec->set_dynamic_schedule(dynamic);
+    sink->set_executive(exec);
+
+    CHECK(src->get_communicator() == comm)
+    CHECK(sink->update() == 0)
+
+    // each time step was processed once, by one of the ranks
+    CHECK(sum_over_ranks(comm, sink->get_count()) == n_steps)
+
+    // with the static partition each rank has its share
+    int rank = 0;
+    int n_ranks = 1;
+    get_rank(comm, rank, n_ranks);
+    if (!dynamic)
+    {
+        unsigned long n_local = n_steps/n_ranks +
+            (static_cast<unsigned long>(rank) < n_steps % n_ranks ? 1 : 0);
+        CHECK(sink->get_count() == n_local)
+    }
+
+    return 0;
+}
+
+// the source --> reduction --> capture pipeline
+struct reduction_pipeline
+{
+    reduction_pipeline(MPI_Comm comm, unsigned long n_steps, int dynamic)
+        : n_steps(n_steps)
+    {
+        p_table_source src = table_source::New();
+        src->set_number_of_time_steps(n_steps);
+
+        p_teca_table_reduce red = teca_table_reduce::New();
+        red->set_thread_pool_size(1);
+        red->set_dynamic_schedule(dynamic);
+        red->set_input_connection(src->get_output_port());
+
+        cap = teca_dataset_capture::New();
+        cap->set_input_connection(red->get_output_port());
+        cap->set_communicator(comm);
+    }
+
+    // the complete result is on rank 0 of the communicator
+    int update()
+    {
+        CHECK(cap->update() == 0)
+
+        int rank = 0;
+        int n_ranks = 1;
+        get_rank(cap->get_communicator(), rank, n_ranks);
+        if (rank == 0)
+        {
+            const_p_teca_table table =
+                std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+            CHECK(check_table(table, n_steps))
+        }
+
+        return 0;
+    }
+
+    unsigned long n_steps;
+    p_teca_dataset_capture cap;
+};
+
+
+int main(int argc, char **argv)
+{
+    // when the second argument is set two pipelines are run
+    // concurrently on different threads, this needs MPI_THREAD_MULTIPLE
+    int threads = argc > 2 ? atoi(argv[2]) : 0;
+
+    teca_mpi_manager mpi_man(argc, argv,
+        threads ? MPI_THREAD_MULTIPLE : MPI_THREAD_SERIALIZED);
+
+    teca_system_interface::set_stack_trace_on_error();
+
+    unsigned long n_steps = argc > 1 ? atol(argv[1]) : 32;
+
+    int rank = mpi_man.get_comm_rank();
+
+    if (threads)
+    {
+        // each pipeline has its own communicator
+        MPI_Comm comm_a = MPI_COMM_WORLD;
+        MPI_Comm comm_b = MPI_COMM_WORLD;
+#if defined(TECA_HAS_MPI)
+        MPI_Comm_dup(MPI_COMM_WORLD, &comm_a);
+        MPI_Comm_dup(MPI_COMM_WORLD, &comm_b);
+#endif
+        reduction_pipeline red_a(comm_a, n_steps, 0);
+        reduction_pipeline red_b(comm_b, n_steps + 3, 0);
+
+        int ierr_a = 0;
+        std::thread thread_a([&]() { ierr_a = red_a.update(); });
+        int ierr_b = red_b.update();
+        thread_a.join();
+
+        CHECK(ierr_a == 0)
+        CHECK(ierr_b == 0)
+
+#if defined(TECA_HAS_MPI)
+        MPI_Comm_free(&comm_a);
+        MPI_Comm_free(&comm_b);
+#endif
+        return 0;
+    }
+
+    // split the ranks in two groups, each runs pipelines on its own
+    // communicator, processing a different number of time steps
+    int color = rank % 2;
+    unsigned long n_color_steps = n_steps + 7*color;
+
+    MPI_Comm comm = MPI_COMM_WORLD;
+#if defined(TECA_HAS_MPI)
+    MPI_Comm_split(MPI_COMM_WORLD, color, rank, &comm);
+#endif
+
+    CHECK(run_executive(comm, n_color_steps, 0) == 0)
+    CHECK(run_executive(comm, n_color_steps, 1) == 0)
+
+    reduction_pipeline red_static(comm, n_color_steps, 0);
+    CHECK(red_static.update() == 0)
+
+    reduction_pipeline red_dynamic(comm, n_color_steps, 1);
+    CHECK(red_dynamic.update() == 0)
+
+#if defined(TECA_HAS_MPI)
+    MPI_Comm_free(&comm);
+#endif
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_thread_pool.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <set>
+#include <algorithm>
+
+using internal::cpu_core;
+using internal::cpu_topology;
+
+// check that the order holds each core once
+bool is_permutation(const std::vector<int> &order, int n_cores)
+{
+    std::set<int> cores(order.begin(), order.end());
+    return (static_cast<int>(order.size()) == n_cores) &&
+        (static_cast<int>(cores.size()) == n_cores) &&
+        (*cores.begin() == 0) && (*cores.rbegin() == n_cores - 1);
+}
+
+// a node with 2 NUMA nodes each with 2 L3 caches shared by 4 cores
+// with 2 hyperthreads. the hyperthreads of core q are q and q + 16.
+void make_topology(cpu_topology &topo)
+{
+    int n_cores = 16;
+    topo.cores.assign(n_cores, cpu_core());
+    topo.cpu_core_id.resize(2*n_cores);
+    for (int q = 0; q < n_cores; ++q)
+    {
+        cpu_core &core = topo.cores[q];
+        core.cpus = {q, q + n_cores};
+        core.l3 = q/4;
+        core.numa = q/8;
+        topo.cpu_core_id[q] = q;
+        topo.cpu_core_id[q + n_cores] = q;
+    }
+    topo.n_l3 = 4;
+    topo.n_numa = 2;
+}
+
+
+int main(int, char **)
+{
+    teca_system_interface::set_stack_trace_on_error();
+
+    // the topology of this node
+    cpu_topology topo;
+    internal::detect_cpu_topology(topo);
+
+    int n_cores = topo.cores.size();
+    int n_cpus = topo.cpu_core_id.size();
+
+    std::cerr << "detected " << n_cpus << " threads " << n_cores
+        << " cores " << topo.n_l3 << " L3 caches " << topo.n_numa
+        << " NUMA nodes" << std::endl;
+
+    CHECK(n_cores > 0)
+    CHECK(n_cores <= n_cpus)
+    CHECK(topo.n_l3 > 0)
+    CHECK(topo.n_numa > 0)
+
+    // each cpu belongs to one core
+    std::set<int> cpus;
+    for (int q = 0; q < n_cores; ++q)
+    {
+        const cpu_core &core = topo.cores[q];
+        CHECK(!core.cpus.empty())
+        CHECK((core.l3 >= 0) && (core.l3 < topo.n_l3))
+        CHECK((core.numa >= 0) && (core.numa < topo.n_numa))
+        for (int cpu : core.cpus)
+        {
+            CHECK((cpu >= 0) && (cpu < n_cpus))
+            CHECK(topo.cpu_core_id[cpu] == q)
+            CHECK(cpus.insert(cpu).second)
+        }
+    }
+
+#if defined(_GNU_SOURCE)
+    // only the cpus this process may run on are used
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (int cpu : cpus)
+            CHECK(CPU_ISSET(cpu, &allowed))
+    }
+#endif
+
+    std::vector<int> order;
+    internal::get_core_order(topo, 0, false, order);
+    CHECK(is_permutation(order, n_cores))
+
+    internal::get_core_order(topo, 0, true, order);
+    CHECK(is_permutation(order, n_cores))
+
+    // a process on NUMA node 1 claims the cores of its node first,
+    // alternating between the L3 caches, starting with its own
+    make_topology(topo);
+
+    internal::get_core_order(topo, 25, false, order);
+    CHECK(is_permutation(order, 16))
+    for (int i = 0; i < 8; ++i)
+    {
+        CHECK(topo.cores[order[i]].numa == 1)
+        CHECK(topo.cores[order[i]].l3 == (i % 2 ? 3 : 2))
+    }
+
+    // spread, consecutive cores come from different NUMA nodes
+    internal::get_core_order(topo, 25, true, order);
+    CHECK(is_permutation(order, 16))
+    for (int i = 0; i < 16; ++i)
+        CHECK(topo.cores[order[i]].numa == (i % 2 ? 0 : 1))
+
+    // binding on this node. each thread is given a cpu
+    std::deque<int> affinity;
+    int n_threads = internal::thread_parameters(MPI_COMM_SELF, 0, 3,
+        true, true, false, affinity);
+
+    CHECK(n_threads == 3)
+    CHECK(affinity.size() == 3)
+    for (int cpu : affinity)
+        CHECK((cpu >= 0) && (cpu < n_cpus))
+
+    return 0;
+}
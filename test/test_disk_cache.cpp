@@ -0,0 +1,360 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_time_step_executive.h"
+#include "teca_disk_cache.h"
+#include "teca_cartesian_mesh.h"
+#include "teca_array_collection.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_file_util.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(mesh_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(pass_stage)
+TECA_SHARED_OBJECT_FORWARD_DECL(check_sink)
+
+// a source that reports an input file, as a reader would, and
+// generates a mesh with an array whose values depend on the time
+// step and the scale property. the number of executions is counted.
+class mesh_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(mesh_source)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_time_steps)
+    TECA_ALGORITHM_PROPERTY(unsigned long, array_size)
+    TECA_ALGORITHM_PROPERTY(double, scale)
+    TECA_ALGORITHM_PROPERTY(std::string, file_name)
+
+    unsigned long get_number_of_executions() const { return this->n_exec; }
+
+    void to_stream(std::ostream &os) const override
+    { os << " scale=" << this->scale; }
+
+protected:
+    mesh_source() : number_of_time_steps(1), array_size(1), scale(1.0),
+        n_exec(0)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    {
+        teca_metadata md;
+        md.insert("number_of_time_steps", this->number_of_time_steps);
+        md.insert("root", teca_file_util::path(this->file_name));
+        md.insert("files", std::vector<std::string>(
+            {teca_file_util::filename(this->file_name)}));
+        return md;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        ++this->n_exec;
+
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        p_teca_double_array f = teca_double_array::New(this->array_size);
+        for (unsigned long i = 0; i < this->array_size; ++i)
+            f->set(i, this->scale*(step + i));
+
+        p_teca_cartesian_mesh mesh = teca_cartesian_mesh::New();
+        mesh->set_time_step(step);
+        mesh->get_point_arrays()->append("f", f);
+
+        return mesh;
+    }
+
+private:
+    unsigned long number_of_time_steps;
+    unsigned long array_size;
+    double scale;
+    std::string file_name;
+    unsigned long n_exec;
+};
+
+// passes the data through. like most algorithms it does not
+// report its properties through to_stream
+class pass_stage : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(pass_stage)
+
+protected:
+    pass_stage()
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        return input_data[0];
+    }
+};
+
+// verifies the data it is given
+class check_sink : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(check_sink)
+
+    TECA_ALGORITHM_PROPERTY(double, scale)
+
+    unsigned long get_number_of_errors() const { return this->n_errors; }
+
+protected:
+    check_sink() : scale(1.0), n_errors(0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override
+    {
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        const_p_teca_cartesian_mesh mesh
+            = std::dynamic_pointer_cast<const teca_cartesian_mesh>(input_data[0]);
+
+        const_p_teca_double_array f;
+        if (!mesh || !(f = std::dynamic_pointer_cast<const teca_double_array>(
+            mesh->get_point_arrays()->get("f"))))
+        {
+            TECA_ERROR("time step " << step << " is invalid")
+            ++this->n_errors;
+            return nullptr;
+        }
+
+        unsigned long n = f->size();
+        for (unsigned long i = 0; i < n; ++i)
+        {
+            if (f->get(i) != this->scale*(step + i))
+            {
+                TECA_ERROR("time step " << step << " has the wrong values")
+                ++this->n_errors;
+                break;
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    double scale;
+    unsigned long n_errors;
+};
+
+// run the pipeline as a new process would, with new algorithms.
+// when stage is set a pass_stage is placed in front of the cache
+int run(const std::string &cache_dir, const std::string &input_file,
+    unsigned long n_steps, double scale, const std::string &tag,
+    long budget, unsigned long &n_exec, unsigned long &n_hits,
+    bool stage = false)
+{
+    p_mesh_source src = mesh_source::New();
+    src->set_number_of_time_steps(n_steps);
+    src->set_array_size(256);
+    src->set_scale(scale);
+    src->set_file_name(input_file);
+
+    p_teca_disk_cache cache = teca_disk_cache::New();
+    cache->set_cache_directory(cache_dir);
+    cache->set_cache_tag(tag);
+    cache->set_disk_budget(budget);
+
+    p_pass_stage pass = pass_stage::New();
+    if (stage)
+    {
+        pass->set_input_connection(src->get_output_port());
+        cache->set_input_connection(pass->get_output_port());
+    }
+    else
+    {
+        cache->set_input_connection(src->get_output_port());
+    }
+
+    p_check_sink sink = check_sink::New();
+    sink->set_scale(scale);
+    sink->set_input_connection(cache->get_output_port());
+
+    p_teca_time_step_executive exec = teca_time_step_executive::New();
+    sink->set_executive(exec);
+    sink->update();
+
+    n_exec = src->get_number_of_executions();
+    n_hits = cache->get_number_of_cache_hits();
+
+    std::cerr << "disk cache scale " << scale << " tag \"" << tag
+        << "\" budget " << budget << " " << n_exec << " executions "
+        << n_hits << " hits " << cache->get_number_of_cache_misses()
+        << " misses" << std::endl;
+
+    // without the tag the stage's settings can't be identified and
+    // requests are passed through
+    unsigned long n_reqs = n_hits + cache->get_number_of_cache_misses();
+    if (n_reqs != ((stage && tag.empty()) ? 0 : n_steps))
+    {
+        TECA_ERROR("requests are not accounted for")
+        return -1;
+    }
+
+    return sink->get_number_of_errors() ? -1 : 0;
+}
+
+// get the number and total size of the cached files
+void get_usage(const std::string &cache_dir, unsigned long &n_files,
+    unsigned long &n_bytes)
+{
+    n_files = 0;
+    n_bytes = 0;
+
+    DIR *dir = opendir(cache_dir.c_str());
+    if (!dir)
+        return;
+
+    struct dirent *ent = nullptr;
+    while ((ent = readdir(dir)))
+    {
+        std::string name = ent->d_name;
+        if (teca_file_util::extension(name) != "teca_cache")
+            continue;
+
+        struct stat s;
+        if (stat((cache_dir + "/" + name).c_str(), &s) == 0)
+        {
+            ++n_files;
+            n_bytes += s.st_size;
+        }
+    }
+
+    closedir(dir);
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 2) && (argc != 3))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> cache directory" << std::endl
+            << "arg 2 -> n time steps" << std::endl)
+        return -1;
+    }
+
+    std::string cache_dir = argv[1];
+    unsigned long n_steps = argc == 3 ? atol(argv[2]) : 16;
+    n_steps = std::max(n_steps, 4ul);
+
+    std::string input_file = cache_dir + "_input.txt";
+    std::ofstream(input_file) << "input" << std::endl;
+
+    // start from an empty cache
+    p_teca_disk_cache cache = teca_disk_cache::New();
+    cache->set_cache_directory(cache_dir);
+    CHECK(cache->clear_disk_cache() == 0)
+
+    unsigned long n_exec = 0;
+    unsigned long n_hits = 0;
+    unsigned long n_files = 0;
+    unsigned long n_bytes = 0;
+
+    // the first run computes and stores each time step
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "", -1, n_exec, n_hits) == 0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    get_usage(cache_dir, n_files, n_bytes);
+    CHECK(n_files == n_steps)
+
+    // a second run reads them back without executing upstream
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "", -1, n_exec, n_hits) == 0)
+    CHECK(n_exec == 0)
+    CHECK(n_hits == n_steps)
+
+    // changing a property reported through to_stream misses
+    CHECK(run(cache_dir, input_file, n_steps, 2.0, "", -1, n_exec, n_hits) == 0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    // as does changing the tag
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "v2", -1, n_exec, n_hits) == 0)
+    CHECK(n_exec == n_steps)
+
+    // and modifying the input file
+    std::ofstream(input_file) << "modified input" << std::endl;
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "", -1, n_exec, n_hits) == 0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    // an algorithm upstream that doesn't report its properties
+    // disables caching, since changes to them would go unnoticed
+    unsigned long n_files_0 = 0;
+    unsigned long n_bytes_0 = 0;
+    get_usage(cache_dir, n_files_0, n_bytes_0);
+
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "", -1, n_exec, n_hits, true) == 0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    unsigned long n_files_1 = 0;
+    unsigned long n_bytes_1 = 0;
+    get_usage(cache_dir, n_files_1, n_bytes_1);
+    CHECK(n_files_1 == n_files_0)
+
+    // unless the tag is set to stand in for them
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "v4", -1, n_exec, n_hits, true) == 0)
+    CHECK(n_exec == n_steps)
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "v4", -1, n_exec, n_hits, true) == 0)
+    CHECK(n_exec == 0)
+    CHECK(n_hits == n_steps)
+
+    // with a budget of 3 datasets the least recently used are removed
+    unsigned long file_size = n_bytes/n_steps;
+    long budget = 3*file_size + file_size/2;
+    CHECK(run(cache_dir, input_file, n_steps, 1.0, "v3", budget, n_exec, n_hits) == 0)
+    get_usage(cache_dir, n_files, n_bytes);
+    CHECK(n_bytes <= static_cast<unsigned long>(budget))
+    CHECK(n_files == 3)
+
+    // the most recently used time steps are still cached. time
+    // steps are requested in reverse order.
+    CHECK(run(cache_dir, input_file, 3, 1.0, "v3", budget, n_exec, n_hits) == 0)
+    CHECK(n_hits == 3)
+
+    CHECK(cache->clear_disk_cache() == 0)
+    get_usage(cache_dir, n_files, n_bytes);
+    CHECK(n_files == 0)
+
+    remove(input_file.c_str());
+
+    return 0;
+}
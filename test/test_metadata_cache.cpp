@@ -0,0 +1,276 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_algorithm_executive.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(attribute_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(pass_through)
+TECA_SHARED_OBJECT_FORWARD_DECL(step_sum)
+TECA_SHARED_OBJECT_FORWARD_DECL(step_executive)
+
+// a source reporting a number of time steps along with a
+// large set of attributes, as a reader of CF files would.
+// produces an array holding the requested time step.
+class attribute_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(attribute_source)
+
+    TECA_ALGORITHM_PROPERTY(long, number_of_time_steps)
+    TECA_ALGORITHM_PROPERTY(long, number_of_attributes)
+
+    // mark the source modified, which invalidates the cached
+    // metadata of all stages downstream
+    void touch() { this->set_modified(); }
+
+protected:
+    attribute_source() : number_of_time_steps(1), number_of_attributes(1)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    {
+        teca_metadata atts;
+        for (long i = 0; i < this->number_of_attributes; ++i)
+        {
+            teca_metadata att;
+            att.insert("units", std::string("kg m-2 s-1"));
+            att.insert("long_name", std::string("attribute ") + std::to_string(i));
+            att.insert("_FillValue", 1.0e20);
+            atts.insert("var_" + std::to_string(i), att);
+        }
+
+        teca_metadata md;
+        md.insert("attributes", atts);
+        md.insert("number_of_time_steps", this->number_of_time_steps);
+        return md;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        p_array out = array::New();
+        out->append(step);
+        return out;
+    }
+
+private:
+    long number_of_time_steps;
+    long number_of_attributes;
+};
+
+// a stage that passes metadata, requests and data through
+class pass_through : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(pass_through)
+
+protected:
+    pass_through()
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    { return input_data[0]; }
+};
+
+// a sink summing the time steps it receives
+class step_sum : public pass_through
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(step_sum)
+
+    double get_sum() const { return this->sum; }
+    void clear_sum() { this->sum = 0.0; }
+
+protected:
+    step_sum() : sum(0.0) {}
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        const_p_array in = std::dynamic_pointer_cast<const array>(input_data[0]);
+        if (!in || in->empty())
+        {
+            TECA_ERROR("invalid input")
+            return nullptr;
+        }
+        this->sum += in->get(0);
+        return in;
+    }
+
+private:
+    double sum;
+};
+
+// requests each of the available time steps. when a source is
+// given it is marked modified before each request, such that the
+// metadata is reported anew by each stage as it was before reports
+// were cached.
+class step_executive : public teca_algorithm_executive
+{
+public:
+    TECA_ALGORITHM_EXECUTIVE_STATIC_NEW(step_executive)
+
+    void set_source(const p_attribute_source &src) { this->source = src; }
+
+    int initialize(const teca_metadata &md) override
+    {
+        this->step = 0;
+        return md.get("number_of_time_steps", this->n_steps);
+    }
+
+    teca_metadata get_next_request() override
+    {
+        teca_metadata req;
+        if (this->step < this->n_steps)
+        {
+            req.insert("time_step", this->step++);
+            if (this->source)
+                this->source->touch();
+        }
+        return req;
+    }
+
+protected:
+    step_executive() : step(0), n_steps(0) {}
+
+private:
+    long step;
+    long n_steps;
+    p_attribute_source source;
+};
+
+// run the pipeline, returns the number of requests per second.
+// when cached is false the metadata is reported anew for each
+// request.
+double run(long n_steps, long n_atts, int n_stages, bool cached, bool &ok)
+{
+    // attribute_source --> pass_through ... pass_through --> step_sum
+    p_attribute_source src = attribute_source::New();
+    src->set_number_of_time_steps(n_steps);
+    src->set_number_of_attributes(n_atts);
+
+    p_teca_algorithm up = src;
+    for (int i = 0; i < n_stages; ++i)
+    {
+        p_teca_algorithm stage = pass_through::New();
+        stage->set_input_connection(up->get_output_port());
+        up = stage;
+    }
+
+    p_step_sum sink = step_sum::New();
+    sink->set_input_connection(up->get_output_port());
+
+    p_step_executive exec = step_executive::New();
+    if (!cached)
+        exec->set_source(src);
+    sink->set_executive(exec);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    sink->update();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    double expected = n_steps*(n_steps - 1)/2;
+    ok = sink->get_sum() == expected;
+    if (!ok)
+    {
+        TECA_ERROR("sum " << sink->get_sum() << " != " << expected)
+        return 0.0;
+    }
+
+    // modify the source, the cached metadata must be invalidated
+    // and the new number of steps seen downstream
+    exec->set_source(nullptr);
+    sink->clear_sum();
+    src->set_number_of_time_steps(n_steps/2);
+    sink->update();
+
+    expected = (n_steps/2)*(n_steps/2 - 1)/2;
+    ok = sink->get_sum() == expected;
+    if (!ok)
+    {
+        TECA_ERROR("after modification sum " << sink->get_sum()
+            << " != " << expected)
+        return 0.0;
+    }
+
+    return n_steps/std::chrono::duration<double>(t1 - t0).count();
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 4))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> n time steps" << std::endl
+            << "arg 2 -> n attributes" << std::endl
+            << "arg 3 -> n stages" << std::endl)
+        return -1;
+    }
+
+    long n_steps = 2000;
+    long n_atts = 200;
+    int n_stages = 4;
+
+    if (argc == 4)
+    {
+        n_steps = atol(argv[1]);
+        n_atts = atol(argv[2]);
+        n_stages = atoi(argv[3]);
+    }
+
+    n_steps = std::max(n_steps, 2l);
+    n_atts = std::max(n_atts, 1l);
+    n_stages = std::max(n_stages, 1);
+
+    bool ok = false;
+
+    double rate_uncached = run(n_steps, n_atts, n_stages, false, ok);
+    if (!ok)
+        return -1;
+
+    double rate_cached = run(n_steps, n_atts, n_stages, true, ok);
+    if (!ok)
+        return -1;
+
+    std::cerr << "metadata cache benchmark " << n_steps << " steps "
+        << n_atts << " attributes " << n_stages << " stages" << std::endl
+        << std::setw(24) << std::left << "requests per second"
+        << std::setw(14) << std::right << "uncached"
+        << std::setw(14) << std::right << "cached" << std::endl
+        << std::setw(24) << "" << std::setw(14) << std::right << rate_uncached
+        << std::setw(14) << std::right << rate_cached << std::endl
+        << std::setw(24) << std::left << "speed up" << std::setw(28)
+        << std::right << rate_cached/rate_uncached << std::endl;
+
+    return 0;
+}
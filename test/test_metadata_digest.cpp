@@ -0,0 +1,291 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_algorithm_executive.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(counting_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(repeat_executive)
+
+// a source that counts the number of times it executes and
+// produces an array holding the requested time step
+class counting_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(counting_source)
+
+    unsigned long get_number_of_executions() const { return this->n_exec; }
+
+protected:
+    counting_source() : n_exec(0)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    { return teca_metadata(); }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        ++this->n_exec;
+
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        p_array out = array::New();
+        out->append(step);
+        return out;
+    }
+
+private:
+    unsigned long n_exec;
+};
+
+// requests time steps 0 to n_steps - 1 n_reps times. each request
+// is a new object with the keys inserted in a different order, so
+// that cache hits depend on the content of the request alone.
+class repeat_executive : public teca_algorithm_executive
+{
+public:
+    TECA_ALGORITHM_EXECUTIVE_STATIC_NEW(repeat_executive)
+
+    void set_number_of_steps(unsigned long n) { this->n_steps = n; }
+    void set_number_of_repetitions(unsigned long n) { this->n_reps = n; }
+
+    int initialize(const teca_metadata &) override
+    {
+        this->i = 0;
+        return 0;
+    }
+
+    teca_metadata get_next_request() override
+    {
+        teca_metadata req;
+        if (this->i < this->n_steps*this->n_reps)
+        {
+            unsigned long step = this->i % this->n_steps;
+            if (this->i % 2)
+            {
+                req.insert("time_step", step);
+                req.insert("variables", std::string("prw"));
+            }
+            else
+            {
+                req.insert("variables", std::string("prw"));
+                req.insert("time_step", step);
+            }
+            ++this->i;
+        }
+        return req;
+    }
+
+protected:
+    repeat_executive() : i(0), n_steps(1), n_reps(1) {}
+
+private:
+    unsigned long i;
+    unsigned long n_steps;
+    unsigned long n_reps;
+};
+
+// verify the properties of the digest
+int test_digest()
+{
+    // the digest does not depend on insertion order
+    teca_metadata a;
+    a.insert("time_step", 10ul);
+    a.insert("bounds", std::vector<double>({0.0, 360.0, -90.0, 90.0}));
+    a.insert("name", std::string("prw"));
+
+    teca_metadata b;
+    b.insert("name", std::string("prw"));
+    b.insert("time_step", 10ul);
+    b.insert("bounds", std::vector<double>({0.0, 360.0, -90.0, 90.0}));
+
+    CHECK(a.get_digest() == b.get_digest())
+    CHECK(a == b)
+
+    // copies share the digest
+    teca_metadata c(a);
+    CHECK(c.get_digest() == a.get_digest())
+
+    // changing a value changes the digest
+    c.set("time_step", 11ul);
+    CHECK(c.get_digest() != a.get_digest())
+    CHECK(!(c == a))
+
+    // changing it back restores it
+    c.set("time_step", 10ul);
+    CHECK(c.get_digest() == a.get_digest())
+    CHECK(c == a)
+
+    // the type is part of the digest
+    teca_metadata d;
+    d.insert("time_step", 10l);
+    teca_metadata e;
+    e.insert("time_step", 10ul);
+    CHECK(d.get_digest() != e.get_digest())
+
+    // appending, removing and replacing
+    c.append("bounds", 0.0);
+    CHECK(c.get_digest() != a.get_digest())
+    c.insert("bounds", std::vector<double>({0.0, 360.0, -90.0, 90.0}));
+    CHECK(c.get_digest() == a.get_digest())
+
+    c.remove("name");
+    CHECK(c.get_digest() != a.get_digest())
+    c.insert("name", std::string("prw"));
+    CHECK(c.get_digest() == a.get_digest())
+
+    // equality is symmetric
+    teca_metadata f(a);
+    f.insert("extra", 1);
+    CHECK(!(f == a))
+    CHECK(!(a == f))
+
+    // nested metadata contributes by content
+    teca_metadata g;
+    g.insert("attributes", a);
+    teca_metadata h;
+    h.insert("attributes", b);
+    CHECK(g.get_digest() == h.get_digest())
+    h.insert("attributes", f);
+    CHECK(g.get_digest() != h.get_digest())
+
+    // the empty object
+    teca_metadata i;
+    teca_metadata j;
+    j.insert("x", 1);
+    j.remove("x");
+    CHECK(i.get_digest() == j.get_digest())
+    CHECK(i == j)
+
+    // arrays modified through a pointer held by the caller
+    teca_metadata k(a);
+    p_teca_variant_array step = k.get("time_step");
+    teca_metadata l(k);
+    CHECK(k.get_digest() == a.get_digest())
+
+    step->set(0, 11ul);
+
+    // copies made before are unaffected
+    CHECK(l == a)
+    CHECK(l.get_digest() == a.get_digest())
+
+    // the change is seen by the digest and the comparison
+    teca_metadata m(a);
+    m.set("time_step", 11ul);
+    CHECK(k.get_digest() == m.get_digest())
+    CHECK(k == m)
+
+    step->set(0, 10ul);
+    CHECK(k.get_digest() == a.get_digest())
+    CHECK(k == a)
+
+    // as are arrays passed to insert
+    p_teca_variant_array bounds = teca_double_array::New(4);
+    bounds->set(0, 3, std::vector<double>({0.0, 360.0, -90.0, 90.0}).data());
+    teca_metadata n;
+    n.insert("bounds", bounds);
+    teca_metadata o(n);
+    bounds->set(0, 1.0);
+    double lon_0 = -1.0;
+    o.get("bounds", 0, lon_0);
+    CHECK(lon_0 == 0.0)
+    CHECK(n.get_digest() != o.get_digest())
+    CHECK(!(n == o))
+
+    // threads requesting a digest that must be recomputed agree
+    teca_metadata p(a);
+    p.set("time_step", 12ul);
+    std::vector<unsigned long long> digests(4);
+    std::vector<std::thread> threads;
+    for (int q = 0; q < 4; ++q)
+        threads.push_back(std::thread([&p, &digests, q]()
+            { digests[q] = p.get_digest(); }));
+    for (auto &t : threads)
+        t.join();
+    teca_metadata r(a);
+    r.insert("time_step", 12ul);
+    CHECK(digests[0] == r.get_digest())
+    for (int q = 1; q < 4; ++q)
+        CHECK(digests[q] == digests[0])
+
+    return 0;
+}
+
+// verify that the data cache finds separately constructed
+// requests with the same content
+int test_data_cache(unsigned long n_steps, unsigned long n_reps)
+{
+    p_counting_source src = counting_source::New();
+    src->set_cache_size(n_steps + 1);
+
+    p_repeat_executive exec = repeat_executive::New();
+    exec->set_number_of_steps(n_steps);
+    exec->set_number_of_repetitions(n_reps);
+
+    src->set_executive(exec);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    src->update();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::cerr << "data cache " << n_steps << " steps " << n_reps
+        << " repetitions " << src->get_number_of_executions()
+        << " executions in "
+        << std::chrono::duration<double, std::milli>(t1 - t0).count()
+        << " ms" << std::endl;
+
+    CHECK(src->get_number_of_executions() == n_steps)
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 3))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> n time steps" << std::endl
+            << "arg 2 -> n repetitions" << std::endl)
+        return -1;
+    }
+
+    unsigned long n_steps = 100;
+    unsigned long n_reps = 4;
+
+    if (argc == 3)
+    {
+        n_steps = atol(argv[1]);
+        n_reps = atol(argv[2]);
+    }
+
+    n_steps = std::max(n_steps, 1ul);
+    n_reps = std::max(n_reps, 1ul);
+
+    if (test_digest() || test_data_cache(n_steps, n_reps))
+        return -1;
+
+    return 0;
+}
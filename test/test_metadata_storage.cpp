@@ -0,0 +1,261 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_metadata.h"
+#include "teca_variant_array.h"
+#include "teca_binary_stream.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+// a request like those the executives pass up the pipeline
+teca_metadata make_base_request()
+{
+    teca_metadata coords;
+    coords.insert("x_variable", std::string("lon"));
+    coords.insert("y_variable", std::string("lat"));
+    coords.insert("z_variable", std::string(""));
+    coords.insert("t_variable", std::string("time"));
+
+    teca_metadata req;
+    req.insert("index_request_key", std::string("time_step"));
+    req.insert("bounds", std::vector<double>({0.0, 360.0, -90.0, 90.0, 0.0, 0.0}));
+    req.insert("coordinates", coords);
+    req.insert("whole_extent", std::vector<unsigned long>({0, 1439, 0, 719, 0, 0}));
+    req.insert("number_of_time_steps", 1460ul);
+    req.insert("calendar", std::string("standard"));
+    req.insert("time_units", std::string("days since 1979-01-01 00:00:00"));
+    req.insert("filename_time_template", std::string("%Y%m%d"));
+    req.insert("device_id", -1);
+    req.insert("rank", 0);
+    return req;
+}
+
+// modifying one of two copies must not affect the other
+int test_copy_on_write()
+{
+    teca_metadata a = make_base_request();
+    a.insert("arrays", std::vector<std::string>({"U850", "V850"}));
+
+    // set
+    teca_metadata b(a);
+    b.set("rank", 3);
+    int rank = -1;
+    a.get("rank", rank);
+    CHECK(rank == 0)
+    b.get("rank", rank);
+    CHECK(rank == 3)
+
+    // set on the original
+    teca_metadata c(a);
+    a.set("rank", 4);
+    c.get("rank", rank);
+    CHECK(rank == 0)
+    a.set("rank", 0);
+
+    // append and resize
+    teca_metadata d(a);
+    d.append("arrays", std::string("PSL"));
+    unsigned int n = 0;
+    a.size("arrays", n);
+    CHECK(n == 2)
+    d.size("arrays", n);
+    CHECK(n == 3)
+
+    d.resize("bounds", 4);
+    a.size("bounds", n);
+    CHECK(n == 6)
+
+    // the array returned by the non-const get
+    teca_metadata e(a);
+    p_teca_variant_array ext = e.get("whole_extent");
+    ext->set(1, 719ul);
+    std::vector<unsigned long> wext;
+    a.get("whole_extent", wext);
+    CHECK(wext[1] == 1439)
+    e.get("whole_extent", wext);
+    CHECK(wext[1] == 719)
+    CHECK(!(a == e))
+
+    // nested metadata
+    teca_metadata f(a);
+    teca_metadata coords;
+    f.get("coordinates", coords);
+    coords.set("z_variable", std::string("plev"));
+    f.insert("coordinates", coords);
+    a.get("coordinates", coords);
+    std::string z_var;
+    coords.get("z_variable", z_var);
+    CHECK(z_var.empty())
+
+    // arrays inserted directly are held, not copied
+    p_teca_double_array g_val = teca_double_array::New(1, 1.0);
+    teca_metadata g;
+    g.insert("value", p_teca_variant_array(g_val));
+    g_val->set(0, 2.0);
+    double val = 0.0;
+    g.get("value", val);
+    CHECK(val == 2.0)
+
+    // the copy of an array inserted directly
+    teca_metadata h(g);
+    h.set("value", 3.0);
+    g.get("value", val);
+    CHECK(val == 2.0)
+
+    return 0;
+}
+
+// verify the container semantics
+int test_container()
+{
+    teca_metadata a;
+    CHECK(a.empty())
+    CHECK(!a)
+
+    // insertion in any order, iteration in key order
+    const char *keys[] = {"time_step", "arrays", "extent", "bounds", "a",
+        "zz", "index_request_key"};
+    for (int i = 0; i < 7; ++i)
+        a.insert(keys[i], i);
+
+    CHECK(!a.empty())
+    for (int i = 0; i < 7; ++i)
+    {
+        int val = -1;
+        CHECK(a.has(keys[i]))
+        CHECK(a.get(keys[i], val) == 0)
+        CHECK(val == i)
+    }
+    CHECK(!a.has("b"))
+
+    std::ostringstream oss;
+    a.to_stream(oss);
+    CHECK(oss.str() == "a = {4}\narrays = {1}\nbounds = {3}\nextent = {2}\n"
+        "index_request_key = {6}\ntime_step = {0}\nzz = {5}\n")
+
+    // replacing
+    a.insert("extent", std::vector<unsigned long>({0, 1, 2, 3, 4, 5}));
+    unsigned int n = 0;
+    CHECK(a.size("extent", n) == 0)
+    CHECK(n == 6)
+
+    // removing
+    CHECK(a.remove("a") == 0)
+    CHECK(a.remove("a") != 0)
+    CHECK(!a.has("a"))
+    CHECK(a.has("arrays"))
+
+    // serialization
+    teca_binary_stream bs;
+    a.to_stream(bs);
+    teca_metadata b;
+    b.from_stream(bs);
+    CHECK(a == b)
+    CHECK(a.get_digest() == b.get_digest())
+
+    // intersection
+    teca_metadata c;
+    c.insert("zz", 5);
+    c.insert("arrays", 2);
+    c.insert("other", 1);
+    teca_metadata d = a & c;
+    CHECK(d.has("zz"))
+    CHECK(!d.has("arrays"))
+    CHECK(!d.has("other"))
+
+    // moves and clears
+    teca_metadata e(std::move(b));
+    CHECK(e == a)
+    e.clear();
+    CHECK(e.empty())
+    CHECK(e.get_digest() == teca_metadata().get_digest())
+
+    return 0;
+}
+
+// time the operations the executives perform for each request.
+// returns the time in nanoseconds per operation
+int time_operations(long n_its)
+{
+    teca_metadata base = make_base_request();
+    unsigned long extent[6] = {0, 1439, 0, 719, 0, 0};
+    std::vector<std::string> arrays({"U850", "V850"});
+
+    // copy
+    auto t0 = hr_clock_t::now();
+    unsigned long n = 0;
+    for (long i = 0; i < n_its; ++i)
+    {
+        teca_metadata req(base);
+        n += req.empty() ? 0 : 1;
+    }
+    auto t1 = hr_clock_t::now();
+
+    // copy and insert the request keys
+    for (long i = 0; i < n_its; ++i)
+    {
+        teca_metadata req(base);
+        req.insert("time_step", (unsigned long)i);
+        req.insert("extent", extent, 6);
+        req.insert("arrays", arrays);
+        n += req.empty() ? 0 : 1;
+    }
+    auto t2 = hr_clock_t::now();
+
+    // get the request keys
+    teca_metadata req(base);
+    req.insert("time_step", 0ul);
+    req.insert("extent", extent, 6);
+    req.insert("arrays", arrays);
+    unsigned long sum = 0;
+    for (long i = 0; i < n_its; ++i)
+    {
+        unsigned long step = 0;
+        unsigned long ext[6] = {0};
+        std::string key;
+        req.get("time_step", step);
+        req.get("extent", ext, 6);
+        req.get("index_request_key", key);
+        sum += step + ext[1] + key.size();
+    }
+    auto t3 = hr_clock_t::now();
+
+    if (n + sum == 0)
+        std::cerr << n << sum << std::endl;
+
+    std::cerr << "request of 10 keys, ns per operation" << std::endl
+        << "    copy " << std::chrono::duration<double, std::nano>(t1 - t0).count()/n_its
+        << std::endl << "    copy and insert 3 "
+        << std::chrono::duration<double, std::nano>(t2 - t1).count()/n_its
+        << std::endl << "    get 3 "
+        << std::chrono::duration<double, std::nano>(t3 - t2).count()/n_its
+        << std::endl;
+
+    return 0;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    long n_its = argc > 1 ? atol(argv[1]) : 100000;
+
+    if (test_copy_on_write() || test_container() || time_operations(n_its))
+        return -1;
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_threaded_algorithm.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(index_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(fan_in_sum)
+
+// a source that produces an array holding the requested index.
+// each execution takes a moment so that requests overlap.
+class index_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(index_source)
+
+protected:
+    index_source()
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    { return teca_metadata(); }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        unsigned long index = 0;
+        request.get("index", index);
+
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+        p_array out = array::New();
+        out->append(index);
+        return out;
+    }
+};
+
+// a threaded stage that requests fan upstream indices for each
+// index requested of it and sums the results
+class fan_in_sum : public teca_threaded_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(fan_in_sum)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, fan)
+
+    double get_result()
+    {
+        std::lock_guard<std::mutex> lock(this->result_mutex);
+        return this->result;
+    }
+
+protected:
+    fan_in_sum() : fan(4), result(0.0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    std::vector<teca_metadata> get_upstream_request(unsigned int,
+        const std::vector<teca_metadata> &,
+        const teca_metadata &request) override
+    {
+        unsigned long index = 0;
+        request.get("index", index);
+
+        std::vector<teca_metadata> up_reqs(this->fan);
+        for (unsigned long i = 0; i < this->fan; ++i)
+            up_reqs[i].insert("index", index*this->fan + i);
+
+        return up_reqs;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        double sum = 0.0;
+        size_t n_in = input_data.size();
+        for (size_t i = 0; i < n_in; ++i)
+        {
+            const_p_array in = std::dynamic_pointer_cast<const array>(input_data[i]);
+            if (!in || in->empty())
+            {
+                TECA_ERROR("input " << i << " is invalid")
+                return nullptr;
+            }
+            sum += in->get(0);
+        }
+
+        p_array out = array::New();
+        out->append(sum);
+
+        std::lock_guard<std::mutex> lock(this->result_mutex);
+        this->result = sum;
+
+        return out;
+    }
+
+private:
+    unsigned long fan;
+    std::mutex result_mutex;
+    double result;
+};
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 3))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> fan in per stage" << std::endl
+            << "arg 2 -> n repetitions" << std::endl)
+        return -1;
+    }
+
+    unsigned long fan = 4;
+    int n_reps = 4;
+
+    if (argc == 3)
+    {
+        fan = atoi(argv[1]);
+        n_reps = atoi(argv[2]);
+    }
+
+    fan = std::max(fan, 1ul);
+    n_reps = std::max(n_reps, 1);
+
+    // the top stage sums all of the indices produced by the source
+    unsigned long n_leaves = fan*fan*fan;
+    double expected = n_leaves*(n_leaves - 1)/2;
+
+    // concurrency limits for each of the three stages. -1 uses all
+    // threads in the shared pool. a limit of 1 on the inner stages
+    // is the case most prone to stalling.
+    int limits[][3] = {{1, 1, 1}, {2, 1, 3}, {1, 3, 1}, {-1, -1, -1}};
+
+    // limits on the requests and bytes in flight for each of the
+    // three stages. -1 is unlimited. a budget smaller than a single
+    // dataset must still make progress.
+    long in_flight[][3] = {{-1, -1, -1}, {1, 1, 1}, {2, -1, 1}};
+    long budget[][3] = {{-1, -1, -1}, {1, 1, 1}, {-1, 64, -1}};
+
+    for (int rep = 0; rep < n_reps; ++rep)
+    {
+        for (int lim = 0; lim < 3; ++lim)
+        {
+            for (auto &limit : limits)
+            {
+                // index_source --> fan_in_sum --> fan_in_sum --> fan_in_sum
+                p_index_source src = index_source::New();
+
+                p_fan_in_sum s0 = fan_in_sum::New();
+                s0->set_fan(fan);
+                s0->set_thread_pool_size(limit[0]);
+                s0->set_max_in_flight(in_flight[lim][0]);
+                s0->set_memory_budget(budget[lim][0]);
+                s0->set_input_connection(src->get_output_port());
+
+                p_fan_in_sum s1 = fan_in_sum::New();
+                s1->set_fan(fan);
+                s1->set_thread_pool_size(limit[1]);
+                s1->set_max_in_flight(in_flight[lim][1]);
+                s1->set_memory_budget(budget[lim][1]);
+                s1->set_input_connection(s0->get_output_port());
+
+                p_fan_in_sum s2 = fan_in_sum::New();
+                s2->set_fan(fan);
+                s2->set_thread_pool_size(limit[2]);
+                s2->set_max_in_flight(in_flight[lim][2]);
+                s2->set_memory_budget(budget[lim][2]);
+                s2->set_input_connection(s1->get_output_port());
+
+                auto t0 = std::chrono::high_resolution_clock::now();
+                s2->update();
+                auto t1 = std::chrono::high_resolution_clock::now();
+
+                double result = s2->get_result();
+
+                std::cerr << "limits " << limit[0] << ", " << limit[1] << ", "
+                    << limit[2] << " in flight " << in_flight[lim][0] << ", "
+                    << in_flight[lim][1] << ", " << in_flight[lim][2] << " budget "
+                    << budget[lim][0] << ", " << budget[lim][1] << ", "
+                    << budget[lim][2] << " result " << result << " in "
+                    << std::chrono::duration<double, std::milli>(t1 - t0).count()
+                    << " ms" << std::endl;
+
+                if (result != expected)
+                {
+                    TECA_ERROR("result " << result << " != " << expected)
+                    return -1;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
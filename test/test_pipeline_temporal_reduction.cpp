@@ -20,27 +20,32 @@ int main(int argc, char **argv)
 
     teca_system_interface::set_stack_trace_on_error();
 
-    if ((rank == 0) && (argc != 1) && (argc != 4))
+    if ((rank == 0) && (argc != 1) && (argc != 4) && (argc != 5))
     {
         TECA_ERROR(
             << "invalid command line arguments. arguments are:" << endl
             << "arg 1 -> n timesteps" << endl
             << "arg 2 -> array size" << endl
-            << "arg 3 -> n threads" << endl)
+            << "arg 3 -> n threads" << endl
+            << "arg 4 -> dynamic schedule (optional)" << endl)
         exit(-1);
     }
 
     int n_timesteps = 16;
     int array_size = 5;
     int n_threads = 2;
+    int dynamic_schedule = 0;
 
-    if (argc == 4)
+    if (argc >= 4)
     {
         n_timesteps = atoi(argv[1]);
         array_size = atoi(argv[2]);
         n_threads = atoi(argv[3]);
     }
 
+    if (argc == 5)
+        dynamic_schedule = atoi(argv[4]);
+
     n_timesteps = max(n_timesteps, 1);
     n_threads = max(n_threads, 1);
     array_size = max(array_size, 1);
@@ -67,6 +72,7 @@ int main(int argc, char **argv)
     stats->set_verbose(1);
     stats->set_thread_pool_size(n_threads);
     stats->set_array_name("array_1");
+    stats->set_dynamic_schedule(dynamic_schedule);
 
     p_array_writer wri = array_writer::New();
 
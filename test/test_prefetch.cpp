@@ -0,0 +1,262 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_prefetch.h"
+#include "teca_time_step_executive.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(slow_reader)
+TECA_SHARED_OBJECT_FORWARD_DECL(slow_writer)
+
+// a source that takes a moment to produce an array holding
+// the requested time step, as a reader would. reading the
+// failing time step throws
+class slow_reader : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(slow_reader)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_time_steps)
+    TECA_ALGORITHM_PROPERTY(unsigned long, array_size)
+    TECA_ALGORITHM_PROPERTY(int, delay)
+    TECA_ALGORITHM_PROPERTY(long, failing_time_step)
+
+    unsigned long get_number_of_executions() const { return this->n_exec; }
+
+protected:
+    slow_reader() : number_of_time_steps(1), array_size(1), delay(0),
+        failing_time_step(-1), n_exec(0)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    {
+        teca_metadata md;
+        md.insert("number_of_time_steps", this->number_of_time_steps);
+        return md;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        ++this->n_exec;
+
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->delay));
+
+        if (static_cast<long>(step) == this->failing_time_step)
+            throw std::runtime_error("failed to read the time step");
+
+        p_array out = array::New();
+        out->resize(this->array_size);
+        out->get(0) = step;
+        return out;
+    }
+
+private:
+    unsigned long number_of_time_steps;
+    unsigned long array_size;
+    int delay;
+    long failing_time_step;
+    std::atomic<unsigned long> n_exec;
+};
+
+// a consumer that takes a moment to process each time step, as
+// a writer would, and verifies that it was given the requested
+// time step
+class slow_writer : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(slow_writer)
+
+    TECA_ALGORITHM_PROPERTY(int, delay)
+
+    unsigned long get_number_of_errors() const { return this->n_errors; }
+
+protected:
+    slow_writer() : delay(0), n_errors(0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override
+    {
+        unsigned long step = 0;
+        request.get("time_step", step);
+
+        const_p_array in = std::dynamic_pointer_cast<const array>(input_data[0]);
+        if (!in || in->empty() || (in->get(0) != step))
+        {
+            TECA_ERROR("time step " << step << " is invalid")
+            ++this->n_errors;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->delay));
+
+        return nullptr;
+    }
+
+private:
+    int delay;
+    unsigned long n_errors;
+};
+
+// run reader --> prefetch --> writer over the time steps.
+// returns the run time in ms, or a negative value on error.
+double run(unsigned long n_steps, long stride, int delay, int depth,
+    long budget, unsigned long &n_exec, unsigned long &n_hits,
+    unsigned long &n_misses, long failing_step = -1)
+{
+    unsigned long n = 1024;
+
+    p_slow_reader rdr = slow_reader::New();
+    rdr->set_number_of_time_steps(n_steps);
+    rdr->set_array_size(n);
+    rdr->set_delay(delay);
+    rdr->set_failing_time_step(failing_step);
+    rdr->set_cache_size(0);
+
+    p_teca_prefetch pf = teca_prefetch::New();
+    pf->set_prefetch_depth(depth);
+    pf->set_memory_budget(budget);
+    pf->set_input_connection(rdr->get_output_port());
+
+    p_slow_writer wri = slow_writer::New();
+    wri->set_delay(delay);
+    wri->set_cache_size(0);
+    wri->set_input_connection(pf->get_output_port());
+
+    p_teca_time_step_executive exec = teca_time_step_executive::New();
+    exec->set_stride(stride);
+    wri->set_executive(exec);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    wri->update();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    double dt = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    n_exec = rdr->get_number_of_executions();
+    n_hits = pf->get_number_of_prefetch_hits();
+    n_misses = pf->get_number_of_prefetch_misses();
+
+    std::cerr << "prefetch depth " << depth << " budget " << budget
+        << " stride " << stride << " " << n_exec << " reads "
+        << n_hits << " hits " << n_misses << " misses in " << dt
+        << " ms" << std::endl;
+
+    if (wri->get_number_of_errors())
+        return -1.0;
+
+    return dt;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 3))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> n time steps" << std::endl
+            << "arg 2 -> delay in ms" << std::endl)
+        return -1;
+    }
+
+    unsigned long n_steps = 32;
+    int delay = 5;
+
+    if (argc == 3)
+    {
+        n_steps = atol(argv[1]);
+        delay = atoi(argv[2]);
+    }
+
+    n_steps = std::max(n_steps, 8ul);
+    delay = std::max(delay, 1);
+
+    long n_bytes = 1024*sizeof(double);
+    unsigned long n_exec = 0;
+    unsigned long n_hits = 0;
+    unsigned long n_misses = 0;
+
+    // read ahead disabled
+    double t_serial = run(n_steps, 1, delay, 0, -1, n_exec, n_hits, n_misses);
+    CHECK(t_serial >= 0.0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    // once the stride is known each time step is read ahead and
+    // reads overlap processing. the time step executive walks
+    // backward. no time step past the end is read. a read ahead
+    // that has not started when its time step is requested is done
+    // in place and counts as a miss, thus the number of hits depends
+    // on how the threads are scheduled.
+    double t_prefetch = run(n_steps, 1, delay, 2, -1, n_exec, n_hits, n_misses);
+    CHECK(t_prefetch >= 0.0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits + n_misses == n_steps)
+    CHECK((n_hits > 0) && (n_hits <= n_steps - 2))
+
+    // the times depend on the load on the machine, they are reported
+    // but not checked
+    std::cerr << "serial " << t_serial << " ms prefetch " << t_prefetch
+        << " ms" << std::endl;
+
+    // a budget of one time step allows one read ahead
+    CHECK(run(n_steps, 1, delay, 4, n_bytes, n_exec, n_hits, n_misses) >= 0.0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits + n_misses == n_steps)
+    CHECK((n_hits > 0) && (n_hits <= n_steps - 2))
+
+    // a budget smaller than a time step prevents read ahead
+    CHECK(run(n_steps, 1, delay, 4, n_bytes/2, n_exec, n_hits, n_misses) >= 0.0)
+    CHECK(n_exec == n_steps)
+    CHECK(n_hits == 0)
+
+    // strided time steps
+    unsigned long n_strided = (n_steps + 2)/3;
+    CHECK(run(n_steps, 3, delay, 2, -1, n_exec, n_hits, n_misses) >= 0.0)
+    CHECK(n_exec == n_strided)
+    CHECK(n_hits + n_misses == n_strided)
+    CHECK((n_hits > 0) && (n_hits <= n_strided - 2))
+
+    // a failed read reaches the caller whether it was read ahead or not
+    bool caught = false;
+    try
+    {
+        run(n_steps, 1, delay, 2, -1, n_exec, n_hits, n_misses, n_steps/2);
+    }
+    catch (const std::runtime_error &)
+    {
+        caught = true;
+    }
+    CHECK(caught)
+
+    return 0;
+}
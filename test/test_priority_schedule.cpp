@@ -0,0 +1,180 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_algorithm.h"
+#include "teca_thread_pool.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_table.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+#include "table_source.h"
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+using task_t = std::packaged_task<int()>;
+using pool_t = teca_thread_pool<task_t, int>;
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+// a skewed workload, many short tasks followed by a few long ones.
+// the tasks sleep so the measurement doesn't depend on the number
+// of cores. returns the makespan, and the latency of the slowest
+// 1% of tasks, in milliseconds.
+int run_skewed(pool_t &pool, bool prioritize, int n_short, int n_long,
+    double &makespan, double &p99)
+{
+    auto t0 = hr_clock_t::now();
+
+    std::vector<double> latency(n_short + n_long);
+    std::vector<std::future<int>> futures;
+
+    for (int i = 0; i < n_short + n_long; ++i)
+    {
+        bool is_long = i >= n_short;
+        int ms = is_long ? 64 : 2;
+
+        task_t task([&latency, t0, ms, i]() -> int
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            latency[i] = std::chrono::duration<double, std::milli>(
+                hr_clock_t::now() - t0).count();
+            return 1;
+        });
+
+        // a long task holds up the batch, give it a priority as
+        // the critical path length would
+        futures.push_back(pool.push_task(task,
+            (prioritize && is_long) ? ms : 0));
+    }
+
+    std::vector<int> data;
+    pool.wait_data(futures, data);
+
+    makespan = std::chrono::duration<double, std::milli>(
+        hr_clock_t::now() - t0).count();
+
+    std::sort(latency.begin(), latency.end());
+    p99 = latency[(99*latency.size())/100];
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    int n_threads = argc > 1 ? atoi(argv[1]) : 4;
+    int n_short = argc > 2 ? atoi(argv[2]) : 96;
+    int n_long = argc > 3 ? atoi(argv[3]) : 2;
+
+    n_threads = std::max(n_threads, 2);
+    n_long = std::max(1, std::min(n_long, n_threads - 1));
+
+    // tasks are executed by priority, then in the order pushed
+    {
+    pool_t pool(MPI_COMM_SELF, 1, true, false, false);
+
+    // hold the thread until all of the tasks are queued
+    std::promise<void> go;
+    std::shared_future<void> ready = go.get_future().share();
+
+    std::vector<std::future<int>> futures;
+    task_t hold([ready]() -> int { ready.wait(); return -1; });
+    futures.push_back(pool.push_task(hold));
+
+    std::mutex order_mutex;
+    std::vector<int> order;
+
+    long priority[] = {0, -2, 3, 0, 7, -1, 3, 0, -2};
+    int n_tasks = sizeof(priority)/sizeof(long);
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        task_t task([&order, &order_mutex, i]() -> int
+        {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(i);
+            return i;
+        });
+        futures.push_back(pool.push_task(task, priority[i]));
+    }
+
+    // wait for the thread to pick up the held task
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    go.set_value();
+
+    // the calling thread would execute tasks in wait_data, wait
+    // without helping so that the order is that of the pool
+    for (auto &f : futures)
+        f.get();
+
+    std::vector<int> expected = {4, 2, 6, 0, 3, 7, 5, 1, 8};
+    CHECK(order == expected)
+    }
+
+    // a reduction issues the requests of its most important time
+    // steps first. with one request running at a time, the first
+    // request starts right away, the others are held and executed
+    // in order of decreasing priority
+    {
+    unsigned long n_steps = 16;
+
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+    src->set_report_priority(1);
+
+    p_teca_table_reduce red = teca_table_reduce::New();
+    red->set_thread_pool_size(1);
+    red->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(red->get_output_port());
+
+    CHECK(cap->update() == 0)
+
+    const_p_teca_table table =
+        std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+    CHECK(table && (table->get_number_of_rows() == n_steps))
+
+    std::vector<unsigned long> order = src->get_steps();
+    CHECK(order.size() == n_steps)
+    order.erase(std::find(order.begin(), order.end(), 0));
+    CHECK(std::is_sorted(order.begin(), order.end(),
+        std::greater<unsigned long>()))
+    }
+
+    // tail latency on the skewed workload
+    double makespan_fifo = 0.0;
+    double p99_fifo = 0.0;
+    double makespan_prio = 0.0;
+    double p99_prio = 0.0;
+    {
+    pool_t pool(MPI_COMM_SELF, n_threads, true, false, false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    CHECK(run_skewed(pool, false, n_short, n_long, makespan_fifo, p99_fifo) == 0)
+    CHECK(run_skewed(pool, true, n_short, n_long, makespan_prio, p99_prio) == 0)
+    }
+
+    // starting the long tasks first lets the short ones fill in
+    // around them, rather than leaving the long ones to the end. the
+    // times depend on the load on the machine, they are reported but
+    // not checked
+    std::cerr << "skewed workload " << n_short << " short " << n_long
+        << " long tasks on " << n_threads << " threads" << std::endl
+        << "    fifo      makespan " << makespan_fifo << " ms p99 "
+        << p99_fifo << " ms" << std::endl
+        << "    priority  makespan " << makespan_prio << " ms p99 "
+        << p99_prio << " ms" << std::endl;
+
+    return 0;
+}
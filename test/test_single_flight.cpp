@@ -0,0 +1,294 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_threaded_algorithm.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "array.h"
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(slow_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(window_sum)
+TECA_SHARED_OBJECT_FORWARD_DECL(total_sum)
+
+// a source that produces an array holding the requested index.
+// each execution takes a moment so that requests overlap. the
+// number of executions is counted.
+class slow_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(slow_source)
+
+    unsigned long get_number_of_executions() const { return this->n_exec; }
+
+protected:
+    slow_source() : n_exec(0)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    { return teca_metadata(); }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        ++this->n_exec;
+
+        unsigned long index = 0;
+        request.get("index", index);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+        p_array out = array::New();
+        out->append(index);
+        return out;
+    }
+
+private:
+    std::atomic<unsigned long> n_exec;
+};
+
+// sums the upstream indices in a window centered on the requested
+// index, as a running average over time would. the windows of
+// neighboring indices overlap.
+class window_sum : public teca_threaded_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(window_sum)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, half_width)
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_indices)
+
+protected:
+    window_sum() : half_width(1), number_of_indices(1)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    std::vector<teca_metadata> get_upstream_request(unsigned int,
+        const std::vector<teca_metadata> &,
+        const teca_metadata &request) override
+    {
+        unsigned long index = 0;
+        request.get("index", index);
+
+        unsigned long i0 = index > this->half_width ? index - this->half_width : 0;
+        unsigned long i1 = std::min(index + this->half_width,
+            this->number_of_indices - 1);
+
+        std::vector<teca_metadata> up_reqs;
+        for (unsigned long i = i0; i <= i1; ++i)
+        {
+            teca_metadata req;
+            req.insert("index", i);
+            up_reqs.push_back(req);
+        }
+
+        return up_reqs;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        double sum = 0.0;
+        size_t n_in = input_data.size();
+        for (size_t i = 0; i < n_in; ++i)
+        {
+            const_p_array in = std::dynamic_pointer_cast<const array>(input_data[i]);
+            if (!in || in->empty())
+            {
+                TECA_ERROR("input " << i << " is invalid")
+                return nullptr;
+            }
+            sum += in->get(0);
+        }
+
+        p_array out = array::New();
+        out->append(sum);
+        return out;
+    }
+
+private:
+    unsigned long half_width;
+    unsigned long number_of_indices;
+};
+
+// requests all of the indices and sums the results
+class total_sum : public teca_threaded_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(total_sum)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_indices)
+
+    double get_result() const { return this->result; }
+
+protected:
+    total_sum() : number_of_indices(1), result(0.0)
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    std::vector<teca_metadata> get_upstream_request(unsigned int,
+        const std::vector<teca_metadata> &,
+        const teca_metadata &) override
+    {
+        std::vector<teca_metadata> up_reqs(this->number_of_indices);
+        for (unsigned long i = 0; i < this->number_of_indices; ++i)
+            up_reqs[i].insert("index", i);
+        return up_reqs;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        double sum = 0.0;
+        for (const const_p_teca_dataset &ds : input_data)
+        {
+            const_p_array in = std::dynamic_pointer_cast<const array>(ds);
+            if (!in || in->empty())
+            {
+                TECA_ERROR("invalid input")
+                return nullptr;
+            }
+            sum += in->get(0);
+        }
+
+        this->result = sum;
+
+        p_array out = array::New();
+        out->append(sum);
+        return out;
+    }
+
+private:
+    unsigned long number_of_indices;
+    double result;
+};
+
+// run the pipeline. returns non-zero if the result is incorrect
+// or the requests are not accounted for.
+int run(unsigned long n, unsigned long hw, int n_threads, int dedup)
+{
+    // slow_source --> window_sum --> total_sum
+    p_slow_source src = slow_source::New();
+    src->set_cache_size(0);
+
+    p_window_sum win = window_sum::New();
+    win->set_half_width(hw);
+    win->set_number_of_indices(n);
+    win->set_thread_pool_size(n_threads);
+    win->set_deduplicate_requests(dedup);
+    win->set_input_connection(src->get_output_port());
+
+    p_total_sum tot = total_sum::New();
+    tot->set_number_of_indices(n);
+    tot->set_thread_pool_size(n_threads);
+    tot->set_deduplicate_requests(dedup);
+    tot->set_input_connection(win->get_output_port());
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    tot->update();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    // each index contributes once for each window that includes it
+    double expected = 0.0;
+    unsigned long n_reqs = 0;
+    for (unsigned long i = 0; i < n; ++i)
+    {
+        unsigned long i0 = i > hw ? i - hw : 0;
+        unsigned long i1 = std::min(i + hw, n - 1);
+        for (unsigned long j = i0; j <= i1; ++j)
+        {
+            expected += j;
+            ++n_reqs;
+        }
+    }
+
+    unsigned long n_exec = src->get_number_of_executions();
+    unsigned long n_dedup = win->get_number_of_deduplicated_requests();
+    unsigned long n_dup = win->get_number_of_duplicated_requests();
+
+    std::cerr << "deduplication " << (dedup ? "on " : "off") << " "
+        << n_reqs << " requests " << n_exec << " executions "
+        << n_dedup << " deduplicated " << n_dup << " duplicated in "
+        << std::chrono::duration<double, std::milli>(t1 - t0).count()
+        << " ms" << std::endl;
+
+    if (tot->get_result() != expected)
+    {
+        TECA_ERROR("result " << tot->get_result() << " != " << expected)
+        return -1;
+    }
+
+    // each request to the source either executed or waited on
+    // one that did
+    if (n_exec + n_dedup != n_reqs)
+    {
+        TECA_ERROR(<< n_exec << " executions and " << n_dedup
+            << " deduplicated requests != " << n_reqs << " requests")
+        return -1;
+    }
+
+    if (!dedup && (n_dedup || n_dup))
+    {
+        TECA_ERROR("requests were deduplicated when disabled")
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 4))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> n indices" << std::endl
+            << "arg 2 -> window half width" << std::endl
+            << "arg 3 -> n threads" << std::endl)
+        return -1;
+    }
+
+    unsigned long n = 64;
+    unsigned long hw = 2;
+    int n_threads = 4;
+
+    if (argc == 4)
+    {
+        n = atol(argv[1]);
+        hw = atol(argv[2]);
+        n_threads = atoi(argv[3]);
+    }
+
+    n = std::max(n, 1ul);
+    n_threads = std::max(n_threads, 1);
+
+    if (run(n, hw, n_threads, 0) || run(n, hw, n_threads, 1))
+        return -1;
+
+    return 0;
+}
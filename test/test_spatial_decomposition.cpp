@@ -0,0 +1,559 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_spatial_executive.h"
+#include "teca_spatial_reduce.h"
+#include "teca_cartesian_mesh.h"
+#include "teca_table.h"
+#include "teca_array_collection.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <cstdlib>
+
+#if defined(TECA_HAS_MPI)
+#include <mpi.h>
+#endif
+
+TECA_SHARED_OBJECT_FORWARD_DECL(grid_source)
+TECA_SHARED_OBJECT_FORWARD_DECL(box_sum)
+TECA_SHARED_OBJECT_FORWARD_DECL(tile_points)
+TECA_SHARED_OBJECT_FORWARD_DECL(collect)
+
+// the value of the source field at a point
+double f(unsigned long i, unsigned long j, unsigned long t)
+{
+    return i + 1000.0*j + 1000000.0*t;
+}
+
+// the sum of the source field over the 3x3 box centered on the
+// point, clamped to the extent.
+double g(const unsigned long *ext, unsigned long i, unsigned long j,
+    unsigned long t)
+{
+    unsigned long i0 = i > ext[0] ? i - 1 : i;
+    unsigned long i1 = i < ext[1] ? i + 1 : i;
+    unsigned long j0 = j > ext[2] ? j - 1 : j;
+    unsigned long j1 = j < ext[3] ? j + 1 : j;
+
+    double sum = 0.0;
+    for (unsigned long jj = j0; jj <= j1; ++jj)
+        for (unsigned long ii = i0; ii <= i1; ++ii)
+            sum += f(ii, jj, t);
+
+    return sum;
+}
+
+// true for points reported by tile_points
+bool selected(double val)
+{
+    return static_cast<unsigned long>(val) % 3 == 0;
+}
+
+// a source that generates the requested extent of an n_x by n_y
+// mesh with the field f
+class grid_source : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(grid_source)
+
+    TECA_ALGORITHM_PROPERTY(unsigned long, nx)
+    TECA_ALGORITHM_PROPERTY(unsigned long, ny)
+    TECA_ALGORITHM_PROPERTY(unsigned long, number_of_time_steps)
+
+protected:
+    grid_source() : nx(1), ny(1), number_of_time_steps(1)
+    {
+        this->set_number_of_input_connections(0);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    teca_metadata get_output_metadata(unsigned int,
+        const std::vector<teca_metadata> &) override
+    {
+        teca_metadata md;
+        md.insert("whole_extent", std::vector<unsigned long>(
+            {0, this->nx - 1, 0, this->ny - 1, 0, 0}));
+        md.insert("number_of_time_steps", this->number_of_time_steps);
+        return md;
+    }
+
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &,
+        const teca_metadata &request) override
+    {
+        std::vector<unsigned long> whole_ext(
+            {0, this->nx - 1, 0, this->ny - 1, 0, 0});
+
+        std::vector<unsigned long> ext;
+        if (request.get("extent", ext))
+            ext = whole_ext;
+
+        unsigned long t = 0;
+        request.get("time_step", t);
+
+        unsigned long n_x = ext[1] - ext[0] + 1;
+        unsigned long n_y = ext[3] - ext[2] + 1;
+
+        p_teca_double_array x = teca_double_array::New(n_x);
+        for (unsigned long i = 0; i < n_x; ++i)
+            x->set(i, ext[0] + i);
+
+        p_teca_double_array y = teca_double_array::New(n_y);
+        for (unsigned long j = 0; j < n_y; ++j)
+            y->set(j, ext[2] + j);
+
+        p_teca_double_array z = teca_double_array::New(1);
+        z->set(0, 0.0);
+
+        p_teca_double_array fa = teca_double_array::New(n_x*n_y);
+        double *pf = fa->get();
+        for (unsigned long j = 0; j < n_y; ++j)
+            for (unsigned long i = 0; i < n_x; ++i)
+                pf[j*n_x + i] = f(ext[0] + i, ext[2] + j, t);
+
+        p_teca_cartesian_mesh mesh = teca_cartesian_mesh::New();
+        mesh->set_x_coordinates(x);
+        mesh->set_y_coordinates(y);
+        mesh->set_z_coordinates(z);
+        mesh->set_whole_extent(whole_ext);
+        mesh->set_extent(ext);
+        mesh->set_time_step(t);
+        mesh->get_point_arrays()->append("f", fa);
+
+        return mesh;
+    }
+
+private:
+    unsigned long nx;
+    unsigned long ny;
+    unsigned long number_of_time_steps;
+};
+
+// a 3x3 box sum of f. at the edges of the extent the box is
+// clamped, as a stencil with one sided differences would be.
+class box_sum : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(box_sum)
+
+protected:
+    box_sum()
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &) override
+    {
+        const_p_teca_cartesian_mesh in_mesh
+            = std::dynamic_pointer_cast<const teca_cartesian_mesh>(input_data[0]);
+
+        const_p_teca_double_array fa;
+        if (!in_mesh || !(fa = std::dynamic_pointer_cast<const teca_double_array>(
+            in_mesh->get_point_arrays()->get("f"))))
+        {
+            TECA_ERROR("invalid input")
+            return nullptr;
+        }
+
+        unsigned long ext[6];
+        in_mesh->get_extent(ext);
+
+        unsigned long n_x = ext[1] - ext[0] + 1;
+        unsigned long n_y = ext[3] - ext[2] + 1;
+
+        const double *pf = fa->get();
+
+        p_teca_double_array ga = teca_double_array::New(n_x*n_y);
+        double *pg = ga->get();
+
+        for (unsigned long j = 0; j < n_y; ++j)
+        {
+            unsigned long j0 = j > 0 ? j - 1 : j;
+            unsigned long j1 = j < n_y - 1 ? j + 1 : j;
+            for (unsigned long i = 0; i < n_x; ++i)
+            {
+                unsigned long i0 = i > 0 ? i - 1 : i;
+                unsigned long i1 = i < n_x - 1 ? i + 1 : i;
+
+                double sum = 0.0;
+                for (unsigned long jj = j0; jj <= j1; ++jj)
+                    for (unsigned long ii = i0; ii <= i1; ++ii)
+                        sum += pf[jj*n_x + ii];
+
+                pg[j*n_x + i] = sum;
+            }
+        }
+
+        p_teca_cartesian_mesh out_mesh = teca_cartesian_mesh::New();
+        out_mesh->shallow_copy(
+            std::const_pointer_cast<teca_cartesian_mesh>(in_mesh));
+        out_mesh->get_point_arrays()->append("g", ga);
+
+        return out_mesh;
+    }
+};
+
+// reports the points of the tile where g is selected. points
+// in the halo are not reported.
+class tile_points : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(tile_points)
+
+protected:
+    tile_points()
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override
+    {
+        const_p_teca_cartesian_mesh in_mesh
+            = std::dynamic_pointer_cast<const teca_cartesian_mesh>(input_data[0]);
+
+        const_p_teca_double_array ga;
+        if (!in_mesh || !(ga = std::dynamic_pointer_cast<const teca_double_array>(
+            in_mesh->get_point_arrays()->get("g"))))
+        {
+            TECA_ERROR("invalid input")
+            return nullptr;
+        }
+
+        unsigned long ext[6];
+        in_mesh->get_extent(ext);
+
+        std::vector<unsigned long> tile;
+        if (request.get("tile_extent", tile))
+            tile.assign(ext, ext + 6);
+
+        unsigned long n_x = ext[1] - ext[0] + 1;
+        const double *pg = ga->get();
+
+        p_teca_table table = teca_table::New();
+        table->declare_columns("i", 0ul, "j", 0ul, "g", 0.0);
+
+        for (unsigned long j = tile[2]; j <= tile[3]; ++j)
+        {
+            for (unsigned long i = tile[0]; i <= tile[1]; ++i)
+            {
+                double val = pg[(j - ext[2])*n_x + i - ext[0]];
+                if (selected(val))
+                    table << i << j << val;
+            }
+        }
+
+        return table;
+    }
+};
+
+// keeps the datasets and requests it is given
+class collect : public teca_algorithm
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(collect)
+
+    std::vector<const_p_teca_dataset> datasets;
+    std::vector<teca_metadata> requests;
+
+protected:
+    collect()
+    {
+        this->set_number_of_input_connections(1);
+        this->set_number_of_output_ports(1);
+    }
+
+private:
+    const_p_teca_dataset execute(unsigned int,
+        const std::vector<const_p_teca_dataset> &input_data,
+        const teca_metadata &request) override
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->datasets.push_back(input_data[0]);
+        this->requests.push_back(request);
+        return input_data[0];
+    }
+
+private:
+    std::mutex mutex;
+};
+
+// sum a count over MPI ranks
+unsigned long sum_over_ranks(unsigned long n)
+{
+#if defined(TECA_HAS_MPI)
+    int is_init = 0;
+    MPI_Initialized(&is_init);
+    if (is_init)
+    {
+        unsigned long tot = 0;
+        MPI_Allreduce(&n, &tot, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+        return tot;
+    }
+#endif
+    return n;
+}
+
+// verify that the tiles cover the extent without overlap
+int test_partition()
+{
+    unsigned long ext[6] = {3, 40, 2, 17, 0, 0};
+
+    for (unsigned long n_i = 1; n_i < 5; ++n_i)
+    {
+        for (unsigned long n_j = 1; n_j < 20; ++n_j)
+        {
+            std::vector<std::vector<unsigned long>> tiles;
+            teca_spatial_executive::partition(ext, n_i, n_j, tiles);
+
+            CHECK(tiles.size() == n_i*std::min(n_j, 16ul))
+
+            std::vector<int> hits(38*16, 0);
+            for (size_t q = 0; q < tiles.size(); ++q)
+            {
+                const std::vector<unsigned long> &t = tiles[q];
+                CHECK((t[0] <= t[1]) && (t[2] <= t[3]))
+                for (unsigned long j = t[2]; j <= t[3]; ++j)
+                    for (unsigned long i = t[0]; i <= t[1]; ++i)
+                        ++hits[(j - ext[2])*38 + i - ext[0]];
+            }
+
+            for (size_t q = 0; q < hits.size(); ++q)
+                CHECK(hits[q] == 1)
+        }
+    }
+
+    // the halo is clamped to the whole extent
+    unsigned long tile[6] = {3, 10, 15, 17, 0, 0};
+    unsigned long out[6] = {0};
+    teca_spatial_executive::add_halo(tile, 2, ext, out);
+    CHECK((out[0] == 3) && (out[1] == 12) && (out[2] == 13) && (out[3] == 17))
+
+    return 0;
+}
+
+// split each time step into tiles across MPI ranks with the
+// executive and into tiles across threads with the reduction.
+// the reassembled result must match the result computed on the
+// whole extent. returns the number of points that don't match.
+long test_mesh(unsigned long nx, unsigned long ny, unsigned long nt,
+    unsigned long n_i_tiles, unsigned long halo, int n_threads)
+{
+    p_grid_source src = grid_source::New();
+    src->set_nx(nx);
+    src->set_ny(ny);
+    src->set_number_of_time_steps(nt);
+
+    p_box_sum bs = box_sum::New();
+    bs->set_input_connection(src->get_output_port());
+
+    p_teca_spatial_reduce red = teca_spatial_reduce::New();
+    red->set_number_of_i_tiles(n_i_tiles);
+    red->set_halo(halo);
+    red->set_thread_pool_size(n_threads);
+    red->set_input_connection(bs->get_output_port());
+
+    p_collect col = collect::New();
+    col->set_input_connection(red->get_output_port());
+
+    p_teca_spatial_executive exec = teca_spatial_executive::New();
+    col->set_executive(exec);
+    col->update();
+
+    unsigned long whole_ext[6] = {0, nx - 1, 0, ny - 1, 0, 0};
+
+    long n_bad = 0;
+    unsigned long n_points = 0;
+    size_t n_ds = col->datasets.size();
+    for (size_t q = 0; q < n_ds; ++q)
+    {
+        const_p_teca_cartesian_mesh mesh
+            = std::dynamic_pointer_cast<const teca_cartesian_mesh>(col->datasets[q]);
+
+        const_p_teca_double_array ga;
+        if (!mesh || !(ga = std::dynamic_pointer_cast<const teca_double_array>(
+            mesh->get_point_arrays()->get("g"))))
+        {
+            TECA_ERROR("invalid output")
+            return -1;
+        }
+
+        std::vector<unsigned long> tile;
+        col->requests[q].get("tile_extent", tile);
+
+        unsigned long t = 0;
+        col->requests[q].get("time_step", t);
+
+        unsigned long ext[6];
+        mesh->get_extent(ext);
+        CHECK(std::vector<unsigned long>(ext, ext + 6) == tile)
+        CHECK(mesh->get_x_coordinates()->size() == tile[1] - tile[0] + 1)
+        CHECK(mesh->get_y_coordinates()->size() == tile[3] - tile[2] + 1)
+
+        double y0 = 0.0;
+        mesh->get_y_coordinates()->get(0, y0);
+        CHECK(y0 == tile[2])
+
+        unsigned long n_x = ext[1] - ext[0] + 1;
+        const double *pg = ga->get();
+        for (unsigned long j = ext[2]; j <= ext[3]; ++j)
+        {
+            for (unsigned long i = ext[0]; i <= ext[1]; ++i)
+            {
+                if (pg[(j - ext[2])*n_x + i - ext[0]] != g(whole_ext, i, j, t))
+                    ++n_bad;
+                ++n_points;
+            }
+        }
+    }
+
+    n_points = sum_over_ranks(n_points);
+    if (n_points != nx*ny*nt)
+    {
+        TECA_ERROR(<< n_points << " points processed but there are "
+            << nx*ny*nt)
+        return -1;
+    }
+
+    return sum_over_ranks(n_bad);
+}
+
+// tile-local tables are concatenated
+int test_table(unsigned long nx, unsigned long ny, unsigned long nt,
+    int n_threads)
+{
+    p_grid_source src = grid_source::New();
+    src->set_nx(nx);
+    src->set_ny(ny);
+    src->set_number_of_time_steps(nt);
+
+    p_box_sum bs = box_sum::New();
+    bs->set_input_connection(src->get_output_port());
+
+    p_tile_points tp = tile_points::New();
+    tp->set_input_connection(bs->get_output_port());
+
+    p_teca_spatial_reduce red = teca_spatial_reduce::New();
+    red->set_number_of_i_tiles(2);
+    red->set_thread_pool_size(n_threads);
+    red->set_input_connection(tp->get_output_port());
+
+    p_collect col = collect::New();
+    col->set_input_connection(red->get_output_port());
+
+    p_teca_spatial_executive exec = teca_spatial_executive::New();
+    col->set_executive(exec);
+    col->update();
+
+    unsigned long whole_ext[6] = {0, nx - 1, 0, ny - 1, 0, 0};
+
+    unsigned long n_rows = 0;
+    size_t n_ds = col->datasets.size();
+    for (size_t q = 0; q < n_ds; ++q)
+    {
+        const_p_teca_table table
+            = std::dynamic_pointer_cast<const teca_table>(col->datasets[q]);
+        CHECK(table)
+
+        unsigned long t = 0;
+        col->requests[q].get("time_step", t);
+
+        unsigned long n = table->get_number_of_rows();
+        for (unsigned long r = 0; r < n; ++r)
+        {
+            unsigned long i = 0, j = 0;
+            double val = 0.0;
+            table->get_column("i")->get(r, i);
+            table->get_column("j")->get(r, j);
+            table->get_column("g")->get(r, val);
+            CHECK(val == g(whole_ext, i, j, t))
+        }
+
+        n_rows += n;
+    }
+
+    unsigned long n_expected = 0;
+    for (unsigned long t = 0; t < nt; ++t)
+        for (unsigned long j = 0; j < ny; ++j)
+            for (unsigned long i = 0; i < nx; ++i)
+                n_expected += selected(g(whole_ext, i, j, t)) ? 1 : 0;
+
+    n_rows = sum_over_ranks(n_rows);
+    if (n_rows != n_expected)
+    {
+        TECA_ERROR(<< n_rows << " rows != " << n_expected)
+        return -1;
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 5))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> nx" << std::endl
+            << "arg 2 -> ny" << std::endl
+            << "arg 3 -> n time steps" << std::endl
+            << "arg 4 -> n threads" << std::endl)
+        return -1;
+    }
+
+    unsigned long nx = 64;
+    unsigned long ny = 48;
+    unsigned long nt = 3;
+    int n_threads = 4;
+
+    if (argc == 5)
+    {
+        nx = atol(argv[1]);
+        ny = atol(argv[2]);
+        nt = atol(argv[3]);
+        n_threads = atoi(argv[4]);
+    }
+
+    nx = std::max(nx, 4ul);
+    ny = std::max(ny, 4ul);
+    nt = std::max(nt, 1ul);
+    n_threads = std::max(n_threads, 2);
+
+    if (test_partition())
+        return -1;
+
+    // with a halo the result matches the untiled result
+    long n_bad = test_mesh(nx, ny, nt, 1, 1, n_threads);
+    CHECK(n_bad == 0)
+
+    n_bad = test_mesh(nx, ny, nt, 3, 2, n_threads);
+    CHECK(n_bad == 0)
+
+    // without one the points on the seams are wrong
+    n_bad = test_mesh(nx, ny, nt, 2, 0, n_threads);
+    CHECK(n_bad > 0)
+
+    if (test_table(nx, ny, nt, n_threads))
+        return -1;
+
+    return 0;
+}
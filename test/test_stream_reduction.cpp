@@ -0,0 +1,204 @@
+#include "teca_config.h"
+#include "teca_algorithm.h"
+#include "teca_table_reduce.h"
+#include "teca_dataset_capture.h"
+#include "teca_table.h"
+#include "teca_variant_array.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+#include "table_source.h"
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+
+TECA_SHARED_OBJECT_FORWARD_DECL(counting_reduce)
+
+// a table reduction that records the largest number of partial
+// results, and of the source's tables, alive while streaming
+class counting_reduce : public teca_table_reduce
+{
+public:
+    TECA_ALGORITHM_STATIC_NEW(counting_reduce)
+
+    void set_source(const p_table_source &src)
+    { this->source = src; }
+
+    unsigned long get_max_partials() const
+    { return this->max_partials; }
+
+    unsigned long get_max_alive() const
+    { return this->max_alive; }
+
+    unsigned long get_number_reported() const
+    { return this->n_reported; }
+
+protected:
+    counting_reduce() : max_partials(0), max_alive(0), n_reported(0) {}
+
+    void stream_progress(unsigned int port,
+        const std::vector<teca_metadata> &up_reqs,
+        const const_p_teca_dataset &arrived,
+        const std::vector<const_p_teca_dataset> &partials,
+        const teca_metadata &request) override
+    {
+        this->teca_table_reduce::stream_progress(port,
+            up_reqs, arrived, partials, request);
+
+        unsigned long n_partials = std::count_if(partials.begin(),
+            partials.end(), [](const const_p_teca_dataset &p) -> bool
+            { return bool(p); });
+
+        this->max_partials = std::max(this->max_partials, n_partials);
+
+        this->max_alive = std::max(this->max_alive,
+            this->source->get_number_alive());
+
+        this->n_reported += up_reqs.size();
+    }
+
+private:
+    p_table_source source;
+    unsigned long max_partials;
+    unsigned long max_alive;
+    unsigned long n_reported;
+};
+
+// check that the table holds each time step once
+bool check_table(const const_p_teca_table &table, unsigned long n_steps)
+{
+    if (!table || (table->get_number_of_rows() != n_steps))
+        return false;
+
+    std::vector<long> steps(n_steps);
+    const_p_teca_variant_array col = table->get_column("step");
+    for (unsigned long i = 0; i < n_steps; ++i)
+        col->get(i, steps[i]);
+
+    std::sort(steps.begin(), steps.end());
+    for (unsigned long i = 0; i < n_steps; ++i)
+    {
+        if (steps[i] != static_cast<long>(i))
+            return false;
+    }
+
+    return true;
+}
+
+// check that the table's rows are in time step order
+bool in_order(const const_p_teca_table &table)
+{
+    unsigned long n_rows = table->get_number_of_rows();
+
+    const_p_teca_variant_array col = table->get_column("step");
+    for (unsigned long i = 0; i < n_rows; ++i)
+    {
+        long step = 0;
+        col->get(i, step);
+        if (step != static_cast<long>(i))
+            return false;
+    }
+
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 4))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> n time steps" << std::endl
+            << "arg 2 -> n threads" << std::endl
+            << "arg 3 -> max in flight" << std::endl)
+        return -1;
+    }
+
+    unsigned long n_steps = argc == 4 ? atol(argv[1]) : 256;
+    int n_threads = argc == 4 ? atoi(argv[2]) : 2;
+    long max_in_flight = argc == 4 ? atol(argv[3]) : 4;
+
+    n_steps = std::max(n_steps, 16ul);
+    n_threads = std::max(n_threads, 1);
+    max_in_flight = std::max(max_in_flight, 1l);
+
+    // streaming is on by default
+    p_counting_reduce red = counting_reduce::New();
+    CHECK(red->get_stream_size() > 0)
+
+    p_table_source src = table_source::New();
+    src->set_number_of_time_steps(n_steps);
+
+    red->set_source(src);
+    red->set_thread_pool_size(n_threads);
+    red->set_max_in_flight(max_in_flight);
+    red->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(red->get_output_port());
+    cap->update();
+
+    const_p_teca_table result =
+        std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+
+    // every time step is reduced once
+    CHECK(check_table(result, n_steps))
+    CHECK(red->get_number_reported() == n_steps)
+
+    // the partial results are folded as in a binary counter, there
+    // is at most one per level
+    unsigned long n_levels = 1;
+    while ((1ul << n_levels) <= n_steps)
+        ++n_levels;
+
+    CHECK(red->get_max_partials() <= n_levels)
+
+    // the data held at once is bounded by the requests in flight
+    // and the partial results, not by the number of time steps
+    CHECK(red->get_max_alive() <= max_in_flight + n_levels)
+
+    std::cerr << "streamed " << n_steps << " time steps holding at most "
+        << red->get_max_partials() << " partial results and "
+        << red->get_max_alive() << " time steps" << std::endl;
+
+    // the data is reduced in the order it was requested, the time
+    // steps are requested in ascending order. the result is the same
+    // as when all of the data is reduced at once
+    CHECK(in_order(result))
+
+    red->set_stream_size(0);
+    cap->update();
+
+    const_p_teca_table ordered =
+        std::dynamic_pointer_cast<const teca_table>(cap->get_dataset());
+
+    CHECK(check_table(ordered, n_steps))
+    CHECK(in_order(ordered))
+    red->set_stream_size(2);
+
+    // an error generating one of the time steps reaches the caller
+    // rather than leaving the reduction waiting for it
+    src->set_failing_time_step(n_steps/2);
+
+    bool caught = false;
+    try
+    {
+        cap->update();
+    }
+    catch (const std::runtime_error &)
+    {
+        caught = true;
+    }
+    CHECK(caught)
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_thread_pool.h"
+#include "teca_threadsafe_queue.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <cstdlib>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+using task_t = std::packaged_task<int()>;
+using pool_t = teca_thread_pool<task_t, int>;
+
+// a replica of the original pool, a single shared queue with
+// workers that spin and yield when it is empty. this is used
+// as the reference point for the measurements.
+class spin_pool
+{
+public:
+    spin_pool(int n) : m_live(true)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            m_threads.push_back(std::thread([this]()
+            {
+                while (m_live.load())
+                {
+                    task_t task;
+                    if (m_queue.try_pop(task))
+                        task();
+                    else
+                        std::this_thread::yield();
+                }
+            }));
+        }
+    }
+
+    ~spin_pool()
+    {
+        m_live = false;
+        for (auto &t : m_threads)
+            t.join();
+    }
+
+    std::future<int> push_task(task_t &task)
+    {
+        std::future<int> f = task.get_future();
+        m_queue.push(std::move(task));
+        return f;
+    }
+
+    void wait_data(std::vector<std::future<int>> &futures,
+        std::vector<int> &data)
+    {
+        for (auto &f : futures)
+            data.push_back(f.get());
+        futures.clear();
+    }
+
+    unsigned int size() const { return m_threads.size(); }
+
+private:
+    std::atomic<bool> m_live;
+    teca_threadsafe_queue<task_t> m_queue;
+    std::vector<std::thread> m_threads;
+};
+
+// get the CPU time in seconds consumed by the process
+double cpu_time()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec
+        + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec)/1.0e6;
+}
+
+// measure the CPU time consumed while the pool has no work
+// returns CPU seconds per wall clock second
+template <typename pool_t>
+double idle_cpu(pool_t &, double wall)
+{
+    // let the threads start up and settle
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    double t0 = cpu_time();
+    std::this_thread::sleep_for(std::chrono::duration<double>(wall));
+    double t1 = cpu_time();
+
+    return (t1 - t0)/wall;
+}
+
+// measure the round trip latency of dispatching a trivial task
+// and waiting for its result. returns microseconds per task.
+template <typename pool_t>
+double dispatch_latency(pool_t &pool, int n_tasks, int &sum)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        task_t task([i]() -> int { return i%2; });
+
+        std::vector<std::future<int>> futures;
+        futures.push_back(pool.push_task(task));
+
+        std::vector<int> data;
+        pool.wait_data(futures, data);
+
+        sum += data[0];
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::micro>(t1 - t0).count()/n_tasks;
+}
+
+// measure the throughput of dispatching a batch of tasks
+// returns microseconds per task
+template <typename pool_t>
+double batch_time(pool_t &pool, int n_tasks, int &sum)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < n_tasks; ++i)
+    {
+        task_t task([i]() -> int { return i%2; });
+        futures.push_back(pool.push_task(task));
+    }
+
+    std::vector<int> data;
+    pool.wait_data(futures, data);
+
+    for (int v : data)
+        sum += v;
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::micro>(t1 - t0).count()/n_tasks;
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    if ((argc != 1) && (argc != 4))
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << endl
+            << "arg 1 -> n threads" << endl
+            << "arg 2 -> n tasks" << endl
+            << "arg 3 -> idle time in seconds" << endl)
+        return -1;
+    }
+
+    int n_threads = 2;
+    int n_tasks = 1000;
+    double wall = 0.25;
+
+    if (argc == 4)
+    {
+        n_threads = atoi(argv[1]);
+        n_tasks = atoi(argv[2]);
+        wall = atof(argv[3]);
+    }
+
+    n_threads = max(n_threads, 1);
+    n_tasks = max(n_tasks, 1);
+
+    int sum = 0;
+
+    double idle_ref = 0.0;
+    double lat_ref = 0.0;
+    double batch_ref = 0.0;
+    {
+    spin_pool pool(n_threads);
+    idle_ref = idle_cpu(pool, wall);
+    lat_ref = dispatch_latency(pool, n_tasks, sum);
+    batch_ref = batch_time(pool, n_tasks, sum);
+    }
+
+    double idle_new = 0.0;
+    double lat_new = 0.0;
+    double batch_new = 0.0;
+    {
+    pool_t pool(MPI_COMM_SELF, n_threads, true, false, false);
+    idle_new = idle_cpu(pool, wall);
+    lat_new = dispatch_latency(pool, n_tasks, sum);
+    batch_new = batch_time(pool, n_tasks, sum);
+
+    // grow and shrink the pool, work must be serviced after
+    // each change
+    int sum_resize = 0;
+    int n_sizes[] = {2*n_threads, 1, n_threads};
+    for (int n : n_sizes)
+    {
+        pool.resize(MPI_COMM_SELF, n, true, false, false);
+        if (pool.size() != static_cast<unsigned int>(n))
+        {
+            TECA_ERROR("resize to " << n << " threads produced "
+                << pool.size() << " threads")
+            return -1;
+        }
+        batch_time(pool, n_tasks, sum_resize);
+    }
+
+    if (sum_resize != 3*(n_tasks/2))
+    {
+        TECA_ERROR("resized pool produced the wrong result " << sum_resize)
+        return -1;
+    }
+    }
+
+    cerr << "thread pool benchmark " << n_threads << " threads "
+        << n_tasks << " tasks" << endl
+        << setw(24) << left << "" << setw(14) << right << "spin-yield"
+        << setw(14) << right << "work-steal" << endl
+        << setw(24) << left << "idle CPU (cores)"
+        << setw(14) << right << idle_ref << setw(14) << right << idle_new << endl
+        << setw(24) << left << "dispatch latency (us)"
+        << setw(14) << right << lat_ref << setw(14) << right << lat_new << endl
+        << setw(24) << left << "batch time (us/task)"
+        << setw(14) << right << batch_ref << setw(14) << right << batch_new << endl;
+
+    // each pool computed the same sum
+    if (sum != 2*(n_tasks/2 + n_tasks/2))
+    {
+        TECA_ERROR("tasks produced the wrong result " << sum)
+        return -1;
+    }
+
+    // an idle pool should not consume any appreciable CPU time
+    if (idle_new > 0.1)
+    {
+        TECA_ERROR("idle pool consumed " << idle_new << " cores")
+        return -1;
+    }
+
+    return 0;
+}
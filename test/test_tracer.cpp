@@ -0,0 +1,118 @@
+#include "teca_config.h"
+#include "array_source.h"
+#include "array_temporal_stats.h"
+#include "array_writer.h"
+#include "teca_tracer.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+
+
+// count the number of times str occurs in the text
+size_t count(const std::string &text, const std::string &str)
+{
+    size_t n = 0;
+    size_t pos = 0;
+    while ((pos = text.find(str, pos)) != std::string::npos)
+    {
+        ++n;
+        pos += str.size();
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    int rank = mpi_man.get_comm_rank();
+
+    teca_system_interface::set_stack_trace_on_error();
+
+    if (argc != 2)
+    {
+        TECA_ERROR(
+            << "invalid command line arguments. arguments are:" << std::endl
+            << "arg 1 -> trace file name" << std::endl)
+        return -1;
+    }
+
+    std::string file_name = argv[1];
+
+    teca_tracer::set_file_name(file_name);
+
+    // array_source --> array_temporal_stats --> array_writer
+    int n_steps = 8;
+
+    p_array_source src = array_source::New();
+    src->set_number_of_timesteps(n_steps);
+    src->set_number_of_arrays(2);
+    src->set_array_size(16);
+
+    p_array_temporal_stats stats = array_temporal_stats::New();
+    stats->set_thread_pool_size(2);
+    stats->set_array_name("array_1");
+    stats->set_input_connection(src->get_output_port());
+
+    p_array_writer wri = array_writer::New();
+    wri->set_input_connection(stats->get_output_port());
+
+    wri->update();
+
+    if (teca_tracer::write())
+    {
+        TECA_ERROR("failed to write the trace")
+        return -1;
+    }
+
+    if (rank == 0)
+    {
+        std::ifstream ifs(file_name);
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        std::string trace = ss.str();
+
+        std::remove(file_name.c_str());
+
+        if ((trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") != 0) ||
+            (trace.rfind("]}") == std::string::npos))
+        {
+            TECA_ERROR("the trace is malformed" << std::endl << trace)
+            return -1;
+        }
+
+        // there is a span per time step in the source
+        size_t n_src = count(trace, "\"array_source::execute\"");
+        if (n_src < static_cast<size_t>(n_steps))
+        {
+            TECA_ERROR("found " << n_src << " of " << n_steps
+                << " source spans" << std::endl << trace)
+            return -1;
+        }
+
+        const char *phases[] = {"array_temporal_stats::get_upstream_request",
+            "array_temporal_stats::wait", "array_temporal_stats::execute",
+            "array_writer::execute", "array_source::get_output_metadata"};
+
+        for (const char *phase : phases)
+        {
+            if (trace.find(phase) == std::string::npos)
+            {
+                TECA_ERROR("no span for " << phase << std::endl << trace)
+                return -1;
+            }
+        }
+
+        std::cerr << "found " << count(trace, "\"ph\":\"X\"")
+            << " spans" << std::endl;
+    }
+
+    // nothing is left to write when MPI is finalized
+    teca_tracer::set_file_name("");
+
+    return 0;
+}
@@ -0,0 +1,277 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_allocator.h"
+#include "teca_variant_array.h"
+#include "teca_binary_stream.h"
+#include "teca_cartesian_mesh.h"
+#include "teca_array_collection.h"
+#include "teca_dataset_source.h"
+#include "teca_vorticity.h"
+#include "teca_dataset_capture.h"
+#include "teca_metadata.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+std::atomic<long> n_allocs(0);
+std::atomic<long> n_bytes(0);
+
+// fills new memory with a pattern, so that tests can see whether
+// the storage was initialized
+void *fill_allocate(std::size_t n, std::size_t alignment)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, n ? n : alignment))
+        return nullptr;
+    memset(ptr, 0xff, n);
+    ++n_allocs;
+    n_bytes += n;
+    return ptr;
+}
+
+void fill_deallocate(void *ptr, std::size_t n, std::size_t)
+{
+    --n_allocs;
+    n_bytes -= n;
+    free(ptr);
+}
+
+// zero fills new memory, as sizing a std::vector does. used to
+// measure the cost of zero filling
+void *zero_allocate(std::size_t n, std::size_t alignment)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, n ? n : alignment))
+        return nullptr;
+    memset(ptr, 0, n);
+    return ptr;
+}
+
+void zero_deallocate(void *ptr, std::size_t, std::size_t)
+{
+    free(ptr);
+}
+
+bool is_aligned(const void *ptr)
+{
+    return (reinterpret_cast<std::uintptr_t>(ptr) % teca_allocator::alignment) == 0;
+}
+
+// a time step read from disk, emulated by copying into the array
+// returns the time in milliseconds per step
+double time_reader(const std::vector<float> &file, int n_steps)
+{
+    size_t n = file.size();
+    float sum = 0.0f;
+
+    auto t0 = hr_clock_t::now();
+    for (int i = 0; i < n_steps; ++i)
+    {
+        p_teca_float_array a = teca_float_array::New(n, teca_uninitialized);
+        memcpy(a->get(), file.data(), n*sizeof(float));
+        sum += a->get(i % n);
+    }
+    auto t1 = hr_clock_t::now();
+
+    if (sum < 0.0f)
+        std::cerr << sum << std::endl;
+
+    return std::chrono::duration<double, std::milli>(t1 - t0).count()/n_steps;
+}
+
+// a mesh with a velocity field on a global lat lon grid
+p_teca_cartesian_mesh make_mesh(unsigned long nx, unsigned long ny)
+{
+    p_teca_double_array x = teca_double_array::New(nx);
+    p_teca_double_array y = teca_double_array::New(ny);
+    p_teca_double_array z = teca_double_array::New(1);
+
+    for (unsigned long i = 0; i < nx; ++i)
+        x->set(i, 360.0*i/nx);
+
+    for (unsigned long j = 0; j < ny; ++j)
+        y->set(j, -89.75 + 179.5*j/(ny - 1));
+
+    p_teca_double_array u = teca_double_array::New(nx*ny);
+    p_teca_double_array v = teca_double_array::New(nx*ny);
+    double *pu = u->get();
+    double *pv = v->get();
+    for (unsigned long j = 0; j < ny; ++j)
+    {
+        for (unsigned long i = 0; i < nx; ++i)
+        {
+            double lon = x->get(i)*M_PI/180.0;
+            double lat = y->get(j)*M_PI/180.0;
+            pu[j*nx + i] = 10.0*cos(lat)*sin(2.0*lon);
+            pv[j*nx + i] = 5.0*sin(lat)*cos(3.0*lon);
+        }
+    }
+
+    unsigned long extent[6] = {0, nx - 1, 0, ny - 1, 0, 0};
+
+    p_teca_cartesian_mesh mesh = teca_cartesian_mesh::New();
+    mesh->set_x_coordinates(x);
+    mesh->set_y_coordinates(y);
+    mesh->set_z_coordinates(z);
+    mesh->set_whole_extent(extent);
+    mesh->set_extent(extent);
+    mesh->get_point_arrays()->append("u", u);
+    mesh->get_point_arrays()->append("v", v);
+
+    return mesh;
+}
+
+// run the vorticity stencil over the mesh. returns the time in
+// milliseconds per step and the result of the last step
+double time_stencil(const p_teca_cartesian_mesh &mesh, int n_steps,
+    const_p_teca_variant_array &w)
+{
+    teca_metadata md;
+    md.insert("number_of_time_steps", 1);
+
+    p_teca_dataset_source src = teca_dataset_source::New();
+    src->set_dataset(mesh);
+    src->set_metadata(md);
+
+    p_teca_vorticity vort = teca_vorticity::New();
+    vort->set_component_0_variable("u");
+    vort->set_component_1_variable("v");
+    vort->set_vorticity_variable("w");
+    vort->set_input_connection(src->get_output_port());
+
+    p_teca_dataset_capture cap = teca_dataset_capture::New();
+    cap->set_input_connection(vort->get_output_port());
+
+    auto t0 = hr_clock_t::now();
+    for (int i = 0; i < n_steps; ++i)
+        cap->update();
+    auto t1 = hr_clock_t::now();
+
+    const_p_teca_cartesian_mesh out =
+        std::dynamic_pointer_cast<const teca_cartesian_mesh>(cap->get_dataset());
+
+    w = out ? out->get_point_arrays()->get("w") : nullptr;
+
+    return std::chrono::duration<double, std::milli>(t1 - t0).count()/n_steps;
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    // the default is a 0.25 degree grid
+    unsigned long nx = argc > 1 ? atol(argv[1]) : 1440;
+    unsigned long ny = argc > 2 ? atol(argv[2]) : 720;
+    int n_steps = argc > 3 ? atoi(argv[3]) : 20;
+
+    // storage is aligned, and initialized only on request
+    {
+    teca_allocator::set_functions(fill_allocate, fill_deallocate);
+
+    size_t sizes[] = {1, 3, 17, 1000};
+    for (size_t n : sizes)
+    {
+        p_teca_float_array a = teca_float_array::New(n);
+        CHECK(is_aligned(a->get()))
+        for (size_t i = 0; i < n; ++i)
+            CHECK(a->get(i) == 0.0f)
+
+        p_teca_char_array b = teca_char_array::New(n, teca_uninitialized);
+        CHECK(is_aligned(b->get()))
+        CHECK(b->get(n - 1) == char(0xff))
+
+        b->resize(2*n);
+        CHECK(is_aligned(b->get()))
+        CHECK(b->get(2*n - 1) == 0)
+
+        b->resize(4*n, teca_uninitialized);
+        CHECK(b->get(4*n - 1) == char(0xff))
+
+        p_teca_variant_array c = a->new_instance(n, teca_uninitialized);
+        CHECK(c->size() == n)
+        CHECK(is_aligned(std::static_pointer_cast<teca_float_array>(c)->get()))
+
+        p_teca_variant_array d = b->new_copy(1, n);
+        CHECK(d->size() == n)
+        CHECK(is_aligned(std::static_pointer_cast<teca_char_array>(d)->get()))
+
+        p_teca_string_array s = teca_string_array::New(n);
+        CHECK(is_aligned(s->get()))
+        CHECK(s->get(n - 1).empty())
+        s->resize(2*n, teca_uninitialized);
+        CHECK(s->get(2*n - 1).empty())
+    }
+
+    // serialization
+    p_teca_double_array a = teca_double_array::New(100);
+    for (int i = 0; i < 100; ++i)
+        a->set(i, 0.5*i);
+
+    p_teca_string_array s = teca_string_array::New();
+    s->append(std::string("one"));
+    s->append(std::string("two"));
+
+    teca_binary_stream bs;
+    a->to_stream(bs);
+    s->to_stream(bs);
+
+    p_teca_double_array a2 = teca_double_array::New();
+    p_teca_string_array s2 = teca_string_array::New();
+    a2->from_stream(bs);
+    s2->from_stream(bs);
+
+    CHECK(*a2 == *a)
+    CHECK(*s2 == *s)
+    }
+
+    // all of the memory was returned to the allocator
+    CHECK(n_allocs == 0)
+    CHECK(n_bytes == 0)
+
+    teca_allocator::set_functions(nullptr, nullptr);
+
+    // time reading and a stencil with and without zero filling.
+    // zero filling is emulated by an allocator that zeros memory
+    std::vector<float> file(nx*ny, 1.0f);
+    p_teca_cartesian_mesh mesh = make_mesh(nx, ny);
+
+    const_p_teca_variant_array w_ref;
+    const_p_teca_variant_array w_new;
+
+    teca_allocator::set_functions(zero_allocate, zero_deallocate);
+    double read_ref = time_reader(file, n_steps);
+    double stencil_ref = time_stencil(mesh, n_steps, w_ref);
+    teca_allocator::set_functions(nullptr, nullptr);
+
+    double read_new = time_reader(file, n_steps);
+    double stencil_new = time_stencil(mesh, n_steps, w_new);
+
+    std::cerr << nx << " x " << ny << " mesh, " << n_steps << " steps"
+        << std::endl << "    reader  zero filled " << read_ref
+        << " ms uninitialized " << read_new << " ms" << std::endl
+        << "    stencil zero filled " << stencil_ref
+        << " ms uninitialized " << stencil_new << " ms" << std::endl;
+
+    // the stencil writes every element
+    CHECK(w_ref && w_new)
+    CHECK(*w_ref == *w_new)
+
+    return 0;
+}
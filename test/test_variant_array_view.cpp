@@ -0,0 +1,208 @@
+#include "teca_config.h"
+#include "teca_common.h"
+#include "teca_variant_array.h"
+#include "teca_binary_stream.h"
+#include "teca_mpi_manager.h"
+#include "teca_system_interface.h"
+#include "teca_test_util.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+using hr_clock_t = std::chrono::high_resolution_clock;
+
+namespace {
+
+// pull out n_rows rows at a time, as the table reader does per time
+// step, by copying them. returns the time in milliseconds
+double time_copy(const const_p_teca_double_array &a, unsigned long n_rows,
+    double &sum)
+{
+    unsigned long n = a->size();
+    auto t0 = hr_clock_t::now();
+    for (unsigned long i = 0; i + n_rows <= n; i += n_rows)
+    {
+        p_teca_double_array b = teca_double_array::New(n_rows, teca_uninitialized);
+        memcpy(b->get(), a->get() + i, n_rows*sizeof(double));
+        sum += static_cast<const teca_double_array*>(b.get())->get(0);
+    }
+    auto t1 = hr_clock_t::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// pull out n_rows rows at a time with views
+double time_view(const const_p_teca_double_array &a, unsigned long n_rows,
+    double &sum)
+{
+    unsigned long n = a->size();
+    auto t0 = hr_clock_t::now();
+    for (unsigned long i = 0; i + n_rows <= n; i += n_rows)
+    {
+        const_p_teca_double_array b = std::static_pointer_cast
+            <const teca_double_array>(a->new_view(i, i + n_rows - 1));
+        sum += b->get(0);
+    }
+    auto t1 = hr_clock_t::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+}
+
+
+int main(int argc, char **argv)
+{
+    teca_mpi_manager mpi_man(argc, argv);
+    teca_system_interface::set_stack_trace_on_error();
+
+    unsigned long n = argc > 1 ? atol(argv[1]) : 10000000;
+    unsigned long n_rows = argc > 2 ? atol(argv[2]) : 10000;
+
+    p_teca_double_array a = teca_double_array::New(100);
+    for (int i = 0; i < 100; ++i)
+        a->set(i, i);
+
+    const_p_teca_double_array ca = a;
+
+    // a view shares the parent's data
+    {
+    const_p_teca_double_array v = std::static_pointer_cast
+        <const teca_double_array>(ca->new_view(10, 29));
+
+    CHECK(v->size() == 20)
+    CHECK(v->get() == ca->get() + 10)
+    CHECK(v->get(0) == 10.0)
+    CHECK(v->get(19) == 29.0)
+
+    // it reports the size of its own values
+    CHECK(v->get_memory_usage() == 20*sizeof(double))
+
+    // a view of a view
+    const_p_teca_double_array vv = std::static_pointer_cast
+        <const teca_double_array>(v->new_view(5, 9));
+    CHECK(vv->size() == 5)
+    CHECK(vv->get() == ca->get() + 15)
+
+    // writing to a view leaves the parent unchanged
+    p_teca_double_array w = std::const_pointer_cast<teca_double_array>(v);
+    w->set(0, -1.0);
+    CHECK(w->get(0) == -1.0)
+    CHECK(ca->get(10) == 10.0)
+    CHECK(vv->get(0) == 15.0)
+
+    // growing a view leaves the parent unchanged
+    w->append(-2.0);
+    CHECK(w->size() == 21)
+    CHECK(ca->get(30) == 30.0)
+    CHECK(w->get_memory_usage() == 21*sizeof(double))
+
+    // writing to the parent leaves the view unchanged
+    a->set(15, -3.0);
+    CHECK(vv->get(0) == 15.0)
+    CHECK(ca->get(15) == -3.0)
+    a->set(15, 15.0);
+    }
+
+    // copies don't share data
+    {
+    double *pa = a->get();
+
+    p_teca_double_array c = std::static_pointer_cast
+        <teca_double_array>(a->new_copy());
+    CHECK(*c == *a)
+    CHECK(static_cast<const teca_double_array*>(c.get())->get() != ca->get())
+
+    // a pointer taken before the copy writes only to the original
+    pa[0] = 200.0;
+    CHECK(c->get(0) == 0.0)
+
+    p_teca_double_array r = std::static_pointer_cast
+        <teca_double_array>(a->new_copy(10, 19));
+    CHECK(r->size() == 10)
+    CHECK(r->get(0) == 10.0)
+    CHECK(r->get_memory_usage() == 10*sizeof(double))
+    pa[10] = 210.0;
+    CHECK(r->get(0) == 10.0)
+    pa[10] = 10.0;
+
+    a->set(0, 100.0);
+    CHECK(c->get(0) == 0.0)
+    CHECK(ca->get(0) == 100.0)
+
+    c->set(1, 101.0);
+    CHECK(ca->get(1) == 1.0)
+
+    // assignment
+    teca_double_array &d = *c;
+    d = *a;
+    CHECK(*c == *a)
+    a->set(2, 102.0);
+    CHECK(c->get(2) == 2.0)
+    }
+
+    // a view is serialized by value
+    {
+    p_teca_double_array v = std::static_pointer_cast
+        <teca_double_array>(ca->new_view(50, 59));
+
+    p_teca_string_array s = teca_string_array::New();
+    for (int i = 0; i < 8; ++i)
+        s->append(std::to_string(i));
+
+    p_teca_string_array sv = std::static_pointer_cast
+        <teca_string_array>(s->new_view(2, 5));
+
+    teca_binary_stream bs;
+    v->to_stream(bs);
+    sv->to_stream(bs);
+
+    p_teca_double_array v2 = teca_double_array::New();
+    p_teca_string_array sv2 = teca_string_array::New();
+    v2->from_stream(bs);
+    sv2->from_stream(bs);
+
+    CHECK(v2->size() == 10)
+    CHECK(*v2 == *v)
+    CHECK(v2->get(0) == 50.0)
+    CHECK(sv2->size() == 4)
+    CHECK(*sv2 == *sv)
+    CHECK(sv2->get(0) == "2")
+
+    // appending a view
+    p_teca_variant_array s2 = teca_string_array::New();
+    s2->append(const_p_teca_variant_array(sv));
+    s2->append(const_p_teca_variant_array(sv));
+    CHECK(s2->size() == 8)
+    CHECK(std::static_pointer_cast<teca_string_array>(s2)->get(4) == "2")
+    }
+
+    // clearing and resizing a view
+    {
+    p_teca_double_array c = std::static_pointer_cast
+        <teca_double_array>(a->new_view(0, 99));
+    c->clear();
+    CHECK(c->size() == 0)
+    CHECK(a->size() == 100)
+    c->resize(10, 1.0);
+    CHECK(c->get(9) == 1.0)
+    CHECK(a->get(9) == 9.0)
+    }
+
+    // time pulling out sub-arrays by copying and with views
+    p_teca_double_array big = teca_double_array::New(n, 1.0);
+    const_p_teca_double_array cbig = big;
+
+    double sum_copy = 0.0;
+    double sum_view = 0.0;
+    double t_copy = time_copy(cbig, n_rows, sum_copy);
+    double t_view = time_view(cbig, n_rows, sum_view);
+
+    std::cerr << n << " values in sub-arrays of " << n_rows << std::endl
+        << "    copy " << t_copy << " ms view " << t_view << " ms" << std::endl;
+
+    CHECK(sum_copy == sum_view)
+
+    return 0;
+}